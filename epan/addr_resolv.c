@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
 
 #include <wsutil/strtoi.h>
 #include <wsutil/ws_assert.h>
@@ -108,6 +109,7 @@
 #define ENAME_SS7PCS    "ss7pcs"
 #define ENAME_ENTERPRISES "enterprises"
 #define ENAME_TACS      "tacs"
+#define ENAME_RESOLVER_CACHE "resolver_cache"
 
 #define HASHETHSIZE      2048
 #define HASHHOSTSIZE     2048
@@ -261,6 +263,8 @@ static wmem_map_t *manuf_hashtable;
 static wmem_map_t *wka_hashtable;
 // Maps address -> hashether_t*
 static wmem_map_t *eth_hashtable;
+// Fixed-size table of hashether_t used once eth_hashtable is full
+static hashether_t *eth_overflow_slots;
 // Maps address -> hasheui64_t*
 static wmem_map_t *eui64_hashtable;
 // Maps unsigned -> serv_port_t*
@@ -283,6 +287,7 @@ static GPtrArray* extra_hosts_files;
 static hashether_t *add_eth_name(const uint8_t *addr, const char *name, bool static_entry);
 static hasheui64_t *add_eui64_name(const uint8_t *addr, const char *name, bool static_entry);
 static void add_serv_port_cb(const uint32_t port, void *ptr);
+static void resolver_cache_add(int family, const void *addrp, const char *name);
 
 /* http://eternallyconfuzzled.com/tuts/algorithms/jsw_tut_hashing.aspx#existing
  * One-at-a-Time hash
@@ -509,7 +514,7 @@ c_ares_ghba_sync_cb(void *arg, int status, int timeouts _U_, struct hostent *he)
                     break;
             }
         }
-
+        resolver_cache_add(sdd->family, &sdd->addr, he->h_name);
     }
 
     /*
@@ -1348,6 +1353,7 @@ c_ares_ghba_cb(void *arg, int status, int timeouts _U_, struct hostent *he) {
                     break;
             }
         }
+        resolver_cache_add(caqm->family, &caqm->addr, he->h_name);
     }
     wmem_free(addr_resolv_scope, caqm);
 }
@@ -2173,6 +2179,7 @@ ethers_cleanup(void)
     wka_hashtable = NULL;
     manuf_hashtable = NULL;
     eth_hashtable = NULL;
+    eth_overflow_slots = NULL;
     eui64_hashtable = NULL;
     g_free(g_ethers_path);
     g_ethers_path = NULL;
@@ -2368,6 +2375,42 @@ eth_hash_new_entry(const uint8_t *addr, const bool resolve)
     return tp;
 } /* eth_hash_new_entry */
 
+/*
+ * When mac_cache_size is set, eth_hashtable stops growing once it holds
+ * that many addresses, so that captures with huge numbers of randomized
+ * MAC addresses do not grow it without bound. Addresses seen after that
+ * are resolved into a fixed, direct-mapped table whose slots are reused
+ * by later addresses with the same hash. The slots are never freed, so a
+ * name returned for such an address stays valid memory, but it may be
+ * overwritten by a later lookup. Names from the ethers files are always
+ * added to eth_hashtable.
+ */
+#define ETH_OVERFLOW_SLOTS 4096     /* Must be a power of 2 */
+
+static unsigned eth_hashtable_max_entries;
+
+static hashether_t *
+eth_overflow_entry(const uint8_t *addr)
+{
+    hashether_t *tp;
+    char *endp;
+
+    if (eth_overflow_slots == NULL) {
+        eth_overflow_slots = wmem_alloc0_array(addr_resolv_scope, hashether_t, ETH_OVERFLOW_SLOTS);
+    }
+
+    tp = &eth_overflow_slots[eth_addr_hash(addr) & (ETH_OVERFLOW_SLOTS - 1)];
+    if (tp->hexaddr[0] == '\0' || memcmp(tp->addr, addr, sizeof(tp->addr)) != 0) {
+        memcpy(tp->addr, addr, sizeof(tp->addr));
+        tp->flags = 0;
+        endp = bytes_to_hexstr_punct(tp->hexaddr, addr, sizeof(tp->addr), ':');
+        *endp = '\0';
+        tp->resolved_name[0] = '\0';
+    }
+
+    return tp;
+} /* eth_overflow_entry */
+
 static hashether_t *
 add_eth_name(const uint8_t *addr, const char *name, bool static_entry)
 {
@@ -2398,6 +2441,11 @@ eth_name_lookup(const uint8_t *addr, const bool resolve)
 
     tp = (hashether_t *)wmem_map_lookup(eth_hashtable, addr);
 
+    if (tp == NULL && eth_hashtable_max_entries != 0 &&
+            wmem_map_size(eth_hashtable) >= eth_hashtable_max_entries) {
+        tp = eth_overflow_entry(addr);
+    }
+
     if (tp == NULL) {
         tp = eth_hash_new_entry(addr, resolve);
     } else {
@@ -2976,6 +3024,176 @@ add_hosts_file (const char *hosts_file)
     return true;
 }
 
+/*
+ * Resolver cache.
+ *
+ * The names the external resolver returned are kept in a file in the
+ * personal configuration directory, so that the next run, or the next
+ * capture file, doesn't have to ask for them again. Each line is
+ * "<address> <name> <expiry>", the expiry in seconds since the epoch.
+ * c-ares doesn't hand us the TTL of the PTR record, so an entry lives
+ * for resolver_cache_ttl seconds from when it was resolved. Names from
+ * hosts files, capture files and captured DNS packets aren't cached.
+ */
+typedef struct {
+    char   *name;
+    time_t  expiry;
+} resolver_cache_entry_t;
+
+static unsigned resolver_cache_ttl;     /* seconds; 0 disables the cache */
+// Maps printable address -> resolver_cache_entry_t*
+static wmem_map_t *resolver_cache;
+static char *resolver_cache_path;
+static bool resolver_cache_dirty;
+
+static void
+resolver_cache_insert(const char *addr_str, const char *name, time_t expiry)
+{
+    resolver_cache_entry_t *entry;
+
+    entry = (resolver_cache_entry_t *)wmem_map_lookup(resolver_cache, addr_str);
+    if (entry == NULL) {
+        entry = wmem_new(addr_resolv_scope, resolver_cache_entry_t);
+        wmem_map_insert(resolver_cache, wmem_strdup(addr_resolv_scope, addr_str), entry);
+    } else {
+        wmem_free(addr_resolv_scope, entry->name);
+    }
+    entry->name = wmem_strdup(addr_resolv_scope, name);
+    entry->expiry = expiry;
+}
+
+/* Remember a name the external resolver returned. */
+static void
+resolver_cache_add(int family, const void *addrp, const char *name)
+{
+    char addr_str[WS_INET6_ADDRSTRLEN];
+
+    if (resolver_cache == NULL || !name || name[0] == '\0')
+        return;
+
+    switch (family) {
+        case AF_INET:
+            ip_addr_to_str_buf((const ws_in4_addr *)addrp, addr_str, sizeof(addr_str));
+            break;
+        case AF_INET6:
+            ip6_to_str_buf((const ws_in6_addr *)addrp, addr_str, sizeof(addr_str));
+            break;
+        default:
+            return;
+    }
+
+    resolver_cache_insert(addr_str, name, time(NULL) + resolver_cache_ttl);
+    resolver_cache_dirty = true;
+}
+
+static void
+resolver_cache_read(void)
+{
+    FILE *cf;
+    char line[MAX_LINELEN];
+    char *addr_str, *name, *expiry_str;
+    union {
+        uint32_t ip4_addr;
+        ws_in6_addr ip6_addr;
+    } host_addr;
+    int64_t expiry;
+    time_t now = time(NULL);
+
+    if ((cf = ws_fopen(resolver_cache_path, "r")) == NULL)
+        return;
+
+    while (fgetline(line, sizeof(line), cf) >= 0) {
+        if (line[0] == '#')
+            continue;
+
+        if ((addr_str = strtok(line, " \t")) == NULL ||
+            (name = strtok(NULL, " \t")) == NULL ||
+            (expiry_str = strtok(NULL, " \t")) == NULL)
+            continue;
+
+        if (!ws_strtoi64(expiry_str, NULL, &expiry) || expiry <= now)
+            continue;
+        /* Don't keep entries longer than the current lifetime allows. */
+        if (expiry > now + resolver_cache_ttl)
+            expiry = now + resolver_cache_ttl;
+
+        if (ws_inet_pton6(addr_str, &host_addr.ip6_addr)) {
+            add_ipv6_name(&host_addr.ip6_addr, name, false);
+        } else if (ws_inet_pton4(addr_str, &host_addr.ip4_addr)) {
+            add_ipv4_name(host_addr.ip4_addr, name, false);
+        } else {
+            continue;
+        }
+        resolver_cache_insert(addr_str, name, (time_t)expiry);
+    }
+
+    fclose(cf);
+}
+
+typedef struct {
+    FILE   *cf;
+    time_t  now;
+} resolver_cache_write_t;
+
+static void
+resolver_cache_write_entry(void *key, void *value, void *user_data)
+{
+    const resolver_cache_entry_t *entry = (const resolver_cache_entry_t *)value;
+    resolver_cache_write_t *rcw = (resolver_cache_write_t *)user_data;
+
+    if (entry->expiry > rcw->now)
+        fprintf(rcw->cf, "%s\t%s\t%" PRId64 "\n", (const char *)key, entry->name, (int64_t)entry->expiry);
+}
+
+/* Write the cache to a temporary file and move it into place, so that a
+ * concurrent reader sees either the old file or the new one. */
+static void
+resolver_cache_write(void)
+{
+    resolver_cache_write_t rcw;
+    char *tmp_path;
+
+    tmp_path = ws_strdup_printf("%s.tmp", resolver_cache_path);
+    if ((rcw.cf = ws_fopen(tmp_path, "w")) == NULL) {
+        g_free(tmp_path);
+        return;
+    }
+
+    fputs("# Host names returned by the external resolver and when they expire.\n"
+          "# This file is maintained automatically.\n", rcw.cf);
+    rcw.now = time(NULL);
+    wmem_map_foreach(resolver_cache, resolver_cache_write_entry, &rcw);
+
+    if (fclose(rcw.cf) != 0 || ws_rename(tmp_path, resolver_cache_path) != 0) {
+        ws_unlink(tmp_path);
+    }
+    g_free(tmp_path);
+}
+
+void
+host_name_lookup_prefetch(const address *addr)
+{
+    uint32_t ip4_addr;
+
+    if (!gbl_resolv_flags.network_name ||
+        !gbl_resolv_flags.use_external_net_name_resolver ||
+        !async_dns_initialized ||
+        resolve_synchronously || name_resolve_concurrency == 0)
+        return;
+
+    switch (addr->type) {
+        case AT_IPv4:
+            memcpy(&ip4_addr, addr->data, sizeof ip4_addr);
+            host_lookup(ip4_addr);
+            break;
+        case AT_IPv6:
+            host_lookup6((const ws_in6_addr *)addr->data);
+            break;
+        default:
+            break;
+    }
+}
+
 bool
 add_ip_name_from_string (const char *addr, const char *name)
 {
@@ -3681,6 +3899,16 @@ addr_resolve_pref_init(module_t *nameres)
             " or system's Ethers file, or to a manufacturer based name.",
             &gbl_resolv_flags.mac_name);
 
+    prefs_register_uint_preference(nameres, "mac_cache_size",
+            "Maximum cached MAC addresses",
+            "The maximum number of MAC addresses whose names are kept"
+            " for the whole session. Further addresses are resolved"
+            " into a small fixed-size cache, so that memory use stays"
+            " flat on captures with many randomized MAC addresses."
+            " 0 means no limit.",
+            10,
+            &eth_hashtable_max_entries);
+
     prefs_register_bool_preference(nameres, "transport_name",
             "Resolve transport names",
             "Resolve TCP/UDP ports into service names",
@@ -3756,6 +3984,16 @@ addr_resolve_pref_init(module_t *nameres)
             10,
             &name_resolve_concurrency);
 
+    prefs_register_uint_preference(nameres, "resolver_cache_ttl",
+            "Resolver cache lifetime (seconds)",
+            "How long host names returned by your system's"
+            " resolver are kept in the \"resolver_cache\" file of"
+            " the personal configuration directory, so that"
+            " they are not looked up again by later runs."
+            " 0 disables the cache.",
+            10,
+            &resolver_cache_ttl);
+
     prefs_register_obsolete_preference(nameres, "hosts_file_handling");
 
     prefs_register_bool_preference(nameres, "vlan_name",
@@ -4082,6 +4320,16 @@ host_name_lookup_init(const char* app_env_var_prefix)
         }
     }
 
+    /*
+     * Load the names cached from earlier lookups. Hosts file entries
+     * are static, so they take precedence.
+     */
+    if (resolver_cache_ttl > 0 && gbl_resolv_flags.use_external_net_name_resolver) {
+        resolver_cache = wmem_map_new(addr_resolv_scope, g_str_hash, g_str_equal);
+        resolver_cache_path = get_persconffile_path(ENAME_RESOLVER_CACHE, false, app_env_var_prefix);
+        resolver_cache_read();
+    }
+
     subnet_name_lookup_init(app_env_var_prefix);
     subnet6_name_lookup_init(app_env_var_prefix);
 
@@ -4098,6 +4346,14 @@ host_name_lookup_cleanup(void)
 
     _host_name_lookup_cleanup();
 
+    if (resolver_cache != NULL && resolver_cache_dirty) {
+        resolver_cache_write();
+    }
+    resolver_cache = NULL;
+    g_free(resolver_cache_path);
+    resolver_cache_path = NULL;
+    resolver_cache_dirty = false;
+
     ipxnet_hash_table = NULL;
     ipv4_hash_table = NULL;
     ipv6_hash_table = NULL;
@@ -341,6 +341,23 @@ WS_DLL_PUBLIC void disable_name_resolution(void);
  */
 WS_DLL_PUBLIC bool host_name_lookup_process(void);
 
+/**
+ * @brief Start resolving an IPv4 or IPv6 address in the background.
+ *
+ * Queues an asynchronous lookup of an address that hasn't been resolved
+ * or tried yet, so that the name is already known when the address is
+ * displayed. Queued lookups are sent, at most "name_resolve_concurrency"
+ * at a time, by host_name_lookup_process(), and set_resolution_synchrony()
+ * waits for all of them to complete. TShark uses this on the first pass
+ * of two-pass analysis to resolve every address before printing.
+ *
+ * Does nothing for other address types, if external network name
+ * resolution is disabled, or if resolution is synchronous.
+ *
+ * @param addr The address to resolve.
+ */
+WS_DLL_PUBLIC void host_name_lookup_prefetch(const address *addr);
+
 /**
  * @brief Resolve an IPv4 address to its host name.
  *
@@ -66,6 +66,145 @@ static GHashTable *session_disabled_filters;
  */
 static bool tmp_colors_set;
 
+/*
+ * The enabled rules of color_filter_list, compiled into an array that
+ * colorizing walks instead of the list. Each rule carries its paused state
+ * and the fields its filter requires (see dfilter_required_fields()). The
+ * required fields are shared by all rules, so a field that many rules need,
+ * such as "tcp", is looked up at most once per packet, and a rule that needs
+ * an absent field is skipped without running its filter.
+ *
+ * Thrown away whenever the list or the paused filters change and rebuilt
+ * on the next packet.
+ */
+typedef struct {
+    color_filter_t *colorf;
+    bool            session_disabled;
+    unsigned        first_field;    /* index into rule_fields */
+    unsigned        num_fields;
+} color_rule_t;
+
+typedef struct {
+    color_rule_t   *rules;
+    unsigned        num_rules;
+    unsigned       *rule_fields;    /* indexes into fields */
+    int            *fields;         /* distinct required fields */
+    int8_t         *presence;       /* per packet: -1 unknown, 0 absent, 1 present */
+    unsigned        num_fields;
+} color_program_t;
+
+static color_program_t *color_program;
+
+static void color_filters_invalidate(void);
+
+static void
+color_program_free(color_program_t *prog)
+{
+    if (!prog)
+        return;
+
+    g_free(prog->rules);
+    g_free(prog->rule_fields);
+    g_free(prog->fields);
+    g_free(prog->presence);
+    g_free(prog);
+}
+
+/* Drop the compiled rules; the next packet rebuilds them. */
+static void
+color_filters_invalidate(void)
+{
+    color_program_free(color_program);
+    color_program = NULL;
+}
+
+static color_program_t *
+color_program_get(void)
+{
+    color_program_t *prog;
+    GArray         *rule_fields, *fields;
+    GHashTable     *field_index;
+    const int      *required;
+    int             num_required;
+
+    if (color_program)
+        return color_program;
+
+    prog = g_new0(color_program_t, 1);
+    prog->rules = g_new(color_rule_t, g_slist_length(color_filter_list));
+    rule_fields = g_array_new(false, false, sizeof(unsigned));
+    fields = g_array_new(false, false, sizeof(int));
+    field_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    for (GSList *curr = color_filter_list; curr != NULL; curr = g_slist_next(curr)) {
+        color_filter_t *colorf = (color_filter_t *)curr->data;
+        color_rule_t   *rule;
+
+        if (colorf->disabled || colorf->c_colorfilter == NULL)
+            continue;
+
+        rule = &prog->rules[prog->num_rules++];
+        rule->colorf = colorf;
+        rule->session_disabled = color_filter_is_session_disabled(colorf->filter_name);
+        rule->first_field = rule_fields->len;
+
+        required = dfilter_required_fields(colorf->c_colorfilter, &num_required);
+        for (int i = 0; i < num_required; i++) {
+            void    *value;
+            unsigned idx;
+
+            if (g_hash_table_lookup_extended(field_index, GINT_TO_POINTER(required[i]), NULL, &value)) {
+                idx = GPOINTER_TO_UINT(value);
+            } else {
+                idx = fields->len;
+                g_array_append_val(fields, required[i]);
+                g_hash_table_insert(field_index, GINT_TO_POINTER(required[i]), GUINT_TO_POINTER(idx));
+            }
+            g_array_append_val(rule_fields, idx);
+        }
+        rule->num_fields = rule_fields->len - rule->first_field;
+    }
+
+    prog->num_fields = fields->len;
+    prog->fields = (int *)g_array_free(fields, false);
+    prog->rule_fields = (unsigned *)g_array_free(rule_fields, false);
+    prog->presence = g_new(int8_t, prog->num_fields + 1);
+    g_hash_table_destroy(field_index);
+
+    color_program = prog;
+    return prog;
+}
+
+/* Does the tree have any instance of the idx'th required field? */
+static bool
+color_program_field_present(color_program_t *prog, proto_tree *tree, unsigned idx)
+{
+    header_field_info *hfinfo;
+
+    if (prog->presence[idx] < 0) {
+        prog->presence[idx] = 0;
+        /* The same test the filter's own field reads make. */
+        for (hfinfo = proto_registrar_get_nth(prog->fields[idx]); hfinfo; hfinfo = hfinfo->same_name_next) {
+            if (proto_check_for_protocol_or_field(tree, hfinfo->id)) {
+                prog->presence[idx] = 1;
+                break;
+            }
+        }
+    }
+    return prog->presence[idx] > 0;
+}
+
+/* Can the rule's filter match the tree at all? */
+static bool
+color_rule_applicable(color_program_t *prog, const color_rule_t *rule, proto_tree *tree)
+{
+    for (unsigned i = 0; i < rule->num_fields; i++) {
+        if (!color_program_field_present(prog, tree, prog->rule_fields[rule->first_field + i]))
+            return false;
+    }
+    return true;
+}
+
 /* Create a new filter */
 color_filter_t *
 color_filter_new(const char *name,          /* The name of the filter to create */
@@ -197,6 +336,7 @@ color_filters_set_tmp(uint8_t filt_nr, const char *filter, bool disabled, char *
                 g_free(name);
                 return false;
             } else {
+                color_filters_invalidate();
                 g_free(colorf->filter_text);
                 dfilter_free(colorf->c_colorfilter);
                 colorf->filter_text = g_strdup(tmpfilter);
@@ -361,6 +501,7 @@ bool
 color_filters_init(char** err_msg, color_filter_add_cb_func add_cb, const char* app_env_var_prefix)
 {
     /* delete all currently existing filters */
+    color_filters_invalidate();
     color_filter_list_delete(&color_filter_list);
 
     /* now try to construct the filters list */
@@ -379,6 +520,7 @@ color_filters_reload(char** err_msg, color_filter_add_cb_func add_cb, const char
 {
     /* "move" old entries to the deleted list
      * we must keep them until the dissection no longer needs them */
+    color_filters_invalidate();
     color_filter_deleted_list = g_slist_concat(color_filter_deleted_list, color_filter_list);
     color_filter_list = NULL;
 
@@ -389,6 +531,8 @@ color_filters_reload(char** err_msg, color_filter_add_cb_func add_cb, const char
 void
 color_filters_cleanup(void)
 {
+    color_filters_invalidate();
+
     /* delete the previously deleted filters */
     color_filter_list_delete(&color_filter_deleted_list);
 
@@ -482,6 +626,7 @@ color_filters_apply(GSList *tmp_cfl, GSList *edit_cfl, char** err_msg)
 
     /* "move" old entries to the deleted list
      * we must keep them until the dissection no longer needs them */
+    color_filters_invalidate();
     color_filter_deleted_list = g_slist_concat(color_filter_deleted_list, color_filter_list);
     color_filter_list = NULL;
 
@@ -591,22 +736,21 @@ color_filters_use_proto(int proto_id)
 const color_filter_t *
 color_filters_colorize_packet(epan_dissect_t *edt)
 {
-    GSList         *curr;
-    color_filter_t *colorf;
+    color_program_t *prog;
+    color_rule_t    *rule;
 
     /* If we have color filters, "search" for the matching one. */
     if ((edt->tree != NULL) && (color_filters_used())) {
-        curr = color_filter_list;
-
-        while(curr != NULL) {
-            colorf = (color_filter_t *)curr->data;
-            if ( (!colorf->disabled) &&
-                 (colorf->c_colorfilter != NULL) &&
-                 dfilter_apply_edt(colorf->c_colorfilter, edt) &&
-                 !color_filter_is_session_disabled(colorf->filter_name)) {
-                return colorf;
+        prog = color_program_get();
+        memset(prog->presence, -1, prog->num_fields);
+
+        for (unsigned i = 0; i < prog->num_rules; i++) {
+            rule = &prog->rules[i];
+            if ( !rule->session_disabled &&
+                 color_rule_applicable(prog, rule, edt->tree) &&
+                 dfilter_apply_edt(rule->colorf->c_colorfilter, edt)) {
+                return rule->colorf;
             }
-            curr = g_slist_next(curr);
         }
     }
 
@@ -625,13 +769,16 @@ color_filters_colorize_packet_all(epan_dissect_t *edt,
 
     /* If we have color filters, collect ALL matching ones. */
     if ((edt->tree != NULL) && (color_filters_used())) {
-        for (GSList *curr = color_filter_list; curr != NULL; curr = g_slist_next(curr)) {
-            color_filter_t *colorf = (color_filter_t *)curr->data;
-            if ((!colorf->disabled) &&
-                (colorf->c_colorfilter != NULL) &&
+        color_program_t *prog = color_program_get();
+        memset(prog->presence, -1, prog->num_fields);
+
+        for (unsigned i = 0; i < prog->num_rules; i++) {
+            const color_rule_t *rule = &prog->rules[i];
+            color_filter_t *colorf = rule->colorf;
+            if (color_rule_applicable(prog, rule, edt->tree) &&
                 dfilter_apply_edt(colorf->c_colorfilter, edt)) {
 
-                bool is_session_disabled = color_filter_is_session_disabled(colorf->filter_name);
+                bool is_session_disabled = rule->session_disabled;
 
                 /* Add to matches list even if paused (for Frame tree display) */
                 if (matches) {
@@ -666,6 +813,7 @@ color_filter_set_session_disabled(const char *filter_name, bool disabled)
     } else {
         g_hash_table_remove(session_disabled_filters, filter_name);
     }
+    color_filters_invalidate();
 
     /* Auto-save to profile directory after every change */
     color_filter_write_paused(NULL);  /* NULL uses default env prefix */
@@ -686,6 +834,7 @@ color_filter_clear_session_disabled(void)
     if (session_disabled_filters) {
         g_hash_table_remove_all(session_disabled_filters);
     }
+    color_filters_invalidate();
     /* Restore from profile directory after clearing (workaround for rescan) */
     color_filter_read_paused(NULL);
 }
@@ -753,6 +902,7 @@ color_filter_read_paused(const char *app_env_var_prefix)
             g_hash_table_insert(session_disabled_filters, g_strdup(line), GINT_TO_POINTER(1));
         }
     }
+    color_filters_invalidate();
 
     fclose(f);
 }
@@ -765,6 +915,7 @@ color_filter_resume_all(const char *app_env_var_prefix)
     if (session_disabled_filters) {
         g_hash_table_remove_all(session_disabled_filters);
     }
+    color_filters_invalidate();
 
     /* Write empty file to profile directory */
     char *path = get_paused_filters_path(app_env_var_prefix);
@@ -507,36 +507,127 @@ col_append_str_uint(column_info *cinfo, const int col, const char *abbrev, uint3
   col_append_lstr(cinfo, col, sep ? sep : "", abbrev, "=", buf, COL_ADD_LSTR_TERMINATOR);
 }
 
-static inline void
-col_snprint_port(char *buf, size_t buf_siz, port_type typ, uint16_t val)
+void
+col_append_uint(column_info *cinfo, const int col, const char *prefix, uint32_t val, const char *suffix)
+{
+  char buf[16];
+
+  if (!CHECK_COL(cinfo, col))
+    return;
+
+  uint32_to_str_buf(val, buf, sizeof(buf));
+  col_append_lstr(cinfo, col, prefix ? prefix : "", buf, suffix ? suffix : "", COL_ADD_LSTR_TERMINATOR);
+}
+
+void
+col_append_address(column_info *cinfo, const int col, const address *addr, const char *sep)
+{
+  char buf[MAX_ADDR_STR_LEN];
+
+  if (!CHECK_COL(cinfo, col))
+    return;
+
+  address_to_str_buf(addr, buf, sizeof(buf));
+  col_append_lstr(cinfo, col, sep ? sep : "", buf, COL_ADD_LSTR_TERMINATOR);
+}
+
+void
+col_append_val_str(column_info *cinfo, const int col, uint32_t val, const value_string *vs, const char *sep)
+{
+  char buf[16];
+  const char *str;
+
+  if (!CHECK_COL(cinfo, col))
+    return;
+
+  str = try_val_to_str(val, vs);
+  if (str == NULL) {
+    uint32_to_str_buf(val, buf, sizeof(buf));
+    str = buf;
+  }
+  col_append_lstr(cinfo, col, sep ? sep : "", str, COL_ADD_LSTR_TERMINATOR);
+}
+
+void
+col_append_val_str_ext(column_info *cinfo, const int col, uint32_t val, value_string_ext *vse, const char *sep)
+{
+  char buf[16];
+  const char *str;
+
+  if (!CHECK_COL(cinfo, col))
+    return;
+
+  str = try_val_to_str_ext(val, vse);
+  if (str == NULL) {
+    uint32_to_str_buf(val, buf, sizeof(buf));
+    str = buf;
+  }
+  col_append_lstr(cinfo, col, sep ? sep : "", str, COL_ADD_LSTR_TERMINATOR);
+}
+
+void
+col_add_val_str_ext(column_info *cinfo, const int col, uint32_t val, value_string_ext *vse)
 {
+  char buf[16];
   const char *str;
 
-  if (gbl_resolv_flags.transport_name &&
-        (str = try_serv_name_lookup(typ, val)) != NULL) {
-    snprintf(buf, buf_siz, "%s(%"PRIu16")", str, val);
+  if (!CHECK_COL(cinfo, col))
+    return;
+
+  str = try_val_to_str_ext(val, vse);
+  if (str != NULL) {
+    /* Value strings are static, so there's no need to copy them. */
+    col_set_str(cinfo, col, str);
   } else {
-    snprintf(buf, buf_siz, "%"PRIu16, val);
+    uint32_to_str_buf(val, buf, sizeof(buf));
+    col_add_str(cinfo, col, buf);
   }
 }
 
 void
 col_append_ports(column_info *cinfo, const int col, port_type typ, uint16_t src, uint16_t dst)
 {
-  char buf_src[32], buf_dst[32];
+  char buf_src[8], buf_dst[8];
+  const char *name_src = NULL, *name_dst = NULL;
 
   if (!CHECK_COL(cinfo, col))
     return;
 
-  col_snprint_port(buf_src, 32, typ, src);
-  col_snprint_port(buf_dst, 32, typ, dst);
-  col_append_lstr(cinfo, col, buf_src, " " UTF8_RIGHTWARDS_ARROW " ", buf_dst, COL_ADD_LSTR_TERMINATOR);
+  if (gbl_resolv_flags.transport_name) {
+    name_src = try_serv_name_lookup(typ, src);
+    name_dst = try_serv_name_lookup(typ, dst);
+  }
+  uint32_to_str_buf(src, buf_src, sizeof(buf_src));
+  uint32_to_str_buf(dst, buf_dst, sizeof(buf_dst));
+
+  /* "name(port)" if the port has a name, otherwise just "port". */
+  col_append_lstr(cinfo, col,
+                  name_src ? name_src : "", name_src ? "(" : "", buf_src, name_src ? ")" : "",
+                  " " UTF8_RIGHTWARDS_ARROW " ",
+                  name_dst ? name_dst : "", name_dst ? "(" : "", buf_dst, name_dst ? ")" : "",
+                  COL_ADD_LSTR_TERMINATOR);
 }
 
 void
 col_append_frame_number(packet_info *pinfo, const int col, const char *fmt_str, unsigned frame_num)
 {
-  col_append_fstr(pinfo->cinfo, col, fmt_str, frame_num);
+  const char *conv = strstr(fmt_str, "%u");
+  size_t prefix_len;
+  char prefix[64];
+
+  /*
+   * Nearly all callers pass a format with a single "%u" and text around
+   * it, which doesn't need printf.
+   */
+  prefix_len = conv ? (size_t)(conv - fmt_str) : 0;
+  if (conv && prefix_len < sizeof(prefix) &&
+      memchr(fmt_str, '%', prefix_len) == NULL && strchr(conv + 2, '%') == NULL) {
+    memcpy(prefix, fmt_str, prefix_len);
+    prefix[prefix_len] = '\0';
+    col_append_uint(pinfo->cinfo, col, prefix, frame_num, conv + 2);
+  } else {
+    col_append_fstr(pinfo->cinfo, col, fmt_str, frame_num);
+  }
   if (!pinfo->fd->visited) {
     col_data_changed_ = true;
   }
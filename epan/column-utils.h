@@ -12,6 +12,8 @@
 #include "packet_info.h"
 #include "ws_symbol_export.h"
 
+#include <wsutil/value_string.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -243,6 +245,72 @@ WS_DLL_PUBLIC void col_append_str(column_info *cinfo, const int col, const char
  */
 WS_DLL_PUBLIC void col_append_str_uint(column_info *cinfo, const int col, const char *abbrev, uint32_t val, const char *sep);
 
+/**
+ * @brief Append an unsigned integer in decimal to a column element,
+ * with optional text before and after it, the text will be copied.
+ *
+ * Same result as col_append_fstr(cinfo, col, "%s%u%s", prefix, val, suffix),
+ * without formatting.
+ *
+ * @param cinfo the current packet row
+ * @param col the column to use, e.g. COL_INFO
+ * @param prefix text to append before the value, or NULL
+ * @param val the value to append
+ * @param suffix text to append after the value, or NULL
+ */
+WS_DLL_PUBLIC void col_append_uint(column_info *cinfo, const int col, const char *prefix, uint32_t val, const char *suffix);
+
+/**
+ * @brief Append an address to a column element, the text will be copied.
+ *
+ * The address is not resolved.
+ *
+ * @param cinfo the current packet row
+ * @param col the column to use, e.g. COL_INFO
+ * @param addr the address to append
+ * @param sep an optional separator to _prepend_ to the address
+ */
+WS_DLL_PUBLIC void col_append_address(column_info *cinfo, const int col, const address *addr, const char *sep);
+
+/**
+ * @brief Append the string for a value to a column element, the text will be copied.
+ *
+ * If the value isn't in the value_string, it is appended in decimal.
+ *
+ * @param cinfo the current packet row
+ * @param col the column to use, e.g. COL_INFO
+ * @param val the value to look up
+ * @param vs the value_string to look it up in
+ * @param sep an optional separator to _prepend_ to the string
+ */
+WS_DLL_PUBLIC void col_append_val_str(column_info *cinfo, const int col, uint32_t val, const value_string *vs, const char *sep);
+
+/**
+ * @brief Append the string for a value to a column element, the text will be copied.
+ *
+ * Same as col_append_val_str() for an extended value_string.
+ *
+ * @param cinfo the current packet row
+ * @param col the column to use, e.g. COL_INFO
+ * @param val the value to look up
+ * @param vse the extended value_string to look it up in
+ * @param sep an optional separator to _prepend_ to the string
+ */
+WS_DLL_PUBLIC void col_append_val_str_ext(column_info *cinfo, const int col, uint32_t val, value_string_ext *vse, const char *sep);
+
+/**
+ * @brief Set the text of a column element to the string for a value.
+ *
+ * The string from the value_string is not copied. If the value isn't in the
+ * value_string, the column is set to the value in decimal.
+ *
+ * @param cinfo the current packet row
+ * @param col the column to use, e.g. COL_DSCP_VALUE
+ * @param val the value to look up
+ * @param vse the extended value_string to look it up in
+ */
+WS_DLL_PUBLIC void col_add_val_str_ext(column_info *cinfo, const int col, uint32_t val, value_string_ext *vse);
+
 /**
  * @brief Append a transport port pair to a column element, the text will be copied.
  *
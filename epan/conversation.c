@@ -18,6 +18,7 @@
 #include <wsutil/array.h>
 
 #include <epan/packet.h>
+#include <epan/prefs.h>
 #include "to_str.h"
 #include "conversation.h"
 
@@ -193,6 +194,34 @@ static wmem_map_t *conversation_hashtable_err_pkts = NULL;
 
 static uint32_t new_index;
 
+/*
+ * Retiring idle conversations in single-pass dissection.
+ *
+ * conversation_expire_idle() records a checkpoint of the capture time and
+ * frame number every quarter of the idle timeout. A conversation whose
+ * last frame is before the frame of a checkpoint that is at least the
+ * idle timeout old hasn't been looked up for that long, and is retired.
+ */
+#define CONVERSATION_EXPIRY_CHECKPOINTS 8
+
+typedef struct {
+    time_t secs;
+    uint32_t frame;
+} conversation_checkpoint_t;
+
+static bool conversation_expiry_allowed;
+static bool conversation_expiry_active;
+static conversation_checkpoint_t conversation_checkpoints[CONVERSATION_EXPIRY_CHECKPOINTS];
+static unsigned conversation_checkpoint_count;
+static unsigned conversation_checkpoint_next;
+static uint64_t conversations_retired;
+static uint64_t conversations_retired_data;
+
+/*
+ * Retire routines, keyed by protocol ID.
+ */
+static wmem_map_t *conversation_retire_routines;
+
 /*
  * Placeholder for address-less conversations.
  */
@@ -580,6 +609,7 @@ conversation_init(void)
      * above.
      */
     conversation_hashtable_element_list = wmem_map_new(wmem_epan_scope(), wmem_str_hash, g_str_equal);
+    conversation_retire_routines = wmem_map_new(wmem_epan_scope(), g_direct_hash, g_direct_equal);
 
     conversation_element_t exact_elements[EXACT_IDX_COUNT] = {
         { CE_ADDRESS, .addr_val = ADDRESS_INIT_NONE },
@@ -787,6 +817,12 @@ conversation_epan_reset(void)
      * Start the conversation indices over at 0.
      */
     new_index = 0;
+
+    conversation_expiry_active = false;
+    conversation_checkpoint_count = 0;
+    conversation_checkpoint_next = 0;
+    conversations_retired = 0;
+    conversations_retired_data = 0;
 }
 
 /*
@@ -869,7 +905,9 @@ conversation_remove_from_hashtable(wmem_map_t *hashtable, conversation_t *conv)
             wmem_map_steal(hashtable, conv->key_ptr);
         }
         else {
-            /* Update the head of the chain */
+            /* Update the head of the chain. Re-key the entry as well,
+             * as wmem_map_insert() would keep the key of the retired
+             * head. */
             chain_head = conv->next;
             chain_head->last = conv->last;
 
@@ -878,6 +916,7 @@ conversation_remove_from_hashtable(wmem_map_t *hashtable, conversation_t *conv)
             else
                 chain_head->latest_found = conv->latest_found;
 
+            wmem_map_steal(hashtable, conv->key_ptr);
             wmem_map_insert(hashtable, chain_head->key_ptr, chain_head);
         }
     }
@@ -919,6 +958,7 @@ conversation_t *conversation_new_full(const uint32_t setup_frame, conversation_e
                 conversation_match_element_list);
         wmem_map_insert(conversation_hashtable_element_list, wmem_strdup(wmem_epan_scope(), el_list_map_key), el_list_map);
     }
+    wmem_free(wmem_epan_scope(), el_list_map_key);
 
     size_t element_count = conversation_element_count(elements);
     conversation_element_t *conv_key = wmem_memdup(wmem_file_scope(), elements, sizeof(conversation_element_t) * element_count);
@@ -1571,8 +1611,12 @@ static conversation_t *conversation_lookup_hashtable(wmem_map_t *conversation_ha
     if (chain_head && (chain_head->setup_frame <= frame_num)) {
         match = chain_head;
 
-        if (chain_head->last && (chain_head->last->setup_frame <= frame_num))
-            return chain_head->last;
+        if (chain_head->last && (chain_head->last->setup_frame <= frame_num)) {
+            match = chain_head->last;
+            if (conversation_expiry_active && frame_num > match->last_frame)
+                match->last_frame = frame_num;
+            return match;
+        }
 
         if (chain_head->latest_found && (chain_head->latest_found->setup_frame <= frame_num))
             match = chain_head->latest_found;
@@ -1586,6 +1630,10 @@ static conversation_t *conversation_lookup_hashtable(wmem_map_t *conversation_ha
 
     if (match) {
         chain_head->latest_found = match;
+        /* find_conversation_pinfo() does this for most lookups, but
+         * retiring idle conversations needs it for every lookup. */
+        if (conversation_expiry_active && frame_num > match->last_frame)
+            match->last_frame = frame_num;
     }
 
     return match;
@@ -2761,6 +2809,132 @@ conversation_delete_proto_data(conversation_t *conv, const int proto)
         wmem_tree_remove32(conv->data_list, proto);
 }
 
+void
+conversation_register_retire_routine(const int proto, conversation_retire_func func)
+{
+    wmem_map_insert(conversation_retire_routines, GINT_TO_POINTER(proto), (void *)func);
+}
+
+void
+conversation_set_expiry_allowed(bool allowed)
+{
+    conversation_expiry_allowed = allowed;
+}
+
+void
+conversation_get_stats(conversation_stats_t *stats)
+{
+    stats->created = new_index;
+    stats->retired = conversations_retired;
+    stats->retired_data = conversations_retired_data;
+}
+
+static bool
+conversation_retire_proto_data(const void *key, void *value, void *userdata)
+{
+    conversation_t *conv = (conversation_t *)userdata;
+    conversation_retire_func func;
+
+    func = (conversation_retire_func)wmem_map_lookup(conversation_retire_routines, key);
+    if (func)
+        func(conv, value);
+    conversations_retired_data++;
+    return false;
+}
+
+typedef struct {
+    uint32_t cutoff_frame;
+    GPtrArray *idle;
+} conversation_sweep_t;
+
+static void
+conversation_collect_idle(void *key _U_, void *value, void *user_data)
+{
+    conversation_sweep_t *sweep = (conversation_sweep_t *)user_data;
+    conversation_t *conv;
+
+    for (conv = (conversation_t *)value; conv; conv = conv->next) {
+        if (conv->last_frame < sweep->cutoff_frame && !(conv->options & CONVERSATION_TEMPLATE))
+            g_ptr_array_add(sweep->idle, conv);
+    }
+}
+
+static void
+conversation_sweep_hashtable(void *key _U_, void *value, void *user_data)
+{
+    wmem_map_t *hashtable = (wmem_map_t *)value;
+    conversation_sweep_t *sweep = (conversation_sweep_t *)user_data;
+    unsigned i;
+
+    g_ptr_array_set_size(sweep->idle, 0);
+    wmem_map_foreach(hashtable, conversation_collect_idle, sweep);
+
+    for (i = 0; i < sweep->idle->len; i++) {
+        conversation_t *conv = (conversation_t *)g_ptr_array_index(sweep->idle, i);
+
+        if (conv->data_list) {
+            wmem_tree_foreach(conv->data_list, conversation_retire_proto_data, conv);
+            wmem_tree_destroy(conv->data_list, false, false);
+            conv->data_list = NULL;
+        }
+        /*
+         * The conversation itself and its key stay allocated until
+         * the file is closed, as per-packet data and other
+         * conversations' proto data may still point to them, and
+         * some dissectors key their own tables on the pointer.
+         */
+        conversation_remove_from_hashtable(hashtable, conv);
+        conversations_retired++;
+    }
+}
+
+void
+conversation_expire_idle(const packet_info *pinfo)
+{
+    conversation_sweep_t sweep;
+    unsigned interval;
+    unsigned i;
+    time_t now;
+
+    conversation_expiry_active = conversation_expiry_allowed && prefs.conversation_idle_timeout > 0;
+    if (!conversation_expiry_active || !(pinfo->presence_flags & PINFO_HAS_TS))
+        return;
+
+    now = pinfo->abs_ts.secs;
+    interval = MAX(prefs.conversation_idle_timeout / 4, 1);
+    if (conversation_checkpoint_count > 0) {
+        unsigned latest = (conversation_checkpoint_next + CONVERSATION_EXPIRY_CHECKPOINTS - 1) % CONVERSATION_EXPIRY_CHECKPOINTS;
+
+        /* Also does nothing if time went backwards. */
+        if (now < conversation_checkpoints[latest].secs + (time_t)interval)
+            return;
+    }
+
+    conversation_checkpoints[conversation_checkpoint_next].secs = now;
+    conversation_checkpoints[conversation_checkpoint_next].frame = pinfo->num;
+    conversation_checkpoint_next = (conversation_checkpoint_next + 1) % CONVERSATION_EXPIRY_CHECKPOINTS;
+    if (conversation_checkpoint_count < CONVERSATION_EXPIRY_CHECKPOINTS)
+        conversation_checkpoint_count++;
+
+    /* Find the newest checkpoint that is at least the timeout old. */
+    sweep.cutoff_frame = 0;
+    for (i = 1; i <= conversation_checkpoint_count; i++) {
+        const conversation_checkpoint_t *checkpoint =
+            &conversation_checkpoints[(conversation_checkpoint_next + CONVERSATION_EXPIRY_CHECKPOINTS - i) % CONVERSATION_EXPIRY_CHECKPOINTS];
+
+        if (checkpoint->secs + (time_t)prefs.conversation_idle_timeout <= now) {
+            sweep.cutoff_frame = checkpoint->frame;
+            break;
+        }
+    }
+    if (sweep.cutoff_frame == 0)
+        return;
+
+    sweep.idle = g_ptr_array_new();
+    wmem_map_foreach(conversation_hashtable_element_list, conversation_sweep_hashtable, &sweep);
+    g_ptr_array_free(sweep.idle, TRUE);
+}
+
 void
 conversation_set_dissector_from_frame_number(conversation_t *conversation,
         const uint32_t starting_frame_num, const dissector_handle_t handle)
@@ -376,6 +376,17 @@ extern void conversation_init(void);
  */
 extern void conversation_epan_reset(void);
 
+/**
+ * @brief Retire conversations that have been idle for too long.
+ *
+ * Called for each frame on the first pass. Does nothing unless the
+ * application allowed it with conversation_set_expiry_allowed() and the
+ * "conversation_idle_timeout" protocol preference is set.
+ *
+ * @param pinfo Packet info of the frame about to be dissected.
+ */
+extern void conversation_expire_idle(const packet_info *pinfo);
+
 /**
  * @brief Create a new conversation identified by a list of elements.
  * @param setup_frame The first frame in the conversation.
@@ -892,6 +903,67 @@ WS_DLL_PUBLIC void conversation_set_port2(conversation_t *conv, const uint32_t p
  */
 WS_DLL_PUBLIC void conversation_set_addr2(conversation_t *conv, const address *addr);
 
+/**
+ * @brief Called for each item of proto data of a conversation that is retired.
+ *
+ * @param conv The conversation being retired.
+ * @param proto_data The data the protocol added with conversation_add_proto_data().
+ */
+typedef void (*conversation_retire_func)(conversation_t *conv, void *proto_data);
+
+/**
+ * @brief Register a routine that is called when a conversation with
+ * proto data for a protocol is retired.
+ *
+ * Conversations are only retired in single-pass dissection, when the
+ * "conversation_idle_timeout" protocol preference is set and no frame
+ * referred to the conversation for that long. A retired conversation is
+ * removed from the conversation tables, so a later frame with the same
+ * endpoints gets a new conversation, and its proto data is dropped.
+ * The routine should flush anything it reports at the end of a
+ * conversation and free the proto data. Proto data of protocols without
+ * a routine stays allocated until the file is closed; only TCP, TLS,
+ * HTTP and DNS register one so far.
+ *
+ * The conversation_t itself and its key stay allocated, as other state
+ * may still point to them or use the pointer as a key. Nothing may keep
+ * a pointer to proto data freed by the routine past the packet that
+ * looked it up.
+ *
+ * @param proto Protocol ID.
+ * @param func The routine.
+ */
+WS_DLL_PUBLIC void conversation_register_retire_routine(const int proto, conversation_retire_func func);
+
+/**
+ * @brief Allow idle conversations to be retired.
+ *
+ * Retiring conversations loses state that a later pass would need, so
+ * this is only for applications that dissect each frame once, such as
+ * TShark without two-pass analysis.
+ *
+ * @param allowed true if frames are dissected only once.
+ */
+WS_DLL_PUBLIC void conversation_set_expiry_allowed(bool allowed);
+
+/**
+ * @brief Counts of conversations since the capture file was opened.
+ */
+typedef struct {
+    uint64_t created;       /**< Conversations created. */
+    uint64_t retired;       /**< Conversations retired because they were idle. */
+    uint64_t retired_data;  /**< Items of proto data dropped along with them. */
+} conversation_stats_t;
+
+/**
+ * @brief Get the conversation counts.
+ *
+ * The number of live conversations is created - retired.
+ *
+ * @param stats Filled in with the counts.
+ */
+WS_DLL_PUBLIC void conversation_get_stats(conversation_stats_t *stats);
+
 /**
  * @brief Get a hash table of conversation hash table.
  *
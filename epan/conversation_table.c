@@ -634,6 +634,75 @@ add_conversation_table_data(conv_hash_t *ch, const address *src, const address *
     add_conversation_table_data_with_conv_id(ch, src, dst, src_port, dst_port, CONV_ID_UNSET, num_frames, num_bytes, ts, abs_ts, ct_info, ctype);
 }
 
+/* Find a conversation in either direction. */
+static conv_item_t *
+conversation_table_lookup(conv_hash_t *ch, const address *src, const address *dst,
+        uint32_t src_port, uint32_t dst_port, conv_id_t conv_id, bool *is_fwd_direction)
+{
+    conv_key_t existing_key;
+    void *conversation_idx_hash_val;
+
+    /* first, check in the fwd conversations */
+    existing_key.addr1 = *src;
+    existing_key.addr2 = *dst;
+    existing_key.port1 = src_port;
+    existing_key.port2 = dst_port;
+    existing_key.conv_id = conv_id;
+    if (g_hash_table_lookup_extended(ch->hashtable, &existing_key, NULL, &conversation_idx_hash_val)) {
+        *is_fwd_direction = true;
+        return &g_array_index(ch->conv_array, conv_item_t, GPOINTER_TO_UINT(conversation_idx_hash_val));
+    }
+
+    /* then, check in the rev conversations if not found in 'fwd' */
+    existing_key.addr1 = *dst;
+    existing_key.addr2 = *src;
+    existing_key.port1 = dst_port;
+    existing_key.port2 = src_port;
+    if (g_hash_table_lookup_extended(ch->hashtable, &existing_key, NULL, &conversation_idx_hash_val)) {
+        *is_fwd_direction = false;
+        return &g_array_index(ch->conv_array, conv_item_t, GPOINTER_TO_UINT(conversation_idx_hash_val));
+    }
+
+    return NULL;
+}
+
+/* Append a copy of conv_item, with its own copies of the addresses. */
+static conv_item_t *
+conversation_table_append(conv_hash_t *ch, const conv_item_t *conv_item)
+{
+    conv_key_t *new_key;
+    conv_item_t new_conv_item = *conv_item;
+    unsigned int conversation_idx;
+
+    copy_address(&new_conv_item.src_address, &conv_item->src_address);
+    copy_address(&new_conv_item.dst_address, &conv_item->dst_address);
+    g_array_append_val(ch->conv_array, new_conv_item);
+    conversation_idx = ch->conv_array->len - 1;
+    conv_item_t *item = &g_array_index(ch->conv_array, conv_item_t, conversation_idx);
+
+    /* ct->conversations address is not a constant but src/dst_address.data are */
+    new_key = g_new(conv_key_t, 1);
+    set_address(&new_key->addr1, item->src_address.type, item->src_address.len, item->src_address.data);
+    set_address(&new_key->addr2, item->dst_address.type, item->dst_address.len, item->dst_address.data);
+    new_key->port1 = item->src_port;
+    new_key->port2 = item->dst_port;
+    new_key->conv_id = item->conv_id;
+    g_hash_table_insert(ch->hashtable, new_key, GUINT_TO_POINTER(conversation_idx));
+
+    return item;
+}
+
+static void
+conversation_table_init_data(conv_hash_t *ch)
+{
+    ch->conv_array = g_array_sized_new(false, false, sizeof(conv_item_t), 10000);
+
+    ch->hashtable = g_hash_table_new_full(conversation_hash,
+                                          conversation_equal, /* key_equal_func */
+                                          g_free,             /* key_destroy_func */
+                                          NULL);              /* value_destroy_func */
+}
+
 conv_item_t *
 add_conversation_table_data_with_conv_id(
     conv_hash_t *ch,
@@ -654,50 +723,18 @@ add_conversation_table_data_with_conv_id(
 
     /* if we don't have any entries at all yet */
     if (ch->conv_array == NULL) {
-        ch->conv_array = g_array_sized_new(false, false, sizeof(conv_item_t), 10000);
-
-        ch->hashtable = g_hash_table_new_full(conversation_hash,
-                                              conversation_equal, /* key_equal_func */
-                                              g_free,             /* key_destroy_func */
-                                              NULL);              /* value_destroy_func */
-
+        conversation_table_init_data(ch);
     } else { /* try to find it among the existing known conversations */
-        /* first, check in the fwd conversations */
-        conv_key_t existing_key;
-        void *conversation_idx_hash_val;
-
-        existing_key.addr1 = *src;
-        existing_key.addr2 = *dst;
-        existing_key.port1 = src_port;
-        existing_key.port2 = dst_port;
-        existing_key.conv_id = conv_id;
-        if (g_hash_table_lookup_extended(ch->hashtable, &existing_key, NULL, &conversation_idx_hash_val)) {
-            conv_item = &g_array_index(ch->conv_array, conv_item_t, GPOINTER_TO_UINT(conversation_idx_hash_val));
-        }
-        if (conv_item == NULL) {
-            /* then, check in the rev conversations if not found in 'fwd' */
-            existing_key.addr1 = *dst;
-            existing_key.addr2 = *src;
-            existing_key.port1 = dst_port;
-            existing_key.port2 = src_port;
-            if (g_hash_table_lookup_extended(ch->hashtable, &existing_key, NULL, &conversation_idx_hash_val)) {
-                conv_item = &g_array_index(ch->conv_array, conv_item_t, GPOINTER_TO_UINT(conversation_idx_hash_val));
-            }
-        } else {
-            /* a conversation was found in this same fwd direction */
-            is_fwd_direction = true;
-        }
+        conv_item = conversation_table_lookup(ch, src, dst, src_port, dst_port, conv_id, &is_fwd_direction);
     }
 
     /* if we still don't know what conversation this is it has to be a new one
        and we have to allocate it and append it to the end of the list */
     if (conv_item == NULL) {
-        conv_key_t *new_key;
         conv_item_t new_conv_item;
-        unsigned int conversation_idx;
 
-        copy_address(&new_conv_item.src_address, src);
-        copy_address(&new_conv_item.dst_address, dst);
+        copy_address_shallow(&new_conv_item.src_address, src);
+        copy_address_shallow(&new_conv_item.dst_address, dst);
         new_conv_item.dissector_info = ct_info;
         new_conv_item.ctype = ctype;
         new_conv_item.src_port = src_port;
@@ -721,18 +758,8 @@ add_conversation_table_data_with_conv_id(
             nstime_set_unset(&new_conv_item.start_time);
             nstime_set_unset(&new_conv_item.stop_time);
         }
-        g_array_append_val(ch->conv_array, new_conv_item);
-        conversation_idx = ch->conv_array->len - 1;
-        conv_item = &g_array_index(ch->conv_array, conv_item_t, conversation_idx);
-
-        /* ct->conversations address is not a constant but src/dst_address.data are */
-        new_key = g_new(conv_key_t, 1);
-        set_address(&new_key->addr1, conv_item->src_address.type, conv_item->src_address.len, conv_item->src_address.data);
-        set_address(&new_key->addr2, conv_item->dst_address.type, conv_item->dst_address.len, conv_item->dst_address.data);
-        new_key->port1 = src_port;
-        new_key->port2 = dst_port;
-        new_key->conv_id = conv_id;
-        g_hash_table_insert(ch->hashtable, new_key, GUINT_TO_POINTER(conversation_idx));
+        new_conv_item.ext_tcp.flows = 0;
+        conv_item = conversation_table_append(ch, &new_conv_item);
 
         /* update the conversation struct */
         conv_item->tx_frames_total += num_frames;
@@ -916,6 +943,53 @@ endpoint_match(const void *v, const void *w)
     return 0;
 }
 
+static endpoint_item_t *
+endpoint_table_lookup(conv_hash_t *ch, const address *addr, uint32_t port)
+{
+    endpoint_key_t existing_key;
+    void *endpoint_idx_hash_val;
+
+    copy_address_shallow(&existing_key.myaddress, addr);
+    existing_key.port = port;
+
+    if (g_hash_table_lookup_extended(ch->hashtable, &existing_key, NULL, &endpoint_idx_hash_val)) {
+        return &g_array_index(ch->conv_array, endpoint_item_t, GPOINTER_TO_UINT(endpoint_idx_hash_val));
+    }
+    return NULL;
+}
+
+/* Append a copy of endpoint_item, with its own copy of the address. */
+static endpoint_item_t *
+endpoint_table_append(conv_hash_t *ch, const endpoint_item_t *endpoint_item)
+{
+    endpoint_key_t *new_key;
+    endpoint_item_t new_endpoint_item = *endpoint_item;
+    unsigned int endpoint_idx;
+
+    copy_address(&new_endpoint_item.myaddress, &endpoint_item->myaddress);
+    g_array_append_val(ch->conv_array, new_endpoint_item);
+    endpoint_idx = ch->conv_array->len - 1;
+    endpoint_item_t *item = &g_array_index(ch->conv_array, endpoint_item_t, endpoint_idx);
+
+    /* hl->hosts address is not a constant but address.data is */
+    new_key = g_new(endpoint_key_t,1);
+    set_address(&new_key->myaddress, item->myaddress.type, item->myaddress.len, item->myaddress.data);
+    new_key->port = item->port;
+    g_hash_table_insert(ch->hashtable, new_key, GUINT_TO_POINTER(endpoint_idx));
+
+    return item;
+}
+
+static void
+endpoint_table_init_data(conv_hash_t *ch)
+{
+    ch->conv_array=g_array_sized_new(false, false, sizeof(endpoint_item_t), 10000);
+    ch->hashtable = g_hash_table_new_full(endpoint_hash,
+                                          endpoint_match, /* key_equal_func */
+                                          g_free,     /* key_destroy_func */
+                                          NULL);      /* value_destroy_func */
+}
+
 void
 add_endpoint_table_data(conv_hash_t *ch, const address *addr, uint32_t port, bool sender, int num_frames, int num_bytes, et_dissector_info_t *et_info, endpoint_type etype)
 {
@@ -925,33 +999,19 @@ add_endpoint_table_data(conv_hash_t *ch, const address *addr, uint32_t port, boo
        instead of just one */
     /* if we don't have any entries at all yet */
     if(ch->conv_array==NULL){
-        ch->conv_array=g_array_sized_new(false, false, sizeof(endpoint_item_t), 10000);
-        ch->hashtable = g_hash_table_new_full(endpoint_hash,
-                                              endpoint_match, /* key_equal_func */
-                                              g_free,     /* key_destroy_func */
-                                              NULL);      /* value_destroy_func */
+        endpoint_table_init_data(ch);
     }
     else {
         /* try to find it among the existing known conversations */
-        endpoint_key_t existing_key;
-        void *endpoint_idx_hash_val;
-
-        copy_address_shallow(&existing_key.myaddress, addr);
-        existing_key.port = port;
-
-        if (g_hash_table_lookup_extended(ch->hashtable, &existing_key, NULL, &endpoint_idx_hash_val)) {
-            endpoint_item = &g_array_index(ch->conv_array, endpoint_item_t, GPOINTER_TO_UINT(endpoint_idx_hash_val));
-        }
+        endpoint_item = endpoint_table_lookup(ch, addr, port);
     }
 
     /* if we still don't know what endpoint this is it has to be a new one
        and we have to allocate it and append it to the end of the list */
     if(endpoint_item==NULL){
-        endpoint_key_t *new_key;
         endpoint_item_t new_endpoint_item;
-        unsigned int endpoint_idx;
 
-        copy_address(&new_endpoint_item.myaddress, addr);
+        copy_address_shallow(&new_endpoint_item.myaddress, addr);
         new_endpoint_item.dissector_info = et_info;
         new_endpoint_item.etype=etype;
         new_endpoint_item.port=port;
@@ -966,15 +1026,7 @@ add_endpoint_table_data(conv_hash_t *ch, const address *addr, uint32_t port, boo
         new_endpoint_item.modified = true;
         new_endpoint_item.filtered = true;
 
-        g_array_append_val(ch->conv_array, new_endpoint_item);
-        endpoint_idx = ch->conv_array->len - 1;
-        endpoint_item = &g_array_index(ch->conv_array, endpoint_item_t, endpoint_idx);
-
-        /* hl->hosts address is not a constant but address.data is */
-        new_key = g_new(endpoint_key_t,1);
-        set_address(&new_key->myaddress, endpoint_item->myaddress.type, endpoint_item->myaddress.len, endpoint_item->myaddress.data);
-        new_key->port = port;
-        g_hash_table_insert(ch->hashtable, new_key, GUINT_TO_POINTER(endpoint_idx));
+        endpoint_item = endpoint_table_append(ch, &new_endpoint_item);
     }
 
     /* if this is a new endpoint we need to initialize the struct */
@@ -1043,6 +1095,136 @@ add_endpoint_table_data_ipv4_subnet(
     }
 }
 
+/*
+ * Worker callbacks for the conversation and endpoint taps; see
+ * set_tap_worker_callbacks(). A worker collects into its own table,
+ * which is added to the listener's table with the same rules as the
+ * packets themselves.
+ */
+void *
+conversation_table_worker_new(void *tapdata)
+{
+    const conv_hash_t *ch = (const conv_hash_t *)tapdata;
+    conv_hash_t *worker = g_new0(conv_hash_t, 1);
+
+    worker->flags = ch->flags;
+    worker->user_data = ch->user_data;
+    return worker;
+}
+
+void
+conversation_table_worker_merge(void *tapdata, void *worker_data)
+{
+    conv_hash_t *ch = (conv_hash_t *)tapdata;
+    const conv_hash_t *worker = (const conv_hash_t *)worker_data;
+
+    if (worker->conv_array == NULL) {
+        return;
+    }
+    if (ch->conv_array == NULL) {
+        conversation_table_init_data(ch);
+    }
+
+    for (unsigned i = 0; i < worker->conv_array->len; i++) {
+        const conv_item_t *src = &g_array_index(worker->conv_array, conv_item_t, i);
+        bool is_fwd_direction = false;
+        conv_item_t *dst = conversation_table_lookup(ch, &src->src_address, &src->dst_address,
+                src->src_port, src->dst_port, src->conv_id, &is_fwd_direction);
+
+        if (dst == NULL) {
+            conversation_table_append(ch, src);
+            continue;
+        }
+
+        if (is_fwd_direction) {
+            dst->tx_frames += src->tx_frames;
+            dst->rx_frames += src->rx_frames;
+            dst->tx_bytes += src->tx_bytes;
+            dst->rx_bytes += src->rx_bytes;
+            dst->tx_frames_total += src->tx_frames_total;
+            dst->rx_frames_total += src->rx_frames_total;
+            dst->tx_bytes_total += src->tx_bytes_total;
+            dst->rx_bytes_total += src->rx_bytes_total;
+        } else {
+            dst->tx_frames += src->rx_frames;
+            dst->rx_frames += src->tx_frames;
+            dst->tx_bytes += src->rx_bytes;
+            dst->rx_bytes += src->tx_bytes;
+            dst->tx_frames_total += src->rx_frames_total;
+            dst->rx_frames_total += src->tx_frames_total;
+            dst->tx_bytes_total += src->rx_bytes_total;
+            dst->rx_bytes_total += src->tx_bytes_total;
+        }
+        dst->filtered = dst->filtered && src->filtered;
+
+        if (!nstime_is_unset(&src->start_time)) {
+            if (nstime_is_unset(&dst->start_time) || nstime_cmp(&src->start_time, &dst->start_time) < 0) {
+                dst->start_time = src->start_time;
+                dst->start_abs_time = src->start_abs_time;
+            }
+            if (nstime_is_unset(&dst->stop_time) || nstime_cmp(&src->stop_time, &dst->stop_time) > 0) {
+                dst->stop_time = src->stop_time;
+            }
+        }
+        dst->ext_tcp.flows = MAX(dst->ext_tcp.flows, src->ext_tcp.flows);
+    }
+}
+
+void
+conversation_table_worker_free(void *worker_data)
+{
+    reset_conversation_table_data((conv_hash_t *)worker_data);
+    g_free(worker_data);
+}
+
+void *
+endpoint_table_worker_new(void *tapdata)
+{
+    return conversation_table_worker_new(tapdata);
+}
+
+void
+endpoint_table_worker_merge(void *tapdata, void *worker_data)
+{
+    conv_hash_t *ch = (conv_hash_t *)tapdata;
+    const conv_hash_t *worker = (const conv_hash_t *)worker_data;
+
+    if (worker->conv_array == NULL) {
+        return;
+    }
+    if (ch->conv_array == NULL) {
+        endpoint_table_init_data(ch);
+    }
+
+    for (unsigned i = 0; i < worker->conv_array->len; i++) {
+        const endpoint_item_t *src = &g_array_index(worker->conv_array, endpoint_item_t, i);
+        endpoint_item_t *dst = endpoint_table_lookup(ch, &src->myaddress, src->port);
+
+        if (dst == NULL) {
+            endpoint_table_append(ch, src);
+            continue;
+        }
+
+        dst->tx_frames += src->tx_frames;
+        dst->rx_frames += src->rx_frames;
+        dst->tx_bytes += src->tx_bytes;
+        dst->rx_bytes += src->rx_bytes;
+        dst->tx_frames_total += src->tx_frames_total;
+        dst->rx_frames_total += src->rx_frames_total;
+        dst->tx_bytes_total += src->tx_bytes_total;
+        dst->rx_bytes_total += src->rx_bytes_total;
+        dst->modified = true;
+        dst->filtered = dst->filtered && src->filtered;
+    }
+}
+
+void
+endpoint_table_worker_free(void *worker_data)
+{
+    reset_endpoint_table_data((conv_hash_t *)worker_data);
+    g_free(worker_data);
+}
+
 /*
  * Editor modelines
  *
@@ -490,6 +490,56 @@ WS_DLL_PUBLIC void add_endpoint_table_data(conv_hash_t *ch, const address *addr,
 WS_DLL_PUBLIC void add_endpoint_table_data_ipv4_subnet(conv_hash_t *ch, const address *addr,
     uint32_t port, bool sender, int num_frames, int num_bytes, et_dissector_info_t *et_info, endpoint_type etype);
 
+/**
+ * @brief Create an empty conversation table for a tap worker.
+ *
+ * Worker callbacks for conversation table taps; see set_tap_worker_callbacks().
+ *
+ * @param tapdata the listener's conv_hash_t
+ * @return a new conv_hash_t with the same flags and user data
+ */
+WS_DLL_PUBLIC void *conversation_table_worker_new(void *tapdata);
+
+/**
+ * @brief Add the conversations a tap worker collected to the listener's table.
+ *
+ * @param tapdata the listener's conv_hash_t
+ * @param worker_data the worker's conv_hash_t
+ */
+WS_DLL_PUBLIC void conversation_table_worker_merge(void *tapdata, void *worker_data);
+
+/**
+ * @brief Free a conversation table created by conversation_table_worker_new().
+ *
+ * @param worker_data the worker's conv_hash_t
+ */
+WS_DLL_PUBLIC void conversation_table_worker_free(void *worker_data);
+
+/**
+ * @brief Create an empty endpoint table for a tap worker.
+ *
+ * Worker callbacks for endpoint table taps; see set_tap_worker_callbacks().
+ *
+ * @param tapdata the listener's conv_hash_t
+ * @return a new conv_hash_t with the same flags and user data
+ */
+WS_DLL_PUBLIC void *endpoint_table_worker_new(void *tapdata);
+
+/**
+ * @brief Add the endpoints a tap worker collected to the listener's table.
+ *
+ * @param tapdata the listener's conv_hash_t
+ * @param worker_data the worker's conv_hash_t
+ */
+WS_DLL_PUBLIC void endpoint_table_worker_merge(void *tapdata, void *worker_data);
+
+/**
+ * @brief Free an endpoint table created by endpoint_table_worker_new().
+ *
+ * @param worker_data the worker's conv_hash_t
+ */
+WS_DLL_PUBLIC void endpoint_table_worker_free(void *worker_data);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -49,6 +49,8 @@ struct epan_dfilter {
     df_cell_t   *registers;              /**< Array of registers storing cell data. */
     int     *interesting_fields;         /**< Array of field IDs that are interesting to the filter. */
     int     num_interesting_fields;      /**< Count of interesting fields. */
+    int     *required_fields;            /**< Array of field IDs that must be present for a match. */
+    int     num_required_fields;         /**< Count of required fields. */
     GPtrArray   *deprecated;             /**< Array of deprecated items used in the filter. */
     GSList      *warnings;               /**< List of warnings generated during compilation. */
     char        *expanded_text;          /**< The expanded filter text after macro expansion. */
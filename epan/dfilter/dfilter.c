@@ -178,6 +178,7 @@ dfilter_free(dfilter_t *df)
 	}
 
 	g_free(df->interesting_fields);
+	g_free(df->required_fields);
 
 	g_hash_table_destroy(df->references);
 	g_hash_table_destroy(df->raw_references);
@@ -488,6 +489,11 @@ dfwork_build(dfwork_t *dfw)
 		tree_str = dump_syntax_tree_str(dfw->st_root);
 	}
 
+	/* Collect the fields a match depends on while the syntax tree
+	 * is still intact; code generation steals from it. */
+	int *required_fields, num_required_fields;
+	required_fields = dfw_required_fields(dfw, &num_required_fields);
+
 	/* Create bytecode */
 	dfw_gencode(dfw);
 
@@ -497,6 +503,8 @@ dfwork_build(dfwork_t *dfw)
 	dfw->insns = NULL;
 	dfilter->interesting_fields = dfw_interesting_fields(dfw,
 		&dfilter->num_interesting_fields);
+	dfilter->required_fields = required_fields;
+	dfilter->num_required_fields = num_required_fields;
 	dfilter->expanded_text = dfw->expanded_text;
 	dfw->expanded_text = NULL;
 	dfilter->references = dfw->references;
@@ -768,6 +776,13 @@ dfilter_interested_in_proto(const dfilter_t *df, int proto_id)
 	return false;
 }
 
+const int *
+dfilter_required_fields(const dfilter_t *df, int *count)
+{
+	*count = df->num_required_fields;
+	return df->required_fields;
+}
+
 bool
 dfilter_requires_columns(const dfilter_t *df)
 {
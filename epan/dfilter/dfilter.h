@@ -286,6 +286,22 @@ dfilter_interested_in_field(const dfilter_t *df, int hfid);
 bool
 dfilter_interested_in_proto(const dfilter_t *df, int proto_id);
 
+/**
+ * @brief Get the fields that must be present for a dfilter to match
+ *
+ * The filter cannot be true for a tree that has no instance of one of
+ * these fields, so callers evaluating many filters against a packet can
+ * skip a filter without running it. Each field is identified by the
+ * first registered field of its name; the other fields of that name
+ * must be checked as well. Negated sub-expressions contribute nothing.
+ *
+ * @param df The dfilter
+ * @param count Set to the number of fields returned
+ * @return The field IDs, or NULL if the filter requires no field.
+ */
+const int *
+dfilter_required_fields(const dfilter_t *df, int *count);
+
 /**
  * @brief Check if a display filter requires specific columns.
  *
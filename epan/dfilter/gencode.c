@@ -949,6 +949,130 @@ dfw_interesting_fields(dfwork_t *dfw, int *caller_num_fields)
 	return hki.fields;
 }
 
+/* Add to "required" the field that st_arg reads, if it has one. A field
+ * operand that is absent from the tree makes the enclosing relation false
+ * (see the jumps in gen_relation), as does a slice or arithmetic expression
+ * over one. Functions may produce a value without their arguments and
+ * references are read from another frame, so neither requires anything. */
+static void
+required_entity(stnode_t *st_arg, GHashTable *required)
+{
+	header_field_info *hfinfo;
+	stnode_op_t	op;
+	stnode_t	*left, *right;
+
+	switch (stnode_type_id(st_arg)) {
+		case STTYPE_FIELD:
+			hfinfo = sttype_field_hfinfo(st_arg);
+			/* Rewind to find the first field of this name. */
+			while (hfinfo->same_name_prev_id != -1) {
+				hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+			}
+			g_hash_table_add(required, GINT_TO_POINTER(hfinfo->id));
+			break;
+		case STTYPE_SLICE:
+			required_entity(sttype_slice_entity(st_arg), required);
+			break;
+		case STTYPE_ARITHMETIC:
+			sttype_oper_get(st_arg, &op, &left, &right);
+			required_entity(left, required);
+			if (right != NULL)
+				required_entity(right, required);
+			break;
+		default:
+			break;
+	}
+}
+
+/* Returns the set of fields that must all be present for st_node to be
+ * true. The set is conservative: a filter may still be false with all of
+ * them present, but never true with one of them missing. */
+static GHashTable *
+required_fields(stnode_t *st_node)
+{
+	GHashTable	*required, *other;
+	GHashTableIter	iter;
+	void		*key;
+	stnode_op_t	op;
+	stnode_t	*left, *right;
+
+	required = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	switch (stnode_type_id(st_node)) {
+		case STTYPE_TEST:
+			sttype_oper_get(st_node, &op, &left, &right);
+			switch (op) {
+				case STNODE_OP_NOT:
+					/* A negation may be true with nothing present. */
+					break;
+				case STNODE_OP_AND:
+					g_hash_table_destroy(required);
+					required = required_fields(left);
+					other = required_fields(right);
+					g_hash_table_iter_init(&iter, other);
+					while (g_hash_table_iter_next(&iter, &key, NULL)) {
+						g_hash_table_add(required, key);
+					}
+					g_hash_table_destroy(other);
+					break;
+				case STNODE_OP_OR:
+					g_hash_table_destroy(required);
+					required = required_fields(left);
+					other = required_fields(right);
+					g_hash_table_iter_init(&iter, required);
+					while (g_hash_table_iter_next(&iter, &key, NULL)) {
+						if (!g_hash_table_contains(other, key))
+							g_hash_table_iter_remove(&iter);
+					}
+					g_hash_table_destroy(other);
+					break;
+				default:
+					/* A relation; the right side of "in" is a set,
+					 * which required_entity() ignores. */
+					required_entity(left, required);
+					if (right != NULL)
+						required_entity(right, required);
+					break;
+			}
+			break;
+		case STTYPE_FIELD:
+		case STTYPE_SLICE:
+		case STTYPE_ARITHMETIC:
+			/* Existence or non-zero test. */
+			required_entity(st_node, required);
+			break;
+		default:
+			break;
+	}
+
+	return required;
+}
+
+int*
+dfw_required_fields(dfwork_t *dfw, int *caller_num_fields)
+{
+	GHashTable	*required;
+	GHashTableIter	iter;
+	void		*key;
+	int		*fields = NULL;
+	int		num_fields, i = 0;
+
+	required = required_fields(dfw->st_root);
+	num_fields = g_hash_table_size(required);
+
+	if (num_fields > 0) {
+		fields = g_new(int, num_fields);
+		g_hash_table_iter_init(&iter, required);
+		while (g_hash_table_iter_next(&iter, &key, NULL)) {
+			fields[i++] = GPOINTER_TO_INT(key);
+		}
+	}
+	g_hash_table_destroy(required);
+
+	*caller_num_fields = num_fields;
+	return fields;
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
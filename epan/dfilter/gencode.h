@@ -35,4 +35,19 @@ int*
  */
 dfw_interesting_fields(dfwork_t *dfw, int *caller_num_fields);
 
+int*
+
+/**
+ * @brief Retrieves the fields that must be present for the filter to match.
+ *
+ * The filter can only be true if every returned field (identified by the
+ * first field of its name) has at least one instance in the tree. Must be
+ * called on the checked syntax tree before dfw_gencode().
+ *
+ * @param dfw Pointer to the dfwork_t structure holding the syntax tree.
+ * @param caller_num_fields Pointer to an integer that will be set to the number of required fields returned.
+ * @return An array of field IDs, or NULL if the filter requires no field.
+ */
+dfw_required_fields(dfwork_t *dfw, int *caller_num_fields);
+
 #endif
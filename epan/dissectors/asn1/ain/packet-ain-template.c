@@ -193,7 +193,9 @@ void proto_reg_handoff_ain(void) {
 }
 
 
-void proto_register_ain(void) {
+static void
+register_ain_fields(const char *unused _U_)
+{
     /* List of fields */
 
     static hf_register_info hf[] = {
@@ -252,6 +254,11 @@ void proto_register_ain(void) {
 #include "packet-ain-ettarr.c"
     };
 
+    proto_register_field_array(proto_ain, hf, array_length(hf));
+    proto_register_subtree_array(ett, array_length(ett));
+}
+
+void proto_register_ain(void) {
     static ei_register_info ei[] = {
         { &ei_ain_unknown_invokeData,{ "ain.unknown.invokeData", PI_MALFORMED, PI_WARN, "Unknown invokeData", EXPFILL } },
         { &ei_ain_unknown_returnResultData,{ "ain.unknown.returnResultData", PI_MALFORMED, PI_WARN, "Unknown returnResultData", EXPFILL } },
@@ -264,8 +271,10 @@ void proto_register_ain(void) {
     proto_ain = proto_register_protocol("Advanced Intelligent Network", "AIN", "ain");
     ain_handle = register_dissector("ain", dissect_ain, proto_ain);
     /* Register fields and subtrees */
-    proto_register_field_array(proto_ain, hf, array_length(hf));
-    proto_register_subtree_array(ett, array_length(ett));
+    proto_register_fields_deferred(proto_ain, register_ain_fields);
+
+    /* Expert infos are registered right away, so that the expert info
+     * severity table can refer to them before the fields are. */
     expert_ain = expert_register_protocol(proto_ain);
     expert_register_field_array(expert_ain, ei, array_length(ei));
 
@@ -43,9 +43,9 @@ static int ett_lppe_civicLocation;
 #include "packet-lppe-fn.c"
 
 
-/*--- proto_register_lpp -------------------------------------------*/
-void proto_register_lppe(void) {
-
+static void
+register_lppe_fields(const char *unused _U_)
+{
   /* List of fields */
   static hf_register_info hf[] = {
 
@@ -59,15 +59,19 @@ void proto_register_lppe(void) {
 #include "packet-lppe-ettarr.c"
   };
 
+  proto_register_field_array(proto_lppe, hf, array_length(hf));
+  proto_register_subtree_array(ett, array_length(ett));
+}
+
+/*--- proto_register_lpp -------------------------------------------*/
+void proto_register_lppe(void) {
 
   /* Register protocol */
   proto_lppe = proto_register_protocol("LTE Positioning Protocol Extensions (LLPe)", "LPPe", "lppe");
   register_dissector("lppe", dissect_OMA_LPPe_MessageExtension_PDU, proto_lppe);
 
   /* Register fields and subtrees */
-  proto_register_field_array(proto_lppe, hf, array_length(hf));
-  proto_register_subtree_array(ett, array_length(ett));
-
+  proto_register_fields_deferred(proto_lppe, register_lppe_fields);
 
 }
 
@@ -230,9 +230,9 @@ dissect_sccp_rnsap_heur(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, voi
 }
 
 
-/*--- proto_register_rnsap -------------------------------------------*/
-void proto_register_rnsap(void) {
-
+static void
+register_rnsap_fields(const char *unused _U_)
+{
   /* List of fields */
   static hf_register_info hf[] = {
     { &hf_rnsap_transportLayerAddress_ipv4,
@@ -259,12 +259,17 @@ void proto_register_rnsap(void) {
 #include "packet-rnsap-ettarr.c"
   };
 
+  proto_register_field_array(proto_rnsap, hf, array_length(hf));
+  proto_register_subtree_array(ett, array_length(ett));
+}
+
+/*--- proto_register_rnsap -------------------------------------------*/
+void proto_register_rnsap(void) {
 
   /* Register protocol */
   proto_rnsap = proto_register_protocol("UTRAN Iur interface Radio Network Subsystem Application Part", "RNSAP", "rnsap");
   /* Register fields and subtrees */
-  proto_register_field_array(proto_rnsap, hf, array_length(hf));
-  proto_register_subtree_array(ett, array_length(ett));
+  proto_register_fields_deferred(proto_rnsap, register_rnsap_fields);
 
   /* Register dissector */
   rnsap_handle = register_dissector("rnsap", dissect_rnsap, proto_rnsap);
@@ -42,9 +42,9 @@ static int ett_rrlp;
 #include "packet-rrlp-fn.c"
 
 
-/*--- proto_register_rrlp -------------------------------------------*/
-void proto_register_rrlp(void) {
-
+static void
+register_rrlp_fields(const char *unused _U_)
+{
   /* List of fields */
   static hf_register_info hf[] = {
 
@@ -57,15 +57,19 @@ void proto_register_rrlp(void) {
 #include "packet-rrlp-ettarr.c"
   };
 
+  proto_register_field_array(proto_rrlp, hf, array_length(hf));
+  proto_register_subtree_array(ett, array_length(ett));
+}
+
+/*--- proto_register_rrlp -------------------------------------------*/
+void proto_register_rrlp(void) {
 
   /* Register protocol */
   proto_rrlp = proto_register_protocol("Radio Resource LCS Protocol (RRLP)", "RRLP", "rrlp");
   register_dissector("rrlp", dissect_PDU_PDU, proto_rrlp);
 
   /* Register fields and subtrees */
-  proto_register_field_array(proto_rrlp, hf, array_length(hf));
-  proto_register_subtree_array(ett, array_length(ett));
-
+  proto_register_fields_deferred(proto_rrlp, register_rrlp_fields);
 
 }
 
@@ -5389,23 +5389,44 @@ static void dns_stats_tree_init(stats_tree* st)
   st_node_service_rrt = stats_tree_create_node(st, st_str_service_rrt, st_node_service_stats, STAT_DT_FLOAT, false);
 }
 
+/* Names of the pivot values, asked for only the first time a value is seen */
+static char *dns_stats_qr_name(unsigned qr)
+{
+  return val_to_str(NULL, qr, dns_qr_vals, "Unknown qr (%d)");
+}
+
+static char *dns_stats_type_name(unsigned type)
+{
+  return val_to_str(NULL, type, dns_types_vals, "Unknown packet type (%d)");
+}
+
+static char *dns_stats_class_name(unsigned qclass)
+{
+  return val_to_str(NULL, qclass, dns_classes, "Unknown class (%d)");
+}
+
+static char *dns_stats_rcode_name(unsigned rcode)
+{
+  return val_to_str(NULL, rcode, rcode_vals, "Unknown rcode (%d)");
+}
+
+static char *dns_stats_opcode_name(unsigned opcode)
+{
+  return val_to_str(NULL, opcode, opcode_vals, "Unknown opcode (%d)");
+}
+
 static tap_packet_status dns_stats_tree_packet(stats_tree* st, packet_info* pinfo _U_, epan_dissect_t* edt _U_, const void* p, tap_flags_t flags _U_)
 {
   const struct DnsTap *pi = (const struct DnsTap *)p;
   tick_stat_node(st, st_str_packets, 0, false);
-  stats_tree_tick_pivot(st, st_node_packet_qr,
-          val_to_str(pinfo->pool, pi->packet_qr, dns_qr_vals, "Unknown qr (%d)"));
-  stats_tree_tick_pivot(st, st_node_packet_qtypes,
-          val_to_str(pinfo->pool, pi->packet_qtype, dns_types_vals, "Unknown packet type (%d)"));
+  stats_tree_tick_pivot_by_key(st, st_node_packet_qr, pi->packet_qr, dns_stats_qr_name);
+  stats_tree_tick_pivot_by_key(st, st_node_packet_qtypes, pi->packet_qtype, dns_stats_type_name);
   if (dns_qname_stats && pi->qname_len > 0) {
         stats_tree_tick_pivot(st, st_node_packet_qnames, pi->qname);
   }
-  stats_tree_tick_pivot(st, st_node_packet_qclasses,
-          val_to_str(pinfo->pool, pi->packet_qclass, dns_classes, "Unknown class (%d)"));
-  stats_tree_tick_pivot(st, st_node_packet_rcodes,
-          val_to_str(pinfo->pool, pi->packet_rcode, rcode_vals, "Unknown rcode (%d)"));
-  stats_tree_tick_pivot(st, st_node_packet_opcodes,
-          val_to_str(pinfo->pool, pi->packet_opcode, opcode_vals, "Unknown opcode (%d)"));
+  stats_tree_tick_pivot_by_key(st, st_node_packet_qclasses, pi->packet_qclass, dns_stats_class_name);
+  stats_tree_tick_pivot_by_key(st, st_node_packet_rcodes, pi->packet_rcode, dns_stats_rcode_name);
+  stats_tree_tick_pivot_by_key(st, st_node_packet_opcodes, pi->packet_opcode, dns_stats_opcode_name);
   avg_stat_node_add_value_int(st, st_str_packets_avg_size, 0, false,
           pi->payload_size);
 
@@ -5435,8 +5456,7 @@ static tap_packet_status dns_stats_tree_packet(stats_tree* st, packet_info* pinf
     /* add answer types to stats */
     for (wmem_list_frame_t *type_entry = wmem_list_head(pi->rr_types); type_entry != NULL; type_entry = wmem_list_frame_next(type_entry)) {
       int qtype_val = GPOINTER_TO_INT(wmem_list_frame_data(type_entry));
-      stats_tree_tick_pivot(st, st_node_rr_types,
-                            val_to_str(pinfo->pool, qtype_val, dns_types_vals, "Unknown packet type (%d)"));
+      stats_tree_tick_pivot_by_key(st, st_node_rr_types, qtype_val, dns_stats_type_name);
     }
 
     if (pi->unsolicited) {
@@ -6371,6 +6391,16 @@ proto_reg_handoff_dns(void)
   heur_dissector_add("udp", dissect_dns_heur, "DNS over UDP", "dns_udp", proto_dns, HEURISTIC_ENABLE);
 }
 
+/* An idle DNS conversation was retired; free its transactions. */
+static void
+dns_conversation_retire(conversation_t *conv _U_, void *proto_data)
+{
+  dns_conv_info_t *dns_info = (dns_conv_info_t *)proto_data;
+
+  wmem_tree_destroy(dns_info->pdus, false, true);
+  wmem_free(wmem_file_scope(), dns_info);
+}
+
 void
 proto_register_dns(void)
 {
@@ -8232,6 +8262,7 @@ proto_register_dns(void)
   register_dissector("svc_params", dissect_svc_params, proto_svc_params);
 
   dns_tap = register_tap("dns");
+  conversation_register_retire_routine(proto_dns, dns_conversation_retire);
 }
 
 /*
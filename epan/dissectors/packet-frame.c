@@ -27,6 +27,7 @@
 #include <epan/sequence_analysis.h>
 #include <epan/tap.h>
 #include <epan/proto_data.h>
+#include <epan/reassemble.h>
 #include <epan/expert.h>
 #include <epan/tfs.h>
 #include <wsutil/wsgcrypt.h>
@@ -121,6 +122,7 @@ static expert_field ei_comments_text;
 static expert_field ei_arrive_time_out_of_range;
 static expert_field ei_incomplete;
 static expert_field ei_len_lt_caplen;
+static expert_field ei_reassembly_evicted;
 
 static int frame_tap;
 
@@ -583,6 +585,7 @@ dissect_frame(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
 	const color_filter_t *color_filter;
 	dissector_handle_t dissector_handle;
 	fr_foreach_t fr_user_data;
+	unsigned     evicted;
 
 	tree=parent_tree;
 
@@ -1225,6 +1228,13 @@ dissect_frame(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
 
 	proto_tree_add_uint(fh_tree, hf_frame_encoding, tvb, 0, 0, pinfo->fd->encoding);
 
+	evicted = reassembly_evictions_in_frame(pinfo->num);
+	if (evicted) {
+		proto_tree_add_expert_format(fh_tree, pinfo, &ei_reassembly_evicted, tvb, 0, 0,
+			"%u incomplete reassembl%s discarded to stay within the reassembly limits",
+			evicted, plurality(evicted, "y was", "ies were"));
+	}
+
 	/* Add the columns as fields. We have to do this here, so that
 	 * they're available for postdissectors that want all the fields.
 	 *
@@ -1700,7 +1710,8 @@ static void common_register_frame(bool use_packets)
 		{ &ei_comments_text, { "frame.comment.expert", PI_COMMENTS_GROUP, PI_COMMENT, "Formatted comment", EXPFILL }},
 		{ &ei_arrive_time_out_of_range, { "frame.time_invalid", PI_SEQUENCE, PI_NOTE, "Arrival Time: Fractional second out of range (0-999999999)", EXPFILL }},
 		{ &ei_incomplete, { "frame.incomplete", PI_UNDECODED, PI_NOTE, "Incomplete dissector", EXPFILL }},
-		{ &ei_len_lt_caplen, { "frame.len_lt_caplen", PI_MALFORMED, PI_ERROR, "Frame length is less than captured length", EXPFILL }}
+		{ &ei_len_lt_caplen, { "frame.len_lt_caplen", PI_MALFORMED, PI_ERROR, "Frame length is less than captured length", EXPFILL }},
+		{ &ei_reassembly_evicted, { "frame.reassembly_evicted", PI_REASSEMBLE, PI_WARN, "Incomplete reassemblies discarded to stay within the reassembly limits", EXPFILL }}
 	};
 
 	module_t *frame_module;
@@ -753,15 +753,25 @@ http_stats_tree_init(stats_tree* st)
 	st_node_other = stats_tree_create_node(st, st_str_other, st_node_packets, STAT_DT_INT, false);
 }
 
+/* Name of a response code node, asked for only the first time the code is seen */
+static char *
+http_stats_tree_code_name(unsigned code)
+{
+	char *desc = val_to_str(NULL, code, vals_http_status_code, "Unknown (%d)");
+	char *name = g_strdup_printf("%u %s", code, desc);
+
+	wmem_free(NULL, desc);
+	return name;
+}
+
 /* HTTP/Packet Counter stats packet function */
 static tap_packet_status
-http_stats_tree_packet(stats_tree* st, packet_info* pinfo, epan_dissect_t* edt _U_, const void* p, tap_flags_t flags _U_)
+http_stats_tree_packet(stats_tree* st, packet_info* pinfo _U_, epan_dissect_t* edt _U_, const void* p, tap_flags_t flags _U_)
 {
 	const http_info_value_t* v = (const http_info_value_t*)p;
 	unsigned i = v->response_code;
 	int resp_grp;
 	const char *resp_str;
-	char* str;
 
 	tick_stat_node(st, st_str_packets, 0, false);
 
@@ -790,9 +800,7 @@ http_stats_tree_packet(stats_tree* st, packet_info* pinfo, epan_dissect_t* edt _
 
 		tick_stat_node(st, resp_str, st_node_responses, false);
 
-		str = wmem_strdup_printf(pinfo->pool, "%u %s", i,
-			   val_to_str(pinfo->pool, i, vals_http_status_code, "Unknown (%d)"));
-		tick_stat_node(st, str, resp_grp, false);
+		tick_stat_node_by_key(st, i, http_stats_tree_code_name, resp_grp, false);
 	} else if (v->request_method) {
 		stats_tree_tick_pivot(st,st_node_requests,v->request_method);
 	} else {
@@ -4720,6 +4728,38 @@ static void reinit_http(void) {
 	range_foreach(http_tls_range, range_add_http_tls_callback, NULL);
 }
 
+static void
+free_match_trans(void *key, void *value, void *user_data _U_)
+{
+	match_trans_t *match_trans = (match_trans_t *)value;
+
+	/* Each match is in the table under both its frames. */
+	if (GPOINTER_TO_UINT(key) == match_trans->req_frame)
+		wmem_free(wmem_file_scope(), match_trans);
+}
+
+/*
+ * An idle HTTP conversation was retired; free its state. The request and
+ * response records belong to the frames that refer to them.
+ */
+static void
+http_conversation_retire(conversation_t *conv _U_, void *proto_data)
+{
+	http_conv_t *conv_data = (http_conv_t *)proto_data;
+	wmem_list_frame_t *frame;
+
+	wmem_map_destroy(conv_data->chunk_offsets_fwd, false, false);
+	wmem_map_destroy(conv_data->chunk_offsets_rev, false, false);
+	for (frame = wmem_list_head(conv_data->req_list); frame; frame = wmem_list_frame_next(frame))
+		wmem_free(wmem_file_scope(), wmem_list_frame_data(frame));
+	wmem_destroy_list(conv_data->req_list);
+	wmem_map_foreach(conv_data->matches_table, free_match_trans, NULL);
+	wmem_map_destroy(conv_data->matches_table, false, false);
+	wmem_free(wmem_file_scope(), conv_data->upgrade_info);
+	free_address_wmem(wmem_file_scope(), &conv_data->server_addr);
+	wmem_free(wmem_file_scope(), conv_data);
+}
+
 void
 proto_register_http(void)
 {
@@ -5167,6 +5207,7 @@ proto_register_http(void)
 							tcp_port_to_display, follow_tvb_tap_listener,
 							get_tcp_stream_count, NULL);
 	http_eo_tap = register_export_object(proto_http, http_eo_packet, NULL);
+	conversation_register_retire_routine(proto_http, http_conversation_retire);
 
 	/* compile patterns, excluding "/" */
 	ws_mempbrk_compile(&pbrk_gen_delims, ":?#[]@");
@@ -9858,8 +9858,8 @@ dissect_ieee1905(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data
     return offset + next_offset;
 }
 
-void
-proto_register_ieee1905(void)
+static void
+register_ieee1905_fields(const char *unused _U_)
 {
     static hf_register_info hf[] = {
         { &hf_ieee1905_fragment_data,
@@ -13684,6 +13684,13 @@ proto_register_ieee1905(void)
         &ett_ieee1905_fragments,
     };
 
+    proto_register_field_array(proto_ieee1905, hf, array_length(hf));
+    proto_register_subtree_array(ett, array_length(ett));
+}
+
+void
+proto_register_ieee1905(void)
+{
     static ei_register_info ei[] = {
         { &ei_ieee1905_malformed_tlv,
           { "ieee1905.tlv.too_short", PI_PROTOCOL, PI_WARN,
@@ -13694,13 +13701,14 @@ proto_register_ieee1905(void)
              "TLV has extra data or an incorrect length", EXPFILL }},
     };
 
-    expert_module_t *expert_ieee1905 = NULL;
+    expert_module_t *expert_ieee1905;
 
     proto_ieee1905 = proto_register_protocol("IEEE 1905.1a", "ieee1905", "ieee1905");
 
-    proto_register_field_array(proto_ieee1905, hf, array_length(hf));
-    proto_register_subtree_array(ett, array_length(ett));
+    proto_register_fields_deferred(proto_ieee1905, register_ieee1905_fields);
 
+    /* Expert infos are registered right away, so that the expert info
+     * severity table can refer to them before the fields are. */
     expert_ieee1905 = expert_register_protocol(proto_ieee1905);
     expert_register_field_array(expert_ieee1905, ei, array_length(ei));
 
@@ -2972,7 +2972,7 @@ ieee802154_dissect_header(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, u
     /* Add the addressing info to the root of the tree. */
     if (packet->src_addr_mode == IEEE802154_FCF_ADDR_SHORT) {
         proto_item_append_text(proto_root, ", Src: %s", address_to_str(pinfo->pool, &pinfo->src));
-        col_append_fstr(pinfo->cinfo, COL_INFO, ", Src: %s", address_to_str(pinfo->pool, &pinfo->src));
+        col_append_address(pinfo->cinfo, COL_INFO, &pinfo->src, ", Src: ");
     }
     else if (packet->src_addr_mode == IEEE802154_FCF_ADDR_EXT) {
         proto_item_append_text(proto_root, ", Src: %s", eui64_to_display(pinfo->pool, packet->src64));
@@ -2981,7 +2981,7 @@ ieee802154_dissect_header(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, u
 
     if (packet->dst_addr_mode == IEEE802154_FCF_ADDR_SHORT) {
         proto_item_append_text(proto_root, ", Dst: %s", address_to_str(pinfo->pool, &pinfo->dst));
-        col_append_fstr(pinfo->cinfo, COL_INFO, ", Dst: %s", address_to_str(pinfo->pool, &pinfo->dst));
+        col_append_address(pinfo->cinfo, COL_INFO, &pinfo->dst, ", Dst: ");
     }
     else if (packet->dst_addr_mode == IEEE802154_FCF_ADDR_EXT) {
         proto_item_append_text(proto_root, ", Dst: %s", eui64_to_display(pinfo->pool, packet->dst64));
@@ -4692,9 +4692,9 @@ dissect_ilp_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data)
 
 void proto_reg_handoff_ilp(void);
 
-/*--- proto_register_ilp -------------------------------------------*/
-void proto_register_ilp(void) {
-
+static void
+register_ilp_fields(const char *unused _U_)
+{
   /* List of fields */
   static hf_register_info hf[] = {
 
@@ -6613,16 +6613,21 @@ void proto_register_ilp(void) {
     &ett_ilp_T_tia801Payload,
   };
 
-  module_t *ilp_module;
+  proto_register_field_array(proto_ilp, hf, array_length(hf));
+  proto_register_subtree_array(ett, array_length(ett));
+}
 
+/*--- proto_register_ilp -------------------------------------------*/
+void proto_register_ilp(void) {
+
+  module_t *ilp_module;
 
   /* Register protocol */
   proto_ilp = proto_register_protocol("OMA Internal Location Protocol", "ILP", "ilp");
   ilp_tcp_handle = register_dissector("ilp", dissect_ilp_tcp, proto_ilp);
 
   /* Register fields and subtrees */
-  proto_register_field_array(proto_ilp, hf, array_length(hf));
-  proto_register_subtree_array(ett, array_length(ett));
+  proto_register_fields_deferred(proto_ilp, register_ilp_fields);
 
   ilp_module = prefs_register_protocol(proto_ilp, NULL);
 
@@ -2032,8 +2032,7 @@ dissect_ip_v4(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
 
   iph->ip_tos = tvb_get_uint8(tvb, offset + 1);
   if (g_ip_dscp_actif) {
-    col_add_str(pinfo->cinfo, COL_DSCP_VALUE,
-                val_to_str_ext(pinfo->pool, IPDSFIELD_DSCP(iph->ip_tos), &dscp_short_vals_ext, "%u"));
+    col_add_val_str_ext(pinfo->cinfo, COL_DSCP_VALUE, IPDSFIELD_DSCP(iph->ip_tos), &dscp_short_vals_ext);
   }
 
   if (tree) {
@@ -2500,8 +2499,8 @@ dissect_ip_v4(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree, void*
                         parent_tree, iph)) {
       /* Unknown protocol */
       if (update_col_info) {
-        col_add_fstr(pinfo->cinfo, COL_INFO, "%s (%u)",
-                   ipprotostr(iph->ip_proto), iph->ip_proto);
+        col_set_str(pinfo->cinfo, COL_INFO, ipprotostr(iph->ip_proto));
+        col_append_uint(pinfo->cinfo, COL_INFO, " (", iph->ip_proto, ")");
       }
       call_data_dissector(next_tvb, pinfo, parent_tree);
     }
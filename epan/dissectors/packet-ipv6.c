@@ -3671,8 +3671,7 @@ dissect_ipv6(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_
                         offset + IP6H_CTL_VFC, 4, ENC_BIG_ENDIAN);
 
     /* Set DSCP column */
-    col_add_str(pinfo->cinfo, COL_DSCP_VALUE,
-                val_to_str_ext(pinfo->pool, IPDSFIELD_DSCP(ip6_tcls), &dscp_short_vals_ext, "%u"));
+    col_add_val_str_ext(pinfo->cinfo, COL_DSCP_VALUE, IPDSFIELD_DSCP(ip6_tcls), &dscp_short_vals_ext);
 
     proto_tree_add_item_ret_uint(ipv6_tree, hf_ipv6_flow, tvb,
                         offset + IP6H_CTL_FLOW + 1, 3, ENC_BIG_ENDIAN, &ip6_flow);
@@ -15866,9 +15866,9 @@ static int dissect_OMA_LPPe_MessageExtension_PDU(tvbuff_t *tvb _U_, packet_info
 
 
 
-/*--- proto_register_lpp -------------------------------------------*/
-void proto_register_lppe(void) {
-
+static void
+register_lppe_fields(const char *unused _U_)
+{
   /* List of fields */
   static hf_register_info hf[] = {
 
@@ -22989,15 +22989,19 @@ void proto_register_lppe(void) {
     &ett_lppe_T_srnMeasurements,
   };
 
+  proto_register_field_array(proto_lppe, hf, array_length(hf));
+  proto_register_subtree_array(ett, array_length(ett));
+}
+
+/*--- proto_register_lpp -------------------------------------------*/
+void proto_register_lppe(void) {
 
   /* Register protocol */
   proto_lppe = proto_register_protocol("LTE Positioning Protocol Extensions (LLPe)", "LPPe", "lppe");
   register_dissector("lppe", dissect_OMA_LPPe_MessageExtension_PDU, proto_lppe);
 
   /* Register fields and subtrees */
-  proto_register_field_array(proto_lppe, hf, array_length(hf));
-  proto_register_subtree_array(ett, array_length(ett));
-
+  proto_register_fields_deferred(proto_lppe, register_lppe_fields);
 
 }
 
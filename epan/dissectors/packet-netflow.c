@@ -13620,8 +13620,8 @@ getprefix(wmem_allocator_t *pool, const uint32_t *addr, unsigned prefix)
     return address_to_str(pool, &prefix_addr);
 }
 
-void
-proto_register_netflow(void)
+static void
+register_netflow_fields(const char *unused _U_)
 {
     static hf_register_info hf[] = {
         /*
@@ -22482,6 +22482,13 @@ proto_register_netflow(void)
         &ett_gtpflags
     };
 
+    proto_register_field_array(proto_netflow, hf, array_length(hf));
+    proto_register_subtree_array(ett, array_length(ett));
+}
+
+void
+proto_register_netflow(void)
+{
     static ei_register_info ei[] = {
         { &ei_cflow_flowset_length,
           { "cflow.flowset_length.invalid", PI_MALFORMED, PI_WARN,
@@ -22524,8 +22531,8 @@ proto_register_netflow(void)
             "SubTemplateList bad length", EXPFILL}},
     };
 
-    module_t *netflow_module;
     expert_module_t* expert_netflow;
+    module_t *netflow_module;
 
     proto_netflow = proto_register_protocol("Cisco NetFlow/IPFIX", "CFLOW", "cflow");
     netflow_handle = register_dissector("netflow", dissect_netflow, proto_netflow);
@@ -22533,8 +22540,10 @@ proto_register_netflow(void)
 
     register_dissector("cflow", dissect_netflow, proto_netflow);
 
-    proto_register_field_array(proto_netflow, hf, array_length(hf));
-    proto_register_subtree_array(ett, array_length(ett));
+    proto_register_fields_deferred(proto_netflow, register_netflow_fields);
+
+    /* Expert infos are registered right away, so that the expert info
+     * severity table can refer to them before the fields are. */
     expert_netflow = expert_register_protocol(proto_netflow);
     expert_register_field_array(expert_netflow, ei, array_length(ei));
 
@@ -6681,11 +6681,8 @@ dissect_openflow_v6(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *d
 
 
 
-/*
- * Register the protocol with Wireshark.
- */
-void
-proto_register_openflow_v6(void)
+static void
+register_openflow_v6_fields(const char *unused _U_)
 {
     static hf_register_info hf[] = {
         { &hf_openflow_v6_version,
@@ -10619,6 +10616,16 @@ proto_register_openflow_v6(void)
         &ett_openflow_v6_controller_status_prop,
     };
 
+    proto_register_field_array(proto_openflow_v6, hf, array_length(hf));
+    proto_register_subtree_array(ett, array_length(ett));
+}
+
+/*
+ * Register the protocol with Wireshark.
+ */
+void
+proto_register_openflow_v6(void)
+{
     static ei_register_info ei[] = {
         { &ei_openflow_v6_oxm_undecoded,
             { "openflow_v6.oxm.undecoded", PI_UNDECODED, PI_NOTE,
@@ -10718,7 +10725,6 @@ proto_register_openflow_v6(void)
         },
     };
 
-
     expert_module_t *expert_openflow_v6;
 
     /* Register the protocol name and description */
@@ -10727,8 +10733,10 @@ proto_register_openflow_v6(void)
     register_dissector("openflow_v6", dissect_openflow_v6, proto_openflow_v6);
 
     /* Required function calls to register the header fields and subtrees */
-    proto_register_field_array(proto_openflow_v6, hf, array_length(hf));
-    proto_register_subtree_array(ett, array_length(ett));
+    proto_register_fields_deferred(proto_openflow_v6, register_openflow_v6_fields);
+
+    /* Expert infos are registered right away, so that the expert info
+     * severity table can refer to them before the fields are. */
     expert_openflow_v6 = expert_register_protocol(proto_openflow_v6);
     expert_register_field_array(expert_openflow_v6, ei, array_length(ei));
 }
@@ -14836,9 +14836,9 @@ proto_reg_handoff_pcap(void)
     dissector_add_for_decode_as_with_preference("sccp.ssn", pcap_handle);
 }
 
-/*--- proto_register_pcap -------------------------------------------*/
-void proto_register_pcap(void) {
-
+static void
+register_pcap_fields(const char *unused _U_)
+{
   /* List of fields */
 
   static hf_register_info hf[] = {
@@ -20293,13 +20293,19 @@ void proto_register_pcap(void) {
     &ett_pcap_Outcome,
   };
 
+  proto_register_field_array(proto_pcap, hf, array_length(hf));
+  proto_register_subtree_array(ett, array_length(ett));
+}
+
+/*--- proto_register_pcap -------------------------------------------*/
+void proto_register_pcap(void) {
+
   /* module_t *pcap_module; */
 
   /* Register protocol */
   proto_pcap = proto_register_protocol("UTRAN Iupc interface Positioning Calculation Application Part (PCAP)", "PCAP", "pcap");
   /* Register fields and subtrees */
-  proto_register_field_array(proto_pcap, hf, array_length(hf));
-  proto_register_subtree_array(ett, array_length(ett));
+  proto_register_fields_deferred(proto_pcap, register_pcap_fields);
 
   /* pcap_module = prefs_register_protocol(proto_pcap, NULL); */
 
@@ -20316,7 +20322,6 @@ void proto_register_pcap(void) {
   pcap_proc_uout_dissector_table = register_dissector_table("pcap.proc.uout", "PCAP-ELEMENTARY-PROCEDURE UnsuccessfulOutcome", proto_pcap, FT_UINT32, BASE_DEC);
   pcap_proc_out_dissector_table = register_dissector_table("pcap.proc.out", "PCAP-ELEMENTARY-PROCEDURE Outcome", proto_pcap, FT_UINT32, BASE_DEC);
 
-
 }
 
 
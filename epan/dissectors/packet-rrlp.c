@@ -8411,9 +8411,9 @@ static int dissect_PDU_PDU(tvbuff_t *tvb _U_, packet_info *pinfo _U_, proto_tree
 
 
 
-/*--- proto_register_rrlp -------------------------------------------*/
-void proto_register_rrlp(void) {
-
+static void
+register_rrlp_fields(const char *unused _U_)
+{
   /* List of fields */
   static hf_register_info hf[] = {
 
@@ -12860,15 +12860,19 @@ void proto_register_rrlp(void) {
     &ett_rrlp_MTA_Security,
   };
 
+  proto_register_field_array(proto_rrlp, hf, array_length(hf));
+  proto_register_subtree_array(ett, array_length(ett));
+}
+
+/*--- proto_register_rrlp -------------------------------------------*/
+void proto_register_rrlp(void) {
 
   /* Register protocol */
   proto_rrlp = proto_register_protocol("Radio Resource LCS Protocol (RRLP)", "RRLP", "rrlp");
   register_dissector("rrlp", dissect_PDU_PDU, proto_rrlp);
 
   /* Register fields and subtrees */
-  proto_register_field_array(proto_rrlp, hf, array_length(hf));
-  proto_register_subtree_array(ett, array_length(ett));
-
+  proto_register_fields_deferred(proto_rrlp, register_rrlp_fields);
 
 }
 
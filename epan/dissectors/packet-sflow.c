@@ -2596,7 +2596,7 @@ dissect_sflow_245(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *dat
             break;
         case ADDR_TYPE_IPV4:
         case ADDR_TYPE_IPV6:
-            col_append_fstr(pinfo->cinfo, COL_INFO, ", agent %s", address_to_str(pinfo->pool, &addr_details));
+            col_append_address(pinfo->cinfo, COL_INFO, &addr_details, ", agent ");
             break;
     }
 
@@ -5223,8 +5223,8 @@ again:
                             proto_item_set_generated(item);
 
                             if (first_pdu) {
-                                col_append_sep_fstr(pinfo->cinfo, COL_INFO, " ", "[TCP PDU reassembled in %u]",
-                                    ipfd_head->reassembled_in);
+                                col_append_sep_str(pinfo->cinfo, COL_INFO, " ", "[TCP PDU reassembled in ");
+                                col_append_uint(pinfo->cinfo, COL_INFO, NULL, ipfd_head->reassembled_in, "]");
                             }
                         }
                     }
@@ -5835,8 +5835,8 @@ again:
              * Just mark this as TCP.
              */
             if (first_pdu && ipfd_head != NULL && ipfd_head->reassembled_in != 0) {
-                col_append_sep_fstr(pinfo->cinfo, COL_INFO, " ", "[TCP PDU reassembled in %u]",
-                    ipfd_head->reassembled_in);
+                col_append_sep_str(pinfo->cinfo, COL_INFO, " ", "[TCP PDU reassembled in ");
+                col_append_uint(pinfo->cinfo, COL_INFO, NULL, ipfd_head->reassembled_in, "]");
             }
         }
 
@@ -10155,6 +10155,53 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
     return tvb_captured_length(tvb);
 }
 
+static void
+tcp_flow_free(tcp_flow_t *flow)
+{
+    wmem_list_frame_t *frame;
+    tcp_unacked_t *ual, *next_ual;
+
+    wmem_tree_destroy(flow->multisegment_pdus, false, true);
+    if (flow->ooo_segments) {
+        for (frame = wmem_list_head(flow->ooo_segments); frame; frame = wmem_list_frame_next(frame)) {
+            ooo_segment_item *fd = (ooo_segment_item *)wmem_list_frame_data(frame);
+            wmem_free(wmem_file_scope(), fd->data);
+            wmem_free(wmem_file_scope(), fd);
+        }
+        wmem_destroy_list(flow->ooo_segments);
+        wmem_map_destroy(flow->ooo_segments_map, false, false);
+    }
+    if (flow->tcp_analyze_seq_info) {
+        for (ual = flow->tcp_analyze_seq_info->segments; ual; ual = next_ual) {
+            next_ual = ual->next;
+            wmem_free(wmem_file_scope(), ual);
+        }
+        wmem_free(wmem_file_scope(), flow->tcp_analyze_seq_info);
+    }
+    if (flow->process_info) {
+        wmem_free(wmem_file_scope(), flow->process_info->username);
+        wmem_free(wmem_file_scope(), flow->process_info->command);
+        wmem_free(wmem_file_scope(), flow->process_info);
+    }
+}
+
+/* An idle TCP conversation was retired; free its analysis state. MPTCP
+ * subflows are left alone, as their MPTCP connection still lists them. */
+static void
+tcp_conversation_retire(conversation_t *conv _U_, void *proto_data)
+{
+    struct tcp_analysis *tcpd = (struct tcp_analysis *)proto_data;
+
+    if (tcpd->mptcp_analysis)
+        return;
+
+    tcp_flow_free(&tcpd->flow1);
+    tcp_flow_free(&tcpd->flow2);
+    wmem_tree_destroy(tcpd->acked_table, false, true);
+    wmem_free(wmem_file_scope(), tcpd->conversation_completeness_str);
+    wmem_free(wmem_file_scope(), tcpd);
+}
+
 static void
 tcp_init(void)
 {
@@ -11466,6 +11513,7 @@ proto_register_tcp(void)
         &read_seq_as_syn_cookie);
 
     register_init_routine(tcp_init);
+    conversation_register_retire_routine(proto_tcp, tcp_conversation_retire);
     reassembly_table_register(&tcp_reassembly_table,
                           &tcp_reassembly_table_functions);
 
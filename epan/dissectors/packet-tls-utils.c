@@ -3801,7 +3801,7 @@ ssl_create_decoder(const SslCipherSuite *cipher_suite, int cipher_algo,
     }
     dec->seq = 0;
     dec->decomp = ssl_create_decompressor(compression);
-    wmem_register_callback(wmem_file_scope(), ssl_decoder_destroy_cb, dec);
+    dec->destroy_cb_id = wmem_register_callback(wmem_file_scope(), ssl_decoder_destroy_cb, dec);
 
     if (ssl_cipher_init(&dec->evp,cipher_algo,sk,iv,cipher_suite->mode) < 0) {
         ssl_debug_printf("%s: can't create cipher id:%d mode:%d\n", G_STRFUNC,
@@ -3853,6 +3853,17 @@ ssl_decoder_destroy_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U
 
     return false;
 }
+
+static void
+ssl_decoder_free(SslDecoder *dec)
+{
+    wmem_unregister_callback(wmem_file_scope(), dec->destroy_cb_id);
+    ssl_decoder_destroy_cb(wmem_file_scope(), WMEM_CB_DESTROY_EVENT, dec);
+    wmem_free(wmem_file_scope(), dec->decomp);
+    wmem_free(wmem_file_scope(), dec->dtls13_aad.data);
+    wmem_free(wmem_file_scope(), dec->app_traffic_secret.data);
+    wmem_free(wmem_file_scope(), dec);
+}
 /* }}} */
 
 /* (Pre-)master secrets calculations {{{ */
@@ -5333,6 +5344,57 @@ ssl_get_session(conversation_t *conversation, dissector_handle_t tls_handle, uin
     return ssl_session;
 }
 
+static void
+ssl_session_free(SslDecryptSession *ssl)
+{
+    SslDecoder *decoders[] = { ssl->client, ssl->server, ssl->client_new, ssl->server_new };
+    SslFlow *flows[G_N_ELEMENTS(decoders)];
+    unsigned i, j, nflows = 0;
+
+    /* Decoders created for a change of keys share the flow of the
+     * decoders they replace. */
+    for (i = 0; i < G_N_ELEMENTS(decoders); i++) {
+        if (!decoders[i])
+            continue;
+        if (decoders[i]->flow) {
+            for (j = 0; j < nflows && flows[j] != decoders[i]->flow; j++)
+                ;
+            if (j == nflows)
+                flows[nflows++] = decoders[i]->flow;
+        }
+        ssl_decoder_free(decoders[i]);
+    }
+    for (i = 0; i < nflows; i++) {
+        wmem_tree_destroy(flows[i]->multisegment_pdus, false, true);
+        wmem_free(wmem_file_scope(), flows[i]);
+    }
+
+    wmem_free(wmem_file_scope(), ssl->session_ticket.data);
+    wmem_free(wmem_file_scope(), ssl->handshake_data.data);
+    wmem_free(wmem_file_scope(), ssl->ech_transcript.data);
+    wmem_free(wmem_file_scope(), ssl->pre_master_secret.data);
+    wmem_free(wmem_file_scope(), ssl->psk.data);
+#ifdef HAVE_LIBGNUTLS
+    wmem_free(wmem_file_scope(), ssl->cert_key_id);
+#endif
+    wmem_free(wmem_file_scope(), ssl);
+}
+
+static void
+ssl_session_free_cb(void *key _U_, void *value, void *user_data _U_)
+{
+    ssl_session_free((SslDecryptSession *)value);
+}
+
+void
+ssl_retire_sessions(conversation_t *conversation _U_, void *proto_data)
+{
+    wmem_map_t *session_map = (wmem_map_t *)proto_data;
+
+    wmem_map_foreach(session_map, ssl_session_free_cb, NULL);
+    wmem_map_destroy(session_map, false, false);
+}
+
 void ssl_reset_session(SslSession *session, SslDecryptSession *ssl, bool is_client)
 {
     if (ssl) {
@@ -369,6 +369,7 @@ typedef struct _SslDecoder {
     uint16_t epoch;
     SslFlow *flow;
     StringInfo app_traffic_secret;  /**< TLS 1.3 application traffic secret (if applicable), wmem file scope. */
+    unsigned destroy_cb_id;         /**< wmem file scope callback that releases the cipher contexts. */
 } SslDecoder;
 
 #define KEX_DHE_DSS     0x10
@@ -653,6 +654,14 @@ SslDecryptSession *ssl_get_session_by_cid(tvbuff_t *tvb, uint32_t offset);
 extern SslDecryptSession *
 ssl_get_session(conversation_t *conversation, dissector_handle_t tls_handle, uint8_t curr_layer_num);
 
+/** Free the sessions of a conversation that was retired for being idle.
+ * Registered with conversation_register_retire_routine() for TLS.
+ * @param conversation The retired conversation.
+ * @param proto_data The session map created by ssl_get_session().
+ */
+extern void
+ssl_retire_sessions(conversation_t *conversation, void *proto_data);
+
 /** Look up an existing SslDecryptSession for a conversation without creating one.
  * Used by functions that query session state (cipher info, ALPN, exporters, etc.)
  * but must not create a new session as a side effect.
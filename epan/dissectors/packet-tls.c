@@ -5216,6 +5216,7 @@ proto_register_tls(void)
 
     register_init_routine(ssl_init);
     register_cleanup_routine(ssl_cleanup);
+    conversation_register_retire_routine(proto_tls, ssl_retire_sessions);
     reassembly_table_register(&ssl_reassembly_table,
                           &tcp_reassembly_table_functions);
     reassembly_table_register(&tls_hs_reassembly_table,
@@ -7821,9 +7821,9 @@ dissect_ulp_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data)
 
 void proto_reg_handoff_ulp(void);
 
-/*--- proto_register_ulp -------------------------------------------*/
-void proto_register_ulp(void) {
-
+static void
+register_ulp_fields(const char *unused _U_)
+{
   /* List of fields */
   static hf_register_info hf[] = {
 
@@ -10838,8 +10838,14 @@ void proto_register_ulp(void) {
     &ett_ulp_HighAccuracyAltitudeInfo,
   };
 
-  module_t *ulp_module;
+  proto_register_field_array(proto_ulp, hf, array_length(hf));
+  proto_register_subtree_array(ett, array_length(ett));
+}
 
+/*--- proto_register_ulp -------------------------------------------*/
+void proto_register_ulp(void) {
+
+  module_t *ulp_module;
 
   /* Register protocol */
   proto_ulp = proto_register_protocol("OMA UserPlane Location Protocol", "ULP", "ulp");
@@ -10847,8 +10853,7 @@ void proto_register_ulp(void) {
   ulp_pdu_handle = register_dissector("ulp.pdu", dissect_ULP_PDU_PDU, proto_ulp);
 
   /* Register fields and subtrees */
-  proto_register_field_array(proto_ulp, hf, array_length(hf));
-  proto_register_subtree_array(ett, array_length(ett));
+  proto_register_fields_deferred(proto_ulp, register_ulp_fields);
 
   ulp_module = prefs_register_protocol(proto_ulp, NULL);
 
@@ -6249,10 +6249,6 @@ dissect_x11(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
 {
       col_set_str(pinfo->cinfo, COL_PROTOCOL, "X11");
 
-      if (hf_x11_errorcode <= 0) {
-            proto_registrar_get_byname("x11.errorcode");
-      }
-
       if (pinfo->match_uint == pinfo->srcport)
             dissect_x11_replies(tvb, pinfo, tree);
       else
@@ -6339,7 +6335,7 @@ void proto_register_x11(void)
       x11_handle = register_dissector("x11", dissect_x11, proto_x11);
 
       /* Delay registration of X11 fields */
-      proto_register_prefix("x11", register_x11_fields);
+      proto_register_fields_deferred(proto_x11, register_x11_fields);
 
       extension_table = wmem_map_new(wmem_epan_scope(), wmem_str_hash, g_str_equal);
       error_table = wmem_map_new(wmem_epan_scope(), wmem_str_hash, g_str_equal);
@@ -751,6 +751,13 @@ epan_dissect_fake_protocols(epan_dissect_t *edt, const bool fake_protocols)
 		proto_tree_set_fake_protocols(edt->tree, fake_protocols);
 }
 
+void
+epan_dissect_defer_strings(epan_dissect_t *edt, const bool deferred_strings)
+{
+	if (edt)
+		proto_tree_set_deferred_strings(edt->tree, deferred_strings);
+}
+
 void
 epan_dissect_run(epan_dissect_t *edt, int file_type_subtype,
 	wtap_rec *rec, frame_data *fd, column_info *cinfo)
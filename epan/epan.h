@@ -593,6 +593,18 @@ WS_DLL_PUBLIC
 void
 epan_dissect_fake_protocols(epan_dissect_t *edt, const bool fake_protocols);
 
+/**
+ * @brief Indicate whether string values are decoded only when first used.
+ *
+ * See proto_tree_set_deferred_strings().
+ *
+ * @param edt               The dissection context.
+ * @param deferred_strings  If true, decoding of string values is deferred.
+ */
+WS_DLL_PUBLIC
+void
+epan_dissect_defer_strings(epan_dissect_t *edt, const bool deferred_strings);
+
 /**
  * @brief Run a single packet dissection.
  *
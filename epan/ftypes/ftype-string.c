@@ -20,12 +20,40 @@
 static void
 string_fvalue_new(fvalue_t *fv)
 {
+	fv->value.string.deferred = NULL;
 	fv->value.strbuf = NULL;
 }
 
+/*
+ * A value set with fvalue_set_string_deferred() is decoded the first time
+ * anything looks at it. The caller made sure that the bytes are in the
+ * tvbuff and that the encoding can't fail, so this doesn't throw.
+ */
+static void
+string_fvalue_decode(fvalue_t *fv)
+{
+	deferred_string_t *ds = fv->value.string.deferred;
+	char *str;
+
+	str = (char *)tvb_get_string_enc(NULL, ds->tvb, ds->offset, ds->length, ds->encoding);
+	g_free(ds);
+	fv->value.string.deferred = NULL;
+	fv->value.strbuf = wmem_strbuf_new(NULL, str);
+	g_free(str);
+}
+
+static inline void
+string_fvalue_materialize(const fvalue_t *fv)
+{
+	if (G_UNLIKELY(fv->value.string.deferred != NULL))
+		string_fvalue_decode((fvalue_t *)fv);
+}
+
 static void
 string_fvalue_copy(fvalue_t *dst, const fvalue_t *src)
 {
+	string_fvalue_materialize(src);
+	dst->value.string.deferred = NULL;
 	dst->value.strbuf = wmem_strbuf_dup(NULL, src->value.strbuf);
 }
 
@@ -33,6 +61,8 @@ static void
 string_fvalue_free(fvalue_t *fv)
 {
 	wmem_strbuf_destroy(fv->value.strbuf);
+	g_free(fv->value.string.deferred);
+	fv->value.string.deferred = NULL;
 }
 
 static void
@@ -49,6 +79,8 @@ string_fvalue_set_strbuf(fvalue_t *fv, wmem_strbuf_t *value)
 static char *
 string_to_repr(wmem_allocator_t *scope, const fvalue_t *fv, ftrepr_t rtype, int field_display _U_)
 {
+	string_fvalue_materialize(fv);
+
 	switch (rtype) {
 	case FTREPR_DISPLAY:
 	case FTREPR_JSON:
@@ -70,6 +102,7 @@ string_to_repr(wmem_allocator_t *scope, const fvalue_t *fv, ftrepr_t rtype, int
 static const wmem_strbuf_t *
 value_get(fvalue_t *fv)
 {
+	string_fvalue_materialize(fv);
 	return fv->value.strbuf;
 }
 
@@ -123,18 +156,22 @@ val_from_charconst(fvalue_t *fv, unsigned long num, char **err_msg)
 static unsigned
 string_hash(const fvalue_t *fv)
 {
+	string_fvalue_materialize(fv);
 	return g_str_hash(wmem_strbuf_get_str(fv->value.strbuf));
 }
 
 static bool
 string_is_zero(const fvalue_t *fv)
 {
+	string_fvalue_materialize(fv);
 	return fv->value.strbuf == NULL || fv->value.strbuf->len == 0;
 }
 
 static unsigned
 len(fvalue_t *fv)
 {
+	string_fvalue_materialize(fv);
+
 	/* g_utf8_strlen returns long for no apparent reason*/
 	long len = g_utf8_strlen(fv->value.strbuf->str, -1);
 	if (len < 0)
@@ -145,6 +182,8 @@ len(fvalue_t *fv)
 static void
 slice(fvalue_t *fv, wmem_strbuf_t *buf, unsigned offset, unsigned length)
 {
+	string_fvalue_materialize(fv);
+
 	const char *str = fv->value.strbuf->str;
 
 	/* Go to the starting offset */
@@ -162,6 +201,8 @@ slice(fvalue_t *fv, wmem_strbuf_t *buf, unsigned offset, unsigned length)
 static enum ft_result
 cmp_order(const fvalue_t *a, const fvalue_t *b, int *cmp)
 {
+	string_fvalue_materialize(a);
+	string_fvalue_materialize(b);
 	*cmp = wmem_strbuf_strcmp(a->value.strbuf, b->value.strbuf);
 	return FT_OK;
 }
@@ -169,6 +210,9 @@ cmp_order(const fvalue_t *a, const fvalue_t *b, int *cmp)
 static enum ft_result
 cmp_contains(const fvalue_t *fv_a, const fvalue_t *fv_b, bool *contains)
 {
+	string_fvalue_materialize(fv_a);
+	string_fvalue_materialize(fv_b);
+
 	/* According to
 	* http://www.introl.com/introl-demo/Libraries/C/ANSI_C/string/strstr.html
 	* strstr() returns a non-NULL value if needle is an empty
@@ -191,6 +235,8 @@ cmp_contains(const fvalue_t *fv_a, const fvalue_t *fv_b, bool *contains)
 static enum ft_result
 cmp_matches(const fvalue_t *fv, const ws_regex_t *regex, bool *matches)
 {
+	string_fvalue_materialize(fv);
+
 	wmem_strbuf_t *buf = fv->value.strbuf;
 
 	if (regex == NULL) {
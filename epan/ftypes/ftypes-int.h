@@ -12,6 +12,20 @@
 #include <epan/proto.h>
 #include <epan/packet.h>
 
+/**
+ * @brief A string value whose decoding has been deferred.
+ *
+ * Set by fvalue_set_string_deferred(); the string is decoded from the
+ * tvbuff the first time the value is used. It is allocated separately,
+ * so that it doesn't make every fvalue_t bigger, and freed once decoded.
+ */
+typedef struct {
+	tvbuff_t *tvb;           /**< Tvbuff holding the undecoded string. */
+	unsigned offset;         /**< Offset of the string in the tvbuff. */
+	unsigned length;         /**< Length in bytes of the string in the tvbuff. */
+	unsigned encoding;       /**< ENC_ value to decode the string with. */
+} deferred_string_t;
+
 /**
  * @brief Represents a typed field value used in protocol dissection.
  *
@@ -27,6 +41,10 @@ struct _fvalue_t {
 		int64_t sinteger64;               /**< Signed 64-bit integer value. */
 		double floating;                  /**< Floating-point value. */
 		wmem_strbuf_t *strbuf;            /**< Pointer to a string buffer. */
+		struct {
+			wmem_strbuf_t *strbuf;        /**< Same storage as value.strbuf, NULL until decoded. */
+			deferred_string_t *deferred;  /**< String not yet decoded, NULL if there is none. */
+		} string;                         /**< String value that may not be decoded yet. */
 		GBytes *bytes;                    /**< Pointer to a byte array. */
 		ipv4_addr_and_mask ipv4;          /**< IPv4 address with subnet mask. */
 		ipv6_addr_and_prefix ipv6;        /**< IPv6 address with prefix length. */
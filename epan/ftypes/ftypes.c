@@ -1041,6 +1041,19 @@ fvalue_set_strbuf(fvalue_t *fv, wmem_strbuf_t *value)
 	fv->ftype->set_value.set_value_strbuf(fv, value);
 }
 
+void
+fvalue_set_string_deferred(fvalue_t *fv, tvbuff_t *tvb, unsigned offset, unsigned length, unsigned encoding)
+{
+	ws_assert(FT_IS_STRING(fv->ftype->ftype) && fv->ftype->ftype != FT_AX25);
+	fvalue_cleanup(fv);
+	fv->value.string.strbuf = NULL;
+	fv->value.string.deferred = g_new(deferred_string_t, 1);
+	fv->value.string.deferred->tvb = tvb;
+	fv->value.string.deferred->offset = offset;
+	fv->value.string.deferred->length = length;
+	fv->value.string.deferred->encoding = encoding;
+}
+
 void
 fvalue_set_protocol(fvalue_t *fv, tvbuff_t *value, const char *name, unsigned length)
 {
@@ -905,6 +905,23 @@ WS_DLL_PUBLIC
 void
 fvalue_set_strbuf(fvalue_t *fv, wmem_strbuf_t *value);
 
+/**
+ * @brief Set a string value that is decoded from a tvbuff only when first used.
+ *
+ * The bytes must already be known to be in the tvbuff, the encoding must
+ * be one that tvb_get_string_enc() decodes without throwing, and the
+ * tvbuff must outlive the fvalue_t.
+ *
+ * @param fv Pointer to the fvalue_t structure.
+ * @param tvb The tvbuff holding the string.
+ * @param offset Offset of the string in the tvbuff.
+ * @param length Length in bytes of the string.
+ * @param encoding ENC_ value to decode the string with.
+ */
+WS_DLL_PUBLIC
+void
+fvalue_set_string_deferred(fvalue_t *fv, tvbuff_t *tvb, unsigned offset, unsigned length, unsigned encoding);
+
 /**
  * @brief Set the protocol value for a field value.
  *
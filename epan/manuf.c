@@ -43,24 +43,6 @@ typedef struct {
 
 #include "manuf-data.c"
 
-static int
-compare_oui24_registry(const void *key, const void *element)
-{
-    const uint8_t *addr = (const uint8_t *)key;
-    const manuf_registry_t *entry = (const manuf_registry_t *)element;
-
-    return memcmp(addr, entry->oui24, 3);
-}
-
-static int
-compare_oui24_entry(const void *key, const void *element)
-{
-    const uint8_t *addr = (const uint8_t *)key;
-    const manuf_oui24_t *oui = (const manuf_oui24_t *)element;
-
-    return memcmp(addr, oui->oui24, 3);
-}
-
 static int
 compare_oui28_entry(const void *key, const void *element)
 {
@@ -81,42 +63,137 @@ compare_oui36_entry(const void *key, const void *element)
     return memcmp(addr, oui->oui36, 5);
 }
 
-static int
-select_registry(const uint8_t addr[6])
+/*
+ * Two-level direct index over the 24-bit prefixes of all three registries.
+ *
+ * The first level is indexed by the first two octets of the OUI and gives
+ * the range of slots for that 16-bit prefix; the second level is the sorted
+ * run of slots, each holding the third octet, the registry and the position
+ * of the first matching entry in the registry's table. Most 16-bit prefixes
+ * have only a handful of assignments, so a lookup is one load in the first
+ * level and a short scan of a single cache line in the second.
+ *
+ * The index is derived once from the sorted tables in manuf-data.c, so it
+ * can never disagree with them, whatever version of the generated file is
+ * compiled in.
+ */
+typedef struct {
+    uint8_t oui_lo;     /* Third octet of the OUI */
+    uint8_t kind;       /* MA_L, MA_M or MA_S */
+    uint16_t idx;       /* First entry with this prefix in the table for kind */
+} manuf_oui24_slot_t;
+
+#define MANUF_OUI24_SLOTS (G_N_ELEMENTS(global_manuf_oui24_table) + G_N_ELEMENTS(ieee_registry_table))
+
+G_STATIC_ASSERT(MANUF_OUI24_SLOTS <= UINT16_MAX);
+G_STATIC_ASSERT(G_N_ELEMENTS(global_manuf_oui28_table) <= UINT16_MAX);
+G_STATIC_ASSERT(G_N_ELEMENTS(global_manuf_oui36_table) <= UINT16_MAX);
+
+static uint16_t manuf_oui24_first[(1 << 16) + 1];
+static manuf_oui24_slot_t manuf_oui24_slots[MANUF_OUI24_SLOTS];
+
+static inline unsigned
+oui24_key(const uint8_t *oui)
+{
+    return (unsigned)oui[0] << 16 | (unsigned)oui[1] << 8 | oui[2];
+}
+
+static unsigned
+first_with_prefix(const uint8_t *table, size_t elem_size, size_t count, const uint8_t oui24[3])
 {
-    const manuf_registry_t *entry;
+    size_t lo = 0, hi = count;
+
+    /* Lower bound of the 24-bit prefix in a table sorted by address. */
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (memcmp(table + mid * elem_size, oui24, 3) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (unsigned)lo;
+}
+
+static void
+manuf_oui24_index_build(void)
+{
+    size_t i24 = 0, ireg = 0, nslots = 0;
+    unsigned prefix16 = 0;
+
+    /* Merge the MA-L table and the registry table, both sorted. */
+    while (i24 < G_N_ELEMENTS(global_manuf_oui24_table) || ireg < G_N_ELEMENTS(ieee_registry_table)) {
+        manuf_oui24_slot_t *slot = &manuf_oui24_slots[nslots];
+        const uint8_t *oui;
+
+        if (ireg == G_N_ELEMENTS(ieee_registry_table) ||
+                (i24 < G_N_ELEMENTS(global_manuf_oui24_table) &&
+                 memcmp(global_manuf_oui24_table[i24].oui24, ieee_registry_table[ireg].oui24, 3) < 0)) {
+            oui = global_manuf_oui24_table[i24].oui24;
+            slot->kind = MA_L;
+            slot->idx = (uint16_t)i24++;
+        }
+        else {
+            oui = ieee_registry_table[ireg].oui24;
+            slot->kind = ieee_registry_table[ireg++].kind;
+            if (slot->kind == MA_M)
+                slot->idx = first_with_prefix((const uint8_t *)global_manuf_oui28_table, sizeof(manuf_oui28_t),
+                                G_N_ELEMENTS(global_manuf_oui28_table), oui);
+            else
+                slot->idx = first_with_prefix((const uint8_t *)global_manuf_oui36_table, sizeof(manuf_oui36_t),
+                                G_N_ELEMENTS(global_manuf_oui36_table), oui);
+        }
+        slot->oui_lo = oui[2];
 
-    entry = bsearch(addr, ieee_registry_table, G_N_ELEMENTS(ieee_registry_table), sizeof(manuf_registry_t), compare_oui24_registry);
-    if (entry)
-        return entry->kind;
-    return MA_L;
+        while (prefix16 <= (oui24_key(oui) >> 8))
+            manuf_oui24_first[prefix16++] = (uint16_t)nslots;
+        nslots++;
+    }
+    while (prefix16 < G_N_ELEMENTS(manuf_oui24_first))
+        manuf_oui24_first[prefix16++] = (uint16_t)nslots;
 }
 
-static const manuf_oui24_t *
-manuf_oui24_lookup(const uint8_t addr[6])
+static const manuf_oui24_slot_t *
+manuf_oui24_slot_lookup(const uint8_t addr[6])
 {
-    return bsearch(addr, global_manuf_oui24_table,
-                    G_N_ELEMENTS(global_manuf_oui24_table),
-                    sizeof(manuf_oui24_t),
-                    compare_oui24_entry);
+    static gsize initialized;
+    unsigned prefix16 = (unsigned)addr[0] << 8 | addr[1];
+
+    if (g_once_init_enter(&initialized)) {
+        manuf_oui24_index_build();
+        g_once_init_leave(&initialized, 1);
+    }
+
+    for (unsigned i = manuf_oui24_first[prefix16]; i < manuf_oui24_first[prefix16 + 1]; i++) {
+        if (manuf_oui24_slots[i].oui_lo == addr[2])
+            return &manuf_oui24_slots[i];
+        if (manuf_oui24_slots[i].oui_lo > addr[2])
+            break;
+    }
+    return NULL;
 }
 
 static const manuf_oui28_t *
-manuf_oui28_lookup(const uint8_t addr[6])
+manuf_oui28_lookup(const uint8_t addr[6], const manuf_oui24_slot_t *slot)
 {
     const uint8_t addr28[6] = { addr[0], addr[1], addr[2], addr[3] & 0xF0, };
-    return bsearch(addr28, global_manuf_oui28_table,
-                    G_N_ELEMENTS(global_manuf_oui28_table),
+    size_t count = G_N_ELEMENTS(global_manuf_oui28_table) - slot->idx;
+
+    /* An MA-M block divides a 24-bit prefix into at most 16 assignments. */
+    return bsearch(addr28, &global_manuf_oui28_table[slot->idx],
+                    MIN(count, 16),
                     sizeof(manuf_oui28_t),
                     compare_oui28_entry);
 }
 
 static const manuf_oui36_t *
-manuf_oui36_lookup(const uint8_t addr[6])
+manuf_oui36_lookup(const uint8_t addr[6], const manuf_oui24_slot_t *slot)
 {
     const uint8_t addr36[6] = { addr[0], addr[1], addr[2], addr[3], addr[4] & 0xF0, };
-    return bsearch(addr36, global_manuf_oui36_table,
-                    G_N_ELEMENTS(global_manuf_oui36_table),
+    size_t count = G_N_ELEMENTS(global_manuf_oui36_table) - slot->idx;
+
+    /* An MA-S block divides a 24-bit prefix into at most 4096 assignments. */
+    return bsearch(addr36, &global_manuf_oui36_table[slot->idx],
+                    MIN(count, 4096),
                     sizeof(manuf_oui36_t),
                     compare_oui36_entry);
 }
@@ -132,20 +209,22 @@ ws_manuf_lookup(const uint8_t addr[6], const char **long_name_ptr, unsigned *mas
     const char *short_name = NULL, *long_name = NULL;
     unsigned mask = 0;
 
-    switch (select_registry(addr_copy)) {
+    const manuf_oui24_slot_t *slot = manuf_oui24_slot_lookup(addr_copy);
+    if (slot == NULL)
+        goto done;
+
+    switch (slot->kind) {
         case MA_L:
         {
-            const manuf_oui24_t *ptr = manuf_oui24_lookup(addr_copy);
-            if (ptr) {
-                short_name = ptr->short_name;
-                long_name = ptr->long_name;
-                mask = 24;
-            }
+            const manuf_oui24_t *ptr = &global_manuf_oui24_table[slot->idx];
+            short_name = ptr->short_name;
+            long_name = ptr->long_name;
+            mask = 24;
             break;
         }
         case MA_M:
         {
-            const manuf_oui28_t *ptr = manuf_oui28_lookup(addr_copy);
+            const manuf_oui28_t *ptr = manuf_oui28_lookup(addr_copy, slot);
             if (ptr) {
                 short_name = ptr->short_name;
                 long_name = ptr->long_name;
@@ -155,7 +234,7 @@ ws_manuf_lookup(const uint8_t addr[6], const char **long_name_ptr, unsigned *mas
         }
         case MA_S:
         {
-            const manuf_oui36_t *ptr = manuf_oui36_lookup(addr_copy);
+            const manuf_oui36_t *ptr = manuf_oui36_lookup(addr_copy, slot);
             if (ptr) {
                 short_name = ptr->short_name;
                 long_name = ptr->long_name;
@@ -167,6 +246,7 @@ ws_manuf_lookup(const uint8_t addr[6], const char **long_name_ptr, unsigned *mas
             ws_assert_not_reached();
     }
 
+done:
     if (mask_ptr) {
         *mask_ptr = mask;
     }
@@ -192,14 +272,16 @@ ws_manuf_lookup_oui24(const uint8_t oui[3], const char **long_name_ptr)
 
     const char *short_name = NULL, *long_name = NULL;
 
-    switch (select_registry(addr_copy)) {
+    const manuf_oui24_slot_t *slot = manuf_oui24_slot_lookup(addr_copy);
+    if (slot == NULL)
+        goto done;
+
+    switch (slot->kind) {
         case MA_L:
         {
-            const manuf_oui24_t *ptr = manuf_oui24_lookup(addr_copy);
-            if (ptr) {
-                short_name = ptr->short_name;
-                long_name = ptr->long_name;
-            }
+            const manuf_oui24_t *ptr = &global_manuf_oui24_table[slot->idx];
+            short_name = ptr->short_name;
+            long_name = ptr->long_name;
             break;
         }
         case MA_M:
@@ -215,6 +297,7 @@ ws_manuf_lookup_oui24(const uint8_t oui[3], const char **long_name_ptr)
             ws_assert_not_reached();
     }
 
+done:
     if (long_name_ptr) {
         *long_name_ptr = long_name;
     }
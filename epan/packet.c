@@ -33,6 +33,7 @@
 #include <epan/wmem_scopes.h>
 
 #include <epan/column-info.h>
+#include <epan/conversation.h>
 #include <epan/exceptions.h>
 #include <epan/reassemble.h>
 #include <epan/stream.h>
@@ -93,9 +94,20 @@ struct data_source {
  *
  * "protocol" is the protocol associated with the dissector table. Used
  * for determining dependencies.
+ *
+ * "uint_pages" is, for FT_UINT8 and FT_UINT16 tables, a two-level page
+ * table indexed by the high and low byte of the uint value, mirroring
+ * "hash_table" so that lookups done while dissecting are two array
+ * indexings instead of a hash lookup. Pages are allocated as entries are
+ * added; it is NULL for other tables and until the first entry is added.
  */
+#define DTBL_UINT_PAGE_BITS	8
+#define DTBL_UINT_PAGE_SIZE	(1 << DTBL_UINT_PAGE_BITS)
+#define DTBL_UINT_PAGES		(1 << (16 - DTBL_UINT_PAGE_BITS))
+
 struct dissector_table {
 	GHashTable	*hash_table;
+	dtbl_entry_t	***uint_pages;
 	GSList		*dissector_handles;
 	GHashTable	*da_descriptions;
 	const char	*ui_name;
@@ -194,6 +206,73 @@ static GHashTable *heur_dissector_lists;
 /* Name hashtables for fast detection of duplicate names */
 static GHashTable* heuristic_short_names;
 
+/* Registration sequence number of the next heuristic dissector */
+static unsigned heur_dissector_next_order;
+
+/*
+ * How one heuristic dissector of a list has done on the packets of one
+ * conversation, counted on the first pass only.
+ */
+typedef struct heur_conv_entry {
+	heur_dtbl_entry_t *entry;
+	uint32_t           first_hit;	/* frame of the first packet it accepted */
+	unsigned           hits;
+	unsigned           misses;
+} heur_conv_entry_t;
+
+/*
+ * The heuristic dissectors of a list that have accepted packets of a
+ * conversation, most hits first. They are tried, in that order, before
+ * the rest of the list for later frames of the conversation.
+ */
+typedef struct heur_conv_list {
+	heur_dissector_list_t  list;
+	heur_conv_entry_t     *entries;
+	unsigned               num_entries;
+	struct heur_conv_list *next;
+} heur_conv_list_t;
+
+/* conversation_t * -> heur_conv_list_t *, file scoped */
+static wmem_map_t *heur_conv_lists;
+
+static int
+heur_dtbl_entry_order_cmp(const void *a, const void *b)
+{
+	const heur_dtbl_entry_t *hdtbl_entry_a = (const heur_dtbl_entry_t *)a;
+	const heur_dtbl_entry_t *hdtbl_entry_b = (const heur_dtbl_entry_t *)b;
+
+	/* Newer registrations are prepended, so they come first. */
+	if (hdtbl_entry_a->order > hdtbl_entry_b->order)
+		return -1;
+	return hdtbl_entry_a->order < hdtbl_entry_b->order;
+}
+
+static void
+heur_dissector_list_reset(void *key _U_, void *value, void *user_data _U_)
+{
+	heur_dissector_list_t sub_dissectors = (heur_dissector_list_t)value;
+
+	for (GSList *entry = sub_dissectors->dissectors; entry != NULL; entry = entry->next) {
+		heur_dtbl_entry_t *hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
+		hdtbl_entry->hits = 0;
+		hdtbl_entry->misses = 0;
+		hdtbl_entry->conversations = 0;
+	}
+	sub_dissectors->dissectors = g_slist_sort(sub_dissectors->dissectors, heur_dtbl_entry_order_cmp);
+}
+
+/*
+ * Clear the hit counters and undo any reordering done while dissecting
+ * the previous file, so that the heuristics tried for a packet don't
+ * depend on what was dissected before.
+ */
+static void
+heur_dissector_lists_reset(void)
+{
+	if (heur_dissector_lists != NULL)
+		g_hash_table_foreach(heur_dissector_lists, heur_dissector_list_reset, NULL);
+}
+
 static void
 destroy_heuristic_dissector_entry(void *data)
 {
@@ -213,12 +292,73 @@ destroy_heuristic_dissector_list(void *data)
 	g_slice_free(struct heur_dissector_list, dissector_list);
 }
 
+static inline bool
+dtbl_uses_uint_pages(dissector_table_t sub_dissectors)
+{
+	return sub_dissectors->type == FT_UINT8 || sub_dissectors->type == FT_UINT16;
+}
+
+/* Record (or, with a NULL entry, forget) an entry in the page table. */
+static void
+dtbl_uint_pages_set(dissector_table_t sub_dissectors, const uint32_t pattern, dtbl_entry_t *dtbl_entry)
+{
+	dtbl_entry_t **page;
+
+	/* Out of range values of misregistered entries are only in the hash table. */
+	if (!dtbl_uses_uint_pages(sub_dissectors) || pattern > UINT16_MAX)
+		return;
+
+	if (sub_dissectors->uint_pages == NULL) {
+		if (dtbl_entry == NULL)
+			return;
+		sub_dissectors->uint_pages = g_new0(dtbl_entry_t **, DTBL_UINT_PAGES);
+	}
+
+	page = sub_dissectors->uint_pages[pattern >> DTBL_UINT_PAGE_BITS];
+	if (page == NULL) {
+		if (dtbl_entry == NULL)
+			return;
+		page = g_new0(dtbl_entry_t *, DTBL_UINT_PAGE_SIZE);
+		sub_dissectors->uint_pages[pattern >> DTBL_UINT_PAGE_BITS] = page;
+	}
+	page[pattern & (DTBL_UINT_PAGE_SIZE - 1)] = dtbl_entry;
+}
+
+static void
+dtbl_uint_pages_free(dissector_table_t sub_dissectors)
+{
+	if (sub_dissectors->uint_pages == NULL)
+		return;
+
+	for (unsigned i = 0; i < DTBL_UINT_PAGES; i++)
+		g_free(sub_dissectors->uint_pages[i]);
+	g_free(sub_dissectors->uint_pages);
+	sub_dissectors->uint_pages = NULL;
+}
+
+/* Rebuild the page table after entries were removed from the hash table in bulk. */
+static void
+dtbl_uint_pages_rebuild(dissector_table_t sub_dissectors)
+{
+	GHashTableIter iter;
+	void *key, *value;
+
+	if (!dtbl_uses_uint_pages(sub_dissectors))
+		return;
+
+	dtbl_uint_pages_free(sub_dissectors);
+	g_hash_table_iter_init(&iter, sub_dissectors->hash_table);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+		dtbl_uint_pages_set(sub_dissectors, GPOINTER_TO_UINT(key), (dtbl_entry_t *)value);
+}
+
 static void
 destroy_dissector_table(void *data)
 {
 	struct dissector_table *table = (struct dissector_table *)data;
 
 	g_hash_table_destroy(table->hash_table);
+	dtbl_uint_pages_free(table);
 	g_slist_free(table->dissector_handles);
 	if (table->da_descriptions)
 		g_hash_table_destroy(table->da_descriptions);
@@ -383,6 +523,10 @@ init_dissection(const char* app_env_var_prefix)
 	/* Initialize the table of conversations. */
 	epan_conversation_init();
 
+	/* Start every file with the heuristic dissectors in registration order. */
+	heur_dissector_lists_reset();
+	heur_conv_lists = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+
 	/* Initialize protocol-specific variables. */
 	g_slist_foreach(init_routines, &call_routine, NULL);
 
@@ -718,6 +862,13 @@ dissect_record(epan_dissect_t *edt, int file_type_subtype, wtap_rec *rec,
 		edt->pi.rel_cap_ts_present = true;
 	}
 
+	/*
+	 * In single-pass dissection, retire the conversations that
+	 * have been idle for too long before this frame looks any up.
+	 */
+	if (!fd->visited)
+		conversation_expire_idle(&edt->pi);
+
 	/*
 	 * If the block has been modified, use the modified block,
 	 * otherwise use the block from the file.
@@ -949,9 +1100,12 @@ call_dissector_through_handle(dissector_handle_t handle, tvbuff_t *tvb,
 	saved_proto = pinfo->current_proto;
 	saved_proto_layer_num = pinfo->curr_proto_layer_num;
 
-	if ((handle->protocol != NULL) && (!proto_is_bytes_pino(handle->protocol))) {
-		pinfo->current_proto =
-			proto_get_protocol_short_name(handle->protocol);
+	if (handle->protocol != NULL) {
+		proto_run_deferred_registration(handle->protocol);
+		if (!proto_is_bytes_pino(handle->protocol)) {
+			pinfo->current_proto =
+				proto_get_protocol_short_name(handle->protocol);
+		}
 	}
 
 	switch (handle->dissector_type) {
@@ -1260,6 +1414,12 @@ find_uint_dtbl_entry(dissector_table_t sub_dissectors, const uint32_t pattern)
 	/*
 	 * Find the entry.
 	 */
+	if (sub_dissectors->uint_pages != NULL && pattern <= UINT16_MAX) {
+		dtbl_entry_t **page = sub_dissectors->uint_pages[pattern >> DTBL_UINT_PAGE_BITS];
+
+		return page ? page[pattern & (DTBL_UINT_PAGE_SIZE - 1)] : NULL;
+	}
+
 	return (dtbl_entry_t *)g_hash_table_lookup(sub_dissectors->hash_table,
 				   GUINT_TO_POINTER(pattern));
 }
@@ -1344,6 +1504,7 @@ dissector_add_uint_real(const char *name _U_, const uint32_t pattern, dissector_
 	/* do the table insertion */
 	g_hash_table_insert(sub_dissectors->hash_table,
 			     GUINT_TO_POINTER(pattern), (void *)dtbl_entry);
+	dtbl_uint_pages_set(sub_dissectors, pattern, dtbl_entry);
 }
 
 /* Add an entry to a uint dissector table. */
@@ -1548,6 +1709,7 @@ dissector_delete_uint(const char *name, const uint32_t pattern,
 		/*
 		 * Found - remove it.
 		 */
+		dtbl_uint_pages_set(sub_dissectors, pattern, NULL);
 		g_hash_table_remove(sub_dissectors->hash_table,
 				    GUINT_TO_POINTER(pattern));
 	}
@@ -1620,7 +1782,8 @@ void dissector_delete_all(const char *name, dissector_handle_t handle)
 	dissector_table_t sub_dissectors = find_dissector_table(name);
 	ws_assert (sub_dissectors);
 
-	g_hash_table_foreach_remove (sub_dissectors->hash_table, dissector_delete_all_check, handle);
+	if (g_hash_table_foreach_remove (sub_dissectors->hash_table, dissector_delete_all_check, handle) > 0)
+		dtbl_uint_pages_rebuild(sub_dissectors);
 }
 
 static void
@@ -1631,7 +1794,8 @@ dissector_delete_from_table(void *key _U_, void *value, void *user_data)
 
 	dissector_handle_t handle = (dissector_handle_t) user_data;
 
-	g_hash_table_foreach_remove(sub_dissectors->hash_table, dissector_delete_all_check, user_data);
+	if (g_hash_table_foreach_remove(sub_dissectors->hash_table, dissector_delete_all_check, user_data) > 0)
+		dtbl_uint_pages_rebuild(sub_dissectors);
 	sub_dissectors->dissector_handles = g_slist_remove(sub_dissectors->dissector_handles, user_data);
 	if (sub_dissectors->da_descriptions)
 		g_hash_table_remove(sub_dissectors->da_descriptions, handle->description);
@@ -1665,6 +1829,7 @@ dissector_change_uint(const char *name, const uint32_t pattern, dissector_handle
 		 * to decode it, just remove the entry to save memory.
 		 */
 		if (handle == NULL && dtbl_entry->initial == NULL) {
+			dtbl_uint_pages_set(sub_dissectors, pattern, NULL);
 			g_hash_table_remove(sub_dissectors->hash_table,
 					    GUINT_TO_POINTER(pattern));
 			return;
@@ -1688,6 +1853,7 @@ dissector_change_uint(const char *name, const uint32_t pattern, dissector_handle
 	/* do the table insertion */
 	g_hash_table_insert(sub_dissectors->hash_table,
 			     GUINT_TO_POINTER(pattern), (void *)dtbl_entry);
+	dtbl_uint_pages_set(sub_dissectors, pattern, dtbl_entry);
 }
 
 /* Reset an entry in a uint dissector table to its initial value. */
@@ -1714,6 +1880,7 @@ dissector_reset_uint(const char *name, const uint32_t pattern)
 	if (dtbl_entry->initial != NULL) {
 		dtbl_entry->current = dtbl_entry->initial;
 	} else {
+		dtbl_uint_pages_set(sub_dissectors, pattern, NULL);
 		g_hash_table_remove(sub_dissectors->hash_table,
 				    GUINT_TO_POINTER(pattern));
 	}
@@ -2836,6 +3003,7 @@ register_dissector_table(const char *name, const char *ui_name, const int proto,
 		ws_error("The dissector table %s (%s) is registering an unsupported type - are you using a buggy plugin?", name, ui_name);
 		ws_assert_not_reached();
 	}
+	sub_dissectors->uint_pages = NULL;
 	sub_dissectors->dissector_handles = NULL;
 	sub_dissectors->da_descriptions = NULL;
 	sub_dissectors->ui_name = ui_name;
@@ -2863,6 +3031,7 @@ dissector_table_t register_custom_dissector_table(const char *name,
 							       key_destroy_func,
 							       &g_free);
 
+	sub_dissectors->uint_pages = NULL;
 	sub_dissectors->dissector_handles = NULL;
 	sub_dissectors->da_descriptions = NULL;
 	sub_dissectors->ui_name = ui_name;
@@ -3020,6 +3189,10 @@ heur_dissector_add(const char *name, heur_dissector_t dissector, const char *dis
 	hdtbl_entry->list_name = g_strdup(name);
 	hdtbl_entry->enabled   = (enable == HEURISTIC_ENABLE);
 	hdtbl_entry->enabled_by_default = (enable == HEURISTIC_ENABLE);
+	hdtbl_entry->order     = heur_dissector_next_order++;
+	hdtbl_entry->hits      = 0;
+	hdtbl_entry->misses    = 0;
+	hdtbl_entry->conversations = 0;
 
 	/* do the table insertion */
 	/* Ensure short_name is unique */
@@ -3078,24 +3251,220 @@ heur_dissector_delete(const char *name, heur_dissector_t dissector, const int pr
 	}
 }
 
+/*
+ * Move a heuristic dissector that just accepted a packet towards the
+ * front of its list, so that it is tried earlier next time.
+ *
+ * By default the entry goes to the very front. If the "order by hit rate"
+ * preference is set, it is placed in front of the first entry that has
+ * fewer hits, leaving entries with as many hits where they are, so the
+ * order only changes on the first pass when the counters do.
+ */
+static void
+heur_dissector_list_promote(heur_dissector_list_t sub_dissectors, heur_dtbl_entry_t *hdtbl_entry,
+			    GSList *entry, bool counted)
+{
+	GSList *sibling;
+
+	if (entry == NULL)
+		entry = g_slist_find(sub_dissectors->dissectors, hdtbl_entry);
+	if (entry == NULL || entry == sub_dissectors->dissectors)
+		return;
+
+	if (!prefs.heuristics_by_hit_rate) {
+		sub_dissectors->dissectors = g_slist_remove_link(sub_dissectors->dissectors, entry);
+		sub_dissectors->dissectors = g_slist_concat(entry, sub_dissectors->dissectors);
+		return;
+	}
+
+	if (!counted)
+		return;
+
+	for (sibling = sub_dissectors->dissectors; sibling != entry; sibling = sibling->next) {
+		if (((heur_dtbl_entry_t *)sibling->data)->hits < hdtbl_entry->hits)
+			break;
+	}
+	if (sibling == entry)
+		return;
+
+	sub_dissectors->dissectors = g_slist_delete_link(sub_dissectors->dissectors, entry);
+	sub_dissectors->dissectors = g_slist_insert_before(sub_dissectors->dissectors, sibling, hdtbl_entry);
+}
+
+static heur_conv_list_t *
+heur_conv_list_find(conversation_t *conv, heur_dissector_list_t sub_dissectors)
+{
+	heur_conv_list_t *conv_list;
+
+	if (conv == NULL || heur_conv_lists == NULL)
+		return NULL;
+
+	for (conv_list = (heur_conv_list_t *)wmem_map_lookup(heur_conv_lists, conv);
+	    conv_list != NULL; conv_list = conv_list->next) {
+		if (conv_list->list == sub_dissectors)
+			return conv_list;
+	}
+	return NULL;
+}
+
+/*
+ * Returns true if the heuristic dissector has already been tried for this
+ * packet from the conversation's list, i.e. before the rest of the list.
+ */
+static bool
+heur_conv_list_tried(const heur_conv_list_t *conv_list, const heur_dtbl_entry_t *hdtbl_entry,
+		     uint32_t frame)
+{
+	if (conv_list == NULL)
+		return false;
+
+	for (unsigned i = 0; i < conv_list->num_entries; i++) {
+		if (conv_list->entries[i].entry == hdtbl_entry)
+			return frame > conv_list->entries[i].first_hit;
+	}
+	return false;
+}
+
+/*
+ * Count a first-pass hit for a heuristic dissector in a conversation,
+ * adding it to the conversation's list if this is its first one, and
+ * move it in front of the entries that now have fewer hits. Entries
+ * with as many hits keep their place, so the order only depends on the
+ * packets seen and not on how often the file has been dissected.
+ */
+static void
+heur_conv_list_hit(conversation_t *conv, heur_dissector_list_t sub_dissectors,
+		   heur_dtbl_entry_t *hdtbl_entry, uint32_t frame)
+{
+	heur_conv_list_t  *conv_list;
+	heur_conv_entry_t  conv_entry;
+	unsigned           i;
+
+	if (conv == NULL || heur_conv_lists == NULL)
+		return;
+
+	conv_list = heur_conv_list_find(conv, sub_dissectors);
+	if (conv_list == NULL) {
+		conv_list = wmem_new0(wmem_file_scope(), heur_conv_list_t);
+		conv_list->list = sub_dissectors;
+		conv_list->next = (heur_conv_list_t *)wmem_map_lookup(heur_conv_lists, conv);
+		wmem_map_insert(heur_conv_lists, conv, conv_list);
+	}
+
+	for (i = 0; i < conv_list->num_entries; i++) {
+		if (conv_list->entries[i].entry == hdtbl_entry)
+			break;
+	}
+	if (i == conv_list->num_entries) {
+		conv_list->entries = (heur_conv_entry_t *)wmem_realloc(wmem_file_scope(), conv_list->entries,
+		    (conv_list->num_entries + 1) * sizeof(heur_conv_entry_t));
+		conv_list->entries[i].entry     = hdtbl_entry;
+		conv_list->entries[i].first_hit = frame;
+		conv_list->entries[i].hits      = 0;
+		conv_list->entries[i].misses    = 0;
+		conv_list->num_entries++;
+		hdtbl_entry->conversations++;
+	}
+	conv_list->entries[i].hits++;
+
+	conv_entry = conv_list->entries[i];
+	for (; i > 0 && conv_list->entries[i - 1].hits < conv_entry.hits; i--)
+		conv_list->entries[i] = conv_list->entries[i - 1];
+	conv_list->entries[i] = conv_entry;
+}
+
+/*
+ * Call a single heuristic dissector on behalf of dissector_try_heuristic().
+ * Returns the dissector's return value, having undone the layer it added
+ * if it rejected the packet.
+ */
+static int
+call_heur_dissector_entry(heur_dtbl_entry_t *hdtbl_entry, tvbuff_t *tvb,
+			  packet_info *pinfo, proto_tree *tree, void *data,
+			  uint16_t saved_can_desegment, unsigned saved_layers_len,
+			  unsigned saved_tree_count)
+{
+	int      proto_id;
+	int      len;
+	bool     consumed_none;
+	unsigned saved_desegment_len;
+
+	/* XXX - why set this now and above? */
+	pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
+
+	if (hdtbl_entry->protocol != NULL) {
+		proto_run_deferred_registration(hdtbl_entry->protocol);
+		proto_id = proto_get_id(hdtbl_entry->protocol);
+		/* do NOT change this behavior - wslua uses the protocol short name set here in order
+		   to determine which Lua-based heuristic dissector to call */
+		pinfo->current_proto =
+			proto_get_protocol_short_name(hdtbl_entry->protocol);
+
+		/*
+		 * Add the protocol name to the layers; we'll remove it
+		 * if the dissector fails.
+		 */
+		add_layer(pinfo, proto_id);
+	}
+
+	pinfo->heur_list_name = hdtbl_entry->list_name;
+
+	saved_desegment_len = pinfo->desegment_len;
+	len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
+	consumed_none = len == 0 || (pinfo->desegment_len != saved_desegment_len && pinfo->desegment_offset == 0);
+	if (hdtbl_entry->protocol != NULL &&
+		(consumed_none || (tree && saved_tree_count == tree->tree_data->count))) {
+		/*
+		 * We added a protocol layer above. The dissector
+		 * didn't consume any data or it didn't add any
+		 * items to the tree so remove it from the list.
+		 */
+		while (wmem_list_count(pinfo->layers) > saved_layers_len) {
+			/*
+			 * Only reduce the layer number if the dissector
+			 * didn't consume data. Since tree can be NULL on
+			 * the first pass, we cannot check it or it will
+			 * break dissectors that rely on a stable value.
+			 */
+			remove_last_layer(pinfo, consumed_none);
+		}
+	}
+
+	/* The counters describe the first pass only, so they add up to one try per packet. */
+	if (!PINFO_FD_VISITED(pinfo)) {
+		if (len)
+			hdtbl_entry->hits++;
+		else
+			hdtbl_entry->misses++;
+	}
+
+	return len;
+}
+
+static inline bool
+heur_dtbl_entry_is_enabled(const heur_dtbl_entry_t *hdtbl_entry)
+{
+	return hdtbl_entry->protocol == NULL ||
+		(proto_is_protocol_enabled(hdtbl_entry->protocol) && hdtbl_entry->enabled);
+}
+
 bool
 dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 			packet_info *pinfo, proto_tree *tree, heur_dtbl_entry_t **heur_dtbl_entry, void *data)
 {
-	bool               status;
-	const char        *saved_curr_proto;
-	int                saved_proto_layer_num;
-	const char        *saved_heur_list_name;
-	GSList            *entry;
-	GSList            *prev_entry = NULL;
-	uint16_t           saved_can_desegment;
-	unsigned           saved_layers_len = 0;
-	heur_dtbl_entry_t *hdtbl_entry;
-	int                proto_id;
-	int                len;
-	bool               consumed_none;
-	unsigned           saved_desegment_len;
-	unsigned           saved_tree_count = tree ? tree->tree_data->count : 0;
+	bool                status;
+	const char         *saved_curr_proto;
+	int                 saved_proto_layer_num;
+	const char         *saved_heur_list_name;
+	GSList             *entry;
+	uint16_t            saved_can_desegment;
+	unsigned            saved_layers_len = 0;
+	heur_dtbl_entry_t  *hdtbl_entry;
+	GSList             *matched_entry = NULL;
+	conversation_t     *conv = NULL;
+	heur_conv_list_t   *conv_list = NULL;
+	int                 len = 0;
+	unsigned            saved_tree_count = tree ? tree->tree_data->count : 0;
 
 	/* can_desegment is set to 2 by anyone which offers this api/service.
 	   then every time a subdissector is called it is decremented by one.
@@ -3120,72 +3489,66 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 
 	DISSECTOR_ASSERT(saved_layers_len < prefs.gui_max_tree_depth);
 
-	for (entry = sub_dissectors->dissectors; entry != NULL;
+	/*
+	 * Try the heuristic dissectors that accepted earlier frames of this
+	 * conversation first, most hits first. A dissector is only moved up
+	 * for frames after its first hit, so frames up to and including that
+	 * one are dissected as they were on the first pass. The conversation
+	 * isn't looked up until some conversation has such a list.
+	 */
+	if (heur_conv_lists != NULL && wmem_map_size(heur_conv_lists) > 0) {
+		conv = find_conversation_pinfo_ro(pinfo, 0);
+		conv_list = heur_conv_list_find(conv, sub_dissectors);
+	}
+	for (unsigned i = 0; conv_list != NULL && len == 0 && i < conv_list->num_entries; i++) {
+		heur_conv_entry_t *conv_entry = &conv_list->entries[i];
+
+		hdtbl_entry = conv_entry->entry;
+		if (pinfo->num <= conv_entry->first_hit || !heur_dtbl_entry_is_enabled(hdtbl_entry))
+			continue;
+
+		len = call_heur_dissector_entry(hdtbl_entry, tvb, pinfo, tree, data,
+		    saved_can_desegment, saved_layers_len, saved_tree_count);
+		if (len == 0 && !PINFO_FD_VISITED(pinfo))
+			conv_entry->misses++;
+	}
+
+	for (entry = sub_dissectors->dissectors; len == 0 && entry != NULL;
 	    entry = g_slist_next(entry)) {
-		/* XXX - why set this now and above? */
-		pinfo->can_desegment = saved_can_desegment-(saved_can_desegment>0);
 		hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
 
-		if (hdtbl_entry->protocol != NULL &&
-			(!proto_is_protocol_enabled(hdtbl_entry->protocol)||(hdtbl_entry->enabled==false))) {
+		if (!heur_dtbl_entry_is_enabled(hdtbl_entry) ||
+		    heur_conv_list_tried(conv_list, hdtbl_entry, pinfo->num)) {
 			/*
 			 * No - don't try this dissector.
 			 */
 			continue;
 		}
 
-		if (hdtbl_entry->protocol != NULL) {
-			proto_id = proto_get_id(hdtbl_entry->protocol);
-			/* do NOT change this behavior - wslua uses the protocol short name set here in order
-			   to determine which Lua-based heuristic dissector to call */
-			pinfo->current_proto =
-				proto_get_protocol_short_name(hdtbl_entry->protocol);
+		len = call_heur_dissector_entry(hdtbl_entry, tvb, pinfo, tree, data,
+		    saved_can_desegment, saved_layers_len, saved_tree_count);
+		if (len)
+			matched_entry = entry;
+	}
 
-			/*
-			 * Add the protocol name to the layers; we'll remove it
-			 * if the dissector fails.
-			 */
-			add_layer(pinfo, proto_id);
+	if (len) {
+		if (ws_log_msg_is_active(WS_LOG_DOMAIN, LOG_LEVEL_DEBUG)) {
+			ws_debug("Frame: %d | Layers: %s | Dissector: %s\n", pinfo->num, proto_list_layers(pinfo), hdtbl_entry->short_name);
 		}
 
-		pinfo->heur_list_name = hdtbl_entry->list_name;
+		*heur_dtbl_entry = hdtbl_entry;
 
-		saved_desegment_len = pinfo->desegment_len;
-		len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
-		consumed_none = len == 0 || (pinfo->desegment_len != saved_desegment_len && pinfo->desegment_offset == 0);
-		if (hdtbl_entry->protocol != NULL &&
-			(consumed_none || (tree && saved_tree_count == tree->tree_data->count))) {
-			/*
-			 * We added a protocol layer above. The dissector
-			 * didn't consume any data or it didn't add any
-			 * items to the tree so remove it from the list.
-			 */
-			while (wmem_list_count(pinfo->layers) > saved_layers_len) {
-				/*
-				 * Only reduce the layer number if the dissector
-				 * didn't consume data. Since tree can be NULL on
-				 * the first pass, we cannot check it or it will
-				 * break dissectors that rely on a stable value.
-				 */
-				remove_last_layer(pinfo, consumed_none);
-			}
-		}
-		if (len) {
-			if (ws_log_msg_is_active(WS_LOG_DOMAIN, LOG_LEVEL_DEBUG)) {
-				ws_debug("Frame: %d | Layers: %s | Dissector: %s\n", pinfo->num, proto_list_layers(pinfo), hdtbl_entry->short_name);
-			}
-
-			*heur_dtbl_entry = hdtbl_entry;
+		/* Bubble the matched entry towards the top for faster search next time. */
+		heur_dissector_list_promote(sub_dissectors, hdtbl_entry, matched_entry,
+		    !PINFO_FD_VISITED(pinfo));
 
-			/* Bubble the matched entry to the top for faster search next time. */
-			if (prev_entry != NULL) {
-				sub_dissectors->dissectors = g_slist_remove_link(sub_dissectors->dissectors, entry);
-				sub_dissectors->dissectors = g_slist_concat(entry, sub_dissectors->dissectors);
-			}
-			status = true;
-			break;
+		if (!PINFO_FD_VISITED(pinfo)) {
+			/* The dissector may have just created the conversation. */
+			if (conv == NULL)
+				conv = find_conversation_pinfo_ro(pinfo, 0);
+			heur_conv_list_hit(conv, sub_dissectors, hdtbl_entry, pinfo->num);
 		}
-		prev_entry = entry;
+		status = true;
 	}
 
 	pinfo->current_proto = saved_curr_proto;
@@ -676,6 +676,10 @@ typedef struct heur_dtbl_entry {
     char*            short_name;       /**< Internal unique identifier string used to distinguish this heuristic from others. */
     bool             enabled;          /**< Whether this heuristic dissector is currently enabled. */
     bool             enabled_by_default; /**< Whether this heuristic dissector is enabled by default upon registration. */
+    unsigned         order;            /**< Registration sequence number, used to restore the initial order of the list. */
+    unsigned         hits;             /**< Times this heuristic accepted a packet in the first pass over the current file. */
+    unsigned         misses;           /**< Times this heuristic rejected a packet in the first pass over the current file. */
+    unsigned         conversations;    /**< Conversations in which this heuristic accepted a packet in the first pass over the current file. */
 } heur_dtbl_entry_t;
 
 /** A protocol uses this function to register a heuristic sub-dissector list.
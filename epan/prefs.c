@@ -3951,6 +3951,12 @@ prefs_register_modules(void)
                                    "Currently ICMP and ICMPv6 use this preference to add VLAN ID to conversation tracking, and IPv4 uses this preference to take VLAN ID into account during reassembly",
                                    &prefs.strict_conversation_tracking_heuristics);
 
+    prefs_register_bool_preference(protocols_module, "heuristics_by_hit_rate",
+                                   "Order heuristic dissectors by hit rate",
+                                   "Try the heuristic dissectors of a list that accepted the most packets first, instead of the one that accepted the last packet. "
+                                   "Either way the order is reset for each capture file.",
+                                   &prefs.heuristics_by_hit_rate);
+
     prefs_register_bool_preference(protocols_module, "ignore_dup_frames",
                                    "Ignore duplicate frames",
                                    "Ignore frames that are exact duplicates of any previous frame.",
@@ -3967,6 +3973,30 @@ prefs_register_modules(void)
             "of cache entries to maintain. A 0 means no limit.",
             10, &prefs.ignore_dup_frames_cache_entries);
 
+    prefs_register_uint_preference(protocols_module, "reassembly_max_memory",
+            "Maximum memory for incomplete reassemblies (kB)",
+            "Limit the fragment data that each reassembly table keeps for incomplete "
+            "reassemblies. When it is exceeded, the least recently used incomplete "
+            "reassemblies are discarded. Meant for long-running live captures. "
+            "A 0 means no limit.",
+            10, &prefs.reassembly_max_memory);
+
+    prefs_register_uint_preference(protocols_module, "reassembly_max_age",
+            "Maximum age of incomplete reassemblies (seconds)",
+            "Discard incomplete reassemblies that haven't had a fragment added "
+            "for this many seconds of capture time. Meant for long-running live "
+            "captures. A 0 means no limit.",
+            10, &prefs.reassembly_max_age);
+
+    prefs_register_uint_preference(protocols_module, "conversation_idle_timeout",
+            "Retire idle conversations after (seconds)",
+            "When each packet is dissected only once, as in TShark without "
+            "two-pass analysis, retire conversations that haven't been seen "
+            "for this many seconds of capture time, along with the state "
+            "dissectors keep for them. Meant for long-running live captures. "
+            "A 0 means conversations are never retired.",
+            10, &prefs.conversation_idle_timeout);
+
 
     /* Obsolete preferences
      * These "modules" were reorganized/renamed to correspond to their GUI
@@ -4294,6 +4324,9 @@ prefs_set_global_defaults(wmem_allocator_t* pref_scope, const char** col_fmt, in
     prefs.display_abs_time_ascii = ABS_TIME_ASCII_TREE;
     prefs.ignore_dup_frames = false;
     prefs.ignore_dup_frames_cache_entries = 10000;
+    prefs.reassembly_max_memory = 0;
+    prefs.reassembly_max_age = 0;
+    prefs.conversation_idle_timeout = 0;
 
     /* set the default values for the io graph dialog */
     prefs.gui_io_graph_automatic_update = true;
@@ -318,6 +318,10 @@ typedef struct _e_prefs {
     bool          enable_incomplete_dissectors_check;  /**< If true, warn when a dissector does not consume all available data */
     bool          incomplete_dissectors_check_debug;   /**< If true, emit debug output for incomplete dissector checks */
     bool          strict_conversation_tracking_heuristics; /**< If true, apply stricter heuristics for conversation tracking */
+    bool          heuristics_by_hit_rate;              /**< If true, keep heuristic dissector lists ordered by number of hits */
+    unsigned      reassembly_max_memory;               /**< Limit in kilobytes on the fragment data of each table's incomplete reassemblies; 0 for none */
+    unsigned      reassembly_max_age;                  /**< Limit in seconds on the age of incomplete reassemblies; 0 for none */
+    unsigned      conversation_idle_timeout;           /**< Seconds after which idle conversations are retired in single-pass dissection; 0 for never */
     int           conversation_deinterlacing_key;      /**< Key bitmask controlling conversation deinterlacing behavior */
 
     /* Duplicate frame detection */
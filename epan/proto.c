@@ -420,6 +420,7 @@ struct _protocol {
 	                                   can be added to a dissector table, but use the
 	                                   parent_proto_id for things like enable/disable */
 	GList      *heur_list;          /* Heuristic dissectors associated with this protocol */
+	prefix_initializer_t deferred_fields; /* Registers the fields, if that hasn't been done yet */
 };
 
 /* List of all protocols */
@@ -439,20 +440,120 @@ static GPtrArray *deregistered_slice;
 /* indexed by prefix, contains initializers */
 static GHashTable* prefixes;
 
+/*
+ * Every item added to a tree needs a proto_node and usually a field_info.
+ * They are never freed one by one, only all together when the tree is
+ * reset after the packet, so they are carved sequentially out of chunks
+ * that the tree keeps from one packet to the next, rather than going
+ * through the general purpose packet scope allocator.
+ */
+#define PROTO_SLAB_CHUNK_ITEMS	256
+/* Chunks kept by proto_slab_reset(); any more are returned to the system. */
+#define PROTO_SLAB_KEEP_CHUNKS	16
+#define PROTO_SLAB_ALIGN(size)	(((size) + 15) & ~(size_t)15)
+
+typedef struct _proto_slab_chunk {
+	struct _proto_slab_chunk *next;
+} proto_slab_chunk_t;
+
+#define PROTO_SLAB_HEADER_SIZE	PROTO_SLAB_ALIGN(sizeof(proto_slab_chunk_t))
+
+struct _proto_slab {
+	size_t              item_size;
+	proto_slab_chunk_t *first;
+	proto_slab_chunk_t *current;	/* NULL until the first allocation */
+	unsigned            used;	/* items handed out from current */
+};
+
+static proto_slab_t *
+proto_slab_new(size_t item_size)
+{
+	proto_slab_t *slab = g_new(proto_slab_t, 1);
+
+	slab->item_size = (item_size + 7) & ~(size_t)7;
+	slab->first = NULL;
+	slab->current = NULL;
+	slab->used = PROTO_SLAB_CHUNK_ITEMS;
+
+	return slab;
+}
+
+static inline void *
+proto_slab_alloc(proto_slab_t *slab)
+{
+	if (G_UNLIKELY(slab->used == PROTO_SLAB_CHUNK_ITEMS)) {
+		proto_slab_chunk_t *chunk;
+
+		chunk = slab->current ? slab->current->next : slab->first;
+		if (chunk == NULL) {
+			chunk = (proto_slab_chunk_t *)g_malloc(PROTO_SLAB_HEADER_SIZE +
+					PROTO_SLAB_CHUNK_ITEMS * slab->item_size);
+			chunk->next = NULL;
+			if (slab->current)
+				slab->current->next = chunk;
+			else
+				slab->first = chunk;
+		}
+		slab->current = chunk;
+		slab->used = 0;
+	}
+
+	return (uint8_t *)slab->current + PROTO_SLAB_HEADER_SIZE +
+		slab->item_size * slab->used++;
+}
+
+static void
+proto_slab_free_chunks(proto_slab_chunk_t *chunk)
+{
+	while (chunk != NULL) {
+		proto_slab_chunk_t *next = chunk->next;
+		g_free(chunk);
+		chunk = next;
+	}
+}
+
+/* Release every item at once. */
+static void
+proto_slab_reset(proto_slab_t *slab)
+{
+	proto_slab_chunk_t *last = slab->first;
+
+	for (unsigned i = 1; last != NULL && i < PROTO_SLAB_KEEP_CHUNKS; i++)
+		last = last->next;
+	if (last != NULL) {
+		proto_slab_free_chunks(last->next);
+		last->next = NULL;
+	}
+
+	slab->current = NULL;
+	slab->used = PROTO_SLAB_CHUNK_ITEMS;
+}
+
+static void
+proto_slab_free(proto_slab_t *slab)
+{
+	proto_slab_free_chunks(slab->first);
+	g_free(slab);
+}
+
 /* Contains information about a field when a dissector calls
  * proto_tree_add_item.  */
-#define FIELD_INFO_NEW(pool, fi)  fi = wmem_new(pool, field_info)
-#define FIELD_INFO_FREE(pool, fi) wmem_free(pool, fi)
+#define FIELD_INFO_NEW(tree, fi) \
+	fi = PTREE_DATA(tree)->finfo_slab ? \
+		(field_info *)proto_slab_alloc(PTREE_DATA(tree)->finfo_slab) : \
+		wmem_new(PNODE_POOL(tree), field_info)
 
 /* Contains the space for proto_nodes. */
+#define PROTO_NODE_NEW(tree, node) \
+	node = PTREE_DATA(tree)->node_slab ? \
+		(proto_node *)proto_slab_alloc(PTREE_DATA(tree)->node_slab) : \
+		wmem_new(PNODE_POOL(tree), proto_node)
+
 #define PROTO_NODE_INIT(node)			\
 	node->first_child = NULL;		\
 	node->last_child = NULL;		\
 	node->next = NULL;
 
-#define PROTO_NODE_FREE(pool, node)			\
-	wmem_free(pool, node)
-
 /* String space for protocol and field items for the GUI */
 #define ITEM_LABEL_NEW(pool, il)			\
 	il = wmem_new(pool, item_label_t);		\
@@ -957,6 +1058,12 @@ proto_tree_reset(proto_tree *tree)
 	tree_data->max_start = 0;
 	tree_data->start_idle_count = 0;
 
+	/* The nodes and field_infos of the tree are all gone now */
+	if (tree_data->node_slab) {
+		proto_slab_reset(tree_data->node_slab);
+		proto_slab_reset(tree_data->finfo_slab);
+	}
+
 	PROTO_NODE_INIT(tree);
 }
 
@@ -978,6 +1085,11 @@ proto_tree_free(proto_tree *tree)
 		g_hash_table_destroy(tree_data->interesting_hfids);
 	}
 
+	if (tree_data->node_slab) {
+		proto_slab_free(tree_data->node_slab);
+		proto_slab_free(tree_data->finfo_slab);
+	}
+
 	g_slice_free(tree_data_t, tree_data);
 
 	g_slice_free(proto_tree, tree);
@@ -997,6 +1109,25 @@ proto_tree_set_visible(proto_tree *tree, bool visible)
 	return old_visible;
 }
 
+void
+proto_tree_set_slabs(proto_tree *tree, bool slabs)
+{
+	tree_data_t *tree_data = PTREE_DATA(tree);
+
+	/* Items already in the tree may live in the slabs */
+	ws_assert(tree->first_child == NULL);
+
+	if (slabs && tree_data->node_slab == NULL) {
+		tree_data->node_slab = proto_slab_new(sizeof(proto_node));
+		tree_data->finfo_slab = proto_slab_new(sizeof(field_info));
+	} else if (!slabs && tree_data->node_slab != NULL) {
+		proto_slab_free(tree_data->node_slab);
+		proto_slab_free(tree_data->finfo_slab);
+		tree_data->node_slab = NULL;
+		tree_data->finfo_slab = NULL;
+	}
+}
+
 void
 proto_tree_set_fake_protocols(proto_tree *tree, bool fake_protocols)
 {
@@ -1004,6 +1135,13 @@ proto_tree_set_fake_protocols(proto_tree *tree, bool fake_protocols)
 		PTREE_DATA(tree)->fake_protocols = fake_protocols;
 }
 
+void
+proto_tree_set_deferred_strings(proto_tree *tree, bool deferred_strings)
+{
+	if (tree)
+		PTREE_DATA(tree)->deferred_strings = deferred_strings;
+}
+
 /* Assume dissector set only its protocol fields.
    This function is called by dissectors and allows the speeding up of filtering
    in wireshark; if this function returns false it is safe to reset tree to NULL
@@ -1115,6 +1253,48 @@ proto_initialize_all_prefixes(void) {
 	g_hash_table_foreach_remove(prefixes, initialize_prefix, NULL);
 }
 
+/* Prefix initializer for protocols registered with
+ * proto_register_fields_deferred(); match is either the protocol's
+ * filter name or the name of one of its fields. */
+static void
+initialize_deferred_fields(const char *match)
+{
+	const char *dot = strchr(match, '.');
+	char       *filter_name = dot ? g_strndup(match, dot - match) : g_strdup(match);
+	protocol_t *protocol = find_protocol_by_id(proto_get_id_by_filter_name(filter_name));
+	prefix_initializer_t pi;
+
+	g_free(filter_name);
+	if (protocol == NULL || protocol->deferred_fields == NULL)
+		return;
+
+	/* Clear it first, in case the initializer looks up one of its own fields. */
+	pi = protocol->deferred_fields;
+	protocol->deferred_fields = NULL;
+	pi(protocol->filter_name);
+}
+
+void
+proto_register_fields_deferred(const int proto_id, prefix_initializer_t initializer)
+{
+	protocol_t *protocol = find_protocol_by_id(proto_id);
+
+	DISSECTOR_ASSERT(protocol != NULL && protocol->fields == NULL);
+
+	protocol->deferred_fields = initializer;
+	proto_register_prefix(protocol->filter_name, initialize_deferred_fields);
+}
+
+void
+proto_run_deferred_registration(protocol_t *protocol)
+{
+	if (protocol->deferred_fields == NULL)
+		return;
+
+	initialize_deferred_fields(protocol->filter_name);
+	g_hash_table_remove(prefixes, protocol->filter_name);
+}
+
 /* Finds a record in the hfinfo array by name.
  * If it fails to find it in the already registered fields,
  * it tries to find and call an initializer in the prefixes
@@ -2900,6 +3080,83 @@ detect_trailing_stray_characters(unsigned encoding, const char *string, int leng
 	}
 }
 
+/* Same check as detect_trailing_stray_characters(), for a string whose
+ * value has been deferred, on the bytes in the tvbuff. */
+static void
+detect_trailing_stray_bytes(unsigned encoding, tvbuff_t *tvb, unsigned start, unsigned length, proto_item *pi)
+{
+	const uint8_t *bytes;
+	unsigned i;
+
+	switch (encoding & ENC_CHARENCODING_MASK) {
+		case ENC_ASCII:
+		case ENC_UTF_8:
+			break;
+
+		default:
+			return;
+	}
+
+	bytes = tvb_get_ptr(tvb, start, length);
+	for (i = 0; i < length && bytes[i] != '\0'; i++)
+		;
+	for (; i < length; i++) {
+		if (bytes[i] != '\0') {
+			expert_add_info(NULL, pi, &ei_string_trailing_characters);
+			return;
+		}
+	}
+}
+
+/*
+ * If the tree defers string values, record where a counted string is
+ * rather than decoding it; see proto_tree_set_deferred_strings(). Only
+ * single byte and UTF-8 encodings, for which decoding can't fail once
+ * the bytes are known to be there, are deferred.
+ *
+ * The value points into a tvbuff until it's decoded, and dissectors free
+ * temporary tvbuffs before the tree goes away, so the string is deferred
+ * only if its bytes are in one of the packet's data sources, which live
+ * as long as the tree does; the value refers to the data source rather
+ * than to the tvbuff it was added with.
+ */
+static bool
+set_string_deferred(proto_tree *tree, field_info *fi, tvbuff_t *tvb,
+    unsigned start, int length, unsigned *ret_length, const unsigned encoding)
+{
+	tvbuff_t *ds_tvb;
+
+	if (!PTREE_DATA(tree)->deferred_strings)
+		return false;
+
+	ds_tvb = tvb_get_ds_tvb(tvb);
+	if (ds_tvb == NULL ||
+	    get_data_source_by_tvb(PTREE_DATA(tree)->pinfo, ds_tvb) == NULL)
+		return false;
+
+	switch (encoding & ENC_CHARENCODING_MASK) {
+		case ENC_ASCII:
+		case ENC_UTF_8:
+		case ENC_ISO_8859_1:
+			break;
+
+		default:
+			return false;
+	}
+
+	/* Throw now any exception that decoding would have thrown. */
+	if (length == -1) {
+		*ret_length = tvb_ensure_captured_length_remaining(tvb, start);
+	} else {
+		tvb_ensure_bytes_exist(tvb, start, length);
+		*ret_length = length;
+	}
+
+	start += tvb_raw_offset(tvb) - tvb_raw_offset(ds_tvb);
+	fvalue_set_string_deferred(fi->value, ds_tvb, start, *ret_length, encoding);
+	return true;
+}
+
 /* Add an item to a proto_tree, using the text label registered to that item;
    the item is extracted from the tvbuff handed to it. */
 static proto_item *
@@ -3203,9 +3460,12 @@ proto_tree_new_item(field_info *new_fi, proto_tree *tree,
 			break;
 
 		case FT_STRING:
-			stringval = (const char*)get_string_value(PNODE_POOL(tree),
-			    tvb, start, length, &item_length, encoding);
-			proto_tree_set_string(new_fi, stringval);
+			if (!set_string_deferred(tree, new_fi, tvb, start,
+			    length, &item_length, encoding)) {
+				stringval = (const char*)get_string_value(PNODE_POOL(tree),
+				    tvb, start, length, &item_length, encoding);
+				proto_tree_set_string(new_fi, stringval);
+			}
 
 			/* Instead of calling proto_item_set_len(), since we
 			 * don't yet have a proto_item, we set the
@@ -3268,9 +3528,12 @@ proto_tree_new_item(field_info *new_fi, proto_tree *tree,
 			break;
 
 		case FT_STRINGZPAD:
-			stringval = (const char*)get_stringzpad_value(PNODE_POOL(tree),
-			    tvb, start, length, &item_length, encoding);
-			proto_tree_set_string(new_fi, stringval);
+			if (!set_string_deferred(tree, new_fi, tvb, start,
+			    length, &item_length, encoding)) {
+				stringval = (const char*)get_stringzpad_value(PNODE_POOL(tree),
+				    tvb, start, length, &item_length, encoding);
+				proto_tree_set_string(new_fi, stringval);
+			}
 
 			/* Instead of calling proto_item_set_len(), since we
 			 * don't yet have a proto_item, we set the
@@ -3285,9 +3548,12 @@ proto_tree_new_item(field_info *new_fi, proto_tree *tree,
 			break;
 
 		case FT_STRINGZTRUNC:
-			stringval = (const char*)get_stringztrunc_value(PNODE_POOL(tree),
-			    tvb, start, length, &item_length, encoding);
-			proto_tree_set_string(new_fi, stringval);
+			if (!set_string_deferred(tree, new_fi, tvb, start,
+			    length, &item_length, encoding)) {
+				stringval = (const char*)get_stringztrunc_value(PNODE_POOL(tree),
+				    tvb, start, length, &item_length, encoding);
+				proto_tree_set_string(new_fi, stringval);
+			}
 
 			/* Instead of calling proto_item_set_len(), since we
 			 * don't yet have a proto_item, we set the
@@ -3399,7 +3665,10 @@ proto_tree_new_item(field_info *new_fi, proto_tree *tree,
 	         * can also do so (and for UTF-8 possibly even make the
 	         * string _shorter_).
 	         */
-		detect_trailing_stray_characters(encoding, stringval, item_length, pi);
+		if (stringval)
+			detect_trailing_stray_characters(encoding, stringval, item_length, pi);
+		else
+			detect_trailing_stray_bytes(encoding, tvb, start, item_length, pi);
 		break;
 
 	default:
@@ -6643,7 +6912,7 @@ proto_tree_add_fake_node(proto_tree *tree, const header_field_info *hfinfo)
 		/* XXX - is it safe to continue here? */
 	}
 
-	pnode = wmem_new(PNODE_POOL(tree), proto_node);
+	PROTO_NODE_NEW(tree, pnode);
 	PROTO_NODE_INIT(pnode);
 	pnode->parent = tnode;
 	PNODE_HFINFO(pnode) = hfinfo;
@@ -6723,7 +6992,7 @@ proto_tree_add_node(proto_tree *tree, field_info *fi)
 		/* XXX - is it safe to continue here? */
 	}
 
-	pnode = wmem_new(PNODE_POOL(tree), proto_node);
+	PROTO_NODE_NEW(tree, pnode);
 	PROTO_NODE_INIT(pnode);
 	pnode->parent = tnode;
 	PNODE_HFINFO(pnode) = fi->hfinfo;
@@ -7134,7 +7403,7 @@ new_field_info(proto_tree *tree, header_field_info *hfinfo, tvbuff_t *tvb,
 {
 	field_info *fi;
 
-	FIELD_INFO_NEW(PNODE_POOL(tree), fi);
+	FIELD_INFO_NEW(tree, fi);
 
 	fi->hfinfo     = hfinfo;
 	fi->start      = start;
@@ -8327,6 +8596,9 @@ proto_tree_create_root(packet_info *pinfo)
 	/* Make sure that we fake protocols (if possible) */
 	pnode->tree_data->fake_protocols = true;
 
+	/* Decode string values as they are added */
+	pnode->tree_data->deferred_strings = false;
+
 	/* Keep track of the number of children */
 	pnode->tree_data->count = 0;
 
@@ -8335,6 +8607,9 @@ proto_tree_create_root(packet_info *pinfo)
 	pnode->tree_data->max_start = 0;
 	pnode->tree_data->start_idle_count = 0;
 
+	pnode->tree_data->node_slab = proto_slab_new(sizeof(proto_node));
+	pnode->tree_data->finfo_slab = proto_slab_new(sizeof(field_info));
+
 	return (proto_tree *)pnode;
 }
 
@@ -8624,6 +8899,7 @@ proto_register_protocol(const char *name, const char *short_name,
 	protocol->can_toggle = true;
 	protocol->parent_proto_id = -1;
 	protocol->heur_list = NULL;
+	protocol->deferred_fields = NULL;
 
 	/* List will be sorted later by name, when all protocols completed registering */
 	protocols = g_list_prepend(protocols, protocol);
@@ -8700,6 +8976,7 @@ proto_register_protocol_in_name_only(const char *name, const char *short_name, c
 
 	protocol->parent_proto_id = parent_proto;
 	protocol->heur_list = NULL;
+	protocol->deferred_fields = NULL;
 
 	/* List will be sorted later by name, when all protocols completed registering */
 	protocols = g_list_prepend(protocols, protocol);
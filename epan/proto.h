@@ -897,17 +897,23 @@ typedef struct
 #define FI_GET_BITS_OFFSET(fi) (FI_GET_FLAG(fi, FI_BITS_OFFSET(63)) >> 5)
 #define FI_GET_BITS_SIZE(fi)   (FI_GET_FLAG(fi, FI_BITS_SIZE(63)) >> 12)
 
+/** Fixed-size allocator for the proto_node and field_info of a tree. */
+typedef struct _proto_slab proto_slab_t;
+
 /** One of these exists for the entire protocol tree. Each proto_node
  * in the protocol tree points to the same copy. */
 typedef struct {
     GHashTable          *interesting_hfids;
     bool                 visible;
     bool                 fake_protocols;
+    bool                 deferred_strings;
     unsigned             count;
     struct _packet_info *pinfo;
     tvbuff_t            *idle_count_ds_tvb;
     unsigned             max_start;
     unsigned             start_idle_count;
+    proto_slab_t        *node_slab;   /**< proto_nodes, released by proto_tree_reset() */
+    proto_slab_t        *finfo_slab;  /**< field_infos, released by proto_tree_reset() */
 } tree_data_t;
 
 /** Each proto_tree, proto_item is one of these. */
@@ -1340,7 +1346,7 @@ WS_DLL_PUBLIC proto_tree *proto_tree_create_root(packet_info *pinfo);
  *
  * @param tree The protocol tree to reset. Must not be NULL.
  */
-void proto_tree_reset(proto_tree *tree);
+WS_DLL_PUBLIC void proto_tree_reset(proto_tree *tree);
 
 /**
  * @brief Free a protocol tree and all of its nodes.
@@ -1359,12 +1365,32 @@ WS_DLL_PUBLIC void proto_tree_free(proto_tree *tree);
 WS_DLL_PUBLIC bool
 proto_tree_set_visible(proto_tree *tree, bool visible);
 
+/** Indicate whether the nodes and field_infos of the tree are allocated from
+ slabs owned by the tree (default = true) or from pinfo->pool. Only useful to
+ measure what the slabs gain. Must be called while the tree is empty.
+ @param tree the tree to be set
+ @param slabs true to allocate from the tree's slabs */
+WS_DLL_PUBLIC void
+proto_tree_set_slabs(proto_tree *tree, bool slabs);
+
 /** Indicate whether we should fake protocols during dissection (default = true)
  @param tree the tree to be set
  @param fake_protocols true if we should fake protocols */
 extern void
 proto_tree_set_fake_protocols(proto_tree *tree, bool fake_protocols);
 
+/** Indicate whether counted string values (FT_STRING, FT_STRINGZPAD and
+ FT_STRINGZTRUNC in ASCII, UTF-8 or ISO 8859-1) added with
+ proto_tree_add_item() are only decoded when first used (default = false).
+ Worthwhile for trees of which only a part is looked at, e.g. in the GUI.
+ Only strings in one of the packet's data sources, which live as long as
+ the tree does, are deferred; strings in temporary tvbuffs are decoded
+ right away.
+ @param tree the tree to be set
+ @param deferred_strings true to defer decoding string values */
+extern void
+proto_tree_set_deferred_strings(proto_tree *tree, bool deferred_strings);
+
 /** Mark a field/protocol ID as "interesting".
  * That means that we don't fake the item (because we are filtering on it),
  * and we mark its parent protocol (if any) as being indirectly referenced
@@ -2936,6 +2962,34 @@ typedef void (*prefix_initializer_t)(const char* match);
 WS_DLL_PUBLIC void
 proto_register_prefix(const char *prefix,  prefix_initializer_t initializer);
 
+/** Delay the registration of a protocol's fields, subtrees and expert
+    infos until they are first needed, which saves startup time and memory
+    for protocols that a capture doesn't contain.
+    The initializer is called, with the protocol's filter name as argument,
+    when one of the protocol's fields is looked up by name (as by
+    proto_registrar_get_byname() and display filters), when
+    proto_initialize_all_prefixes() is called, or right before one of the
+    protocol's dissectors is first called through a handle or as a
+    heuristic dissector. Protocols whose fields are used in any other way
+    before that, e.g. by a dissector of another protocol or by a tap
+    registered at startup, must not use this.
+    Code that lists the fields of every protocol, such as field name
+    completion, must call proto_initialize_all_prefixes() first.
+    Expert infos should still be registered from the protocol's register
+    routine, after this call, as the expert info severity table looks them
+    up when preferences are read.
+@param proto_id the protocol, which must not have registered any fields yet
+@param initializer function that registers the protocol's fields */
+WS_DLL_PUBLIC void
+proto_register_fields_deferred(const int proto_id, prefix_initializer_t initializer);
+
+/** Run the initializer passed to proto_register_fields_deferred() for
+    this protocol, if it hasn't run yet. Called by the dissector handle
+    machinery before calling one of the protocol's dissectors.
+@param protocol the protocol */
+extern void
+proto_run_deferred_registration(protocol_t *protocol);
+
 /** Initialize every remaining uninitialized prefix. */
 WS_DLL_PUBLIC void proto_initialize_all_prefixes(void);
 
@@ -10,6 +10,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 
 #include <epan/wmem_scopes.h>
@@ -26,78 +28,167 @@ typedef struct _proto_data {
   void *proto_data;
 } proto_data_t;
 
-static int
-p_compare(const void *a, const void *b)
+/* Number of entries stored in the list itself. */
+#define PROTO_DATA_INLINE_ENTRIES 4
+
+/* Number of entries above which lookups go through a hash index. */
+#define PROTO_DATA_HASH_THRESHOLD 8
+
+/* The protocol data of a frame or a packet. Dissectors look entries up
+   several times per packet, so rather than a linked list this is an array,
+   in the order the entries were added, that starts out inside the structure.
+   Short lists are searched from the newest entry, so the most recently added
+   entry for a protocol and key is found; longer ones get an open addressing
+   index of the entries keyed on the protocol and key. */
+struct _proto_data_list {
+  wmem_allocator_t *scope;
+  proto_data_t *entries;        /* inline_entries, or an array from scope */
+  unsigned      count;
+  unsigned      size;
+  unsigned     *index;          /* entry number + 1, or 0 for an empty slot */
+  unsigned      index_mask;
+  proto_data_t  inline_entries[PROTO_DATA_INLINE_ENTRIES];
+};
+
+static inline unsigned
+p_hash(int proto, uint32_t key)
+{
+  uint32_t h = ((uint32_t)proto * 0x9e3779b1U) ^ key;
+
+  h ^= h >> 16;
+  h *= 0x85ebca6bU;
+  h ^= h >> 13;
+  return h;
+}
+
+static void
+p_index_insert(struct _proto_data_list *list, unsigned entry)
 {
-  const proto_data_t *ap = (const proto_data_t *)a;
-  const proto_data_t *bp = (const proto_data_t *)b;
-
-  if (ap -> proto > bp -> proto) {
-    return 1;
-  } else if (ap -> proto == bp -> proto) {
-    if (ap->key > bp->key){
-      return 1;
-    } else if (ap -> key == bp -> key) {
-      return 0;
+  const proto_data_t *pd = &list->entries[entry];
+  unsigned slot = p_hash(pd->proto, pd->key) & list->index_mask;
+
+  while (list->index[slot] != 0) {
+    const proto_data_t *other = &list->entries[list->index[slot] - 1];
+
+    if (other->proto == pd->proto && other->key == pd->key) {
+      /* The newer entry hides the older one. */
+      break;
     }
-    return -1;
-  } else {
-    return -1;
+    slot = (slot + 1) & list->index_mask;
   }
+  list->index[slot] = entry + 1;
+}
+
+/* (Re)build the index after the entries were reallocated or removed. */
+static void
+p_index_rebuild(struct _proto_data_list *list)
+{
+  unsigned i;
+
+  if (list->index) {
+    wmem_free(list->scope, list->index);
+    list->index = NULL;
+  }
+  if (list->count <= PROTO_DATA_HASH_THRESHOLD)
+    return;
+
+  /* At most half full. */
+  list->index_mask = 2 * list->size - 1;
+  list->index = wmem_alloc0_array(list->scope, unsigned, 2 * list->size);
+  for (i = 0; i < list->count; i++)
+    p_index_insert(list, i);
+}
+
+static proto_data_t *
+p_find(const struct _proto_data_list *list, int proto, uint32_t key)
+{
+  unsigned i;
+
+  if (list->index) {
+    unsigned slot = p_hash(proto, key) & list->index_mask;
+
+    while (list->index[slot] != 0) {
+      proto_data_t *pd = &list->entries[list->index[slot] - 1];
+
+      if (pd->proto == proto && pd->key == key)
+        return pd;
+      slot = (slot + 1) & list->index_mask;
+    }
+    return NULL;
+  }
+
+  for (i = list->count; i-- > 0; ) {
+    proto_data_t *pd = &list->entries[i];
+
+    if (pd->proto == proto && pd->key == key)
+      return pd;
+  }
+  return NULL;
+}
+
+static struct _proto_data_list **
+p_get_list(wmem_allocator_t *scope, struct _packet_info* pinfo)
+{
+  if (scope == pinfo->pool)
+    return &pinfo->proto_data;
+
+  DISSECTOR_ASSERT(scope == wmem_file_scope() && "invalid wmem scope");
+  return &pinfo->fd->pfd;
 }
 
 void
 p_add_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, uint32_t key, void *proto_data)
 {
-  proto_data_t     *p1;
-  wmem_list_t     **proto_list;
-
-  if (scope == pinfo->pool) {
-    proto_list = &pinfo->proto_data;
-  } else if (scope == wmem_file_scope()) {
-    proto_list = &pinfo->fd->pfd;
-  } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
+  struct _proto_data_list **proto_list = p_get_list(scope, pinfo);
+  struct _proto_data_list *list = *proto_list;
+  proto_data_t *p1;
+
+  if (list == NULL) {
+    list = wmem_new(scope, struct _proto_data_list);
+    list->scope = scope;
+    list->entries = list->inline_entries;
+    list->count = 0;
+    list->size = PROTO_DATA_INLINE_ENTRIES;
+    list->index = NULL;
+    list->index_mask = 0;
+    *proto_list = list;
   }
 
-  if (*proto_list == NULL) {
-    *proto_list = wmem_list_new(scope);
+  if (list->count == list->size) {
+    proto_data_t *entries = wmem_alloc_array(scope, proto_data_t, 2 * list->size);
+
+    memcpy(entries, list->entries, list->count * sizeof(proto_data_t));
+    if (list->entries != list->inline_entries)
+      wmem_free(scope, list->entries);
+    list->entries = entries;
+    list->size *= 2;
+    if (list->index) {
+      wmem_free(scope, list->index);
+      list->index = NULL;
+    }
   }
 
-  p1 = wmem_new(scope, proto_data_t);
-
+  p1 = &list->entries[list->count++];
   p1->proto = proto;
   p1->key = key;
   p1->proto_data = proto_data;
 
-  /* Add it to the list */
-  wmem_list_prepend(*proto_list, p1);
+  /* Add it to the index */
+  if (list->index)
+    p_index_insert(list, list->count - 1);
+  else if (list->count > PROTO_DATA_HASH_THRESHOLD)
+    p_index_rebuild(list);
 }
 
 void
 p_set_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, uint32_t key, void *proto_data)
 {
   /* Probably more dissectors should use this instead of p_add_proto_data. */
-  proto_data_t  temp;
-  wmem_list_t  *proto_list;
-  wmem_list_frame_t *item;
-
-  temp.proto = proto;
-  temp.key = key;
-  temp.proto_data = NULL;
-
-  if (scope == pinfo->pool) {
-    proto_list = pinfo->proto_data;
-  } else if (scope == wmem_file_scope()) {
-    proto_list = pinfo->fd->pfd;
-  } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
-  }
+  struct _proto_data_list *list = *p_get_list(scope, pinfo);
 
-  if (proto_list) {
-    item = wmem_list_find_custom(proto_list, &temp, p_compare);
-    if (item) {
-      proto_data_t *pd = (proto_data_t*)wmem_list_frame_data(item);
+  if (list) {
+    proto_data_t *pd = p_find(list, proto, key);
+    if (pd) {
       pd->proto_data = proto_data;
       return;
     }
@@ -109,31 +200,15 @@ p_set_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto,
 void *
 p_get_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, uint32_t key)
 {
-  proto_data_t  temp, *p1;
-  wmem_list_t  *proto_list;
-  wmem_list_frame_t *item;
-
-  temp.proto = proto;
-  temp.key = key;
-  temp.proto_data = NULL;
-
-  if (scope == pinfo->pool) {
-    proto_list = pinfo->proto_data;
-  } else if (scope == wmem_file_scope()) {
-    proto_list = pinfo->fd->pfd;
-  } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
-  }
+  struct _proto_data_list *list = *p_get_list(scope, pinfo);
+  proto_data_t *p1;
 
-  if (!proto_list)
+  if (!list)
     return NULL;
 
-  item = wmem_list_find_custom(proto_list, &temp, p_compare);
-
-  if (item) {
-    p1 = wmem_list_frame_data(item);
+  p1 = p_find(list, proto, key);
+  if (p1)
     return p1->proto_data;
-  }
 
   return NULL;
 }
@@ -141,54 +216,38 @@ p_get_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto,
 void
 p_remove_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, uint32_t key)
 {
-  proto_data_t  temp;
-  wmem_list_t  *proto_list;
-  wmem_list_frame_t *item;
-
-  temp.proto = proto;
-  temp.key = key;
-  temp.proto_data = NULL;
-
-  if (scope == pinfo->pool) {
-    proto_list = pinfo->proto_data;
-  } else if (scope == wmem_file_scope()) {
-    proto_list = pinfo->fd->pfd;
-  } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
-  }
+  struct _proto_data_list *list = *p_get_list(scope, pinfo);
+  proto_data_t *p1;
+  unsigned entry;
 
-  if (!proto_list)
+  if (!list)
     return;
 
-  item = wmem_list_find_custom(proto_list, &temp, p_compare);
-  if (item) {
-    wmem_list_remove_frame(proto_list, item);
+  p1 = p_find(list, proto, key);
+  if (p1) {
+    entry = (unsigned)(p1 - list->entries);
+    memmove(p1, p1 + 1, (list->count - entry - 1) * sizeof(proto_data_t));
+    list->count--;
+    if (list->index)
+      p_index_rebuild(list);
   }
 }
 
 GPtrArray *
 p_get_proto_names_and_keys(wmem_allocator_t *scope, struct _packet_info* pinfo) {
-  wmem_list_t  *proto_list;
+  struct _proto_data_list *list = *p_get_list(scope, pinfo);
   proto_data_t *temp;
   GPtrArray *ret;
+  unsigned i;
 
-  if (scope == pinfo->pool) {
-    proto_list = pinfo->proto_data;
-  } else if (scope == wmem_file_scope()) {
-    proto_list = pinfo->fd->pfd;
-  } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
-  }
-
-  if (!proto_list)
+  if (!list || list->count == 0)
     return NULL;
 
   ret = g_ptr_array_new();
 
-  for (wmem_list_frame_t *frame = wmem_list_head(proto_list);
-      frame; frame = wmem_list_frame_next(frame)) {
-
-    temp = wmem_list_frame_data(frame);
+  /* Newest first. */
+  for (i = list->count; i-- > 0; ) {
+    temp = &list->entries[i];
     g_ptr_array_add(ret, wmem_strdup_printf(pinfo->pool, "[%s, key %u]",proto_get_protocol_name(temp->proto), temp->key));
   }
   return ret;
@@ -14,6 +14,7 @@
 
 #include <epan/packet.h>
 #include <epan/exceptions.h>
+#include <epan/prefs.h>
 #include <epan/reassemble.h>
 #include <epan/tvbuff-int.h>
 
@@ -32,6 +33,31 @@ typedef struct _fragment_addresses_key {
 
 static GList* reassembly_table_list;
 
+/*
+ * An incomplete reassembly in a table with memory or age limits; see
+ * reassembly_table_set_limits().
+ *
+ * The size is the fragment data added to the reassembly; fragments that
+ * fragment_add_seq_single() moves to another reassembly stay counted
+ * where they were added, so it is an estimate.
+ */
+struct _fragment_lru {
+	struct _fragment_lru *prev;
+	struct _fragment_lru *next;
+	fragment_head *fd_head;
+	void *key;		/* key of fd_head in the fragment table */
+	nstime_t last_ts;	/* arrival time of the frame that last added a fragment */
+	uint32_t last_frame;	/* and its number */
+	uint32_t size;		/* bytes of fragment data added */
+	uint32_t accounted;	/* part of size included in the table's counters */
+};
+
+/* The counters of all tables combined. */
+static reassembly_table_stats reassembly_total_stats;
+
+/* Number of reassemblies discarded while dissecting each frame. */
+static wmem_map_t *reassembly_frame_evictions;
+
 static unsigned
 fragment_addresses_hash(const void *k)
 {
@@ -388,6 +414,8 @@ free_fd_head(fragment_head *fd_head)
 	while (fd_i != NULL) {
 		fd_i = fragment_item_free(fd_i);
 	}
+	if (fd_head->lru)
+		g_slice_free(struct _fragment_lru, fd_head->lru);
 	g_slice_free(fragment_head, fd_head);
 }
 
@@ -454,6 +482,98 @@ reassembled_table_insert(GHashTable *reassembled_table, reassembled_key *key, fr
 	g_hash_table_insert(reassembled_table, key, fd_head);
 }
 
+static void
+fragment_lru_unlink(reassembly_table *table, struct _fragment_lru *lru)
+{
+	if (lru->prev)
+		lru->prev->next = lru->next;
+	else
+		table->lru_first = lru->next;
+	if (lru->next)
+		lru->next->prev = lru->prev;
+	else
+		table->lru_last = lru->prev;
+}
+
+static void
+fragment_lru_append(reassembly_table *table, struct _fragment_lru *lru)
+{
+	lru->prev = table->lru_last;
+	lru->next = NULL;
+	if (table->lru_last)
+		table->lru_last->next = lru;
+	else
+		table->lru_first = lru;
+	table->lru_last = lru;
+}
+
+/*
+ * Stop tracking a reassembly because it is complete or is being freed.
+ */
+static void
+fragment_lru_remove(reassembly_table *table, fragment_head *fd_head)
+{
+	struct _fragment_lru *lru = fd_head->lru;
+
+	if (lru == NULL)
+		return;
+
+	fragment_lru_unlink(table, lru);
+	table->stats.memory_used -= lru->accounted;
+	table->stats.incomplete--;
+	reassembly_total_stats.memory_used -= lru->accounted;
+	reassembly_total_stats.incomplete--;
+	g_slice_free(struct _fragment_lru, lru);
+	fd_head->lru = NULL;
+}
+
+/*
+ * Forget about all tracked reassemblies after they were freed along with
+ * the fragment table entries.
+ */
+static void
+fragment_lru_clear(reassembly_table *table)
+{
+	reassembly_total_stats.memory_used -= table->stats.memory_used;
+	reassembly_total_stats.incomplete -= table->stats.incomplete;
+	memset(&table->stats, 0, sizeof(table->stats));
+	table->lru_first = NULL;
+	table->lru_last = NULL;
+}
+
+void
+reassembly_table_get_limits(const reassembly_table *table,
+			    uint64_t *max_memory, uint32_t *max_age)
+{
+	*max_memory = table->max_memory ? table->max_memory :
+	    (uint64_t)prefs.reassembly_max_memory * 1024;
+	*max_age = table->max_age ? table->max_age : prefs.reassembly_max_age;
+}
+
+void
+reassembly_table_set_limits(reassembly_table *table, const char *name,
+			    uint64_t max_memory, uint32_t max_age)
+{
+	table->name = name;
+	table->max_memory = max_memory;
+	table->max_age = max_age;
+}
+
+void
+reassembly_tables_get_stats(reassembly_table_stats *stats)
+{
+	*stats = reassembly_total_stats;
+}
+
+unsigned
+reassembly_evictions_in_frame(uint32_t frame)
+{
+	if (reassembly_frame_evictions == NULL)
+		return 0;
+	return GPOINTER_TO_UINT(wmem_map_lookup(reassembly_frame_evictions,
+						GUINT_TO_POINTER(frame)));
+}
+
 typedef struct register_reassembly_table {
 	reassembly_table *table;
 	const reassembly_table_functions *funcs;
@@ -479,6 +599,29 @@ reassembly_table_register(reassembly_table *table,
 	reassembly_table_list = g_list_prepend(reassembly_table_list, reg_table);
 }
 
+typedef struct reassembly_tables_foreach_info {
+	void (*func)(const reassembly_table *table, void *user_data);
+	void *user_data;
+} reassembly_tables_foreach_info_t;
+
+static void
+reassembly_tables_foreach_func(void *p, void *user_data)
+{
+	register_reassembly_table_t *reg_table = (register_reassembly_table_t *)p;
+	reassembly_tables_foreach_info_t *info = (reassembly_tables_foreach_info_t *)user_data;
+
+	info->func(reg_table->table, info->user_data);
+}
+
+void
+reassembly_tables_foreach(void (*func)(const reassembly_table *table, void *user_data),
+			  void *user_data)
+{
+	reassembly_tables_foreach_info_t info = { func, user_data };
+
+	g_list_foreach(reassembly_table_list, reassembly_tables_foreach_func, &info);
+}
+
 /*
  * Initialize a reassembly table, with specified functions.
  */
@@ -509,6 +652,7 @@ reassembly_table_init(reassembly_table *table,
 		table->fragment_table = g_hash_table_new_full(funcs->hash_func,
 		    funcs->equal_func, funcs->free_persistent_key_func, NULL);
 	}
+	fragment_lru_clear(table);
 
 	if (table->reassembled_table != NULL) {
 		/*
@@ -556,6 +700,7 @@ reassembly_table_destroy(reassembly_table *table)
 		g_hash_table_destroy(table->fragment_table);
 		table->fragment_table = NULL;
 	}
+	fragment_lru_clear(table);
 	if (table->reassembled_table != NULL) {
 		/*
 		 * The reassembled-packet hash table exists.
@@ -600,6 +745,32 @@ lookup_fd_head(reassembly_table *table, const packet_info *pinfo,
 	return (fragment_head *)value;
 }
 
+/*
+ * If the table has limits, keep track of the reassembly with the given
+ * fragment table key until it's complete.
+ */
+static void
+fragment_lru_track(reassembly_table *table, fragment_head *fd_head,
+		   void *key, const packet_info *pinfo)
+{
+	uint64_t max_memory;
+	uint32_t max_age;
+
+	reassembly_table_get_limits(table, &max_memory, &max_age);
+	if (max_memory != 0 || max_age != 0) {
+		struct _fragment_lru *lru = g_slice_new0(struct _fragment_lru);
+
+		lru->fd_head = fd_head;
+		lru->key = key;
+		lru->last_ts = pinfo->abs_ts;
+		lru->last_frame = pinfo->num;
+		fd_head->lru = lru;
+		fragment_lru_append(table, lru);
+		table->stats.incomplete++;
+		reassembly_total_stats.incomplete++;
+	}
+}
+
 /*
  * Insert an fd_head into the fragment table, and return the key used.
  */
@@ -615,9 +786,98 @@ insert_fd_head(reassembly_table *table, fragment_head *fd_head,
 	 */
 	key = table->persistent_key_func(pinfo, id, data);
 	g_hash_table_insert(table->fragment_table, key, fd_head);
+
+	fragment_lru_track(table, fd_head, key, pinfo);
 	return key;
 }
 
+/*
+ * Discard the least recently used incomplete reassemblies while the
+ * table is over its memory limit, or they are older than its age limit.
+ * Reassemblies that got a fragment in the current frame are kept, as the
+ * dissector might still be using them.
+ */
+static void
+fragment_lru_evict(reassembly_table *table, const packet_info *pinfo,
+		   const uint64_t max_memory, const uint32_t max_age)
+{
+	struct _fragment_lru *lru;
+	fragment_head *fd_head;
+	void *key;
+	nstime_t age;
+	unsigned evicted = 0;
+
+	while ((lru = table->lru_first) != NULL && lru->last_frame != pinfo->num) {
+		if (max_memory != 0 && table->stats.memory_used > max_memory) {
+			table->stats.evicted_memory++;
+			reassembly_total_stats.evicted_memory++;
+		} else {
+			if (max_age == 0)
+				break;
+			nstime_delta(&age, &pinfo->abs_ts, &lru->last_ts);
+			if (nstime_to_sec(&age) <= max_age)
+				break;
+			table->stats.evicted_age++;
+			reassembly_total_stats.evicted_age++;
+		}
+		table->stats.evicted_bytes += lru->accounted;
+		reassembly_total_stats.evicted_bytes += lru->accounted;
+
+		fd_head = lru->fd_head;
+		key = lru->key;
+		fragment_lru_remove(table, fd_head);
+		g_hash_table_remove(table->fragment_table, key);
+		free_fd_head(fd_head);
+		evicted++;
+	}
+
+	if (evicted && reassembly_frame_evictions) {
+		evicted += reassembly_evictions_in_frame(pinfo->num);
+		wmem_map_insert(reassembly_frame_evictions,
+				GUINT_TO_POINTER(pinfo->num), GUINT_TO_POINTER(evicted));
+	}
+}
+
+/*
+ * Called on the first pass after a fragment was added to fd_head: count
+ * the fragment's data, make the reassembly the most recently used one,
+ * and discard others if the table is over its limits.
+ */
+static void
+fragment_lru_update(reassembly_table *table, fragment_head *fd_head,
+		    const packet_info *pinfo)
+{
+	struct _fragment_lru *lru = fd_head->lru;
+	uint64_t max_memory;
+	uint32_t max_age;
+
+	if (lru == NULL)
+		return;
+
+	if (fd_head->flags & FD_DEFRAGMENTED) {
+		fragment_lru_remove(table, fd_head);
+		return;
+	}
+
+	table->stats.memory_used += lru->size - lru->accounted;
+	reassembly_total_stats.memory_used += lru->size - lru->accounted;
+	lru->accounted = lru->size;
+	if (table->stats.memory_peak < table->stats.memory_used)
+		table->stats.memory_peak = table->stats.memory_used;
+	if (reassembly_total_stats.memory_peak < reassembly_total_stats.memory_used)
+		reassembly_total_stats.memory_peak = reassembly_total_stats.memory_used;
+
+	lru->last_ts = pinfo->abs_ts;
+	lru->last_frame = pinfo->num;
+	if (table->lru_last != lru) {
+		fragment_lru_unlink(table, lru);
+		fragment_lru_append(table, lru);
+	}
+
+	reassembly_table_get_limits(table, &max_memory, &max_age);
+	fragment_lru_evict(table, pinfo, max_memory, max_age);
+}
+
 /* This function cleans up the stored state and removes the reassembly data and
  * (with one exception) all allocated memory for matching reassembly.
  *
@@ -651,6 +911,7 @@ fragment_delete(reassembly_table *table, const packet_info *pinfo,
 	while (fd != NULL) {
 		fd = fragment_item_free(fd);
 	}
+	fragment_lru_remove(table, fd_head);
 	g_slice_free(fragment_head, fd_head);
 	g_hash_table_remove(table->fragment_table, key);
 
@@ -1018,6 +1279,15 @@ fragment_set_partial_reassembly(reassembly_table *table,
 static void
 fragment_unhash(reassembly_table *table, void *key)
 {
+	/*
+	 * Stop tracking it for the table's limits, if any.
+	 */
+	if (table->lru_first != NULL) {
+		fragment_head *fd_head = (fragment_head *)g_hash_table_lookup(table->fragment_table, key);
+		if (fd_head != NULL)
+			fragment_lru_remove(table, fd_head);
+	}
+
 	/*
 	 * Remove the entry from the fragment table.
 	 */
@@ -1106,6 +1376,9 @@ LINK_FRAG(fragment_head *fd_head,fragment_item *fd)
 {
 	fragment_item *fd_i;
 
+	if (fd_head->lru && fd->tvb_data)
+		fd_head->lru->size += fd->len;
+
 	/* add fragment to list, keep list sorted */
 	/* It is important that new fragments are added *after* any
 	 * fragments with the same offset (as currently done.) */
@@ -1551,6 +1824,7 @@ fragment_add_common(reassembly_table *table, tvbuff_t *tvb, const int offset,
 	fragment_head *fd_head;
 	fragment_item *fd_item;
 	bool already_added;
+	void *key;
 
 
 	/*
@@ -1562,7 +1836,7 @@ fragment_add_common(reassembly_table *table, tvbuff_t *tvb, const int offset,
 	 */
 	DISSECTOR_ASSERT(tvb_bytes_exist(tvb, offset, frag_data_len));
 
-	fd_head = lookup_fd_head(table, pinfo, id, data, NULL);
+	fd_head = lookup_fd_head(table, pinfo, id, data, &key);
 
 #if 0
 	/* debug output of associated fragments. */
@@ -1715,6 +1989,18 @@ fragment_add_common(reassembly_table *table, tvbuff_t *tvb, const int offset,
 		 * Insert it into the hash table.
 		 */
 		insert_fd_head(table, fd_head, pinfo, id, data);
+	} else if (fd_head->lru == NULL &&
+		   (fd_head->flags & FD_DEFRAGMENTED) &&
+		   (fd_head->flags & FD_PARTIAL_REASSEMBLY)) {
+		/*
+		 * A completed reassembly that the dissector asked to
+		 * extend; if this fragment reopens it, it's incomplete
+		 * again and counts toward the table's limits, with the
+		 * data reassembled so far.
+		 */
+		fragment_lru_track(table, fd_head, key, pinfo);
+		if (fd_head->lru && fd_head->tvb_data)
+			fd_head->lru->size = tvb_captured_length(fd_head->tvb_data);
 	}
 
 	if (fragment_add_work(fd_head, tvb, offset, pinfo, frag_offset,
@@ -1722,11 +2008,13 @@ fragment_add_common(reassembly_table *table, tvbuff_t *tvb, const int offset,
 		/*
 		 * Reassembly is complete.
 		 */
+		fragment_lru_update(table, fd_head, pinfo);
 		return fd_head;
 	} else {
 		/*
 		 * Reassembly isn't complete.
 		 */
+		fragment_lru_update(table, fd_head, pinfo);
 		return NULL;
 	}
 }
@@ -1901,6 +2189,7 @@ fragment_add_check_common(reassembly_table *table, tvbuff_t *tvb, const int offs
 		/*
 		 * Reassembly isn't complete.
 		 */
+		fragment_lru_update(table, fd_head, pinfo);
 		return NULL;
 	}
 }
@@ -2354,11 +2643,13 @@ fragment_add_seq_common(reassembly_table *table, tvbuff_t *tvb,
 		/*
 		 * Reassembly is complete.
 		 */
+		fragment_lru_update(table, fd_head, pinfo);
 		return fd_head;
 	} else {
 		/*
 		 * Reassembly isn't complete.
 		 */
+		fragment_lru_update(table, fd_head, pinfo);
 		return NULL;
 	}
 }
@@ -3217,6 +3508,11 @@ static void
 reassembly_table_init_reg_tables(void)
 {
 	g_list_foreach(reassembly_table_list, reassembly_table_init_reg_table, NULL);
+	reassembly_total_stats.memory_peak = reassembly_total_stats.memory_used;
+	reassembly_total_stats.evicted_memory = 0;
+	reassembly_total_stats.evicted_age = 0;
+	reassembly_total_stats.evicted_bytes = 0;
+	reassembly_frame_evictions = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
 }
 
 static void
@@ -3229,6 +3525,7 @@ reassembly_table_cleanup_reg_table(void *p, void *user_data _U_)
 static void
 reassembly_table_cleanup_reg_tables(void)
 {
+	reassembly_frame_evictions = NULL;
 	g_list_foreach(reassembly_table_list, reassembly_table_cleanup_reg_table, NULL);
 }
 
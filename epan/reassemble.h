@@ -97,6 +97,8 @@ typedef struct _fragment_head {
     tvbuff_t* tvb_data;                   /**< Tvbuff containing the reassembled payload once reassembly is complete. */
     const char* error;                    /**< NULL if reassembly completed without error; otherwise a string
                                                describing the reassembly error that occurred. */
+    struct _fragment_lru* lru;            /**< Position in the table's list of incomplete reassemblies, least
+                                               recently used first; NULL unless the table has memory or age limits. */
 } fragment_head;
 
 /*
@@ -134,6 +136,18 @@ typedef void * (*fragment_temporary_key)(const packet_info *pinfo,
 typedef void * (*fragment_persistent_key)(const packet_info *pinfo,
     const uint32_t id, const void *data);
 
+/**
+ * @brief Counters for the incomplete reassemblies of a reassembly table with memory or age limits.
+ */
+typedef struct {
+    uint64_t memory_used;       /**< Bytes of fragment data currently held by incomplete reassemblies. */
+    uint64_t memory_peak;       /**< Largest value memory_used has had. */
+    unsigned incomplete;        /**< Number of incomplete reassemblies currently held. */
+    uint64_t evicted_memory;    /**< Incomplete reassemblies discarded to stay within the memory limit. */
+    uint64_t evicted_age;       /**< Incomplete reassemblies discarded because no fragment was added within the age limit. */
+    uint64_t evicted_bytes;     /**< Bytes of fragment data discarded with them. */
+} reassembly_table_stats;
+
 /**
  * @brief Tracks all in-progress fragment chains and completed reassemblies for a single reassembly context.
  */
@@ -143,6 +157,12 @@ typedef struct {
     fragment_temporary_key  temporary_key_func;      /**< Callback that constructs a short-lived lookup key from packet data for fragment_table queries. */
     fragment_persistent_key persistent_key_func;     /**< Callback that constructs a long-lived key allocated for permanent storage in the fragment_table. */
     GDestroyNotify          free_temporary_key_func; /**< GLib destroy callback used to release temporary keys after a lookup. */
+    const char*             name;                    /**< Name of a table with its own limits, as given to reassembly_table_set_limits(); NULL otherwise. */
+    uint64_t                max_memory;              /**< Limit in bytes on the fragment data of incomplete reassemblies; 0 to use the global preference. */
+    uint32_t                max_age;                 /**< Limit in seconds on the time since an incomplete reassembly last got a fragment; 0 to use the global preference. */
+    struct _fragment_lru*   lru_first;               /**< Least recently used incomplete reassembly, discarded first. */
+    struct _fragment_lru*   lru_last;                /**< Most recently used incomplete reassembly. */
+    reassembly_table_stats  stats;                   /**< Memory use and eviction counters. */
 } reassembly_table;
 
 /**
@@ -223,6 +243,78 @@ reassembly_table_init(reassembly_table *table,
 WS_DLL_PUBLIC void
 reassembly_table_destroy(reassembly_table *table);
 
+/**
+ * @brief Limit the memory and age of the incomplete reassemblies of a table.
+ *
+ * When adding a fragment takes the fragment data held by the table's
+ * incomplete reassemblies over max_memory bytes, the least recently used
+ * incomplete reassemblies are discarded until it no longer does.
+ * Incomplete reassemblies that haven't had a fragment added for more than
+ * max_age seconds of capture time are discarded as well. Reassemblies that
+ * got a fragment in the current frame are never discarded.
+ *
+ * Discarding only happens on the first pass, so the fragments of a
+ * discarded reassembly are shown as unreassembled on later passes too.
+ * This is meant for long-running live captures, where incomplete
+ * reassemblies otherwise accumulate for the life of the capture.
+ *
+ * A limit of 0 means the "reassembly_max_memory" or "reassembly_max_age"
+ * protocol preference applies; if that is 0 as well, there is no limit.
+ * This is normally called when registering the table.
+ *
+ * @param table The reassembly table.
+ * @param name Name of the table in statistics, e.g. the protocol's.
+ * @param max_memory Limit in bytes, or 0.
+ * @param max_age Limit in seconds, or 0.
+ */
+WS_DLL_PUBLIC void
+reassembly_table_set_limits(reassembly_table *table, const char *name,
+		      uint64_t max_memory, uint32_t max_age);
+
+/**
+ * @brief Get the limits that apply to a reassembly table.
+ *
+ * These are the table's own limits where it has them, and the
+ * "reassembly_max_memory" and "reassembly_max_age" preferences otherwise.
+ *
+ * @param table The reassembly table.
+ * @param max_memory Set to the limit in bytes, or 0 if there is none.
+ * @param max_age Set to the limit in seconds, or 0 if there is none.
+ */
+WS_DLL_PUBLIC void
+reassembly_table_get_limits(const reassembly_table *table,
+		      uint64_t *max_memory, uint32_t *max_age);
+
+/**
+ * @brief Call a function for each registered reassembly table.
+ *
+ * @param func Function called with each table and user_data.
+ * @param user_data Data passed to func.
+ */
+WS_DLL_PUBLIC void
+reassembly_tables_foreach(void (*func)(const reassembly_table *table, void *user_data),
+		      void *user_data);
+
+/**
+ * @brief Get the counters of all reassembly tables combined.
+ *
+ * Only tables with memory or age limits are counted.
+ *
+ * @param stats Filled in with the totals since the capture file was opened.
+ */
+WS_DLL_PUBLIC void
+reassembly_tables_get_stats(reassembly_table_stats *stats);
+
+/**
+ * @brief Number of incomplete reassemblies discarded while dissecting a frame.
+ *
+ * @param frame The frame number.
+ * @return The number of reassemblies discarded because of memory or age
+ * limits when fragments of this frame were added.
+ */
+WS_DLL_PUBLIC unsigned
+reassembly_evictions_in_frame(uint32_t frame);
+
 /**
  * @brief Adds a fragment to a reassembly table.
  *
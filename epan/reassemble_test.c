@@ -3203,6 +3203,134 @@ test_fragment_add_check_duplicate_conflict(void)
         print_fragment_table();
     }
 }
+/* Test the memory and age limits of a reassembly table: the least recently
+ * used incomplete reassembly is discarded when the limit is exceeded, and
+ * complete reassemblies no longer count, unless they are reopened by a
+ * partial reassembly.
+ */
+/*   id  frame  time  frag  len  more
+      1     1     0     0    60   T
+      2     2     1     0    60   T    discards 1 (memory)
+      2     3     2    60    30   F    completes 2
+      3     4     3     0    20   T
+      4     5    20     0    20   T    discards 3 (age)
+      3     6    21    20    20   F    starts a new reassembly for 3
+      5     7    22     0    30   F    completes 5, which is set to partial
+      5     8    23    30    30   T    reopens 5
+      6     9    40     0    10   T    discards 4 (memory), 3 and 5 (age)
+*/
+static void
+test_fragment_add_check_limits(void)
+{
+    fragment_head *fd_head;
+
+    printf("Starting test test_fragment_add_check_limits\n");
+
+    reassembly_table_set_limits(&test_reassembly_table, "test", 100, 10);
+
+    pinfo.num = 1;
+    pinfo.abs_ts.secs = 0;
+    fd_head=fragment_add_check(&test_reassembly_table, tvb, 0, &pinfo, 1,
+                               NULL, 0, 60, true);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+    ASSERT_EQ(1,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ(60,test_reassembly_table.stats.memory_used);
+    ASSERT_EQ(1,test_reassembly_table.stats.incomplete);
+
+    /* 120 bytes is over the limit, so the first one goes. */
+    pinfo.num = 2;
+    pinfo.abs_ts.secs = 1;
+    fd_head=fragment_add_check(&test_reassembly_table, tvb, 0, &pinfo, 2,
+                               NULL, 0, 60, true);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+    ASSERT_EQ(1,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ_POINTER(NULL,fragment_get(&test_reassembly_table, &pinfo, 1, NULL));
+    ASSERT_NE_POINTER(NULL,fragment_get(&test_reassembly_table, &pinfo, 2, NULL));
+    ASSERT_EQ(60,test_reassembly_table.stats.memory_used);
+    ASSERT_EQ(120,test_reassembly_table.stats.memory_peak);
+    ASSERT_EQ(1,test_reassembly_table.stats.incomplete);
+    ASSERT_EQ(1,test_reassembly_table.stats.evicted_memory);
+    ASSERT_EQ(60,test_reassembly_table.stats.evicted_bytes);
+
+    /* Complete the second one; it no longer counts. */
+    pinfo.num = 3;
+    pinfo.abs_ts.secs = 2;
+    fd_head=fragment_add_check(&test_reassembly_table, tvb, 60, &pinfo, 2,
+                               NULL, 60, 30, false);
+    ASSERT_NE_POINTER(NULL,fd_head);
+    ASSERT_EQ(90,fd_head->datalen);
+    ASSERT_EQ(0,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ(2,g_hash_table_size(test_reassembly_table.reassembled_table));
+    ASSERT_EQ(0,test_reassembly_table.stats.memory_used);
+    ASSERT_EQ(0,test_reassembly_table.stats.incomplete);
+
+    pinfo.num = 4;
+    pinfo.abs_ts.secs = 3;
+    fd_head=fragment_add_check(&test_reassembly_table, tvb, 0, &pinfo, 3,
+                               NULL, 0, 20, true);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+
+    /* 17 seconds later, the third one is too old. */
+    pinfo.num = 5;
+    pinfo.abs_ts.secs = 20;
+    fd_head=fragment_add_check(&test_reassembly_table, tvb, 0, &pinfo, 4,
+                               NULL, 0, 20, true);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+    ASSERT_EQ(1,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ_POINTER(NULL,fragment_get(&test_reassembly_table, &pinfo, 3, NULL));
+    ASSERT_EQ(1,test_reassembly_table.stats.evicted_age);
+    ASSERT_EQ(80,test_reassembly_table.stats.evicted_bytes);
+    ASSERT_EQ(20,test_reassembly_table.stats.memory_used);
+
+    /* Its last fragment can't complete it any more. */
+    pinfo.num = 6;
+    pinfo.abs_ts.secs = 21;
+    fd_head=fragment_add_check(&test_reassembly_table, tvb, 20, &pinfo, 3,
+                               NULL, 20, 20, false);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+    ASSERT_EQ(2,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ(2,test_reassembly_table.stats.incomplete);
+    ASSERT_EQ(40,test_reassembly_table.stats.memory_used);
+
+    /* A complete reassembly that is extended counts again, with the data
+     * reassembled so far. */
+    pinfo.num = 7;
+    pinfo.abs_ts.secs = 22;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 0, &pinfo, 5,
+                         NULL, 0, 30, false);
+    ASSERT_NE_POINTER(NULL,fd_head);
+    ASSERT_EQ(3,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ(2,test_reassembly_table.stats.incomplete);
+    ASSERT_EQ(40,test_reassembly_table.stats.memory_used);
+
+    fragment_set_partial_reassembly(&test_reassembly_table, &pinfo, 5, NULL);
+
+    pinfo.num = 8;
+    pinfo.abs_ts.secs = 23;
+    fd_head=fragment_add(&test_reassembly_table, tvb, 30, &pinfo, 5,
+                         NULL, 30, 30, true);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+    ASSERT_EQ(3,test_reassembly_table.stats.incomplete);
+    ASSERT_EQ(100,test_reassembly_table.stats.memory_used);
+
+    /* ... and is discarded like any other incomplete one. */
+    pinfo.num = 9;
+    pinfo.abs_ts.secs = 40;
+    fd_head=fragment_add_check(&test_reassembly_table, tvb, 0, &pinfo, 6,
+                               NULL, 0, 10, true);
+    ASSERT_EQ_POINTER(NULL,fd_head);
+    ASSERT_EQ(1,g_hash_table_size(test_reassembly_table.fragment_table));
+    ASSERT_EQ_POINTER(NULL,fragment_get(&test_reassembly_table, &pinfo, 5, NULL));
+    ASSERT_EQ(1,test_reassembly_table.stats.incomplete);
+    ASSERT_EQ(10,test_reassembly_table.stats.memory_used);
+    ASSERT_EQ(2,test_reassembly_table.stats.evicted_memory);
+    ASSERT_EQ(3,test_reassembly_table.stats.evicted_age);
+    ASSERT_EQ(180,test_reassembly_table.stats.evicted_bytes);
+
+    reassembly_table_set_limits(&test_reassembly_table, NULL, 0, 0);
+    pinfo.abs_ts.secs = 0;
+}
+
 /**********************************************************************************
  *
  * main
@@ -3251,6 +3379,7 @@ main(int argc _U_, char **argv _U_)
         test_fragment_add_check_duplicate_last,
 #endif
         test_fragment_add_check_duplicate_conflict,
+        test_fragment_add_check_limits,
     };
 
     /* a tvbuff for testing with */
@@ -111,6 +111,7 @@ free_stat_node(stat_node *node)
     }
 
     if (node->hash) g_hash_table_destroy(node->hash);
+    if (node->keys) g_hash_table_destroy(node->keys);
 
     while (node->bh) {
         bucket = node->bh;
@@ -146,6 +147,8 @@ stats_tree_free(stats_tree *st)
         next = child->next;
         free_stat_node(child);
     }
+    if (st->root.hash) g_hash_table_destroy(st->root.hash);
+    if (st->root.keys) g_hash_table_destroy(st->root.keys);
     g_free(st->root.name);
     g_free(st->root.bh);
 
@@ -228,6 +231,15 @@ stats_tree_reinit(void *p)
     }
 
     st->root.children = NULL;
+    st->root.last_child = NULL;
+    if (st->root.hash) {
+        g_hash_table_destroy(st->root.hash);
+        st->root.hash = NULL;
+    }
+    if (st->root.keys) {
+        g_hash_table_destroy(st->root.keys);
+        st->root.keys = NULL;
+    }
     st->root.counter = 0;
     switch (st->root.datatype)
     {
@@ -496,7 +508,6 @@ new_stat_node(stats_tree *st, const char *name, int parent_id, stat_node_datatyp
 {
 
     stat_node *node = g_new0(stat_node, 1);
-    stat_node *last_chld = NULL;
 
     node->datatype = datatype;
     switch (datatype)
@@ -518,7 +529,7 @@ new_stat_node(stats_tree *st, const char *name, int parent_id, stat_node_datatyp
 
     node->name = g_strdup(name);
     node->st = st;
-    node->hash = with_hash ? g_hash_table_new(g_str_hash,g_str_equal) : NULL;
+    node->with_hash = with_hash;
 
     if (as_parent_node) {
         g_hash_table_insert(st->names,
@@ -539,23 +550,21 @@ new_stat_node(stats_tree *st, const char *name, int parent_id, stat_node_datatyp
         ws_assert_not_reached();
     }
 
-    if (node->parent->children) {
-        /* insert as last child */
-
-        for (last_chld = node->parent->children;
-             last_chld->next;
-             last_chld = last_chld->next ) ;
-
-        last_chld->next = node;
-
+    /* insert as last child */
+    if (node->parent->last_child) {
+        node->parent->last_child->next = node;
     } else {
-        /* insert as first child */
         node->parent->children = node;
     }
+    node->parent->last_child = node;
 
-    if(node->parent->hash) {
-        g_hash_table_replace(node->parent->hash,node->name,node);
+    /* Every parent indexes its children by name, whether or not lookups
+     * by name go through it (with_hash), so that merging never has to
+     * walk the children. The index shares the node's name. */
+    if (!node->parent->hash) {
+        node->parent->hash = g_hash_table_new(g_str_hash,g_str_equal);
     }
+    g_hash_table_replace(node->parent->hash,node->name,node);
 
     if (st->cfg->setup_node_pr) {
         st->cfg->setup_node_pr(node);
@@ -674,31 +683,21 @@ update_burst_calc(stat_node *node, int value)
 }
 
 /*
- * Increases by delta the counter of the node whose name is given
- * if the node does not exist yet it's created (with counter=1)
- * using parent_name as parent node.
- * with_hash=true to indicate that the created node will have a parent
+ * Finds the node a name refers to under parent: one of its children if
+ * it was created with_hash, otherwise any named node of the tree.
  */
-int
-stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name,
-              int parent_id, bool with_hash, int value)
+static stat_node *
+lookup_stat_node(const stats_tree *st, const stat_node *parent, const char *name)
 {
-    stat_node *node = NULL;
-    stat_node *parent = NULL;
-
-    ws_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
-
-    parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
-
-    if( parent->hash ) {
-        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
-    } else {
-        node = (stat_node *)g_hash_table_lookup(st->names,name);
+    if (parent->with_hash) {
+        return parent->hash ? (stat_node *)g_hash_table_lookup(parent->hash,name) : NULL;
     }
+    return (stat_node *)g_hash_table_lookup(st->names,name);
+}
 
-    if ( node == NULL )
-        node = new_stat_node(st,name,parent_id,STAT_DT_INT,with_hash,with_hash);
-
+static void
+manip_stat_node_int(manip_node_mode mode, stat_node *node, int value)
+{
     switch (mode) {
         case MN_INCREASE:
             node->counter += value;
@@ -728,11 +727,77 @@ stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name
             node->st_flags &= ~value;
             break;
     }
+}
 
-    if (node)
-        return node->id;
-    else
-        return -1;
+/*
+ * Increases by delta the counter of the node whose name is given
+ * if the node does not exist yet it's created (with counter=1)
+ * using parent_name as parent node.
+ * with_hash=true to indicate that the created node will have a parent
+ */
+int
+stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name,
+              int parent_id, bool with_hash, int value)
+{
+    stat_node *node = NULL;
+    stat_node *parent = NULL;
+
+    ws_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
+
+    parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
+
+    node = lookup_stat_node(st,parent,name);
+
+    if ( node == NULL )
+        node = new_stat_node(st,name,parent_id,STAT_DT_INT,with_hash,with_hash);
+
+    manip_stat_node_int(mode,node,value);
+
+    return node->id;
+}
+
+/*
+ * Same as stats_tree_manip_node_int(), but the node is found by an integer
+ * key instead of by name, so that no string needs to be built or hashed
+ * once the node exists. The name is asked for (and looked up, in case the
+ * node was created by name) only the first time a key is seen.
+ */
+int
+stats_tree_manip_node_int_by_key(manip_node_mode mode, stats_tree *st, unsigned key,
+              stat_node_name_cb key_name, int parent_id, bool with_hash, int value)
+{
+    stat_node *node = NULL;
+    stat_node *parent = NULL;
+    char *name;
+
+    ws_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
+
+    parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
+
+    if (parent->keys) {
+        node = (stat_node *)g_hash_table_lookup(parent->keys,GUINT_TO_POINTER(key));
+    }
+
+    if ( node == NULL ) {
+        name = key_name ? key_name(key) : g_strdup_printf("%u", key);
+        node = lookup_stat_node(st,parent,name);
+        if ( node == NULL )
+            node = new_stat_node(st,name,parent_id,STAT_DT_INT,with_hash,with_hash);
+        g_free(name);
+
+        if (node->parent == parent) {
+            node->has_key = true;
+            node->key = key;
+        }
+        if (!parent->keys) {
+            parent->keys = g_hash_table_new(g_direct_hash,g_direct_equal);
+        }
+        g_hash_table_insert(parent->keys,GUINT_TO_POINTER(key),node);
+    }
+
+    manip_stat_node_int(mode,node,value);
+
+    return node->id;
 }
 
 /*
@@ -752,12 +817,7 @@ stats_tree_manip_node_float(manip_node_mode mode, stats_tree *st, const char *na
 
     parent = (stat_node *)g_ptr_array_index(st->parents, parent_id);
 
-    if (parent->hash) {
-        node = (stat_node *)g_hash_table_lookup(parent->hash, name);
-    }
-    else {
-        node = (stat_node *)g_hash_table_lookup(st->names, name);
-    }
+    node = lookup_stat_node(st, parent, name);
 
     if (node == NULL)
         node = new_stat_node(st, name, parent_id, STAT_DT_FLOAT, with_hash, with_hash);
@@ -958,11 +1018,7 @@ stats_tree_tick_range(stats_tree *st, const char *name, int parent_id,
         ws_assert_not_reached();
     }
 
-    if( parent->hash ) {
-        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
-    } else {
-        node = (stat_node *)g_hash_table_lookup(st->names,name);
-    }
+    node = lookup_stat_node(st,parent,name);
 
     if ( node == NULL )
         ws_assert_not_reached();
@@ -1037,6 +1093,111 @@ stats_tree_tick_pivot(stats_tree *st, int pivot_id, const char *pivot_value)
     return pivot_id;
 }
 
+int
+stats_tree_tick_pivot_by_key(stats_tree *st, int pivot_id, unsigned key, stat_node_name_cb key_name)
+{
+    stat_node *parent = (stat_node *)g_ptr_array_index(st->parents,pivot_id);
+
+    parent->counter++;
+    update_burst_calc(parent, 1);
+    stats_tree_manip_node_int_by_key( MN_INCREASE, st, key, key_name, pivot_id, false, 1);
+
+    return pivot_id;
+}
+
+/* Worker callbacks; see set_tap_worker_callbacks(). */
+void *
+stats_tree_worker_new(void *p)
+{
+    stats_tree *st = (stats_tree *)p;
+    stats_tree *worker = stats_tree_new(st->cfg, NULL, st->filter);
+
+    if (st->cfg->init)
+        st->cfg->init(worker);
+
+    return worker;
+}
+
+/* adds the values of src, and of its children by name, to dst */
+static void
+// NOLINTNEXTLINE(misc-no-recursion)
+merge_stat_node(stats_tree *st, stat_node *dst, const stat_node *src)
+{
+    const stat_node *src_child;
+    stat_node *dst_child;
+
+    dst->counter += src->counter;
+    switch (dst->datatype)
+    {
+    case STAT_DT_INT:
+        dst->total.int_total += src->total.int_total;
+        dst->minvalue.int_min = MIN(dst->minvalue.int_min, src->minvalue.int_min);
+        dst->maxvalue.int_max = MAX(dst->maxvalue.int_max, src->maxvalue.int_max);
+        break;
+    case STAT_DT_FLOAT:
+        dst->total.float_total += src->total.float_total;
+        dst->minvalue.float_min = MIN(dst->minvalue.float_min, src->minvalue.float_min);
+        dst->maxvalue.float_max = MAX(dst->maxvalue.float_max, src->maxvalue.float_max);
+        break;
+    }
+    dst->st_flags |= src->st_flags;
+
+    /* A burst that straddles two workers is not seen by either of them,
+     * so this is the largest burst each of them saw on its own. */
+    if (src->max_burst > dst->max_burst) {
+        dst->max_burst = src->max_burst;
+        dst->burst_time = src->burst_time;
+    }
+
+    for (src_child = src->children; src_child; src_child = src_child->next) {
+        dst_child = dst->hash ? (stat_node *)g_hash_table_lookup(dst->hash, src_child->name) : NULL;
+        if (dst_child == NULL) {
+            dst_child = new_stat_node(st, src_child->name, dst->id, src_child->datatype,
+                                      src_child->with_hash, src_child->id >= 0);
+            if (src_child->rng)
+                dst_child->rng = (range_pair_t *)g_memdup2(src_child->rng, sizeof(range_pair_t));
+        }
+        if (src_child->has_key && !dst_child->has_key) {
+            dst_child->has_key = true;
+            dst_child->key = src_child->key;
+            if (!dst->keys)
+                dst->keys = g_hash_table_new(g_direct_hash, g_direct_equal);
+            g_hash_table_insert(dst->keys, GUINT_TO_POINTER(src_child->key), dst_child);
+        }
+        // Recursion is limited by proto.c checks
+        merge_stat_node(st, dst_child, src_child);
+    }
+}
+
+void
+stats_tree_merge(stats_tree *st, const stats_tree *src)
+{
+    ws_assert(st->cfg == src->cfg);
+
+    if (src->start < 0.0)
+        return;
+
+    if (st->start < 0.0 || src->start < st->start)
+        st->start = src->start;
+    if (src->now > st->now)
+        st->now = src->now;
+    st->elapsed = st->now - st->start;
+
+    merge_stat_node(st, &st->root, &src->root);
+}
+
+void
+stats_tree_worker_merge(void *p, void *worker_data)
+{
+    stats_tree_merge((stats_tree *)p, (const stats_tree *)worker_data);
+}
+
+void
+stats_tree_worker_free(void *worker_data)
+{
+    stats_tree_free((stats_tree *)worker_data);
+}
+
 char*
 stats_tree_get_displayname (const char* fullname)
 {
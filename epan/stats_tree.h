@@ -273,6 +273,31 @@ WS_DLL_PUBLIC int stats_tree_tick_pivot(stats_tree *st,
                                         int pivot_id,
                                         const char *pivot_value);
 
+/**
+ * @brief Returns the name of the node for an integer key.
+ *
+ * @param key The key, e.g. a port number or a status code.
+ * @return The name, allocated with g_malloc(); the caller frees it.
+ */
+typedef char *(*stat_node_name_cb)(unsigned key);
+
+/**
+ * @brief Ticks a pivot node in the statistics tree, by integer key.
+ *
+ * Same as stats_tree_tick_pivot(), but the value's node is found by key, so
+ * no string has to be built for the packet once the key has been seen.
+ *
+ * @param st Pointer to the stats_tree structure.
+ * @param pivot_id ID of the pivot node to tick.
+ * @param key Integer value associated with the pivot node.
+ * @param key_name Returns the name for a new key, or NULL for its decimal value.
+ * @return The pivot_id.
+ */
+WS_DLL_PUBLIC int stats_tree_tick_pivot_by_key(stats_tree *st,
+                                               int pivot_id,
+                                               unsigned key,
+                                               stat_node_name_cb key_name);
+
 /**
  * @brief Cleans up the statistics tree registry.
  *
@@ -315,6 +340,32 @@ WS_DLL_PUBLIC int stats_tree_manip_node_int(manip_node_mode mode,
                                         bool with_children,
                                         int value);
 
+/**
+ * @brief Manipulates a node in a statistics tree found by an integer key.
+ *
+ * Same as stats_tree_manip_node_int(), for children that stand for numbers
+ * (ports, status codes, ...). The node is looked up in a per-parent table
+ * of keys, so no name is built or hashed once the key has been seen; the
+ * first time, key_name gives its name, and a node of that name which was
+ * created by name is reused.
+ *
+ * @param mode The manipulation mode (e.g., increase or set).
+ * @param st The statistics tree to manipulate.
+ * @param key The integer key of the node.
+ * @param key_name Returns the name for a new key, or NULL for its decimal value.
+ * @param parent_id The ID of the parent node.
+ * @param with_children Indicates if children should be included.
+ * @param value The integer value to add to the node's counter.
+ * @return The ID of the node, or -1 if it isn't a parent node.
+ */
+WS_DLL_PUBLIC int stats_tree_manip_node_int_by_key(manip_node_mode mode,
+                                        stats_tree *st,
+                                        unsigned key,
+                                        stat_node_name_cb key_name,
+                                        int parent_id,
+                                        bool with_children,
+                                        int value);
+
 /**
  * @brief Manipulates a node in the statistics tree with a float value.
  *
@@ -339,6 +390,12 @@ WS_DLL_PUBLIC int stats_tree_manip_node_float(manip_node_mode mode,
 #define tick_stat_node(st,name,parent_id,with_children)                 \
     (stats_tree_manip_node_int(MN_INCREASE,(st),(name),(parent_id),(with_children),1))
 
+#define increase_stat_node_by_key(st,key,key_name,parent_id,with_children,value) \
+    (stats_tree_manip_node_int_by_key(MN_INCREASE,(st),(key),(key_name),(parent_id),(with_children),(value)))
+
+#define tick_stat_node_by_key(st,key,key_name,parent_id,with_children)  \
+    (stats_tree_manip_node_int_by_key(MN_INCREASE,(st),(key),(key_name),(parent_id),(with_children),1))
+
 #define set_stat_node(st,name,parent_id,with_children,value)            \
     (stats_tree_manip_node_int(MN_SET,(st),(name),(parent_id),(with_children),value))
 
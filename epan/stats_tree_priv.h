@@ -97,13 +97,18 @@ struct _stat_node {
 	int max_burst;                  /**< Maximum burst count observed. */
 	double burst_time;              /**< Time span of the burst. */
 
-	GHashTable *hash;               /**< Child nodes indexed by name. */
+	GHashTable *hash;               /**< Child nodes indexed by name, or NULL until the first child. */
+	GHashTable *keys;               /**< Child nodes indexed by integer key, or NULL. */
+	bool with_hash;                 /**< Children are looked up by name among this node's children rather than in the tree's namespace. */
+	bool has_key;                   /**< The node was created for an integer key. */
+	unsigned key;                   /**< The integer key, if has_key. */
 
 	stats_tree *st;                 /**< Pointer to the owning statistics tree. */
 
 	/** Tree relationships. */
 	stat_node *parent;              /**< Pointer to parent node. */
 	stat_node *children;            /**< Pointer to first child node. */
+	stat_node *last_child;          /**< Pointer to last child node. */
 	stat_node *next;                /**< Pointer to next sibling node. */
 
 	range_pair_t *rng;              /**< Optional range constraint for value filtering. */
@@ -238,6 +243,47 @@ WS_DLL_PUBLIC void stats_tree_reinit(void *p_st);
  */
 WS_DLL_PUBLIC void stats_tree_free(stats_tree *st);
 
+/**
+ * @brief Adds the statistics of one tree to another.
+ *
+ * Both trees must have been created from the same configuration, e.g.
+ * by tap workers or for different capture files. Nodes are matched by
+ * name under the same parent, and missing ones are created. Counters,
+ * totals, minimums and maximums combine exactly; the burst rate is the
+ * larger of the two, as bursts spanning both trees cannot be seen.
+ *
+ * @param st Pointer to the tree to add to.
+ * @param src Pointer to the tree to add; it is left unchanged.
+ */
+WS_DLL_PUBLIC void stats_tree_merge(stats_tree *st, const stats_tree *src);
+
+/**
+ * @brief Creates an empty copy of a statistics tree for a tap worker.
+ *
+ * callback for tap workers, see set_tap_worker_callbacks()
+ *
+ * @param p_st Pointer to the listener's statistics tree.
+ * @return Pointer to a new, initialized tree with the same configuration.
+ */
+WS_DLL_PUBLIC void *stats_tree_worker_new(void *p_st);
+
+/**
+ * @brief Adds the nodes a tap worker counted to a statistics tree.
+ *
+ * See stats_tree_merge().
+ *
+ * @param p_st Pointer to the listener's statistics tree.
+ * @param worker_data Pointer to the worker's statistics tree.
+ */
+WS_DLL_PUBLIC void stats_tree_worker_merge(void *p_st, void *worker_data);
+
+/**
+ * @brief Frees a statistics tree created by stats_tree_worker_new().
+ *
+ * @param worker_data Pointer to the worker's statistics tree.
+ */
+WS_DLL_PUBLIC void stats_tree_worker_free(void *worker_data);
+
 /**
  * @brief Retrieves an abbreviation from a given option argument.
  *
@@ -27,8 +27,9 @@
 #include <epan/dfilter/dfilter.h>
 #include <epan/tap.h>
 #include <wsutil/wslog.h>
+#include <wsutil/ws_assert.h>
+#include <ws_attributes.h>
 
-static bool tapping_is_active=false;
 static dfilter_t *main_filter;
 
 typedef struct _tap_dissector_t {
@@ -76,8 +77,35 @@ typedef struct _tap_packet_t {
 #define TAP_PACKET_IS_ERROR_PACKET	0x00000001	/* packet being queued is an error packet */
 
 #define TAP_PACKET_QUEUE_LEN 5000
-static tap_packet_t tap_packet_array[TAP_PACKET_QUEUE_LEN];
-static unsigned tap_packet_index;
+
+/*
+ * Each thread that dissects packets has its own queue, so that packets
+ * can be dissected and tapped on several threads at once. The queue is
+ * allocated the first time the thread initializes it and freed when the
+ * thread exits.
+ */
+typedef struct _tap_queue_t {
+	bool tapping_is_active;
+	unsigned tap_packet_index;
+	tap_packet_t tap_packet_array[TAP_PACKET_QUEUE_LEN];
+} tap_queue_t;
+
+static WS_THREAD_LOCAL tap_queue_t *tap_queue;
+static GPrivate tap_queue_private = G_PRIVATE_INIT(g_free);
+
+/*
+ * The worker a thread taps packets for; see tap_set_current_worker().
+ * Worker 0 uses the listeners' own tapdata.
+ */
+static WS_THREAD_LOCAL unsigned tap_current_worker;
+static unsigned tap_num_workers = 1;
+
+/* The state of a listener for one of the workers 1 and up. */
+typedef struct _tap_worker_t {
+	void *tapdata;
+	bool needs_redraw;
+	bool failed;
+} tap_worker_t;
 
 typedef struct _tap_listener_t {
 	struct _tap_listener_t *next;
@@ -92,6 +120,11 @@ typedef struct _tap_listener_t {
 	tap_packet_cb packet;
 	tap_draw_cb draw;
 	tap_finish_cb finish;
+	tap_worker_new_cb worker_new;
+	tap_worker_merge_cb worker_merge;
+	tap_worker_free_cb worker_free;
+	tap_worker_t *workers;		/* tap_num_workers - 1 entries, or NULL */
+	GArray *wanted_hfids;		/* fields read from the tree, or NULL */
 } tap_listener_t;
 
 static tap_listener_t *tap_listener_queue;
@@ -154,7 +187,7 @@ register_all_tap_listeners(tap_reg_t const *tap_reg_listeners)
 void
 tap_init(void)
 {
-	tap_packet_index=0;
+	tap_num_workers=1;
 }
 
 /* **********************************************************************
@@ -232,28 +265,29 @@ register_tap(const char *name)
 void
 tap_queue_packet(int tap_id, packet_info *pinfo, const void *tap_specific_data)
 {
+	tap_queue_t *tq = tap_queue;
 	tap_packet_t *tpt;
 
-	if(!tapping_is_active){
+	if(!tq || !tq->tapping_is_active){
 		return;
 	}
 	/*
 	 * XXX - should we allocate this with an ep_allocator,
 	 * rather than having a fixed maximum number of entries?
 	 */
-	if(tap_packet_index >= TAP_PACKET_QUEUE_LEN){
+	if(tq->tap_packet_index >= TAP_PACKET_QUEUE_LEN){
 		ws_warning("Too many taps queued");
 		return;
 	}
 
-	tpt=&tap_packet_array[tap_packet_index];
+	tpt=&tq->tap_packet_array[tq->tap_packet_index];
 	tpt->tap_id=tap_id;
 	tpt->flags = 0;
 	if (pinfo->flags.in_error_pkt)
 		tpt->flags |= TAP_PACKET_IS_ERROR_PACKET;
 	tpt->pinfo=pinfo;
 	tpt->tap_specific_data=tap_specific_data;
-	tap_packet_index++;
+	tq->tap_packet_index++;
 }
 
 
@@ -281,6 +315,9 @@ void tap_build_interesting (epan_dissect_t *edt)
 		if(tl->code){
 			epan_dissect_prime_with_dfilter(edt, tl->code);
 		}
+		if(tl->wanted_hfids){
+			epan_dissect_prime_with_hfid_array(edt, tl->wanted_hfids);
+		}
 		if(tl->flags & TL_REQUIRES_PROTOCOLS){
 			need_protocols = true;
 		}
@@ -308,9 +345,14 @@ tap_queue_init(epan_dissect_t *edt)
 		return;
 	}
 
-	tapping_is_active=true;
+	if(!tap_queue){
+		tap_queue=g_new(tap_queue_t, 1);
+		g_private_set(&tap_queue_private, tap_queue);
+	}
+
+	tap_queue->tapping_is_active=true;
 
-	tap_packet_index=0;
+	tap_queue->tap_packet_index=0;
 
 	tap_build_interesting (edt);
 }
@@ -321,27 +363,28 @@ tap_queue_init(epan_dissect_t *edt)
 void
 tap_push_tapped_queue(epan_dissect_t *edt)
 {
+	tap_queue_t *tq = tap_queue;
 	tap_packet_t *tp;
 	tap_listener_t *tl;
 	unsigned i;
 
 	/* nothing to do, just return */
-	if(!tapping_is_active){
+	if(!tq || !tq->tapping_is_active){
 		return;
 	}
 
-	tapping_is_active=false;
+	tq->tapping_is_active=false;
 
 	/* nothing to do, just return */
-	if(!tap_packet_index){
+	if(!tq->tap_packet_index){
 		return;
 	}
 
 	/* loop over all tap listeners and call the listener callback
 	   for all packets that match the filter. */
-	for(i=0;i<tap_packet_index;i++){
+	for(i=0;i<tq->tap_packet_index;i++){
 		for(tl=tap_listener_queue;tl;tl=tl->next){
-			tp=&tap_packet_array[i];
+			tp=&tq->tap_packet_array[i];
 			/* Don't tap the packet if it's an "error packet"
 			 * unless the listener has requested that we do so.
 			 */
@@ -354,7 +397,19 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 						 */
 						continue;
 					}
-					if(tl->failed){
+					/* Workers other than the first
+					 * have their own tap state.
+					 */
+					void *tapdata = tl->tapdata;
+					bool *needs_redraw = &tl->needs_redraw;
+					bool *failed = &tl->failed;
+					if(tap_current_worker && tl->workers){
+						tap_worker_t *tw = &tl->workers[tap_current_worker - 1];
+						tapdata = tw->tapdata;
+						needs_redraw = &tw->needs_redraw;
+						failed = &tw->failed;
+					}
+					if(*failed){
 						/* A previous call failed,
 						 * meaning "stop running this
 						 * tap", so don't call the
@@ -392,7 +447,7 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 					/* So call the per-packet routine. */
 					tap_packet_status status;
 
-					status = tl->packet(tl->tapdata, tp->pinfo, edt, tp->tap_specific_data, flags);
+					status = tl->packet(tapdata, tp->pinfo, edt, tp->tap_specific_data, flags);
 
 					switch (status) {
 
@@ -400,11 +455,11 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 						break;
 
 					case TAP_PACKET_REDRAW:
-						tl->needs_redraw=true;
+						*needs_redraw=true;
 						break;
 
 					case TAP_PACKET_FAILED:
-						tl->failed=true;
+						*failed=true;
 						break;
 					}
 				}
@@ -431,22 +486,23 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 const void *
 fetch_tapped_data(int tap_id, int idx)
 {
+	tap_queue_t *tq = tap_queue;
 	tap_packet_t *tp;
 	unsigned i;
 
 	/* nothing to do, just return */
-	if(!tapping_is_active){
+	if(!tq || !tq->tapping_is_active){
 		return NULL;
 	}
 
 	/* nothing to do, just return */
-	if(!tap_packet_index){
+	if(!tq->tap_packet_index){
 		return NULL;
 	}
 
 	/* loop over all tapped packets and return the one with index idx */
-	for(i=0;i<tap_packet_index;i++){
-		tp=&tap_packet_array[i];
+	for(i=0;i<tq->tap_packet_index;i++){
+		tp=&tq->tap_packet_array[i];
 		if(tp->tap_id==tap_id){
 			if(!idx--){
 				return tp->tap_specific_data;
@@ -457,6 +513,94 @@ fetch_tapped_data(int tap_id, int idx)
 	return NULL;
 }
 
+/* Create the state of a listener for workers 1 and up. */
+static void
+tap_listener_workers_new(tap_listener_t *tl)
+{
+	unsigned i;
+
+	if(!tl->worker_new || tap_num_workers < 2){
+		return;
+	}
+
+	tl->workers=g_new0(tap_worker_t, tap_num_workers - 1);
+	for(i=0;i<tap_num_workers - 1;i++){
+		tl->workers[i].tapdata=tl->worker_new(tl->tapdata);
+	}
+}
+
+/* Free the state of a listener for workers 1 and up, without merging it. */
+static void
+tap_listener_workers_free(tap_listener_t *tl)
+{
+	unsigned i;
+
+	if(!tl->workers){
+		return;
+	}
+
+	for(i=0;i<tap_num_workers - 1;i++){
+		tl->worker_free(tl->workers[i].tapdata);
+	}
+	g_free(tl->workers);
+	tl->workers=NULL;
+}
+
+void
+tap_set_workers(unsigned num_workers)
+{
+	tap_listener_t *tl;
+
+	if(num_workers == 0){
+		num_workers=1;
+	}
+
+	tap_merge_workers();
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		tap_listener_workers_free(tl);
+	}
+	tap_num_workers=num_workers;
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		tap_listener_workers_new(tl);
+	}
+}
+
+void
+tap_set_current_worker(unsigned worker)
+{
+	ws_assert(worker < tap_num_workers);
+	tap_current_worker=worker;
+}
+
+void
+tap_merge_workers(void)
+{
+	tap_listener_t *tl;
+	tap_worker_t *tw;
+	unsigned i;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(!tl->workers){
+			continue;
+		}
+		for(i=0;i<tap_num_workers - 1;i++){
+			tw=&tl->workers[i];
+			tl->worker_merge(tl->tapdata, tw->tapdata);
+			tl->worker_free(tw->tapdata);
+			tw->tapdata=tl->worker_new(tl->tapdata);
+			if(tw->needs_redraw){
+				tl->needs_redraw=true;
+			}
+			if(tw->failed){
+				tl->failed=true;
+			}
+			tw->needs_redraw=false;
+			tw->failed=false;
+		}
+	}
+}
+
 /* This function is called when we need to reset all tap listeners, for example
    when we open/start a new capture or if we need to rescan the packet list.
 */
@@ -466,11 +610,14 @@ reset_tap_listeners(void)
 	tap_listener_t *tl;
 
 	for(tl=tap_listener_queue;tl;tl=tl->next){
+		/* Throw away what the workers have not merged yet. */
+		tap_listener_workers_free(tl);
 		if(tl->reset){
 			tl->reset(tl->tapdata);
 		}
 		tl->needs_redraw=true;
 		tl->failed=false;
+		tap_listener_workers_new(tl);
 	}
 
 }
@@ -488,6 +635,8 @@ draw_tap_listeners(bool draw_all)
 {
 	tap_listener_t *tl;
 
+	tap_merge_workers();
+
 	for(tl=tap_listener_queue;tl;tl=tl->next){
 		if(tl->needs_redraw || draw_all){
 			if(tl->draw){
@@ -541,11 +690,15 @@ find_tap_id(const char *name)
 static void
 free_tap_listener(tap_listener_t *tl)
 {
+	tap_listener_workers_free(tl);
 	if (tl->finish) {
 		tl->finish(tl->tapdata);
 	}
 	dfilter_free(tl->code);
 	g_free(tl->fstring);
+	if (tl->wanted_hfids) {
+		g_array_free(tl->wanted_hfids, true);
+	}
 	g_free(tl);
 }
 
@@ -696,6 +849,59 @@ set_tap_flags(void *tapdata, unsigned flags)
 	return NULL;
 }
 
+void
+set_tap_worker_callbacks(void *tapdata, tap_worker_new_cb worker_new,
+			 tap_worker_merge_cb worker_merge, tap_worker_free_cb worker_free)
+{
+	tap_listener_t *tl;
+
+	ws_assert(worker_new && worker_merge && worker_free);
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->tapdata==tapdata){
+			break;
+		}
+	}
+	if(!tl){
+		ws_warning("no listener found with that tap data");
+		return;
+	}
+
+	tap_listener_workers_free(tl);
+	tl->worker_new=worker_new;
+	tl->worker_merge=worker_merge;
+	tl->worker_free=worker_free;
+	tap_listener_workers_new(tl);
+}
+
+void
+set_tap_wanted_hfids(void *tapdata, GArray *wanted_hfids)
+{
+	tap_listener_t *tl;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->tapdata==tapdata){
+			break;
+		}
+	}
+	if(!tl){
+		ws_warning("no listener found with that tap data");
+		if (wanted_hfids) {
+			g_array_free(wanted_hfids, true);
+		}
+		return;
+	}
+
+	if (tl->wanted_hfids) {
+		g_array_free(tl->wanted_hfids, true);
+	}
+	if (wanted_hfids && wanted_hfids->len == 0) {
+		g_array_free(wanted_hfids, true);
+		wanted_hfids = NULL;
+	}
+	tl->wanted_hfids=wanted_hfids;
+}
+
 /* this function recompiles dfilter for all registered tap listeners
  */
 void
@@ -828,6 +1034,22 @@ have_filtering_tap_listeners(void)
 	return false;
 }
 
+/*
+ * Return true if every tap listener can run on several workers at once,
+ * false otherwise.
+ */
+bool
+tap_listeners_support_workers(void)
+{
+	tap_listener_t *tl;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->packet && !tl->worker_new)
+			return false;
+	}
+	return true;
+}
+
 void
 tap_listeners_load_field_references(epan_dissect_t *edt)
 {
@@ -852,6 +1074,10 @@ union_of_tap_listener_flags(void)
 
 	for(tl=tap_listener_queue;tl;tl=tl->next){
 		flags|=tl->flags;
+		/* Fields can only be read back from a tree, but a tree
+		 * in which only they are primed. */
+		if(tl->wanted_hfids)
+			flags|=TL_REQUIRES_PROTO_TREE;
 	}
 	return flags;
 }
@@ -869,6 +1095,7 @@ void tap_cleanup(void)
 		free_tap_listener(elem_lq);
 	}
 	tap_listener_queue = NULL;
+	tap_num_workers = 1;
 
 	while(head_dl){
 		elem_dl = head_dl;
@@ -880,6 +1107,10 @@ void tap_cleanup(void)
 
 	g_slist_free(tap_plugins);
 	tap_plugins = NULL;
+
+	/* Frees this thread's queue. */
+	g_private_replace(&tap_queue_private, NULL);
+	tap_queue = NULL;
 }
 
 void tap_load_main_filter(dfilter_t *dfcode)
@@ -32,6 +32,13 @@ typedef tap_packet_status (*tap_packet_cb)(void *tapdata, packet_info *pinfo, ep
 typedef void (*tap_draw_cb)(void *tapdata);
 typedef void (*tap_finish_cb)(void *tapdata);
 
+/** Create an empty copy of tapdata for one worker. */
+typedef void *(*tap_worker_new_cb)(void *tapdata);
+/** Add what one worker collected in worker_data to tapdata. */
+typedef void (*tap_worker_merge_cb)(void *tapdata, void *worker_data);
+/** Free the state created by a tap_worker_new_cb. */
+typedef void (*tap_worker_free_cb)(void *worker_data);
+
 /**
  * Flags to indicate what a tap listener's packet routine requires.
  */
@@ -337,6 +344,84 @@ WS_DLL_PUBLIC void remove_tap_listener(void *tapdata);
  */
 WS_DLL_PUBLIC GString *set_tap_flags(void *tapdata, unsigned flags);
 
+/**
+ * @brief Let a tap listener run on several workers at once.
+ *
+ * Packets are normally tapped on a single thread, and every listener
+ * sees every packet in order. When packets are dissected by several
+ * workers at once (see tap_set_workers()), each worker other than the
+ * first passes its packets to a private copy of the listener's tapdata,
+ * created by worker_new. tap_merge_workers() later adds each copy to the
+ * listener's own tapdata with worker_merge and starts the worker afresh.
+ * The packet callback must then only modify the tapdata it is given.
+ *
+ * @param tapdata The tapdata the listener was registered with.
+ * @param worker_new Creates an empty copy of tapdata for one worker.
+ * @param worker_merge Adds a worker's copy to tapdata.
+ * @param worker_free Frees a worker's copy.
+ */
+WS_DLL_PUBLIC void set_tap_worker_callbacks(void *tapdata, tap_worker_new_cb worker_new,
+    tap_worker_merge_cb worker_merge, tap_worker_free_cb worker_free);
+
+/**
+ * @brief Declare the fields a tap listener reads from the protocol tree.
+ *
+ * Many listeners only look at the data passed to tap_queue_packet() and,
+ * perhaps, a handful of fields. Registering such a listener with
+ * TL_REQUIRES_PROTO_TREE makes dissectors build the tree for every packet
+ * even when nothing else needs one. Instead, register it with
+ * TL_REQUIRES_NOTHING and name the fields here: a tree is then created
+ * only because of these fields, they are primed like the fields of a
+ * filter, and everything else is faked as usual. A listener with no
+ * filter and no wanted fields lets the packets be dissected without a
+ * tree at all.
+ *
+ * @param tapdata The tapdata the listener was registered with.
+ * @param wanted_hfids An array of hfids (type int), which should be NULL to
+ * clear the list. This function will take ownership of the array.
+ */
+WS_DLL_PUBLIC void set_tap_wanted_hfids(void *tapdata, GArray *wanted_hfids);
+
+/**
+ * @brief Set the number of workers that tap packets at the same time.
+ *
+ * Merges what the current workers have collected, then creates the state
+ * of every listener for the new workers. Must not be called while any
+ * worker is tapping a packet. The default is a single worker.
+ *
+ * @param num_workers The number of workers, including the first.
+ */
+WS_DLL_PUBLIC void tap_set_workers(unsigned num_workers);
+
+/**
+ * @brief Set the worker that the calling thread taps packets for.
+ *
+ * Each worker must be used by one thread at a time. Worker 0, the
+ * default for every thread, uses the listeners' own tapdata.
+ *
+ * @param worker The worker, less than the number given to tap_set_workers().
+ */
+WS_DLL_PUBLIC void tap_set_current_worker(unsigned worker);
+
+/**
+ * @brief Merge what the workers have collected into the listeners' tapdata.
+ *
+ * Called by draw_tap_listeners(). Must not be called while any worker
+ * is tapping a packet.
+ */
+WS_DLL_PUBLIC void tap_merge_workers(void);
+
+/**
+ * @brief Check if every tap listener can run on several workers at once.
+ *
+ * Listeners without worker callbacks are always passed their own tapdata,
+ * so packets must only be tapped on more than one worker when this
+ * returns true.
+ *
+ * @return true if every listener with a packet callback has worker callbacks.
+ */
+WS_DLL_PUBLIC bool tap_listeners_support_workers(void);
+
 /**
  * @brief Check if any tap listeners require dissection.
  *
@@ -10,6 +10,22 @@
 
 #include "strutil.h"
 #include <wsutil/utf8_entities.h>
+#include <wsutil/time_util.h>
+#include <wsutil/wslog.h>
+
+#include "epan.h"
+#include "epan_dissect.h"
+#include "color_filters.h"
+#include "conversation.h"
+#include "packet.h"
+#include "proto.h"
+#include "packet_info.h"
+#include "prefs.h"
+#include "proto_data.h"
+#include "stats_tree_priv.h"
+#include "tap.h"
+#include "tvbuff.h"
+#include "wmem_scopes.h"
 
 /*
  * FIXME: LABEL_LENGTH includes the nul byte terminator.
@@ -74,6 +90,698 @@ void test_label_escape_control(void)
     g_assert_cmpuint(pos, ==, strlen(dst));
 }
 
+/*
+ * Tree construction benchmark. Builds the tree of an IPv4/UDP/DNS like
+ * packet over and over, resetting the tree between packets the way
+ * epan_dissect_reset() does. Then times dissector table dispatch.
+ *
+ * NOTE: You have to run "test_epan -m perf" to run the performance tests.
+ */
+#define BENCH_PACKETS   (200 * 1000)
+#define BENCH_FIELDS    8       /* per header, three headers */
+
+static int proto_bench;
+static int hf_bench_u8;
+static int hf_bench_u16;
+static int hf_bench_u32;
+static int hf_bench_ipv4;
+static int hf_bench_bytes;
+static int ett_bench;
+static dissector_table_t bench_port_table;
+
+#define BENCH_LOOKUPS   (10 * 1000 * 1000)
+
+static int
+dissect_bench(tvbuff_t *tvb, packet_info *pinfo _U_, proto_tree *tree _U_, void *data _U_)
+{
+    return tvb_captured_length(tvb);
+}
+
+static void
+register_bench(register_cb cb _U_, void *client_data _U_)
+{
+    static hf_register_info hf[] = {
+        { &hf_bench_u8,
+          { "UInt8", "bench.u8", FT_UINT8, BASE_DEC, NULL, 0x0, NULL, HFILL }},
+        { &hf_bench_u16,
+          { "UInt16", "bench.u16", FT_UINT16, BASE_HEX, NULL, 0x0, NULL, HFILL }},
+        { &hf_bench_u32,
+          { "UInt32", "bench.u32", FT_UINT32, BASE_DEC, NULL, 0x0, NULL, HFILL }},
+        { &hf_bench_ipv4,
+          { "Address", "bench.ipv4", FT_IPv4, BASE_NONE, NULL, 0x0, NULL, HFILL }},
+        { &hf_bench_bytes,
+          { "Bytes", "bench.bytes", FT_BYTES, BASE_NONE, NULL, 0x0, NULL, HFILL }},
+    };
+    static int *ett[] = {
+        &ett_bench,
+    };
+
+    proto_bench = proto_register_protocol("Tree Benchmark", "BENCH", "bench");
+    proto_register_field_array(proto_bench, hf, G_N_ELEMENTS(hf));
+    proto_register_subtree_array(ett, G_N_ELEMENTS(ett));
+
+    bench_port_table = register_dissector_table("bench.port", "Benchmark port",
+                                                proto_bench, FT_UINT16, BASE_DEC);
+}
+
+static void
+bench_add_header(proto_tree *tree, tvbuff_t *tvb, unsigned offset)
+{
+    proto_item *ti;
+    proto_tree *subtree;
+
+    ti = proto_tree_add_item(tree, proto_bench, tvb, offset, 20, ENC_NA);
+    subtree = proto_item_add_subtree(ti, ett_bench);
+    proto_tree_add_item(subtree, hf_bench_u8, tvb, offset, 1, ENC_NA);
+    proto_tree_add_item(subtree, hf_bench_u8, tvb, offset + 1, 1, ENC_NA);
+    proto_tree_add_item(subtree, hf_bench_u16, tvb, offset + 2, 2, ENC_BIG_ENDIAN);
+    proto_tree_add_item(subtree, hf_bench_u16, tvb, offset + 4, 2, ENC_BIG_ENDIAN);
+    proto_tree_add_item(subtree, hf_bench_u32, tvb, offset + 6, 4, ENC_BIG_ENDIAN);
+    proto_tree_add_item(subtree, hf_bench_ipv4, tvb, offset + 10, 4, ENC_BIG_ENDIAN);
+    proto_tree_add_item(subtree, hf_bench_ipv4, tvb, offset + 14, 4, ENC_BIG_ENDIAN);
+    proto_tree_add_item(subtree, hf_bench_bytes, tvb, offset + 18, 2, ENC_NA);
+}
+
+/*
+ * Coloring benchmark. As many rules as there are default coloring rules,
+ * over the benchmark protocol's fields as it's the only one registered.
+ * None but the last match the packet, as most default rules don't match
+ * most packets of a GUI load or of "tshark --color".
+ */
+static const char *bench_color_rules[] = {
+    "bench.u8 == 255",
+    "bench.u8 > 200 && bench.u16 < 0x0100",
+    "bench.u16 == 0xffff",
+    "bench.u16 in { 0x0800, 0x0806, 0x86dd }",
+    "bench.u32 in { 0..0xff, 0xffff0000..0xffffffff }",
+    "bench.u32 & 0x80000000",
+    "bench.ipv4 == 224.0.0.0/4",
+    "bench.ipv4 == 192.168.0.0/16 || bench.ipv4 == 172.16.0.0/12",
+    "bench.ipv4 == 10.0.0.0/8 && bench.u8 > 100",
+    "bench.bytes == ff:ff",
+    "bench.bytes contains 00:00",
+    "bench.bytes[0] == ff",
+    "len(bench.bytes) > 2",
+    "!bench",
+    "bench.u8 == 1 && bench.u16 == 0xffff",
+    "bench.u8 == 3 || bench.u8 == 5 || bench.u8 == 7",
+    "bench.u32 == 0x06070809 && bench.u8 == 50",
+    "bench.u16 > 0x8000 || bench.u32 < 0x100",
+    "bench.ipv4 != 0.0.0.0/1",
+    "bench.u8 == 0 && !bench.ipv4",
+    "bench.u16 == 0x0203",
+};
+
+static void
+bench_colorize(packet_info *pinfo, tvbuff_t *tvb)
+{
+    GSList *cfl = NULL;
+    color_t color = { 0 };
+    char *err_msg = NULL;
+    epan_dissect_t edt;
+    const color_filter_t *colorf = NULL;
+    int i;
+    double start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    for (i = 0; i < (int)G_N_ELEMENTS(bench_color_rules); i++) {
+        cfl = g_slist_append(cfl, color_filter_new("bench", bench_color_rules[i], &color, &color, false));
+    }
+    color_filters_apply(NULL, cfl, &err_msg);
+    g_assert_null(err_msg);
+
+    memset(&edt, 0, sizeof(edt));
+    edt.tree = proto_tree_create_root(pinfo);
+    proto_tree_set_visible(edt.tree, true);
+    color_filters_prime_edt(&edt);
+    bench_add_header(edt.tree, tvb, 0);
+    bench_add_header(edt.tree, tvb, 20);
+    bench_add_header(edt.tree, tvb, 40);
+
+    get_resource_usage(&start_utime, &start_stime);
+    for (i = 0; i < BENCH_PACKETS; i++) {
+        colorf = color_filters_colorize_packet_all(&edt, NULL, NULL);
+    }
+    get_resource_usage(&end_utime, &end_stime);
+    g_assert_nonnull(colorf);
+    g_assert_cmpstr(colorf->filter_text, ==, "bench.u16 == 0x0203");
+    utime_ms = (end_utime - start_utime) * 1000.0;
+    stime_ms = (end_stime - start_stime) * 1000.0;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "colorize, %u rules: u %.3f ms s %.3f ms",
+        (unsigned)G_N_ELEMENTS(bench_color_rules), utime_ms, stime_ms);
+
+    proto_tree_free(edt.tree);
+    color_filters_apply(NULL, NULL, &err_msg);
+    color_filters_cleanup();
+    color_filter_list_delete(&cfl);
+}
+
+static bool epan_initialized;
+
+/* Register the dissectors, with the bench protocol, once for all tests. */
+static void
+test_epan_init(void)
+{
+    static const char *col_fmt[] = { "No.", "%m" };
+    epan_app_data_t app_data = { 0 };
+
+    if (epan_initialized)
+        return;
+
+    app_data.env_var_prefix = "WIRESHARK";
+    app_data.col_fmt = col_fmt;
+    app_data.num_cols = 1;
+    app_data.register_func = register_bench;
+    g_assert_true(epan_init(NULL, NULL, false, &app_data));
+    epan_initialized = true;
+}
+
+/* A session has a file scope, as an open capture file does. */
+static epan_t *
+test_epan_new(void)
+{
+    static const struct packet_provider_funcs funcs = { NULL };
+
+    test_epan_init();
+    return epan_new(NULL, &funcs);
+}
+
+static void
+test_proto_perf(void)
+{
+    static uint8_t data[64];
+    packet_info pinfo;
+    proto_tree *tree;
+    tvbuff_t *tvb;
+    int i, j;
+    double start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    test_epan_init();
+
+    for (i = 0; i < (int)sizeof(data); i++)
+        data[i] = (uint8_t)i;
+
+    memset(&pinfo, 0, sizeof(pinfo));
+    pinfo.pool = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+    tvb = tvb_new_real_data(data, sizeof(data), sizeof(data));
+
+    /* The same trees, once with their nodes allocated from the packet
+     * scope as before the slabs, and once from the slabs. */
+    for (j = 0; j < 2; j++) {
+        tree = proto_tree_create_root(&pinfo);
+        proto_tree_set_visible(tree, true);
+        proto_tree_set_slabs(tree, j == 1);
+
+        get_resource_usage(&start_utime, &start_stime);
+        for (i = 0; i < BENCH_PACKETS; i++) {
+            bench_add_header(tree, tvb, 0);
+            bench_add_header(tree, tvb, 20);
+            bench_add_header(tree, tvb, 40);
+            proto_tree_reset(tree);
+            wmem_free_all(pinfo.pool);
+        }
+        get_resource_usage(&end_utime, &end_stime);
+        utime_ms = (end_utime - start_utime) * 1000.0;
+        stime_ms = (end_stime - start_stime) * 1000.0;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "tree construction, %s: u %.3f ms s %.3f ms",
+            j == 1 ? "slabs" : "packet scope", utime_ms, stime_ms);
+
+        proto_tree_free(tree);
+    }
+
+    /*
+     * Dissector table dispatch. Ports registered like a port table of
+     * well known and registered services; the traffic mixes those with
+     * ephemeral ports that aren't in the table.
+     */
+    static const uint16_t ports[] = {
+        20, 21, 22, 23, 25, 53, 67, 68, 69, 80, 88, 110, 123, 137, 138, 139,
+        143, 161, 162, 179, 389, 443, 445, 500, 514, 520, 554, 636, 853, 993,
+        995, 1194, 1433, 1701, 1723, 1812, 1813, 1883, 2049, 3306, 3389, 4500,
+        5060, 5061, 5353, 5432, 6379, 8080, 8443, 9200,
+    };
+    dissector_handle_t handle = create_dissector_handle(dissect_bench, proto_bench);
+    uint16_t *traffic = g_new(uint16_t, BENCH_LOOKUPS);
+    uint32_t rnd = 1;
+    int hits = 0;
+
+    for (i = 0; i < (int)G_N_ELEMENTS(ports); i++)
+        dissector_add_uint("bench.port", ports[i], handle);
+
+    for (i = 0; i < BENCH_LOOKUPS; i++) {
+        rnd = rnd * 1103515245 + 12345;
+        /* 3 out of 4 lookups hit the table */
+        if ((rnd >> 16) & 3)
+            traffic[i] = ports[(rnd >> 18) % G_N_ELEMENTS(ports)];
+        else
+            traffic[i] = (uint16_t)(49152 + ((rnd >> 18) & 0x3FFF));
+    }
+
+    pinfo.layers = wmem_list_new(pinfo.pool);
+
+    get_resource_usage(&start_utime, &start_stime);
+    for (i = 0; i < BENCH_LOOKUPS; i++) {
+        /* Every lookup starts a new packet, without any layers yet. */
+        while (wmem_list_count(pinfo.layers) > 0)
+            wmem_list_remove_frame(pinfo.layers, wmem_list_tail(pinfo.layers));
+        pinfo.curr_layer_num = 0;
+        if (dissector_try_uint_with_data(bench_port_table, traffic[i], tvb, &pinfo, NULL, false, NULL))
+            hits++;
+    }
+    get_resource_usage(&end_utime, &end_stime);
+    utime_ms = (end_utime - start_utime) * 1000.0;
+    stime_ms = (end_stime - start_stime) * 1000.0;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "dissector_try_uint_with_data, %d of %d matched: u %.3f ms s %.3f ms",
+        hits, BENCH_LOOKUPS, utime_ms, stime_ms);
+
+    g_free(traffic);
+
+    bench_colorize(&pinfo, tvb);
+
+    tvb_free(tvb);
+    wmem_destroy_allocator(pinfo.pool);
+}
+
+static void
+test_proto_data(void)
+{
+    frame_data fd;
+    packet_info pinfo;
+    wmem_allocator_t *scopes[2];
+    epan_t *session;
+    int i, proto;
+
+    session = test_epan_new();
+
+    memset(&fd, 0, sizeof(fd));
+    memset(&pinfo, 0, sizeof(pinfo));
+    pinfo.fd = &fd;
+    pinfo.pool = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+    scopes[0] = pinfo.pool;
+    scopes[1] = wmem_file_scope();
+
+    for (i = 0; i < 2; i++) {
+        wmem_allocator_t *scope = scopes[i];
+
+        g_assert_null(p_get_proto_data(scope, &pinfo, 1, 0));
+
+        /* Enough entries to go past the inline ones and to the hash index. */
+        for (proto = 1; proto <= 20; proto++) {
+            p_add_proto_data(scope, &pinfo, proto, 0, GINT_TO_POINTER(proto));
+            p_add_proto_data(scope, &pinfo, proto, 1, GINT_TO_POINTER(-proto));
+        }
+        for (proto = 1; proto <= 20; proto++) {
+            g_assert_cmpint(GPOINTER_TO_INT(p_get_proto_data(scope, &pinfo, proto, 0)), ==, proto);
+            g_assert_cmpint(GPOINTER_TO_INT(p_get_proto_data(scope, &pinfo, proto, 1)), ==, -proto);
+            g_assert_null(p_get_proto_data(scope, &pinfo, proto, 2));
+        }
+
+        /* The most recently added entry wins, until it is removed. */
+        p_add_proto_data(scope, &pinfo, 5, 0, GINT_TO_POINTER(500));
+        g_assert_cmpint(GPOINTER_TO_INT(p_get_proto_data(scope, &pinfo, 5, 0)), ==, 500);
+        p_remove_proto_data(scope, &pinfo, 5, 0);
+        g_assert_cmpint(GPOINTER_TO_INT(p_get_proto_data(scope, &pinfo, 5, 0)), ==, 5);
+
+        p_set_proto_data(scope, &pinfo, 7, 1, GINT_TO_POINTER(700));
+        g_assert_cmpint(GPOINTER_TO_INT(p_get_proto_data(scope, &pinfo, 7, 1)), ==, 700);
+        p_set_proto_data(scope, &pinfo, 7, 2, GINT_TO_POINTER(702));
+        g_assert_cmpint(GPOINTER_TO_INT(p_get_proto_data(scope, &pinfo, 7, 2)), ==, 702);
+
+        /* Back below the size that uses the hash index. */
+        for (proto = 1; proto <= 20; proto++) {
+            p_remove_proto_data(scope, &pinfo, proto, 1);
+            if (proto > 3)
+                p_remove_proto_data(scope, &pinfo, proto, 0);
+        }
+        for (proto = 1; proto <= 20; proto++) {
+            if (proto <= 3)
+                g_assert_cmpint(GPOINTER_TO_INT(p_get_proto_data(scope, &pinfo, proto, 0)), ==, proto);
+            else
+                g_assert_null(p_get_proto_data(scope, &pinfo, proto, 0));
+            g_assert_null(p_get_proto_data(scope, &pinfo, proto, 1));
+        }
+        g_assert_cmpint(GPOINTER_TO_INT(p_get_proto_data(scope, &pinfo, 7, 2)), ==, 702);
+    }
+
+    wmem_destroy_allocator(pinfo.pool);
+    epan_free(session);
+}
+
+#define BENCH_LAYERS    12      /* protocols per packet, like ETH/IP/UDP/GTP/IP/TCP/TLS/HTTP2/... */
+
+static void
+test_proto_data_perf(void)
+{
+    frame_data *frames;
+    packet_info pinfo;
+    uintptr_t sum = 0;
+    int i, layer, lookup;
+    double start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+    epan_t *session;
+
+    session = test_epan_new();
+
+    frames = g_new0(frame_data, BENCH_PACKETS);
+    memset(&pinfo, 0, sizeof(pinfo));
+    pinfo.pool = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+
+    /*
+     * Each layer of a packet adds per-packet data and per-frame data,
+     * and then looks up its own and the lower layers' data several times,
+     * the way TCP, TLS, HTTP/2 and QUIC do.
+     */
+    get_resource_usage(&start_utime, &start_stime);
+    for (i = 0; i < BENCH_PACKETS; i++) {
+        pinfo.fd = &frames[i];
+        pinfo.proto_data = NULL;
+        for (layer = 1; layer <= BENCH_LAYERS; layer++) {
+            p_add_proto_data(pinfo.pool, &pinfo, layer, 0, GINT_TO_POINTER(layer));
+            p_add_proto_data(wmem_file_scope(), &pinfo, layer, 0, GINT_TO_POINTER(layer));
+            for (lookup = 0; lookup < 4; lookup++) {
+                sum += GPOINTER_TO_UINT(p_get_proto_data(pinfo.pool, &pinfo, layer, 0));
+                sum += GPOINTER_TO_UINT(p_get_proto_data(wmem_file_scope(), &pinfo, 1 + (layer + lookup) % layer, 0));
+                sum += GPOINTER_TO_UINT(p_get_proto_data(wmem_file_scope(), &pinfo, layer, 1));
+            }
+        }
+        wmem_free_all(pinfo.pool);
+    }
+    get_resource_usage(&end_utime, &end_stime);
+    utime_ms = (end_utime - start_utime) * 1000.0;
+    stime_ms = (end_stime - start_stime) * 1000.0;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "proto data, %d layers, checksum %" PRIuPTR ": u %.3f ms s %.3f ms",
+        BENCH_LAYERS, sum, utime_ms, stime_ms);
+
+    g_free(frames);
+    wmem_destroy_allocator(pinfo.pool);
+    epan_free(session);
+}
+
+/*
+ * Conversations that go idle are retired and their retire routines free
+ * their proto data. The conversations themselves stay allocated, so the
+ * file scope grows by much less than the proto data would take.
+ */
+#define CONV_TEST_TIMEOUT       4       /* seconds */
+#define CONV_TEST_ROUNDS        50
+#define CONV_TEST_WARM_ROUND    4
+#define CONV_TEST_PER_ROUND     2000
+#define CONV_TEST_DATA_SIZE     2048
+
+static unsigned conv_test_retired;
+
+static void
+conv_test_retire(conversation_t *conv _U_, void *proto_data)
+{
+    wmem_free(wmem_file_scope(), proto_data);
+    conv_test_retired++;
+}
+
+static void
+test_conversation_expiry(void)
+{
+    frame_data fd;
+    packet_info pinfo;
+    wmem_allocator_stats_t warm, stats;
+    conversation_stats_t conv_before, conv_after;
+    epan_t *session;
+    uint32_t src, dst;
+    unsigned saved_timeout;
+    int round, i;
+
+    session = test_epan_new();
+    saved_timeout = prefs.conversation_idle_timeout;
+    prefs.conversation_idle_timeout = CONV_TEST_TIMEOUT;
+    conversation_set_expiry_allowed(true);
+    conversation_register_retire_routine(proto_bench, conv_test_retire);
+    conv_test_retired = 0;
+    conversation_get_stats(&conv_before);
+
+    memset(&fd, 0, sizeof(fd));
+    memset(&pinfo, 0, sizeof(pinfo));
+    pinfo.fd = &fd;
+    pinfo.presence_flags = PINFO_HAS_TS;
+    set_address(&pinfo.src, AT_IPv4, 4, &src);
+    set_address(&pinfo.dst, AT_IPv4, 4, &dst);
+    dst = g_htonl(0xc0a80001);
+
+    memset(&warm, 0, sizeof(warm));
+    for (round = 0; round < CONV_TEST_ROUNDS; round++) {
+        for (i = 0; i < CONV_TEST_PER_ROUND; i++) {
+            conversation_t *conv;
+
+            pinfo.num++;
+            src = g_htonl(0x0a000000 | (uint32_t)(round * CONV_TEST_PER_ROUND + i));
+            conv = conversation_new(pinfo.num, &pinfo.src, &pinfo.dst, CONVERSATION_TCP, 1024 + i, 80, 0);
+            conversation_add_proto_data(conv, proto_bench, wmem_alloc0(wmem_file_scope(), CONV_TEST_DATA_SIZE));
+        }
+
+        /* Each round is a timeout after the one before, which has been
+         * idle since and is retired. */
+        pinfo.num++;
+        pinfo.abs_ts.secs = round * CONV_TEST_TIMEOUT;
+        conversation_expire_idle(&pinfo);
+
+        if (round == CONV_TEST_WARM_ROUND)
+            wmem_allocator_get_stats(wmem_file_scope(), &warm);
+    }
+    wmem_allocator_get_stats(wmem_file_scope(), &stats);
+    conversation_get_stats(&conv_after);
+
+    g_assert_cmpuint(conv_after.created - conv_before.created, ==, CONV_TEST_ROUNDS * CONV_TEST_PER_ROUND);
+    g_assert_cmpuint(conv_after.retired - conv_before.retired, ==, (CONV_TEST_ROUNDS - 1) * CONV_TEST_PER_ROUND);
+    g_assert_cmpuint(conv_test_retired, ==, (CONV_TEST_ROUNDS - 1) * CONV_TEST_PER_ROUND);
+    /* Each conversation created after the warm-up rounds keeps its
+     * conversation_t, key and dissector tree, well under half of the
+     * proto data that was freed. */
+    g_assert_cmpuint(stats.bytes_in_use - warm.bytes_in_use, <,
+                     (uint64_t)(CONV_TEST_ROUNDS - 1 - CONV_TEST_WARM_ROUND) *
+                     CONV_TEST_PER_ROUND * CONV_TEST_DATA_SIZE / 2);
+
+    conversation_set_expiry_allowed(false);
+    prefs.conversation_idle_timeout = saved_timeout;
+    epan_free(session);
+}
+
+/*
+ * stats_tree merge: a tree fed half of the packets merged with one fed
+ * the other half must equal a tree fed all of them.
+ */
+typedef struct {
+    unsigned port;
+    const char *host;
+    int size;
+} st_test_packet_t;
+
+static int st_node_ports;
+static int st_node_hosts;
+
+static void
+st_test_init(stats_tree *st)
+{
+    st_node_ports = stats_tree_create_node(st, "Ports", 0, STAT_DT_INT, true);
+    st_node_hosts = stats_tree_create_pivot(st, "Hosts", 0);
+}
+
+static char *
+st_test_port_name(unsigned port)
+{
+    return g_strdup_printf("Port %u", port);
+}
+
+/* Odd packets count their port by key and even ones by name, so keys
+ * have to find the nodes created by name. */
+static tap_packet_status
+st_test_packet(stats_tree *st, packet_info *pinfo, epan_dissect_t *edt _U_,
+               const void *p, tap_flags_t flags _U_)
+{
+    const st_test_packet_t *pkt = (const st_test_packet_t *)p;
+    char *name;
+
+    tick_stat_node(st, "Ports", 0, false);
+    if (pinfo->num % 2) {
+        tick_stat_node_by_key(st, pkt->port, st_test_port_name, st_node_ports, false);
+    } else {
+        name = st_test_port_name(pkt->port);
+        tick_stat_node(st, name, st_node_ports, false);
+        g_free(name);
+    }
+    stats_tree_tick_pivot(st, st_node_hosts, pkt->host);
+    avg_stat_node_add_value_int(st, "Sizes", 0, false, pkt->size);
+
+    return TAP_PACKET_REDRAW;
+}
+
+/* Burst rates aren't compared, as merging can only approximate them. */
+static void
+// NOLINTNEXTLINE(misc-no-recursion)
+st_test_compare_node(const stat_node *a, const stat_node *b)
+{
+    const stat_node *ac, *bc;
+
+    g_assert_cmpstr(a->name, ==, b->name);
+    g_assert_cmpint(a->counter, ==, b->counter);
+    g_assert_cmpint(a->total.int_total, ==, b->total.int_total);
+    g_assert_cmpint(a->minvalue.int_min, ==, b->minvalue.int_min);
+    g_assert_cmpint(a->maxvalue.int_max, ==, b->maxvalue.int_max);
+    g_assert_cmpint(a->st_flags, ==, b->st_flags);
+
+    for (ac = a->children, bc = b->children; ac && bc; ac = ac->next, bc = bc->next)
+        st_test_compare_node(ac, bc);
+    g_assert_null(ac);
+    g_assert_null(bc);
+}
+
+static void
+test_stats_tree_merge(void)
+{
+    static const st_test_packet_t packets[] = {
+        /* first half */
+        { 80, "10.0.0.1", 60 },
+        { 443, "10.0.0.2", 1500 },
+        { 443, "10.0.0.1", 40 },
+        { 80, "10.0.0.3", 576 },
+        /* second half */
+        { 53, "10.0.0.3", 80 },
+        { 80, "10.0.0.4", 1200 },
+        { 80, "10.0.0.1", 52 },
+        { 22, "10.0.0.2", 9000 },
+    };
+    /* Seen by name only in the second half, then by key. */
+    static const st_test_packet_t last = { 22, "10.0.0.5", 30 };
+    stats_tree_cfg *cfg;
+    stats_tree *all, *first, *second;
+    packet_info pinfo;
+    unsigned i;
+
+    test_epan_init();
+    cfg = stats_tree_register("frame", "test_merge", "Merge test", 0,
+                              st_test_packet, st_test_init, NULL);
+
+    all = stats_tree_new(cfg, NULL, NULL);
+    first = stats_tree_new(cfg, NULL, NULL);
+    second = stats_tree_new(cfg, NULL, NULL);
+    cfg->init(all);
+    cfg->init(first);
+    cfg->init(second);
+
+    memset(&pinfo, 0, sizeof(pinfo));
+    for (i = 0; i < G_N_ELEMENTS(packets); i++) {
+        pinfo.num = i + 1;
+        pinfo.rel_ts.secs = i;
+        stats_tree_packet(all, &pinfo, NULL, &packets[i], 0);
+        stats_tree_packet(i < G_N_ELEMENTS(packets) / 2 ? first : second,
+                          &pinfo, NULL, &packets[i], 0);
+    }
+
+    stats_tree_merge(first, second);
+    st_test_compare_node(&all->root, &first->root);
+    g_assert_cmpfloat(first->start, ==, all->start);
+    g_assert_cmpfloat(first->now, ==, all->now);
+
+    /* A key finds the node that the merge created by name. */
+    pinfo.num = i + 1;
+    pinfo.rel_ts.secs = i;
+    g_assert_true(pinfo.num % 2);
+    stats_tree_packet(all, &pinfo, NULL, &last, 0);
+    stats_tree_packet(first, &pinfo, NULL, &last, 0);
+    st_test_compare_node(&all->root, &first->root);
+
+    stats_tree_free(all);
+    stats_tree_free(first);
+    stats_tree_free(second);
+}
+
+/*
+ * Tap workers: a stats tree listener tapped on two workers must, once its
+ * draw callback runs, equal a tree fed every packet.
+ */
+static stats_tree *st_test_reference;
+static unsigned st_test_draws;
+
+static void
+st_test_draw(void *p)
+{
+    st_test_compare_node(&st_test_reference->root, &((stats_tree *)p)->root);
+    st_test_draws++;
+}
+
+static void
+test_tap_workers(void)
+{
+    static const st_test_packet_t packets[] = {
+        { 80, "10.0.0.1", 60 },
+        { 443, "10.0.0.2", 1500 },
+        { 443, "10.0.0.1", 40 },
+        { 80, "10.0.0.3", 576 },
+        { 53, "10.0.0.3", 80 },
+        { 80, "10.0.0.4", 1200 },
+        { 22, "10.0.0.2", 9000 },
+        { 22, "10.0.0.5", 30 },
+    };
+    stats_tree_cfg *cfg;
+    stats_tree *st;
+    epan_dissect_t edt;
+    packet_info pinfo;
+    GString *error;
+    int tap_id;
+    unsigned i;
+
+    test_epan_init();
+    tap_id = register_tap("test_workers");
+    cfg = stats_tree_register("test_workers", "test_workers", "Tap worker test", 0,
+                              st_test_packet, st_test_init, NULL);
+
+    st_test_reference = stats_tree_new(cfg, NULL, NULL);
+    cfg->init(st_test_reference);
+    st = stats_tree_new(cfg, NULL, NULL);
+    cfg->init(st);
+    error = register_tap_listener("test_workers", st, NULL, 0, NULL,
+                                  stats_tree_packet, st_test_draw, NULL);
+    g_assert_null(error);
+    set_tap_worker_callbacks(st, stats_tree_worker_new,
+                             stats_tree_worker_merge, stats_tree_worker_free);
+    tap_set_workers(2);
+    g_assert_true(tap_listeners_support_workers());
+
+    /* Worker 0 taps the even packets into st, worker 1 the odd ones
+     * into its own tree. */
+    memset(&edt, 0, sizeof(edt));
+    memset(&pinfo, 0, sizeof(pinfo));
+    for (i = 0; i < G_N_ELEMENTS(packets); i++) {
+        pinfo.num = i + 1;
+        pinfo.rel_ts.secs = i;
+        stats_tree_packet(st_test_reference, &pinfo, NULL, &packets[i], 0);
+
+        tap_set_current_worker(i % 2);
+        tap_queue_init(&edt);
+        tap_queue_packet(tap_id, &pinfo, &packets[i]);
+        tap_push_tapped_queue(&edt);
+    }
+    tap_set_current_worker(0);
+
+    /* The listener's own tree has seen worker 0's packets only. */
+    g_assert_cmpstr(st->root.children->name, ==, "Ports");
+    g_assert_cmpint(st->root.children->counter, ==, G_N_ELEMENTS(packets) / 2);
+
+    /* Drawing merges worker 1 first. */
+    draw_tap_listeners(true);
+    g_assert_cmpuint(st_test_draws, ==, 1);
+
+    /* The merge restarts the workers, so drawing again doesn't count
+     * worker 1's packets twice. */
+    draw_tap_listeners(true);
+    g_assert_cmpuint(st_test_draws, ==, 2);
+
+    remove_tap_listener(st);
+    tap_set_workers(1);
+    stats_tree_free(st);
+    stats_tree_free(st_test_reference);
+    st_test_reference = NULL;
+}
+
 int main(int argc, char **argv)
 {
     int ret;
@@ -88,9 +796,21 @@ int main(int argc, char **argv)
     g_test_add_func("/label/strcat", test_label_strcat);
     g_test_add_func("/label/escape_whitespace", test_label_strcat_escape_whitespace);
     g_test_add_func("/label/escape_control", test_label_escape_control);
+    g_test_add_func("/proto_data/exec", test_proto_data);
+    g_test_add_func("/conversation/expiry", test_conversation_expiry);
+    g_test_add_func("/stats_tree/merge", test_stats_tree_merge);
+    g_test_add_func("/tap/workers", test_tap_workers);
+
+    if (g_test_perf()) {
+        g_test_add_func("/proto/perf", test_proto_perf);
+        g_test_add_func("/proto_data/perf", test_proto_data_perf);
+    }
 
     ret = g_test_run();
 
+    if (epan_initialized)
+        epan_cleanup();
+
     return ret;
 }
 
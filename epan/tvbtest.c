@@ -616,6 +616,101 @@ run_tests(void)
 	tvb_free_chain(tvb_parent);  /* should free all tvb's and associated data */
 }
 
+/* A composite of many members, built with both append and prepend, read
+ * in an order that defeats any caching of the last member used. */
+static void
+composite_member_tests(void)
+{
+#define COMP_MEMBERS	97
+	tvbuff_t	*tvb_parent, *tvb_comp, *tvb_member;
+	uint8_t		data[COMP_MEMBERS * 3];
+	uint8_t		expected[COMP_MEMBERS * 3];
+	uint8_t		buf[COMP_MEMBERS * 3];
+	unsigned	exp_len = 0;
+	unsigned	i, offset;
+
+	for (i = 0; i < sizeof data; i++)
+		data[i] = (uint8_t)(i * 7 + 1);
+
+	tvb_parent = tvb_new_real_data((const uint8_t*)"", 0, 0);
+	tvb_comp = tvb_new_composite();
+
+	/* Members 0, 1, 2, ... have 1, 2, 3, 1, ... bytes; odd ones are
+	 * prepended, so the composite is odd members in reverse, then
+	 * even members in order. */
+	for (i = COMP_MEMBERS; i-- > 0; ) {
+		if (i % 2) {
+			unsigned len = i % 3 + 1;
+			memcpy(&expected[exp_len], &data[i * 3], len);
+			exp_len += len;
+		}
+	}
+	for (i = 0; i < COMP_MEMBERS; i++) {
+		unsigned len = i % 3 + 1;
+		tvb_member = tvb_new_child_real_data(tvb_parent, &data[i * 3], len, len);
+		if (i % 2) {
+			tvb_composite_prepend(tvb_comp, tvb_member);
+		} else {
+			tvb_composite_append(tvb_comp, tvb_member);
+			memcpy(&expected[exp_len], &data[i * 3], len);
+			exp_len += len;
+		}
+	}
+	tvb_composite_finalize(tvb_comp);
+
+	if (tvb_captured_length(tvb_comp) != exp_len) {
+		printf("Many-member composite: length %u, expected %u\n", tvb_captured_length(tvb_comp), exp_len);
+		failed = true;
+		goto out;
+	}
+
+	/* Forward, backward, and jumping around. */
+	for (i = 0; i < exp_len; i++) {
+		if (tvb_get_uint8(tvb_comp, i) != expected[i]) {
+			printf("Many-member composite: forward byte %u\n", i);
+			failed = true;
+			goto out;
+		}
+	}
+	for (i = exp_len; i-- > 0; ) {
+		if (tvb_get_uint8(tvb_comp, i) != expected[i]) {
+			printf("Many-member composite: backward byte %u\n", i);
+			failed = true;
+			goto out;
+		}
+	}
+	for (i = 0, offset = 0; i < exp_len; i++, offset = (offset + 89) % exp_len) {
+		if (tvb_get_uint8(tvb_comp, offset) != expected[offset]) {
+			printf("Many-member composite: byte %u\n", offset);
+			failed = true;
+			goto out;
+		}
+	}
+
+	/* Copies that span members, from every starting offset. */
+	for (offset = 0; offset < exp_len; offset++) {
+		unsigned len = MIN(exp_len - offset, 11);
+		tvb_memcpy(tvb_comp, buf, offset, len);
+		if (memcmp(buf, &expected[offset], len) != 0) {
+			printf("Many-member composite: memcpy at %u\n", offset);
+			failed = true;
+			goto out;
+		}
+	}
+
+	/* Flattening */
+	if (memcmp(tvb_get_ptr(tvb_comp, 0, exp_len), expected, exp_len) != 0) {
+		printf("Many-member composite: tvb_get_ptr\n");
+		failed = true;
+		goto out;
+	}
+	printf("Passed many-member composite\n");
+
+out:
+	tvb_free_chain(tvb_parent);  /* should free all tvb's and associated data */
+#undef COMP_MEMBERS
+}
+
 typedef struct
 {
 	// Raw bytes
@@ -821,6 +916,7 @@ main(void)
 
 	except_init();
 	run_tests();
+	composite_member_tests();
 	varint_tests();
 	zstd_tests ();
 	except_deinit();
@@ -24,42 +24,19 @@ typedef struct {
 	unsigned end_offset;
 } tvb_comp_member_t;
 
-static int
-tvb_comp_off_compare(const void *a, const void *b, void *user_data)
-{
-	tvb_comp_member_t* off_a = (tvb_comp_member_t*)a;
-	tvb_comp_member_t* off_b = (tvb_comp_member_t*)b;
-	tvb_comp_member_t* key = (tvb_comp_member_t*)user_data;
-
-	if (off_a->end_offset < off_b->end_offset)
-		return -1;
-	else if (off_a->end_offset > off_b->end_offset)
-		return 1;
-
-	/* This is a hack to ensure that in cases of ties, key is always
-	 * sorted first. This ensures that g_sequence_search returns an
-	 * iterator pointing to the tvb in the sequence with a matching
-	 * offset instead of the node after it. (It would be simpler but
-	 * somewhat slower to have the natural comparison function and
-	 * call g_sequence_lookup followed by g_sequence_search in case
-	 * of failure.)
-	 *
-	 * If we allowed zero length TVBs to be part of the composite,
-	 * we might have to search through all the TVBs with the same
-	 * end_offset to find the right one. (Or maybe we could just
-	 * no-op and not add the zero length TVBs?)
-	 */
-	if (off_a == key) {
-		return -1;
-	} else if (off_b == key) {
-		return 1;
-	}
-	return 0;
-}
-
 typedef struct {
-	GSequence	*tvbs;
+	/* Member tvbs in the order they were appended or prepended;
+	 * only used until the composite is finalized. */
+	GPtrArray	*pending;
 
+	/* Members sorted by offset, set up by tvb_composite_finalize() */
+	tvb_comp_member_t *members;
+	unsigned	num_members;
+
+	/* Index of the member that satisfied the last access; dissectors
+	 * mostly read forward, so the next access is usually in the same
+	 * member or the one after it. */
+	unsigned	last_hit;
 } tvb_comp_t;
 
 struct tvb_composite {
@@ -74,7 +51,9 @@ composite_free(tvbuff_t *tvb)
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	tvb_comp_t *composite = &composite_tvb->composite;
 
-	g_sequence_free(composite->tvbs);
+	if (composite->pending)
+		g_ptr_array_free(composite->pending, true);
+	g_free(composite->members);
 
 	g_free((void *)tvb->real_data);
 }
@@ -85,6 +64,47 @@ composite_offset(const tvbuff_t *tvb _U_, const unsigned counter)
 	return counter;
 }
 
+/*
+ * Return the index of the member containing abs_offset, or
+ * composite->num_members if abs_offset is past the end.
+ */
+static unsigned
+composite_find_member(tvb_comp_t *composite, unsigned abs_offset)
+{
+	const tvb_comp_member_t *members = composite->members;
+	unsigned lo, hi, mid;
+
+	/* Try the member of the previous access and the one after it first. */
+	lo = composite->last_hit;
+	if (abs_offset >= members[lo].start_offset) {
+		if (abs_offset <= members[lo].end_offset)
+			return lo;
+		if (lo + 1 < composite->num_members && abs_offset <= members[lo + 1].end_offset) {
+			composite->last_hit = lo + 1;
+			return lo + 1;
+		}
+		lo++;
+		hi = composite->num_members;
+	} else {
+		hi = lo;
+		lo = 0;
+	}
+
+	/* Find the first member whose end_offset is >= abs_offset. As
+	 * zero length members aren't allowed, it's the one containing it. */
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (members[mid].end_offset < abs_offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo < composite->num_members)
+		composite->last_hit = lo;
+	return lo;
+}
+
 static const uint8_t*
 composite_get_ptr(tvbuff_t *tvb, unsigned abs_offset, unsigned abs_length)
 {
@@ -93,6 +113,7 @@ composite_get_ptr(tvbuff_t *tvb, unsigned abs_offset, unsigned abs_length)
 	tvb_comp_member_t *member = NULL;
 	tvbuff_t   *member_tvb = NULL;
 	unsigned	member_offset;
+	unsigned	idx;
 
 	/* DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops); */
 
@@ -100,16 +121,15 @@ composite_get_ptr(tvbuff_t *tvb, unsigned abs_offset, unsigned abs_length)
 	 * is contiguous inside one of the member tvbuffs */
 	composite = &composite_tvb->composite;
 
-	tvb_comp_member_t key = { .end_offset = abs_offset };
-	GSequenceIter *iter = g_sequence_search(composite->tvbs, &key, tvb_comp_off_compare, &key);
+	idx = composite_find_member(composite, abs_offset);
 
 	/* special case */
-	if (g_sequence_iter_is_end(iter)) {
+	if (idx == composite->num_members) {
 		DISSECTOR_ASSERT(abs_offset == tvb->length && abs_length == 0);
 		return (const uint8_t*)"";
 	}
 
-	member = (tvb_comp_member_t *)g_sequence_get(iter);
+	member = &composite->members[idx];
 	member_tvb = member->tvb;
 	member_offset = abs_offset - member->start_offset;
 
@@ -141,6 +161,7 @@ composite_memcpy(tvbuff_t *tvb, void* _target, unsigned abs_offset, unsigned abs
 	tvb_comp_member_t *member = NULL;
 	tvbuff_t   *member_tvb = NULL;
 	unsigned	    member_offset, member_length;
+	unsigned	idx;
 
 	/* DISSECTOR_ASSERT(tvb->ops == &tvb_composite_ops); */
 
@@ -148,16 +169,15 @@ composite_memcpy(tvbuff_t *tvb, void* _target, unsigned abs_offset, unsigned abs
 	 * is contiguous inside one of the member tvbuffs */
 	composite   = &composite_tvb->composite;
 
-	tvb_comp_member_t key = { .end_offset = abs_offset };
-	GSequenceIter *iter = g_sequence_search(composite->tvbs, &key, tvb_comp_off_compare, &key);
+	idx = composite_find_member(composite, abs_offset);
 
 	/* special case */
-	if (g_sequence_iter_is_end(iter)) {
+	if (idx == composite->num_members) {
 		DISSECTOR_ASSERT(abs_offset == tvb->length && abs_length == 0);
 		return target;
 	}
 
-	member = (tvb_comp_member_t *)g_sequence_get(iter);
+	member = &composite->members[idx];
 	member_tvb = member->tvb;
 	member_offset = abs_offset - member->start_offset;
 
@@ -189,15 +209,16 @@ composite_memcpy(tvbuff_t *tvb, void* _target, unsigned abs_offset, unsigned abs
 
 			if (!abs_length)
 				break;
-			iter = g_sequence_iter_next(iter);
+			idx++;
 			/* tvb_memcpy calls check_offset_length and so there
 			 * should be enough captured length to copy. */
-			DISSECTOR_ASSERT(!g_sequence_iter_is_end(iter));
+			DISSECTOR_ASSERT(idx < composite->num_members);
 
-			member = (tvb_comp_member_t *)g_sequence_get(iter);
+			member = &composite->members[idx];
 			member_tvb = member->tvb;
 			member_offset = 0;
 		}
+		composite->last_hit = idx;
 
 		return target;
 	}
@@ -238,7 +259,10 @@ tvb_new_composite(void)
 	struct tvb_composite *composite_tvb = (struct tvb_composite *) tvb;
 	tvb_comp_t *composite = &composite_tvb->composite;
 
-	composite->tvbs		 = g_sequence_new(g_free);
+	composite->pending	 = g_ptr_array_new();
+	composite->members	 = NULL;
+	composite->num_members	 = 0;
+	composite->last_hit	 = 0;
 
 	return tvb;
 }
@@ -258,14 +282,10 @@ tvb_composite_append(tvbuff_t *tvb, tvbuff_t *member)
 	if (member && member->length) {
 		composite       = &composite_tvb->composite;
 		/* Attach the composite TVB to the first TVB only. */
-		if (g_sequence_is_empty(composite->tvbs)) {
+		if (composite->pending->len == 0) {
 			tvb_add_to_chain(member, tvb);
 		}
-		tvb_comp_member_t *new_member = g_new(tvb_comp_member_t, 1);
-		new_member->tvb = member;
-		new_member->start_offset = 0;
-		new_member->end_offset = 0;
-		g_sequence_append(composite->tvbs, new_member);
+		g_ptr_array_add(composite->pending, member);
 	}
 }
 
@@ -284,14 +304,10 @@ tvb_composite_prepend(tvbuff_t *tvb, tvbuff_t *member)
 	if (member && member->length) {
 		composite       = &composite_tvb->composite;
 		/* Attach the composite TVB to the first TVB only. */
-		if (g_sequence_is_empty(composite->tvbs)) {
+		if (composite->pending->len == 0) {
 			tvb_add_to_chain(member, tvb);
 		}
-		tvb_comp_member_t *new_member = g_new(tvb_comp_member_t, 1);
-		new_member->tvb = member;
-		new_member->start_offset = 0;
-		new_member->end_offset = 0;
-		g_sequence_prepend(composite->tvbs, new_member);
+		g_ptr_array_insert(composite->pending, 0, member);
 	}
 }
 
@@ -314,25 +330,25 @@ tvb_composite_finalize(tvbuff_t *tvb)
 
 	composite   = &composite_tvb->composite;
 
-	num_members = g_sequence_get_length(composite->tvbs);
+	num_members = composite->pending->len;
 
 	/* Dissectors should not create composite TVBs if they're not going to
 	 * put at least one TVB in them.
-	 * (Without this check--or something similar--we'll seg-fault below.)
-	 * (XXX - Now with a GSequence we shouldn't segfault, we'll get the
-	 * end iterator and it should work, so we could remove this and some
-	 * checks in dissectors to simplify their code.)
+	 * (Without this check--or something similar--the member lookups
+	 * would index an empty array.)
 	 */
 	DISSECTOR_ASSERT(num_members);
 
 	/* Record the offsets - we have to do that now because it's possible
-	 * to prepend TVBs. Note that the GSequence is already sorted according
-	 * to these offsets, we're just noting them, so we don't need to sort.
+	 * to prepend TVBs. The pending array is already in offset order,
+	 * so the members just have to be copied over.
 	 */
-	GSequenceIter *iter = g_sequence_get_begin_iter(composite->tvbs);
-	for (i=0; i < num_members; i++, iter=g_sequence_iter_next(iter)) {
-		member = (tvb_comp_member_t *)g_sequence_get(iter);
-		member_tvb = member->tvb;
+	composite->members = g_new(tvb_comp_member_t, num_members);
+	composite->num_members = num_members;
+	for (i=0; i < num_members; i++) {
+		member = &composite->members[i];
+		member_tvb = (tvbuff_t *)g_ptr_array_index(composite->pending, i);
+		member->tvb = member_tvb;
 		member->start_offset = tvb->length;
 		tvb->length += member_tvb->length;
 		/* XXX - What does it mean to make a composite TVB out of
@@ -342,6 +358,8 @@ tvb_composite_finalize(tvbuff_t *tvb)
 		tvb->contained_length += member_tvb->contained_length;
 		member->end_offset = tvb->length - 1;
 	}
+	g_ptr_array_free(composite->pending, true);
+	composite->pending = NULL;
 
 	tvb->initialized = true;
 	tvb->ds_tvb = tvb;
@@ -81,6 +81,19 @@ void wscbor_enc_int64(GByteArray *buf, int64_t value) {
     }
 }
 
+void wscbor_enc_float64(GByteArray *buf, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint8_t tmp[9];
+    tmp[0] = (CBOR_TYPE_FLOAT_CTRL << 5) | 0x1B;
+    for (unsigned ix = 8; ix > 0; --ix) {
+        tmp[ix] = (uint8_t)(bits & 0xFF);
+        bits >>= 8;
+    }
+    g_byte_array_append(buf, tmp, sizeof(tmp));
+}
+
 void wscbor_enc_bstr(GByteArray *buf, const uint8_t *ptr, size_t len) {
     wscbor_enc_head(buf, CBOR_TYPE_BYTESTRING, len);
     if (len && (len < UINT_MAX)) {
@@ -111,3 +124,26 @@ void wscbor_enc_array_head(GByteArray *buf, size_t len) {
 void wscbor_enc_map_head(GByteArray *buf, size_t len) {
     wscbor_enc_head(buf, CBOR_TYPE_MAP, len);
 }
+
+/** Encode a head with the indefinite length minor type.
+ */
+static void wscbor_enc_head_indef(GByteArray *buf, uint8_t type_major) {
+    const uint8_t tmp[1] = { (type_major << 5) | 0x1F };
+    g_byte_array_append(buf, tmp, sizeof(tmp));
+}
+
+void wscbor_enc_bstr_head_indef(GByteArray *buf) {
+    wscbor_enc_head_indef(buf, CBOR_TYPE_BYTESTRING);
+}
+
+void wscbor_enc_array_head_indef(GByteArray *buf) {
+    wscbor_enc_head_indef(buf, CBOR_TYPE_ARRAY);
+}
+
+void wscbor_enc_map_head_indef(GByteArray *buf) {
+    wscbor_enc_head_indef(buf, CBOR_TYPE_MAP);
+}
+
+void wscbor_enc_break(GByteArray *buf) {
+    wscbor_enc_head_indef(buf, CBOR_TYPE_FLOAT_CTRL);
+}
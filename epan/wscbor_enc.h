@@ -55,6 +55,13 @@ void wscbor_enc_uint64(GByteArray *buf, uint64_t value);
 WS_DLL_PUBLIC
 void wscbor_enc_int64(GByteArray *buf, int64_t value);
 
+/** Add an item containing a double precision float.
+ * @param[in,out] buf The buffer to append to.
+ * @param value The value to write.
+ */
+WS_DLL_PUBLIC
+void wscbor_enc_float64(GByteArray *buf, double value);
+
 /** Add an item containing a definite length byte string.
  * @param[in,out] buf The buffer to append to.
  * @param[in] ptr The data to write.
@@ -98,6 +105,36 @@ void wscbor_enc_array_head(GByteArray *buf, size_t len);
 WS_DLL_PUBLIC
 void wscbor_enc_map_head(GByteArray *buf, size_t len);
 
+/** Add a byte string header with an indefinite length.
+ * @note The items which follow this header must be definite length
+ * byte strings, terminated by wscbor_enc_break().
+ * @param[in,out] buf The buffer to append to.
+ */
+WS_DLL_PUBLIC
+void wscbor_enc_bstr_head_indef(GByteArray *buf);
+
+/** Add an array header with an indefinite length.
+ * @note The items which follow this header must be terminated by
+ * wscbor_enc_break().
+ * @param[in,out] buf The buffer to append to.
+ */
+WS_DLL_PUBLIC
+void wscbor_enc_array_head_indef(GByteArray *buf);
+
+/** Add a map header with an indefinite length.
+ * @note The pairs which follow this header must be terminated by
+ * wscbor_enc_break().
+ * @param[in,out] buf The buffer to append to.
+ */
+WS_DLL_PUBLIC
+void wscbor_enc_map_head_indef(GByteArray *buf);
+
+/** Add the "break" stop code ending an indefinite length item.
+ * @param[in,out] buf The buffer to append to.
+ */
+WS_DLL_PUBLIC
+void wscbor_enc_break(GByteArray *buf);
+
 #ifdef __cplusplus
 }
 #endif
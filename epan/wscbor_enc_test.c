@@ -178,6 +178,41 @@ wscbor_enc_test_uint64(void)
     }
 }
 
+typedef struct {
+    double value;
+    // Raw bytes expected
+    int enc_len;
+    const uint8_t *enc;
+} wscbor_enc_test_float64_t;
+
+static const wscbor_enc_test_float64_t input_float64[] = {
+    { 0.0, 9, (const uint8_t *)"\xFB\x00\x00\x00\x00\x00\x00\x00\x00"},
+    { 1.1, 9, (const uint8_t *)"\xFB\x3F\xF1\x99\x99\x99\x99\x99\x9A"},
+    { -4.1, 9, (const uint8_t *)"\xFB\xC0\x10\x66\x66\x66\x66\x66\x66"},
+    { 1.0e+300, 9, (const uint8_t *)"\xFB\x7E\x37\xE4\x3C\x88\x00\x75\x9C"},
+};
+
+static void
+wscbor_enc_test_float64(void)
+{
+    for (size_t inp_ix = 0; inp_ix < array_length(input_float64); ++inp_ix) {
+        const wscbor_enc_test_float64_t *inp = &input_float64[inp_ix];
+        printf("case #%zu with %g\n", inp_ix, inp->value);
+
+        GByteArray *buf = g_byte_array_new();
+        g_assert_nonnull(buf);
+
+        wscbor_enc_float64(buf, inp->value);
+
+        GBytes *data = g_byte_array_free_to_bytes(buf);
+        g_assert_nonnull(data);
+        g_assert_cmpmem(g_bytes_get_data(data, NULL), (int)g_bytes_get_size(data),
+                        inp->enc, (int)inp->enc_len);
+
+        g_bytes_unref(data);
+    }
+}
+
 typedef struct {
     const size_t len;
     const uint8_t *ptr;
@@ -282,6 +317,63 @@ wscbor_enc_test_map(void)
     g_bytes_unref(data);
 }
 
+static void
+wscbor_enc_test_bstr_indef(void)
+{
+    GByteArray *buf = g_byte_array_new();
+    g_assert_nonnull(buf);
+
+    wscbor_enc_bstr_head_indef(buf);
+    wscbor_enc_bstr(buf, (const uint8_t *)"\x01\x02", 2);
+    wscbor_enc_bstr(buf, (const uint8_t *)"\x03", 1);
+    wscbor_enc_break(buf);
+
+    GBytes *data = g_byte_array_free_to_bytes(buf);
+    g_assert_nonnull(data);
+    g_assert_cmpmem(g_bytes_get_data(data, NULL), (int)g_bytes_get_size(data),
+                    "\x5F\x42\x01\x02\x41\x03\xFF", (int)7);
+
+    g_bytes_unref(data);
+}
+
+static void
+wscbor_enc_test_array_indef(void)
+{
+    GByteArray *buf = g_byte_array_new();
+    g_assert_nonnull(buf);
+
+    wscbor_enc_array_head_indef(buf);
+    wscbor_enc_int64(buf, 10);
+    wscbor_enc_int64(buf, -10);
+    wscbor_enc_break(buf);
+
+    GBytes *data = g_byte_array_free_to_bytes(buf);
+    g_assert_nonnull(data);
+    g_assert_cmpmem(g_bytes_get_data(data, NULL), (int)g_bytes_get_size(data),
+                    "\x9F\x0A\x29\xFF", (int)4);
+
+    g_bytes_unref(data);
+}
+
+static void
+wscbor_enc_test_map_indef(void)
+{
+    GByteArray *buf = g_byte_array_new();
+    g_assert_nonnull(buf);
+
+    wscbor_enc_map_head_indef(buf);
+    wscbor_enc_tstr(buf, "hi");
+    wscbor_enc_boolean(buf, true);
+    wscbor_enc_break(buf);
+
+    GBytes *data = g_byte_array_free_to_bytes(buf);
+    g_assert_nonnull(data);
+    g_assert_cmpmem(g_bytes_get_data(data, NULL), (int)g_bytes_get_size(data),
+                    "\xBF\x62\x68\x69\xF5\xFF", (int)6);
+
+    g_bytes_unref(data);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -294,10 +386,14 @@ main(int argc, char **argv)
     g_test_add_func("/wscbor_enc/boolean", wscbor_enc_test_boolean);
     g_test_add_func("/wscbor_enc/int64", wscbor_enc_test_int64);
     g_test_add_func("/wscbor_enc/uint64", wscbor_enc_test_uint64);
+    g_test_add_func("/wscbor_enc/float64", wscbor_enc_test_float64);
     g_test_add_func("/wscbor_enc/bstr", wscbor_enc_test_bstr);
     g_test_add_func("/wscbor_enc/tstr", wscbor_enc_test_tstr);
     g_test_add_func("/wscbor_enc/array", wscbor_enc_test_array);
     g_test_add_func("/wscbor_enc/map", wscbor_enc_test_map);
+    g_test_add_func("/wscbor_enc/bstr_indef", wscbor_enc_test_bstr_indef);
+    g_test_add_func("/wscbor_enc/array_indef", wscbor_enc_test_array_indef);
+    g_test_add_func("/wscbor_enc/map_indef", wscbor_enc_test_map_indef);
 
     result = g_test_run();
 
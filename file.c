@@ -4939,6 +4939,8 @@ cf_select_packet(capture_file *cf, frame_data *fdata)
     /* Create the logical protocol tree. */
     /* We don't need the columns here. */
     cf->edt = epan_dissect_new(cf->epan, true, true);
+    /* Only the parts of the tree that are shown need their string values. */
+    epan_dissect_defer_strings(cf->edt, true);
 
     /* Prime for color filter evaluation so dissect_frame stores all matching
      * filters in proto_data, reflecting current session state (e.g., after
@@ -15,6 +15,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 #include <limits.h>
 #include <signal.h>
 
@@ -73,6 +74,10 @@ capture_file cfile;
 
 static frame_data ref_frame;
 
+/* Set when the capture file delivered name resolution or decryption secrets
+ * blocks, which are only seen by the sequential pass. */
+static bool cf_has_side_blocks;
+
 /*
  * The leading + ensures that getopt_long() does not permute the argv[]
  * entries.
@@ -99,6 +104,7 @@ static const struct ws_option long_options[] = {
     {"help", ws_no_argument, NULL, 'h'},
     {"version", ws_no_argument, NULL, 'v'},
     {"config-profile", ws_required_argument, NULL, 'C'},
+    {"snapshot-dir", ws_required_argument, NULL, LONGOPT_SNAPSHOT_DIR},
     LONGOPT_WSLOG
     {0, 0, 0, 0 }
 };
@@ -457,6 +463,27 @@ cf_close(capture_file *cf)
     cf->state = FILE_CLOSED;
 }
 
+static void
+sharkd_new_ipv4(const unsigned addr, const char *name, const bool static_entry)
+{
+    cf_has_side_blocks = true;
+    add_ipv4_name(addr, name, static_entry);
+}
+
+static void
+sharkd_new_ipv6(const ws_in6_addr *addrp, const char *name, const bool static_entry)
+{
+    cf_has_side_blocks = true;
+    add_ipv6_name(addrp, name, static_entry);
+}
+
+static void
+sharkd_new_secrets(uint32_t secrets_type, const void *secrets, unsigned size)
+{
+    cf_has_side_blocks = true;
+    secrets_wtap_callback(secrets_type, secrets, size);
+}
+
 cf_status_t
 cf_open(capture_file *cf, const char *fname, unsigned int type, bool is_tempfile, int *err)
 {
@@ -503,9 +530,10 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, bool is_tempfile
 
     cf->state = FILE_READ_IN_PROGRESS;
 
-    wtap_set_cb_new_ipv4(cf->provider.wth, add_ipv4_name);
-    wtap_set_cb_new_ipv6(cf->provider.wth, (wtap_new_ipv6_callback_t) add_ipv6_name);
-    wtap_set_cb_new_secrets(cf->provider.wth, secrets_wtap_callback);
+    cf_has_side_blocks = false;
+    wtap_set_cb_new_ipv4(cf->provider.wth, sharkd_new_ipv4);
+    wtap_set_cb_new_ipv6(cf->provider.wth, sharkd_new_ipv6);
+    wtap_set_cb_new_secrets(cf->provider.wth, sharkd_new_secrets);
 
     return CF_OK;
 
@@ -532,6 +560,399 @@ sharkd_load_cap_file_with_limits(int max_packet_count, int64_t max_byte_count)
     return load_cap_file(&cfile, max_packet_count, max_byte_count);
 }
 
+/*
+ * Frame table snapshot.
+ *
+ * A snapshot holds what the first pass learned about each record of a
+ * capture file without needing dissection: its file offset, lengths, time
+ * stamp and user flags. Restoring it rebuilds cfile.provider.frames and the
+ * frame counters without reading the file sequentially or dissecting it.
+ *
+ * The header identifies the capture file by its type, size, modification
+ * time and a hash of its first and last SHARKD_SNAPSHOT_SAMPLE_SIZE bytes,
+ * so that a file rewritten in place doesn't get a stale frame table.
+ * Snapshots are kept in the directory given with --snapshot-dir, named
+ * after a hash of that identity, so clients never choose the path that is
+ * written or read. Without the option, snapshots are disabled.
+ *
+ * Name resolution and decryption secrets blocks are only delivered by the
+ * sequential pass, so a snapshot of a file that has any is never restored;
+ * the file is loaded normally instead. Per-conversation dissector state
+ * (TCP, TLS, HTTP, DNS, ...) is out of scope: it is not saved. The restored
+ * frames have not been visited, so that state is built for frames in the
+ * order the client dissects them, and results that depend on seeing every
+ * earlier frame first, such as TCP sequence analysis, can differ from those
+ * of a normal load.
+ *
+ * All values are stored little-endian. The version must be bumped whenever
+ * the layout of the header or of the per-frame record changes.
+ */
+#define SHARKD_SNAPSHOT_MAGIC   "sharkdfs"
+#define SHARKD_SNAPSHOT_VERSION 2
+
+#define SHARKD_SNAPSHOT_SAMPLE_SIZE (64 * 1024)
+#define SHARKD_SNAPSHOT_DIGEST_LEN  32  /* SHA-256 */
+
+#define SHARKD_SNAPSHOT_HDR_SIDE_BLOCKS 0x0001u
+
+struct sharkd_snapshot_header {
+    char     magic[8];
+    uint32_t version;
+    uint32_t file_type_subtype;
+    int64_t  file_size;
+    int64_t  file_mtime;
+    uint8_t  file_digest[SHARKD_SNAPSHOT_DIGEST_LEN];
+    uint32_t frame_count;
+    uint32_t idb_count;         /* interfaces known at the end of the first pass */
+    uint32_t hdr_flags;
+    uint32_t reserved;
+};
+
+#define SHARKD_SNAPSHOT_FLAG_HAS_TS     0x0001u
+#define SHARKD_SNAPSHOT_FLAG_MARKED     0x0002u
+#define SHARKD_SNAPSHOT_FLAG_IGNORED    0x0004u
+#define SHARKD_SNAPSHOT_FLAG_REF_TIME   0x0008u
+#define SHARKD_SNAPSHOT_FLAG_EBCDIC     0x0010u
+#define SHARKD_SNAPSHOT_TSPREC_SHIFT    8
+#define SHARKD_SNAPSHOT_TCP_SND_SHIFT   16
+
+/* Directory that holds the snapshots, or NULL if they are disabled. */
+static char *snapshot_dir;
+
+struct sharkd_snapshot_frame {
+    int64_t  file_off;
+    int64_t  ts_secs;
+    int32_t  ts_nsecs;
+    uint32_t pkt_len;
+    uint32_t cap_len;
+    uint32_t flags;
+};
+
+static unsigned
+sharkd_snapshot_idb_count(wtap *wth)
+{
+    wtapng_iface_descriptions_t *idb_inf = wtap_file_get_idb_info(wth);
+    unsigned count = idb_inf->interface_data->len;
+
+    g_free(idb_inf);
+    return count;
+}
+
+/*
+ * Get the modification time of a capture file and a digest of its first
+ * and last SHARKD_SNAPSHOT_SAMPLE_SIZE bytes.
+ */
+static bool
+sharkd_snapshot_identify(const char *filename, int64_t *mtime, uint8_t *digest)
+{
+    ws_statb64 st;
+    GChecksum *checksum;
+    uint8_t *buf;
+    size_t len;
+    gsize digest_len = SHARKD_SNAPSHOT_DIGEST_LEN;
+    FILE *fh;
+    bool ok = true;
+
+    if (filename == NULL || ws_stat64(filename, &st) != 0)
+        return false;
+
+    fh = ws_fopen(filename, "rb");
+    if (fh == NULL)
+        return false;
+
+    checksum = g_checksum_new(G_CHECKSUM_SHA256);
+    buf = (uint8_t *)g_malloc(SHARKD_SNAPSHOT_SAMPLE_SIZE);
+
+    len = fread(buf, 1, SHARKD_SNAPSHOT_SAMPLE_SIZE, fh);
+    g_checksum_update(checksum, buf, len);
+
+    if ((int64_t)st.st_size > SHARKD_SNAPSHOT_SAMPLE_SIZE)
+    {
+        if (ws_fseek64(fh, -(int64_t)SHARKD_SNAPSHOT_SAMPLE_SIZE, SEEK_END) == 0)
+        {
+            len = fread(buf, 1, SHARKD_SNAPSHOT_SAMPLE_SIZE, fh);
+            g_checksum_update(checksum, buf, len);
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+
+    if (ferror(fh))
+        ok = false;
+
+    g_checksum_get_digest(checksum, digest, &digest_len);
+    g_checksum_free(checksum);
+    g_free(buf);
+    fclose(fh);
+
+    *mtime = (int64_t)st.st_mtime;
+    return ok;
+}
+
+/*
+ * Get the path of the snapshot of a capture file from the fields of the
+ * header that identify the file, stored little-endian.
+ */
+static char *
+sharkd_snapshot_path(const struct sharkd_snapshot_header *hdr)
+{
+    GChecksum *checksum;
+    char *name, *path;
+
+    checksum = g_checksum_new(G_CHECKSUM_SHA256);
+    g_checksum_update(checksum, (const uint8_t *)&hdr->file_type_subtype, sizeof(hdr->file_type_subtype));
+    g_checksum_update(checksum, (const uint8_t *)&hdr->file_size, sizeof(hdr->file_size));
+    g_checksum_update(checksum, (const uint8_t *)&hdr->file_mtime, sizeof(hdr->file_mtime));
+    g_checksum_update(checksum, hdr->file_digest, sizeof(hdr->file_digest));
+    name = g_strdup_printf("%s.%s", g_checksum_get_string(checksum), SHARKD_SNAPSHOT_MAGIC);
+    g_checksum_free(checksum);
+
+    path = g_build_filename(snapshot_dir, name, NULL);
+    g_free(name);
+    return path;
+}
+
+/*
+ * Fill in the fields of the header that identify the open capture file.
+ */
+static bool
+sharkd_snapshot_identify_cf(capture_file *cf, struct sharkd_snapshot_header *hdr)
+{
+    int64_t file_mtime;
+
+    if (!sharkd_snapshot_identify(cf->filename, &file_mtime, hdr->file_digest))
+        return false;
+
+    hdr->file_type_subtype = GUINT32_TO_LE((uint32_t)cf->cd_t);
+    hdr->file_size         = GINT64_TO_LE(wtap_file_size(cf->provider.wth, NULL));
+    hdr->file_mtime        = GINT64_TO_LE(file_mtime);
+    return true;
+}
+
+bool
+sharkd_set_snapshot_dir(const char *dir)
+{
+    if (!g_file_test(dir, G_FILE_TEST_IS_DIR))
+        return false;
+
+    g_free(snapshot_dir);
+    snapshot_dir = g_strdup(dir);
+    return true;
+}
+
+bool
+sharkd_snapshots_enabled(void)
+{
+    return snapshot_dir != NULL;
+}
+
+int
+sharkd_save_snapshot(void)
+{
+    struct sharkd_snapshot_header hdr;
+    char *fname;
+    FILE *fh;
+    int err = 0;
+
+    if (snapshot_dir == NULL)
+        return ENOTSUP;
+
+    if (cfile.provider.wth == NULL || cfile.provider.frames == NULL)
+        return EINVAL;
+
+    memset(&hdr, 0, sizeof(hdr));
+    if (!sharkd_snapshot_identify_cf(&cfile, &hdr))
+        return EIO;
+
+    fname = sharkd_snapshot_path(&hdr);
+    fh = ws_fopen(fname, "wb");
+    if (fh == NULL)
+    {
+        err = errno;
+        g_free(fname);
+        return err;
+    }
+
+    memcpy(hdr.magic, SHARKD_SNAPSHOT_MAGIC, sizeof(hdr.magic));
+    hdr.version           = GUINT32_TO_LE(SHARKD_SNAPSHOT_VERSION);
+    hdr.frame_count       = GUINT32_TO_LE(cfile.count);
+    hdr.idb_count         = GUINT32_TO_LE(sharkd_snapshot_idb_count(cfile.provider.wth));
+    hdr.hdr_flags         = GUINT32_TO_LE(cf_has_side_blocks ? SHARKD_SNAPSHOT_HDR_SIDE_BLOCKS : 0);
+
+    if (fwrite(&hdr, sizeof(hdr), 1, fh) != 1)
+        err = errno;
+
+    for (uint32_t framenum = 1; err == 0 && framenum <= cfile.count; framenum++)
+    {
+        const frame_data *fdata = sharkd_get_frame(framenum);
+        struct sharkd_snapshot_frame rec;
+        uint32_t flags = 0;
+
+        if (fdata->has_ts)
+            flags |= SHARKD_SNAPSHOT_FLAG_HAS_TS;
+        if (fdata->marked)
+            flags |= SHARKD_SNAPSHOT_FLAG_MARKED;
+        if (fdata->ignored)
+            flags |= SHARKD_SNAPSHOT_FLAG_IGNORED;
+        if (fdata->ref_time)
+            flags |= SHARKD_SNAPSHOT_FLAG_REF_TIME;
+        if (fdata->encoding == PACKET_CHAR_ENC_CHAR_EBCDIC)
+            flags |= SHARKD_SNAPSHOT_FLAG_EBCDIC;
+        flags |= (uint32_t)fdata->tsprec << SHARKD_SNAPSHOT_TSPREC_SHIFT;
+        flags |= (uint32_t)fdata->tcp_snd_manual_analysis << SHARKD_SNAPSHOT_TCP_SND_SHIFT;
+
+        rec.file_off = GINT64_TO_LE(fdata->file_off);
+        rec.ts_secs  = GINT64_TO_LE((int64_t)fdata->abs_ts.secs);
+        rec.ts_nsecs = GINT32_TO_LE(fdata->abs_ts.nsecs);
+        rec.pkt_len  = GUINT32_TO_LE(fdata->pkt_len);
+        rec.cap_len  = GUINT32_TO_LE(fdata->cap_len);
+        rec.flags    = GUINT32_TO_LE(flags);
+
+        if (fwrite(&rec, sizeof(rec), 1, fh) != 1)
+            err = errno;
+    }
+
+    if (fclose(fh) != 0 && err == 0)
+        err = errno;
+
+    /* The name is ours, so this only removes our own partial snapshot. */
+    if (err != 0)
+        ws_unlink(fname);
+
+    g_free(fname);
+    return err;
+}
+
+int
+sharkd_load_snapshot(void)
+{
+    capture_file *cf = &cfile;
+    struct sharkd_snapshot_header hdr;
+    struct sharkd_snapshot_header id;
+    char *fname;
+    FILE *fh;
+    uint32_t frame_count;
+    int err = 0;
+
+    if (snapshot_dir == NULL)
+        return ENOTSUP;
+
+    memset(&id, 0, sizeof(id));
+    if (!sharkd_snapshot_identify_cf(cf, &id))
+        return WTAP_ERR_BAD_FILE;
+
+    fname = sharkd_snapshot_path(&id);
+    fh = ws_fopen(fname, "rb");
+    if (fh == NULL)
+    {
+        err = errno;
+        g_free(fname);
+        return err;
+    }
+    g_free(fname);
+
+    if (fread(&hdr, sizeof(hdr), 1, fh) != 1 ||
+            memcmp(hdr.magic, SHARKD_SNAPSHOT_MAGIC, sizeof(hdr.magic)) != 0 ||
+            GUINT32_FROM_LE(hdr.version) != SHARKD_SNAPSHOT_VERSION)
+    {
+        fclose(fh);
+        return WTAP_ERR_UNSUPPORTED;
+    }
+
+    /*
+     * The snapshot must describe this very file. Interfaces seen later in
+     * the file are only learned by a sequential read, so random access
+     * reads can't resolve them if the open did not see them all.
+     */
+    if (hdr.file_type_subtype != id.file_type_subtype ||
+            hdr.file_size != id.file_size ||
+            hdr.file_mtime != id.file_mtime ||
+            memcmp(hdr.file_digest, id.file_digest, sizeof(id.file_digest)) != 0 ||
+            GUINT32_FROM_LE(hdr.idb_count) > sharkd_snapshot_idb_count(cf->provider.wth))
+    {
+        fclose(fh);
+        return WTAP_ERR_BAD_FILE;
+    }
+
+    /* Restoring would lose the names and secrets of those blocks. */
+    if (GUINT32_FROM_LE(hdr.hdr_flags) & SHARKD_SNAPSHOT_HDR_SIDE_BLOCKS)
+    {
+        fclose(fh);
+        return WTAP_ERR_UNSUPPORTED;
+    }
+
+    frame_count = GUINT32_FROM_LE(hdr.frame_count);
+
+    cf->provider.frames = new_frame_data_sequence();
+
+    for (uint32_t framenum = 1; framenum <= frame_count; framenum++)
+    {
+        struct sharkd_snapshot_frame rec;
+        frame_data fdlocal;
+        uint32_t flags;
+
+        if (fread(&rec, sizeof(rec), 1, fh) != 1)
+        {
+            err = WTAP_ERR_SHORT_READ;
+            break;
+        }
+
+        flags = GUINT32_FROM_LE(rec.flags);
+
+        memset(&fdlocal, 0, sizeof(fdlocal));
+        fdlocal.num            = framenum;
+        fdlocal.dis_num        = framenum;
+        fdlocal.file_off       = GINT64_FROM_LE(rec.file_off);
+        fdlocal.pkt_len        = GUINT32_FROM_LE(rec.pkt_len);
+        fdlocal.cap_len        = GUINT32_FROM_LE(rec.cap_len);
+        fdlocal.abs_ts.secs    = (time_t)GINT64_FROM_LE(rec.ts_secs);
+        fdlocal.abs_ts.nsecs   = GINT32_FROM_LE(rec.ts_nsecs);
+        fdlocal.passed_dfilter = 1;
+        fdlocal.has_ts         = (flags & SHARKD_SNAPSHOT_FLAG_HAS_TS) ? 1 : 0;
+        fdlocal.marked         = (flags & SHARKD_SNAPSHOT_FLAG_MARKED) ? 1 : 0;
+        fdlocal.ignored        = (flags & SHARKD_SNAPSHOT_FLAG_IGNORED) ? 1 : 0;
+        fdlocal.ref_time       = (flags & SHARKD_SNAPSHOT_FLAG_REF_TIME) ? 1 : 0;
+        fdlocal.encoding       = (flags & SHARKD_SNAPSHOT_FLAG_EBCDIC) ? PACKET_CHAR_ENC_CHAR_EBCDIC : PACKET_CHAR_ENC_CHAR_ASCII;
+        fdlocal.tsprec         = (flags >> SHARKD_SNAPSHOT_TSPREC_SHIFT) & 0xF;
+        fdlocal.tcp_snd_manual_analysis = (flags >> SHARKD_SNAPSHOT_TCP_SND_SHIFT) & 0xFF;
+
+        /* Same bookkeeping as process_packet(), minus the dissection. */
+        frame_data_set_before_dissect(&fdlocal, &cf->elapsed_time,
+                &cf->provider.ref, cf->provider.prev_dis);
+        if (cf->provider.ref == &fdlocal) {
+            ref_frame = fdlocal;
+            cf->provider.ref = &ref_frame;
+        }
+        frame_data_set_after_dissect(&fdlocal, &cf->cum_bytes);
+        cf->provider.prev_cap = cf->provider.prev_dis = frame_data_sequence_add(cf->provider.frames, &fdlocal);
+        cf->count++;
+    }
+
+    fclose(fh);
+
+    if (err != 0)
+    {
+        free_frame_data_sequence(cf->provider.frames);
+        cf->provider.frames = NULL;
+        cf->provider.ref = NULL;
+        cf->count = 0;
+        cf->cum_bytes = 0;
+        nstime_set_zero(&cf->elapsed_time);
+    }
+    else
+    {
+        /* The sequential side isn't needed, only random access reads. */
+        wtap_sequential_close(cf->provider.wth);
+    }
+
+    cf->provider.prev_dis = NULL;
+    cf->provider.prev_cap = NULL;
+
+    return err;
+}
+
 frame_data *
 sharkd_get_frame(uint32_t framenum)
 {
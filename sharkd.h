@@ -29,6 +29,7 @@
 typedef void (*sharkd_dissect_func_t)(epan_dissect_t *edt, proto_tree *tree, struct epan_column_info *cinfo, const GSList *data_src, void *data);
 
 #define LONGOPT_FOREGROUND 4000
+#define LONGOPT_SNAPSHOT_DIR 4001
 
 /* sharkd.c */
 
@@ -63,6 +64,59 @@ int sharkd_load_cap_file(void);
  */
 int sharkd_load_cap_file_with_limits(int max_packet_count, int64_t max_byte_count);
 
+/**
+ * @brief Set the directory that holds frame table snapshots.
+ *
+ * Snapshots are disabled until this is called.
+ *
+ * @param dir The directory, which must exist.
+ * @return true on success, false if dir is not a directory.
+ */
+bool sharkd_set_snapshot_dir(const char *dir);
+
+/**
+ * @brief Check if a snapshot directory has been set.
+ *
+ * @return true if snapshots can be saved and restored.
+ */
+bool sharkd_snapshots_enabled(void);
+
+/**
+ * @brief Save a snapshot of the frame table of the current capture file.
+ *
+ * The snapshot records, for every frame, what the first pass learned without
+ * dissecting it (file offset, lengths, time stamp and user flags), so that a
+ * later session can restore the frame table with sharkd_load_snapshot().
+ * Dissector state, including per-conversation state such as that of TCP,
+ * TLS, HTTP or DNS, is out of scope and not part of the snapshot.
+ *
+ * The snapshot is written to the snapshot directory, under a name derived
+ * from the identity of the capture file, replacing any earlier snapshot of
+ * the same file.
+ *
+ * @return 0 on success, an errno value on failure.
+ */
+int sharkd_save_snapshot(void);
+
+/**
+ * @brief Restore the frame table of the just opened capture file from a snapshot.
+ *
+ * Must be called after sharkd_cf_open() instead of sharkd_load_cap_file().
+ * The snapshot is only used if it was written for the same, unmodified
+ * file, and if that file has no name resolution or decryption secrets
+ * blocks, which only the sequential pass delivers. On failure nothing is
+ * loaded and the capture file can be loaded normally instead.
+ *
+ * Frames of a restored file have not been visited by the dissectors, so
+ * state that depends on earlier frames (conversations, reassembly,
+ * decryption) is built for frames in the order they get dissected. Results
+ * that depend on seeing every earlier frame first, such as TCP sequence
+ * analysis, can therefore differ from those of a normal load.
+ *
+ * @return 0 on success, an errno or WTAP_ERR_ value on failure.
+ */
+int sharkd_load_snapshot(void);
+
 /**
  * @brief Retaps all packets in the current capture file.
  *
@@ -231,6 +231,8 @@ print_usage(FILE* output)
     fprintf(output, "  -v, --version            show version information\n");
     fprintf(output, "  -C <config profile>, --config-profile <config profile>\n");
     fprintf(output, "                           start with specified configuration profile\n");
+    fprintf(output, "  --snapshot-dir <directory>\n");
+    fprintf(output, "                           keep frame table snapshots in this directory\n");
 
     fprintf(output, "\n");
     fprintf(output, "Supported socket types:\n");
@@ -384,6 +386,13 @@ sharkd_init(int argc, char **argv)
                     foreground = true;
                     break;
 
+                case LONGOPT_SNAPSHOT_DIR:
+                    if (!sharkd_set_snapshot_dir(ws_optarg)) {
+                        fprintf(stderr, "Snapshot directory \"%s\" does not exist\n", ws_optarg);
+                        return -1;
+                    }
+                    break;
+
                 default:
                     /* wslog arguments are okay */
                     if (ws_log_is_wslog_arg(opt))
@@ -49,6 +49,8 @@
 #include <epan/srt_table.h>
 #include <epan/to_str.h>
 #include <epan/secrets.h>
+#include <epan/wscbor_enc.h>
+#include <epan/wmem_scopes.h>
 
 #include <epan/dissectors/packet-h225.h>
 #include <ui/voip_calls.h>
@@ -83,6 +85,7 @@ struct sharkd_filter_item
 };
 
 static GHashTable *filter_table;
+static GHashTable *frames_cursors;
 
 static int mode;
 static uint32_t rpcid;
@@ -107,21 +110,168 @@ json_find_attr(const char *buf, const jsmntok_t *tokens, int count, const char *
     return NULL;
 }
 
+/*
+ * Responses are normally JSON text written through the json_dumper. Once a
+ * client negotiates CBOR with the "encoding" request, every response is
+ * instead a single CBOR data item (so a session is a CBOR sequence, RFC 8742)
+ * built from indefinite length maps and arrays, with numbers sent as native
+ * CBOR integers and floats and byte fields sent as raw byte strings.
+ */
+#define SHARKD_ENCODING_JSON  0
+#define SHARKD_ENCODING_CBOR  1
+
+#define SHARKD_CBOR_FLUSH_SIZE (64 * 1024)
+
+static int encoding = SHARKD_ENCODING_JSON;
+static GByteArray *cbor_buf;
+
+static void
+sharkd_cbor_flush(void)
+{
+    if (cbor_buf->len)
+    {
+        fwrite(cbor_buf->data, 1, cbor_buf->len, stdout);
+        g_byte_array_set_size(cbor_buf, 0);
+    }
+}
+
 static void
-json_print_base64(const uint8_t *data, size_t len)
+sharkd_cbor_member_name(const char *key)
 {
+    if (key)
+        wscbor_enc_tstr(cbor_buf, key);
+}
+
+/*
+ * Convert a JSON literal, as produced by the format strings passed to
+ * sharkd_json_value_anyf(), to CBOR. Only what sharkd itself emits is
+ * handled: numbers, true/false/null and (nested) arrays of them.
+ */
+static const char *
+// NOLINTNEXTLINE(misc-no-recursion)
+sharkd_cbor_value_literal(const char *text)
+{
+    while (g_ascii_isspace(*text))
+        text++;
+
+    if (*text == '[')
+    {
+        text++;
+        wscbor_enc_array_head_indef(cbor_buf);
+        while (g_ascii_isspace(*text))
+            text++;
+        while (*text != '\0' && *text != ']')
+        {
+            // We recurse here but our depth is limited by our format strings
+            text = sharkd_cbor_value_literal(text);
+            while (g_ascii_isspace(*text) || *text == ',')
+                text++;
+        }
+        wscbor_enc_break(cbor_buf);
+        return (*text == ']') ? text + 1 : text;
+    }
+
+    if (g_str_has_prefix(text, "true"))
+    {
+        wscbor_enc_boolean(cbor_buf, true);
+        return text + 4;
+    }
+    if (g_str_has_prefix(text, "false"))
+    {
+        wscbor_enc_boolean(cbor_buf, false);
+        return text + 5;
+    }
+    if (g_str_has_prefix(text, "null"))
+    {
+        wscbor_enc_null(cbor_buf);
+        return text + 4;
+    }
+
+    size_t len = strcspn(text, ",]");
+    char *end;
+
+    if (strcspn(text, ".eEnNiI") < len)
+    {
+        double value = g_ascii_strtod(text, &end);
+        wscbor_enc_float64(cbor_buf, value);
+    }
+    else if (*text == '-')
+    {
+        int64_t value = g_ascii_strtoll(text, &end, 10);
+        wscbor_enc_int64(cbor_buf, value);
+    }
+    else
+    {
+        uint64_t value = g_ascii_strtoull(text, &end, 10);
+        wscbor_enc_uint64(cbor_buf, value);
+    }
+
+    /* Anything we cannot parse is skipped rather than looping forever. */
+    return (end != text) ? end : text + len;
+}
+
+static void
+sharkd_json_base64_open(const char *key)
+{
+    if (encoding == SHARKD_ENCODING_CBOR)
+    {
+        sharkd_cbor_member_name(key);
+        wscbor_enc_bstr_head_indef(cbor_buf);
+        return;
+    }
+
+    if (key)
+        json_dumper_set_member_name(&dumper, key);
     json_dumper_begin_base64(&dumper);
+}
+
+static void
+sharkd_json_base64_write(const uint8_t *data, size_t len)
+{
+    if (encoding == SHARKD_ENCODING_CBOR)
+    {
+        /* An indefinite length byte string is a series of definite length chunks. */
+        wscbor_enc_bstr(cbor_buf, data, len);
+        if (cbor_buf->len >= SHARKD_CBOR_FLUSH_SIZE)
+            sharkd_cbor_flush();
+        return;
+    }
+
     json_dumper_write_base64(&dumper, data, len);
+}
+
+static void
+sharkd_json_base64_close(void)
+{
+    if (encoding == SHARKD_ENCODING_CBOR)
+    {
+        wscbor_enc_break(cbor_buf);
+        return;
+    }
+
     json_dumper_end_base64(&dumper);
 }
 
 static void G_GNUC_PRINTF(2, 3)
 sharkd_json_value_anyf(const char *key, const char *format, ...)
 {
+    va_list ap;
+
+    if (encoding == SHARKD_ENCODING_CBOR)
+    {
+        sharkd_cbor_member_name(key);
+
+        va_start(ap, format);
+        char *literal = ws_strdup_vprintf(format, ap);
+        va_end(ap);
+        sharkd_cbor_value_literal(literal);
+        g_free(literal);
+        return;
+    }
+
     if (key)
         json_dumper_set_member_name(&dumper, key);
 
-    va_list ap;
     va_start(ap, format);
     json_dumper_value_va_list(&dumper, format, ap);
     va_end(ap);
@@ -130,6 +280,16 @@ sharkd_json_value_anyf(const char *key, const char *format, ...)
 static void
 sharkd_json_value_string(const char *key, const char *str)
 {
+    if (encoding == SHARKD_ENCODING_CBOR)
+    {
+        sharkd_cbor_member_name(key);
+        if (str)
+            wscbor_enc_tstr(cbor_buf, str);
+        else
+            wscbor_enc_null(cbor_buf);
+        return;
+    }
+
     if (key)
         json_dumper_set_member_name(&dumper, key);
     json_dumper_value_string(&dumper, str);
@@ -138,18 +298,38 @@ sharkd_json_value_string(const char *key, const char *str)
 static void
 sharkd_json_value_base64(const char *key, const uint8_t *data, size_t len)
 {
-    if (key)
-        json_dumper_set_member_name(&dumper, key);
-    json_print_base64(data, len);
+    if (encoding == SHARKD_ENCODING_CBOR)
+    {
+        sharkd_cbor_member_name(key);
+        wscbor_enc_bstr(cbor_buf, data, len);
+        return;
+    }
+
+    sharkd_json_base64_open(key);
+    json_dumper_write_base64(&dumper, data, len);
+    sharkd_json_base64_close();
 }
 
 static void G_GNUC_PRINTF(2, 3)
 sharkd_json_value_stringf(const char *key, const char *format, ...)
 {
+    va_list ap;
+
+    if (encoding == SHARKD_ENCODING_CBOR)
+    {
+        sharkd_cbor_member_name(key);
+
+        va_start(ap, format);
+        char *str = ws_strdup_vprintf(format, ap);
+        va_end(ap);
+        wscbor_enc_tstr(cbor_buf, str);
+        g_free(str);
+        return;
+    }
+
     if (key)
         json_dumper_set_member_name(&dumper, key);
 
-    va_list ap;
     va_start(ap, format);
     char* sformat = ws_strdup_printf("\"%s\"", format);
     json_dumper_value_va_list(&dumper, sformat, ap);
@@ -160,6 +340,13 @@ sharkd_json_value_stringf(const char *key, const char *format, ...)
 static void
 sharkd_json_array_open(const char *key)
 {
+    if (encoding == SHARKD_ENCODING_CBOR)
+    {
+        sharkd_cbor_member_name(key);
+        wscbor_enc_array_head_indef(cbor_buf);
+        return;
+    }
+
     if (key)
         json_dumper_set_member_name(&dumper, key);
     json_dumper_begin_array(&dumper);
@@ -168,12 +355,27 @@ sharkd_json_array_open(const char *key)
 static void
 sharkd_json_array_close(void)
 {
+    if (encoding == SHARKD_ENCODING_CBOR)
+    {
+        wscbor_enc_break(cbor_buf);
+        if (cbor_buf->len >= SHARKD_CBOR_FLUSH_SIZE)
+            sharkd_cbor_flush();
+        return;
+    }
+
     json_dumper_end_array(&dumper);
 }
 
 static void
 sharkd_json_object_open(const char *key)
 {
+    if (encoding == SHARKD_ENCODING_CBOR)
+    {
+        sharkd_cbor_member_name(key);
+        wscbor_enc_map_head_indef(cbor_buf);
+        return;
+    }
+
     if (key)
         json_dumper_set_member_name(&dumper, key);
     json_dumper_begin_object(&dumper);
@@ -182,13 +384,21 @@ sharkd_json_object_open(const char *key)
 static void
 sharkd_json_object_close(void)
 {
+    if (encoding == SHARKD_ENCODING_CBOR)
+    {
+        wscbor_enc_break(cbor_buf);
+        if (cbor_buf->len >= SHARKD_CBOR_FLUSH_SIZE)
+            sharkd_cbor_flush();
+        return;
+    }
+
     json_dumper_end_object(&dumper);
 }
 
 static void
 sharkd_json_response_open(uint32_t id)
 {
-    json_dumper_begin_object(&dumper);  // start the message
+    sharkd_json_object_open(NULL);  // start the message
     sharkd_json_value_string("jsonrpc", "2.0");
     sharkd_json_value_anyf("id", "%d", id);
 }
@@ -196,9 +406,12 @@ sharkd_json_response_open(uint32_t id)
 static void
 sharkd_json_response_close(void)
 {
-    json_dumper_end_object(&dumper);  // end the message
+    sharkd_json_object_close();  // end the message
 
-    json_dumper_finish(&dumper);
+    if (encoding == SHARKD_ENCODING_CBOR)
+        sharkd_cbor_flush();
+    else
+        json_dumper_finish(&dumper);
 
     /*
      * We do an explicit fflush after every line, because
@@ -227,7 +440,7 @@ sharkd_json_result_prologue(uint32_t id)
 static void
 sharkd_json_result_epilogue(void)
 {
-    json_dumper_end_object(&dumper);  // end the result object
+    sharkd_json_object_close();  // end the result object
     sharkd_json_response_close();
 }
 
@@ -376,6 +589,7 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"method",     "complete",       1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "download",       1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "dumpconf",       1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"method",     "encoding",       1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "follow",         1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "field",          1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "fields",         1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
@@ -387,6 +601,7 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"method",     "load",           1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "setcomment",     1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "setconf",        1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"method",     "snapshot",       1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "status",         1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"method",     "tap",            1, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
 
@@ -397,6 +612,7 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"complete",   "pref",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"download",   "token",          2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"dumpconf",   "pref",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"encoding",   "name",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
         {"follow",     "follow",         2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
         {"follow",     "filter",         2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
         {"follow",     "sub_stream",     2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
@@ -414,6 +630,8 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"frames",     "skip",           2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"frames",     "limit",          2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"frames",     "refs",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"frames",     "paged",          2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
+        {"frames",     "cursor",         2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"intervals",  "interval",       2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"intervals",  "filter",         2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"iograph",    "interval",       2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
@@ -452,6 +670,7 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"load",       "file",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
         {"load",       "max_packets",    2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"load",       "max_bytes",      2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
+        {"load",       "snapshot",       2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
         {"setcomment", "frame",          2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_MANDATORY},
         {"setcomment", "comment",        2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
         {"setconf",    "name",           2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
@@ -814,10 +1033,10 @@ sharkd_session_process_info_nstat_cb(const void *key, void *value, void *userdat
 {
     stat_tap_table_ui *stat_tap = (stat_tap_table_ui *) value;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_string("name", stat_tap->title);
     sharkd_json_value_stringf("tap", "nstat:%s", (const char *) key);
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 
     return false;
 }
@@ -831,18 +1050,18 @@ sharkd_session_process_info_conv_cb(const void* key, void* value, void* userdata
 
     if (get_conversation_packet_func(table))
     {
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
         sharkd_json_value_stringf("name", "Conversation List/%s", label);
         sharkd_json_value_stringf("tap", "conv:%s", label);
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
 
     if (get_endpoint_packet_func(table))
     {
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
         sharkd_json_value_stringf("name", "Endpoint/%s", label);
         sharkd_json_value_stringf("tap", "endpt:%s", label);
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     return false;
 }
@@ -852,10 +1071,10 @@ sharkd_session_seq_analysis_cb(const void *key, void *value, void *userdata _U_)
 {
     register_analysis_t *analysis = (register_analysis_t *) value;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_string("name", sequence_analysis_get_ui_name(analysis));
     sharkd_json_value_stringf("tap", "seqa:%s", (const char *) key);
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 
     return false;
 }
@@ -869,10 +1088,10 @@ sharkd_export_object_visit_cb(const void *key _U_, void *value, void *user_data
     const char *filter = proto_get_protocol_filter_name(proto_id);
     const char *label  = proto_get_protocol_short_name(find_protocol_by_id(proto_id));
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_stringf("name", "Export Object/%s", label);
     sharkd_json_value_stringf("tap", "eo:%s", filter);
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 
     return false;
 }
@@ -886,10 +1105,10 @@ sharkd_srt_visit_cb(const void *key _U_, void *value, void *user_data _U_)
     const char *filter = proto_get_protocol_filter_name(proto_id);
     const char *label  = proto_get_protocol_short_name(find_protocol_by_id(proto_id));
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_stringf("name", "Service Response Time/%s", label);
     sharkd_json_value_stringf("tap", "srt:%s", filter);
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 
     return false;
 }
@@ -903,10 +1122,10 @@ sharkd_rtd_visit_cb(const void *key _U_, void *value, void *user_data _U_)
     const char *filter = proto_get_protocol_filter_name(proto_id);
     const char *label  = proto_get_protocol_short_name(find_protocol_by_id(proto_id));
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_stringf("name", "Response Time Delay/%s", label);
     sharkd_json_value_stringf("tap", "rtd:%s", filter);
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 
     return false;
 }
@@ -920,10 +1139,10 @@ sharkd_follower_visit_cb(const void *key _U_, void *value, void *user_data _U_)
     const char *label  = proto_get_protocol_short_name(find_protocol_by_id(proto_id));
     const char *filter = label; /* correct: get_follow_by_name() is registered by short name */
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_stringf("name", "Follow/%s", label);
     sharkd_json_value_stringf("tap", "follow:%s", filter);
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 
     return false;
 }
@@ -1056,10 +1275,10 @@ sharkd_session_process_info(void)
         const char *col_format = col_format_to_string(i);
         const char *col_descr  = col_format_desc(i);
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
         sharkd_json_value_string("name", col_descr);
         sharkd_json_value_string("format", col_format);
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 
@@ -1072,10 +1291,10 @@ sharkd_session_process_info(void)
         {
             stats_tree_cfg *cfg = (stats_tree_cfg *) l->data;
 
-            json_dumper_begin_object(&dumper);
+            sharkd_json_object_open(NULL);
             sharkd_json_value_string("name", cfg->title);
             sharkd_json_value_stringf("tap", "stat:%s", cfg->abbr);
-            json_dumper_end_object(&dumper);
+            sharkd_json_object_close();
         }
 
         g_list_free(cfg_list);
@@ -1114,35 +1333,35 @@ sharkd_session_process_info(void)
 
     sharkd_json_array_open("taps");
     {
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
         sharkd_json_value_string("name", "UDP Multicast Streams");
         sharkd_json_value_string("tap", "multicast");
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
         sharkd_json_value_string("name", "RTP streams");
         sharkd_json_value_string("tap", "rtp-streams");
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
         sharkd_json_value_string("name", "Protocol Hierarchy Statistics");
         sharkd_json_value_string("tap", "phs");
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
         sharkd_json_value_string("name", "VoIP Calls");
         sharkd_json_value_string("tap", "voip-calls");
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
         sharkd_json_value_string("name", "VoIP Conversations");
         sharkd_json_value_string("tap", "voip-convs");
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
         sharkd_json_value_string("name", "Expert Information");
         sharkd_json_value_string("tap", "expert");
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 
@@ -1195,6 +1414,9 @@ sharkd_session_print_fields(void)
     void* field_cookie = NULL;
     int protocol_id = -1;
 
+    /* Register the fields of protocols that register them on first use. */
+    proto_initialize_all_prefixes();
+
     for (protocol_id = proto_get_first_protocol(&proto_cookie); protocol_id != -1; protocol_id = proto_get_next_protocol(&proto_cookie))
     {
         protocol_t* protocol = find_protocol_by_id(protocol_id);
@@ -1286,9 +1508,22 @@ sharkd_session_process_field(const char* buf, const jsmntok_t* tokens, int count
  *
  * Input:
  *   (m) file - file to be loaded
+ *   (o) max_packets - stop loading after this many packets
+ *   (o) max_bytes - stop loading after this many bytes
+ *   (o) snapshot - true to restore the frame table from the snapshot of this file,
+ *                  written by the snapshot request, instead of reading the whole file
  *
  * Output object with attributes:
  *   (m) err - error code
+ *   (o) snapshot - "restored" if the snapshot was used, "ignored" if there is none
+ *                  for this file as it is now, snapshots are disabled, or the file
+ *                  has name resolution or decryption secrets blocks, and the file
+ *                  was loaded normally
+ *
+ * The frames of a restored file have not been dissected yet. Dissector state
+ * that depends on earlier frames, such as conversations, reassembly, decryption
+ * and TCP sequence analysis, is built in the order the client requests frames,
+ * so it can differ from that of a normal load, until the frames are retapped.
  */
 static void
 sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
@@ -1296,6 +1531,9 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
     const char *tok_file = json_find_attr(buf, tokens, count, "file");
     const char *tok_max_packets = json_find_attr(buf, tokens, count, "max_packets");
     const char *tok_max_bytes = json_find_attr(buf, tokens, count, "max_bytes");
+    const char *tok_snapshot = json_find_attr(buf, tokens, count, "snapshot");
+    bool use_snapshot = (tok_snapshot && !strcmp(tok_snapshot, "true"));
+    bool snapshot_restored = false;
     int err = 0;
 
     uint32_t max_packets = 0;  /* 0 means unlimited */
@@ -1343,12 +1581,28 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
     }
 
     /* The open succeeded, and any previous file was closed. Remove any filter
-     * results that refer to the previous file. */
+     * results and frames cursors that refer to the previous file. */
     g_hash_table_remove_all(filter_table);
+    g_hash_table_remove_all(frames_cursors);
+
+    /* A snapshot describes the whole file, so it can't honor load limits. */
+    if (use_snapshot && max_packets == 0 && max_bytes == 0)
+    {
+        err = sharkd_load_snapshot();
+        if (err == 0)
+            snapshot_restored = true;
+        else
+            fprintf(stderr, "load: snapshot not used: %s\n", wtap_strerror(err));
+        err = 0;
+    }
 
     TRY
     {
-        if (max_packets > 0 || max_bytes > 0)
+        if (snapshot_restored)
+        {
+            /* The frame table has been restored, nothing to read. */
+        }
+        else if (max_packets > 0 || max_bytes > 0)
         {
             err = sharkd_load_cap_file_with_limits((int)max_packets, (int64_t)max_bytes);
         }
@@ -1368,10 +1622,17 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
     }
     ENDTRY;
 
-    if (err == 0)
+    if (err == 0 && !use_snapshot)
     {
         sharkd_json_simple_ok(rpcid);
     }
+    else if (err == 0)
+    {
+        sharkd_json_result_prologue(rpcid);
+        sharkd_json_value_string("status", "OK");
+        sharkd_json_value_string("snapshot", snapshot_restored ? "restored" : "ignored");
+        sharkd_json_result_epilogue();
+    }
     else
     {
         sharkd_json_result_prologue(rpcid);
@@ -1382,6 +1643,27 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
 
 }
 
+static void
+sharkd_session_write_wmem_stats(const char *name, wmem_allocator_t *allocator)
+{
+    wmem_allocator_stats_t stats;
+
+    wmem_allocator_get_stats(allocator, &stats);
+
+    sharkd_json_object_open(name);
+    sharkd_json_value_anyf("in_use", "%" PRIu64, stats.bytes_in_use);
+    sharkd_json_value_anyf("peak", "%" PRIu64, stats.bytes_peak);
+    sharkd_json_value_anyf("blocks", "%u", stats.block_count);
+    sharkd_json_value_anyf("allocations", "%" PRIu64, stats.alloc_count);
+    sharkd_json_array_open("histogram");
+    for (unsigned i = 0; i < WMEM_ALLOC_HISTOGRAM_BUCKETS; i++)
+    {
+        sharkd_json_value_anyf(NULL, "%" PRIu64, stats.alloc_histogram[i]);
+    }
+    sharkd_json_array_close();
+    sharkd_json_object_close();
+}
+
 /**
  * sharkd_session_process_status()
  *
@@ -1398,6 +1680,19 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
  *                      'format'   - column format (%x or %Cus:<expr>:<occurrence> if COL_CUSTOM)
  *                      'visible'  - true if column is visible
  *                      'display'  - column display format; 'U', 'R' or 'D'
+ *   (m) memory      - memory statistics, object with attributes:
+ *                      'epan'        - the epan scope, see below
+ *                      'file'        - the file scope, see below
+ *                      'block_cache' - bytes in the block cache of the session thread
+ *
+ * The scope objects have attributes:
+ *   (m) in_use      - bytes of system memory held by the scope
+ *   (m) peak        - highest value in_use has reached
+ *   (m) blocks      - number of blocks held by the scope
+ *   (m) allocations - number of allocations made in the scope
+ *   (m) histogram   - array of allocation counts by size; element i counts the
+ *                     allocations of at most 16 << (2 * i) bytes that didn't fit
+ *                     in the previous element, the last one all larger ones
  */
 static void
 sharkd_session_process_status(void)
@@ -1451,6 +1746,12 @@ sharkd_session_process_status(void)
         sharkd_json_array_close();
     }
 
+    sharkd_json_object_open("memory");
+    sharkd_session_write_wmem_stats("epan", wmem_epan_scope());
+    sharkd_session_write_wmem_stats("file", wmem_file_scope());
+    sharkd_json_value_anyf("block_cache", "%zu", wmem_block_cache_size());
+    sharkd_json_object_close();
+
     sharkd_json_result_epilogue();
 }
 
@@ -1649,7 +1950,7 @@ sharkd_session_process_frames_cb(epan_dissect_t *edt, proto_tree *tree _U_,
     unsigned int i;
     char *comment = NULL;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
 
     sharkd_json_array_open("c");
     for (unsigned col = 0; col < cinfo->num_cols; ++col)
@@ -1693,7 +1994,77 @@ sharkd_session_process_frames_cb(epan_dissect_t *edt, proto_tree *tree _U_,
     }
 
     wtap_block_unref(pkt_block);
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
+}
+
+/*
+ * Iteration state of a paged frames request, kept between requests so that
+ * the next page can be resumed where the previous one stopped.
+ */
+struct sharkd_frames_cursor
+{
+    char *filter;               /* NULL if all frames are requested */
+    column_info *cinfo;         /* NULL if default column set is used */
+    char *refs;                 /* NULL if no time reference frames given */
+    const char *refs_pos;       /* parse position in refs */
+    uint32_t next_framenum;     /* first frame number to check on resume */
+    uint32_t prev_dis_num;
+    uint32_t current_ref_frame;
+    uint32_t next_ref_frame;
+};
+
+#define SHARKD_FRAMES_CURSORS_MAX 16
+
+static uint32_t frames_cursor_next_id = 1;
+
+static void
+sharkd_session_frames_cursor_clear(struct sharkd_frames_cursor *cursor)
+{
+    if (cursor->cinfo)
+    {
+        col_cleanup(cursor->cinfo);
+        g_free(cursor->cinfo);
+    }
+    g_free(cursor->filter);
+    g_free(cursor->refs);
+}
+
+static void
+sharkd_session_frames_cursor_free(void *data)
+{
+    struct sharkd_frames_cursor *cursor = (struct sharkd_frames_cursor *) data;
+
+    sharkd_session_frames_cursor_clear(cursor);
+    g_free(cursor);
+}
+
+static uint32_t
+sharkd_session_frames_cursor_add(struct sharkd_frames_cursor *cursor)
+{
+    uint32_t id;
+
+    /* Abandoned cursors are never released by the client, drop the oldest one. */
+    if (g_hash_table_size(frames_cursors) >= SHARKD_FRAMES_CURSORS_MAX)
+    {
+        GHashTableIter iter;
+        void *key;
+        uint32_t oldest = UINT32_MAX;
+
+        g_hash_table_iter_init(&iter, frames_cursors);
+        while (g_hash_table_iter_next(&iter, &key, NULL))
+        {
+            if (GPOINTER_TO_UINT(key) < oldest)
+                oldest = GPOINTER_TO_UINT(key);
+        }
+        g_hash_table_remove(frames_cursors, GUINT_TO_POINTER(oldest));
+    }
+
+    id = frames_cursor_next_id++;
+    if (frames_cursor_next_id == 0)
+        frames_cursor_next_id = 1;
+
+    g_hash_table_insert(frames_cursors, GUINT_TO_POINTER(id), cursor);
+    return id;
 }
 
 /**
@@ -1708,6 +2079,9 @@ sharkd_session_process_frames_cb(epan_dissect_t *edt, proto_tree *tree _U_,
  *   (o) skip=N   - skip N frames
  *   (o) limit=N  - show only N frames
  *   (o) refs  - list (comma separated) with sorted time reference frame numbers.
+ *   (o) paged - if true, keep the iteration state on the server and return a cursor to resume from
+ *   (o) cursor=N - resume the paged request identified by cursor N; the filter, columns and refs
+ *                  of the original request are used, only limit is taken from this request.
  *
  * Output array of frames with attributes:
  *   (m) c   - array of column data
@@ -1718,6 +2092,10 @@ sharkd_session_process_frames_cb(epan_dissect_t *edt, proto_tree *tree _U_,
  *   (o) comments - array of comment strings
  *   (o) bg  - color filter - background color in hex
  *   (o) fg  - color filter - foreground color in hex
+ *
+ * For paged or cursor requests, output object with attributes:
+ *   (m) frames - array of frames as above
+ *   (o) cursor - cursor to pass in the next request, present only while frames remain
  */
 static void
 sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int count)
@@ -1727,74 +2105,119 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
     const char *tok_skip   = json_find_attr(buf, tokens, count, "skip");
     const char *tok_limit  = json_find_attr(buf, tokens, count, "limit");
     const char *tok_refs   = json_find_attr(buf, tokens, count, "refs");
+    const char *tok_paged  = json_find_attr(buf, tokens, count, "paged");
+    const char *tok_cursor = json_find_attr(buf, tokens, count, "cursor");
 
     const uint8_t *filter_data = NULL;
 
-    uint32_t prev_dis_num = 0;
-    uint32_t current_ref_frame = 0, next_ref_frame = UINT32_MAX;
+    struct sharkd_frames_cursor request_state;
+    struct sharkd_frames_cursor *state;
+    uint32_t cursor_id = 0;
+    bool paged;
+    uint32_t framenum;
     uint32_t skip;
     uint32_t limit;
 
     wtap_rec rec; /* Record information */
     column_info *cinfo = &cfile.cinfo;
-    column_info user_cinfo;
 
-    if (tok_column)
+    limit = 0;
+    if (tok_limit)
+    {
+        if (!ws_strtou32(tok_limit, NULL, &limit))
+            return;
+    }
+
+    if (tok_cursor)
     {
-        memset(&user_cinfo, 0, sizeof(user_cinfo));
-        cinfo = sharkd_session_create_columns(&user_cinfo, buf, tokens, count);
-        if (!cinfo)
+        if (!ws_strtou32(tok_cursor, NULL, &cursor_id))
+            return;
+
+        state = (struct sharkd_frames_cursor *) g_hash_table_lookup(frames_cursors, GUINT_TO_POINTER(cursor_id));
+        if (!state)
         {
             sharkd_json_error(
-                    rpcid, -13001, NULL,
-                    "Column definition invalid - note column 6 requires a custom definition"
+                    rpcid, -13003, NULL,
+                    "Cursor %u not found or expired", cursor_id
                     );
             return;
         }
+
+        paged = true;
+        skip = 0;
     }
+    else
+    {
+        state = &request_state;
+        memset(state, 0, sizeof(*state));
+        state->next_framenum = 1;
+        state->next_ref_frame = UINT32_MAX;
 
-    if (tok_filter)
+        if (tok_column)
+        {
+            state->cinfo = g_new0(column_info, 1);
+            if (!sharkd_session_create_columns(state->cinfo, buf, tokens, count))
+            {
+                g_free(state->cinfo);
+                sharkd_json_error(
+                        rpcid, -13001, NULL,
+                        "Column definition invalid - note column 6 requires a custom definition"
+                        );
+                return;
+            }
+        }
+
+        skip = 0;
+        if (tok_skip)
+        {
+            if (!ws_strtou32(tok_skip, NULL, &skip))
+                goto invalid_request;
+        }
+
+        if (tok_refs)
+        {
+            state->refs = g_strdup(tok_refs);
+            if (!ws_strtou32(state->refs, &state->refs_pos, &state->next_ref_frame))
+                goto invalid_request;
+        }
+
+        if (tok_filter)
+            state->filter = g_strdup(tok_filter);
+
+        paged = (tok_paged && !strcmp(tok_paged, "true"));
+    }
+
+    if (state->filter)
     {
         const struct sharkd_filter_item *filter_item;
 
-        filter_item = sharkd_session_filter_data(tok_filter);
+        filter_item = sharkd_session_filter_data(state->filter);
         if (!filter_item)
         {
             sharkd_json_error(
                     rpcid, -13002, NULL,
                     "Filter expression invalid"
                     );
-            return;
+            goto invalid_request;
         }
 
         filter_data = filter_item->filtered;
     }
 
-    skip = 0;
-    if (tok_skip)
-    {
-        if (!ws_strtou32(tok_skip, NULL, &skip))
-            return;
-    }
-
-    limit = 0;
-    if (tok_limit)
-    {
-        if (!ws_strtou32(tok_limit, NULL, &limit))
-            return;
-    }
+    if (state->cinfo)
+        cinfo = state->cinfo;
 
-    if (tok_refs)
+    if (paged)
     {
-        if (!ws_strtou32(tok_refs, &tok_refs, &next_ref_frame))
-            return;
+        sharkd_json_result_prologue(rpcid);
+        sharkd_json_array_open("frames");
     }
-
-    sharkd_json_result_array_prologue(rpcid);
+    else
+        sharkd_json_result_array_prologue(rpcid);
 
     wtap_rec_init(&rec, DEFAULT_INIT_BUFFER_SIZE_2048);
 
-    for (uint32_t framenum = 1; framenum <= cfile.count; framenum++)
+    for (framenum = state->next_framenum; framenum <= cfile.count; framenum++)
     {
         frame_data *fdata;
         uint32_t ref_frame = (framenum != 1) ? 1 : 0;
@@ -1808,44 +2231,48 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
         if (skip)
         {
             skip--;
-            prev_dis_num = framenum;
+            state->prev_dis_num = framenum;
             continue;
         }
 
-        if (tok_refs)
+        if (state->refs)
         {
-            if (framenum >= next_ref_frame)
+            const char *refs_pos = state->refs_pos;
+
+            if (framenum >= state->next_ref_frame)
             {
-                current_ref_frame = next_ref_frame;
+                state->current_ref_frame = state->next_ref_frame;
 
-                if (*tok_refs != ',')
-                    next_ref_frame = UINT32_MAX;
+                if (*refs_pos != ',')
+                    state->next_ref_frame = UINT32_MAX;
 
-                while (*tok_refs == ',' && framenum >= next_ref_frame)
+                while (*refs_pos == ',' && framenum >= state->next_ref_frame)
                 {
-                    current_ref_frame = next_ref_frame;
+                    state->current_ref_frame = state->next_ref_frame;
 
-                    if (!ws_strtou32(tok_refs + 1, &tok_refs, &next_ref_frame))
+                    if (!ws_strtou32(refs_pos + 1, &refs_pos, &state->next_ref_frame))
                     {
-                        fprintf(stderr, "sharkd_session_process_frames() wrong format for refs: %s\n", tok_refs);
+                        fprintf(stderr, "sharkd_session_process_frames() wrong format for refs: %s\n", refs_pos);
                         break;
                     }
                 }
 
-                if (*tok_refs == '\0' && framenum >= next_ref_frame)
+                if (*refs_pos == '\0' && framenum >= state->next_ref_frame)
                 {
-                    current_ref_frame = next_ref_frame;
-                    next_ref_frame = UINT32_MAX;
+                    state->current_ref_frame = state->next_ref_frame;
+                    state->next_ref_frame = UINT32_MAX;
                 }
             }
 
-            if (current_ref_frame)
-                ref_frame = current_ref_frame;
+            state->refs_pos = refs_pos;
+
+            if (state->current_ref_frame)
+                ref_frame = state->current_ref_frame;
         }
 
         fdata = sharkd_get_frame(framenum);
         status = sharkd_dissect_request(framenum,
-                ref_frame, prev_dis_num,
+                ref_frame, state->prev_dis_num,
                 &rec, cinfo,
                 (fdata->color_filter == NULL) ? SHARKD_DISSECT_FLAG_COLOR : SHARKD_DISSECT_FLAG_NULL,
                 &sharkd_session_process_frames_cb, NULL,
@@ -1868,17 +2295,47 @@ sharkd_session_process_frames(const char *buf, const jsmntok_t *tokens, int coun
                 break;
         }
 
-        prev_dis_num = framenum;
+        state->prev_dis_num = framenum;
 
         if (limit && --limit == 0)
+        {
+            framenum++;
             break;
+        }
     }
-    sharkd_json_result_array_epilogue();
-
-    if (cinfo != &cfile.cinfo)
-        col_cleanup(cinfo);
 
     wtap_rec_cleanup(&rec);
+
+    if (!paged)
+    {
+        sharkd_json_result_array_epilogue();
+        sharkd_session_frames_cursor_clear(state);
+        return;
+    }
+
+    sharkd_json_array_close();
+
+    state->next_framenum = framenum;
+    if (framenum <= cfile.count)
+    {
+        if (state == &request_state)
+        {
+            state = (struct sharkd_frames_cursor *) g_memdup2(&request_state, sizeof(request_state));
+            cursor_id = sharkd_session_frames_cursor_add(state);
+        }
+        sharkd_json_value_anyf("cursor", "%u", cursor_id);
+    }
+    else if (state == &request_state)
+        sharkd_session_frames_cursor_clear(state);
+    else
+        g_hash_table_remove(frames_cursors, GUINT_TO_POINTER(cursor_id));
+
+    sharkd_json_result_epilogue();
+    return;
+
+invalid_request:
+    if (state == &request_state)
+        sharkd_session_frames_cursor_clear(state);
 }
 
 static void
@@ -1890,7 +2347,7 @@ sharkd_session_process_tap_stats_node_cb(const char *key, const stat_node *n)
     sharkd_json_array_open(key);
     for (node = n->children; node; node = node->next)
     {
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         /* code based on stats_tree_get_values_from_node() */
         sharkd_json_value_string("name", node->name);
@@ -1935,7 +2392,7 @@ sharkd_session_process_tap_stats_node_cb(const char *key, const stat_node *n)
             // We recurse here but our depth is limited
             sharkd_session_process_tap_stats_node_cb("sub", node);
         }
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 }
@@ -1966,7 +2423,7 @@ sharkd_session_process_tap_stats_cb(void *psp)
 {
     stats_tree *st = (stats_tree *) psp;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
 
     sharkd_json_value_stringf("tap", "stats:%s", st->cfg->abbr);
     sharkd_json_value_string("type", "stats");
@@ -1974,7 +2431,7 @@ sharkd_session_process_tap_stats_cb(void *psp)
 
     sharkd_session_process_tap_stats_node_cb("stats", &st->root);
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 static void
@@ -2011,7 +2468,7 @@ sharkd_session_process_tap_expert_cb(void *tapdata)
     struct sharkd_expert_tap *etd = (struct sharkd_expert_tap *) tapdata;
     GSList *list;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
 
     sharkd_json_value_string("tap", "expert");
     sharkd_json_value_string("type", "expert");
@@ -2022,7 +2479,7 @@ sharkd_session_process_tap_expert_cb(void *tapdata)
         expert_info_t *ei = (expert_info_t *) list->data;
         const char *tmp;
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         sharkd_json_value_anyf("f", "%u", ei->packet_num);
 
@@ -2039,11 +2496,11 @@ sharkd_session_process_tap_expert_cb(void *tapdata)
         if (ei->protocol)
             sharkd_json_value_string("p", ei->protocol);
 
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 static tap_packet_status
@@ -2101,7 +2558,7 @@ sharkd_session_process_tap_flow_cb(void *tapdata)
 
     sequence_analysis_get_nodes(graph_analysis);
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_stringf("tap", "seqa:%s", graph_analysis->name);
     sharkd_json_value_string("type", "flow");
 
@@ -2127,7 +2584,7 @@ sharkd_session_process_tap_flow_cb(void *tapdata)
         if (!sai->display)
             continue;
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         sharkd_json_value_string("t", sai->time_str);
         sharkd_json_value_anyf("n", "[%u,%u]", sai->src_node, sai->dst_node);
@@ -2136,11 +2593,11 @@ sharkd_session_process_tap_flow_cb(void *tapdata)
         if (sai->comment)
             sharkd_json_value_string("c", sai->comment);
 
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 static void
@@ -2348,7 +2805,7 @@ sharkd_session_process_tap_rtp_analyse_cb(void *tapdata)
 
     GSList *l;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
 
     sharkd_json_value_string("tap", rtp_req->tap_name);
     sharkd_json_value_string("type", "rtp-analyse");
@@ -2368,7 +2825,7 @@ sharkd_session_process_tap_rtp_analyse_cb(void *tapdata)
     {
         struct sharkd_analyse_rtp_items *item = (struct sharkd_analyse_rtp_items *) l->data;
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         sharkd_json_value_anyf("f", "%u", item->frame_num);
         sharkd_json_value_anyf("o", "%.9f", item->arrive_offset);
@@ -2432,11 +2889,11 @@ sharkd_session_process_tap_rtp_analyse_cb(void *tapdata)
         if (item->marker)
             sharkd_json_value_anyf("mark", "1");
 
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 /**
@@ -2481,7 +2938,7 @@ sharkd_session_process_tap_conv_cb(void *arg)
 
     int with_geoip = 0;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_string("tap", iu->type);
 
     if (!strncmp(iu->type, "conv:", 5))
@@ -2513,7 +2970,7 @@ sharkd_session_process_tap_conv_cb(void *arg)
             char *src_port, *dst_port;
             char *filter_str;
 
-            json_dumper_begin_object(&dumper);
+            sharkd_json_object_open(NULL);
 
             sharkd_json_value_string("saddr", (src_addr = get_conversation_address(NULL, &iui->src_address, iu->resolve_name)));
             sharkd_json_value_string("daddr", (dst_addr = get_conversation_address(NULL, &iui->dst_address, iu->resolve_name)));
@@ -2551,7 +3008,7 @@ sharkd_session_process_tap_conv_cb(void *arg)
             if (sharkd_session_geoip_addr(&(iui->dst_address), "2"))
                 with_geoip = 1;
 
-            json_dumper_end_object(&dumper);
+            sharkd_json_object_close();
         }
     }
     else if (iu->hash.conv_array != NULL && !strncmp(iu->type, "endpt:", 6))
@@ -2562,7 +3019,7 @@ sharkd_session_process_tap_conv_cb(void *arg)
             char *host_str, *port_str;
             char *filter_str;
 
-            json_dumper_begin_object(&dumper);
+            sharkd_json_object_open(NULL);
 
             sharkd_json_value_string("host", (host_str = get_conversation_address(NULL, &endpoint->myaddress, iu->resolve_name)));
 
@@ -2590,7 +3047,7 @@ sharkd_session_process_tap_conv_cb(void *arg)
 
             if (sharkd_session_geoip_addr(&(endpoint->myaddress), ""))
                 with_geoip = 1;
-            json_dumper_end_object(&dumper);
+            sharkd_json_object_close();
         }
     }
     sharkd_json_array_close();
@@ -2598,7 +3055,7 @@ sharkd_session_process_tap_conv_cb(void *arg)
     sharkd_json_value_string("proto", proto);
     sharkd_json_value_anyf("geoip", with_geoip ? "true" : "false");
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 static void
@@ -2638,7 +3095,7 @@ sharkd_session_process_tap_nstat_cb(void *arg)
     stat_data_t *stat_data = (stat_data_t *) arg;
     unsigned i, j, k;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_stringf("tap", "nstat:%s", stat_data->stat_tap_data->cli_string);
     sharkd_json_value_string("type", "nstat");
 
@@ -2647,9 +3104,9 @@ sharkd_session_process_tap_nstat_cb(void *arg)
     {
         stat_tap_table_item *field = &(stat_data->stat_tap_data->fields[i]);
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
         sharkd_json_value_string("c", field->column_name);
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 
@@ -2658,7 +3115,7 @@ sharkd_session_process_tap_nstat_cb(void *arg)
     {
         stat_tap_table *table = g_array_index(stat_data->stat_tap_data->tables, stat_tap_table *, i);
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         sharkd_json_value_string("t", table->title);
 
@@ -2707,11 +3164,11 @@ sharkd_session_process_tap_nstat_cb(void *arg)
             sharkd_json_array_close();
         }
         sharkd_json_array_close();
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 static void
@@ -2763,7 +3220,7 @@ sharkd_session_process_tap_rtd_cb(void *arg)
      */
     const value_string *vs = get_rtd_value_string(rtd);
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_stringf("tap", "rtd:%s", filter);
     sharkd_json_value_string("type", "rtd");
 
@@ -2789,7 +3246,7 @@ sharkd_session_process_tap_rtd_cb(void *arg)
             if (ms->rtd[j].num == 0)
                 continue;
 
-            json_dumper_begin_object(&dumper);
+            sharkd_json_object_open(NULL);
 
             if (rtd_data->stat_table.num_rtds == 1)
                 type_str = val_to_str_const(j, vs, "Other"); /* 1 table - description per row */
@@ -2813,12 +3270,12 @@ sharkd_session_process_tap_rtd_cb(void *arg)
                 sharkd_json_value_anyf("rsp_dup", "%u", ms->rsp_dup_num);
             }
 
-            json_dumper_end_object(&dumper);
+            sharkd_json_object_close();
         }
     }
     sharkd_json_array_close();
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 static void
@@ -2859,7 +3316,7 @@ sharkd_session_process_tap_srt_cb(void *arg)
 
     unsigned i;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_stringf("tap", "srt:%s", filter);
     sharkd_json_value_string("type", "srt");
 
@@ -2871,7 +3328,7 @@ sharkd_session_process_tap_srt_cb(void *arg)
 
         int j;
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         if (rst->name)
             sharkd_json_value_string("n", rst->name);
@@ -2895,7 +3352,7 @@ sharkd_session_process_tap_srt_cb(void *arg)
             if (proc->stats.num == 0)
                 continue;
 
-            json_dumper_begin_object(&dumper);
+            sharkd_json_object_open(NULL);
 
             sharkd_json_value_string("n", proc->procedure);
 
@@ -2908,15 +3365,15 @@ sharkd_session_process_tap_srt_cb(void *arg)
             sharkd_json_value_anyf("max", "%.9f", nstime_to_sec(&proc->stats.max));
             sharkd_json_value_anyf("tot", "%.9f", nstime_to_sec(&proc->stats.tot));
 
-            json_dumper_end_object(&dumper);
+            sharkd_json_object_close();
         }
         sharkd_json_array_close();
 
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 static void
@@ -3024,7 +3481,7 @@ sharkd_session_process_tap_eo_cb(void *tapdata)
     char *sha1sum_str;
     uint8_t sha1sum_bytes[HASH_SHA1_LENGTH];
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_string("tap", object_list->type);
     sharkd_json_value_string("type", "eo");
 
@@ -3035,7 +3492,7 @@ sharkd_session_process_tap_eo_cb(void *tapdata)
     {
         const export_object_entry_t *eo_entry = (export_object_entry_t *) slist->data;
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         sharkd_json_value_anyf("pkt", "%u", eo_entry->pkt_num);
 
@@ -3057,13 +3514,13 @@ sharkd_session_process_tap_eo_cb(void *tapdata)
         sharkd_json_value_string("sha1", sha1sum_str);
         g_free(sha1sum_str);
 
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
 
         i++;
     }
     sharkd_json_array_close();
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 static void
@@ -3124,7 +3581,7 @@ sharkd_session_process_tap_rtp_cb(void *arg)
 
     GList *listx;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_string("tap", "rtp-streams");
     sharkd_json_value_string("type", "rtp-streams");
 
@@ -3136,7 +3593,7 @@ sharkd_session_process_tap_rtp_cb(void *arg)
 
         rtpstream_info_calculate(streaminfo, &calc);
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         sharkd_json_value_stringf("ssrc", "0x%x", calc.ssrc);
         sharkd_json_value_string("payload", calc.all_payload_type_names);
@@ -3170,11 +3627,11 @@ sharkd_session_process_tap_rtp_cb(void *arg)
 
         rtpstream_info_calc_free(&calc);
 
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 /**
@@ -3211,7 +3668,7 @@ sharkd_session_process_tap_multicast_cb(void *arg)
     GList *list_item;
     char *addr_str;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
 
     sharkd_json_value_string("tap", "multicast");
     sharkd_json_value_string("type", "multicast");
@@ -3262,7 +3719,7 @@ sharkd_session_process_tap_multicast_cb(void *arg)
     }
     sharkd_json_array_close();
 
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 }
 
 static void
@@ -4222,7 +4679,7 @@ sharkd_session_process_follow(char *buf, const jsmntok_t *tokens, int count)
         {
             follow_record = (follow_record_t *) cur->data;
 
-            json_dumper_begin_object(&dumper);
+            sharkd_json_object_open(NULL);
 
             sharkd_json_value_anyf("n", "%u", follow_record->packet_num);
             sharkd_json_value_base64("d", follow_record->data->data, follow_record->data->len);
@@ -4230,7 +4687,7 @@ sharkd_session_process_follow(char *buf, const jsmntok_t *tokens, int count)
             if (follow_record->is_server)
                 sharkd_json_value_anyf("s", "%d", 1);
 
-            json_dumper_end_object(&dumper);
+            sharkd_json_object_close();
         }
         sharkd_json_array_close();
     }
@@ -4258,7 +4715,7 @@ sharkd_session_process_frame_cb_tree(const char *key, epan_dissect_t *edt, proto
         if (!display_hidden && FI_GET_FLAG(finfo, FI_HIDDEN))
             continue;
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         if (!finfo->rep)
         {
@@ -4351,7 +4808,7 @@ sharkd_session_process_frame_cb_tree(const char *key, epan_dissect_t *edt, proto
             sharkd_session_process_frame_cb_tree("n", edt, (proto_tree *) node, tvbs, display_hidden);
         }
 
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
     }
     sharkd_json_array_close();
 }
@@ -4375,10 +4832,10 @@ sharkd_follower_visit_layers_cb(const void *key _U_, void *value, void *user_dat
 
         follow_filter = get_follow_conv_func(follower)(edt, pi, &ignore_stream, &ignore_sub_stream);
 
-        json_dumper_begin_array(&dumper);
-        json_dumper_value_string(&dumper, layer_proto);
-        json_dumper_value_string(&dumper, follow_filter);
-        json_dumper_end_array(&dumper);
+        sharkd_json_array_open(NULL);
+        sharkd_json_value_string(NULL, layer_proto);
+        sharkd_json_value_string(NULL, follow_filter);
+        sharkd_json_array_close();
 
         g_free(follow_filter);
     }
@@ -4573,11 +5030,11 @@ sharkd_session_process_frame_cb(epan_dissect_t *edt, proto_tree *tree, struct ep
         {
             src = (struct data_source *) data_src->data;
 
-            json_dumper_begin_object(&dumper);
+            sharkd_json_object_open(NULL);
 
             sharkd_session_process_add_data_source(src, ds_open);
 
-            json_dumper_end_object(&dumper);
+            sharkd_json_object_close();
 
             data_src = data_src->next;
         }
@@ -4788,7 +5245,15 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
         }
 
         if (!graph->error)
-            graph->error = register_tap_listener("frame", graph, tok_filter, TL_REQUIRES_PROTO_TREE, NULL, sharkd_iograph_packet, NULL, NULL);
+            graph->error = register_tap_listener("frame", graph, tok_filter, TL_REQUIRES_NOTHING, NULL, sharkd_iograph_packet, NULL, NULL);
+
+        if (!graph->error && graph->hf_index >= 0)
+        {
+            /* Only the graphed field is read from the tree. */
+            GArray *wanted_hfids = g_array_new(false, false, (unsigned)sizeof(int));
+            g_array_append_val(wanted_hfids, graph->hf_index);
+            set_tap_wanted_hfids(graph, wanted_hfids);
+        }
 
         if (graph->error)
         {
@@ -4814,7 +5279,7 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
     {
         struct sharkd_iograph *graph = &graphs[i];
 
-        json_dumper_begin_object(&dumper);
+        sharkd_json_object_open(NULL);
 
         if (graph->error)
         {
@@ -4847,7 +5312,7 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
             }
             sharkd_json_array_close();
         }
-        json_dumper_end_object(&dumper);
+        sharkd_json_object_close();
 
     }
     sharkd_json_array_close();
@@ -5212,10 +5677,10 @@ sharkd_session_process_complete_pref_cb(module_t *module, void *d)
     if (strncmp(data->pref, module->name, strlen(data->pref)) != 0)
         return 0;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_string("f", module->name);
     sharkd_json_value_string("d", module->title);
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 
     return 0;
 }
@@ -5230,10 +5695,10 @@ sharkd_session_process_complete_pref_option_cb(pref_t *pref, void *d)
     if (strncmp(data->pref, pref_name, strlen(data->pref)) != 0)
         return 0;
 
-    json_dumper_begin_object(&dumper);
+    sharkd_json_object_open(NULL);
     sharkd_json_value_stringf("f", "%s.%s", data->module, pref_name);
     sharkd_json_value_string("d", pref_title);
-    json_dumper_end_object(&dumper);
+    sharkd_json_object_close();
 
     return 0; /* continue */
 }
@@ -5276,6 +5741,10 @@ sharkd_session_process_complete(char *buf, const jsmntok_t *tokens, int count)
 
         sharkd_json_array_open("field");
 
+        /* Register the fields of protocols that register them on first use. */
+        if (filter_with_dot)
+            proto_initialize_all_prefixes();
+
         for (proto_id = proto_get_first_protocol(&proto_cookie); proto_id != -1; proto_id = proto_get_next_protocol(&proto_cookie))
         {
             protocol_t *protocol = find_protocol_by_id(proto_id);
@@ -5291,13 +5760,13 @@ sharkd_session_process_complete(char *buf, const jsmntok_t *tokens, int count)
 
             if (strlen(protocol_filter) >= filter_length && !g_ascii_strncasecmp(tok_field, protocol_filter, filter_length))
             {
-                json_dumper_begin_object(&dumper);
+                sharkd_json_object_open(NULL);
                 {
                     sharkd_json_value_string("f", protocol_filter);
                     sharkd_json_value_anyf("t", "%d", FT_PROTOCOL);
                     sharkd_json_value_string("n", protocol_name);
                 }
-                json_dumper_end_object(&dumper);
+                sharkd_json_object_close();
             }
 
             if (!filter_with_dot)
@@ -5310,7 +5779,7 @@ sharkd_session_process_complete(char *buf, const jsmntok_t *tokens, int count)
 
                 if (strlen(hfinfo->abbrev) >= filter_length && !g_ascii_strncasecmp(tok_field, hfinfo->abbrev, filter_length))
                 {
-                    json_dumper_begin_object(&dumper);
+                    sharkd_json_object_open(NULL);
                     {
                         sharkd_json_value_string("f", hfinfo->abbrev);
 
@@ -5321,7 +5790,7 @@ sharkd_session_process_complete(char *buf, const jsmntok_t *tokens, int count)
                             sharkd_json_value_string("n", hfinfo->name);
                         }
                     }
-                    json_dumper_end_object(&dumper);
+                    sharkd_json_object_close();
                 }
             }
         }
@@ -5554,7 +6023,7 @@ sharkd_session_process_dumpconf_cb(pref_t *pref, void *d)
                     sharkd_json_array_open("e");
                     for (enums = prefs_get_enumvals(pref); enums->name; enums++)
                     {
-                        json_dumper_begin_object(&dumper);
+                        sharkd_json_object_open(NULL);
 
                         sharkd_json_value_anyf("v", "%d", enums->value);
 
@@ -5563,7 +6032,7 @@ sharkd_session_process_dumpconf_cb(pref_t *pref, void *d)
 
                         sharkd_json_value_string("d", enums->description);
 
-                        json_dumper_end_object(&dumper);
+                        sharkd_json_object_close();
                     }
                     sharkd_json_array_close();
                     break;
@@ -5828,7 +6297,7 @@ sharkd_rtp_download_decode(struct sharkd_download_rtp *req)
             memcpy(&wav_hdr[36], "data", 4);
             memcpy(&wav_hdr[40], "\xFF\xFF\xFF\xFF", 4); /* XXX, unknown */
 
-            json_dumper_write_base64(&dumper, wav_hdr, sizeof(wav_hdr));
+            sharkd_json_base64_write(wav_hdr, sizeof(wav_hdr));
         }
 
         // Write samples to our file.
@@ -5872,7 +6341,7 @@ sharkd_rtp_download_decode(struct sharkd_download_rtp *req)
         }
 
         /* Write the decoded, possibly-resampled audio */
-        json_dumper_write_base64(&dumper, (const uint8_t*)write_buff, write_bytes);
+        sharkd_json_base64_write((const uint8_t*)write_buff, write_bytes);
 
         g_free(decode_buff);
     }
@@ -6099,10 +6568,9 @@ sharkd_session_process_download(char *buf, const jsmntok_t *tokens, int count)
             sharkd_json_value_string("file", filename);
             sharkd_json_value_string("mime", mime);
 
-            json_dumper_set_member_name(&dumper, "data");
-            json_dumper_begin_base64(&dumper);
+            sharkd_json_base64_open("data");
             sharkd_rtp_download_decode(&rtp_req);
-            json_dumper_end_base64(&dumper);
+            sharkd_json_base64_close();
 
             sharkd_json_result_epilogue();
 
@@ -6125,6 +6593,85 @@ sharkd_session_process_download(char *buf, const jsmntok_t *tokens, int count)
     }
 }
 
+/**
+ * sharkd_session_process_encoding()
+ *
+ * Process encoding request, selecting the encoding of the following responses.
+ *
+ * Input:
+ *   (m) name - "json" (default) or "cbor"
+ *
+ * Output object with attributes:
+ *   (m) status - "OK"
+ *
+ * The response to this request is still sent in the previous encoding.
+ * Requests are always JSON. With "cbor" each following response is a single
+ * CBOR data item with the same members as its JSON counterpart; byte fields
+ * which would be base64 encoded in JSON are CBOR byte strings.
+ */
+static void
+sharkd_session_process_encoding(char *buf, const jsmntok_t *tokens, int count)
+{
+    const char *tok_name = json_find_attr(buf, tokens, count, "name");
+    int new_encoding;
+
+    if (!strcmp(tok_name, "json"))
+        new_encoding = SHARKD_ENCODING_JSON;
+    else if (!strcmp(tok_name, "cbor"))
+        new_encoding = SHARKD_ENCODING_CBOR;
+    else
+    {
+        sharkd_json_error(
+                rpcid, -14001, NULL,
+                "Unsupported encoding %s", tok_name
+                );
+        return;
+    }
+
+    sharkd_json_simple_ok(rpcid);
+    encoding = new_encoding;
+}
+
+/**
+ * sharkd_session_process_snapshot()
+ *
+ * Process snapshot request
+ *
+ * Output object with attributes:
+ *   (m) status - "OK" on success
+ *
+ * Saves the frame table of the loaded capture file in the directory given with
+ * --snapshot-dir, under a name derived from the capture file. A later load
+ * request of the same, unmodified file with "snapshot":true restores it.
+ * Only the frame table is saved, no dissector state; see the load request.
+ */
+static void
+sharkd_session_process_snapshot(void)
+{
+    int err;
+
+    if (!sharkd_snapshots_enabled())
+    {
+        sharkd_json_error(
+                rpcid, -15002, NULL,
+                "Snapshots are disabled, start sharkd with --snapshot-dir"
+                );
+        return;
+    }
+
+    err = sharkd_save_snapshot();
+    if (err != 0)
+    {
+        sharkd_json_error(
+                rpcid, -15001, NULL,
+                "Unable to save snapshot: %s", g_strerror(err)
+                );
+        return;
+    }
+
+    sharkd_json_simple_ok(rpcid);
+}
+
 static void
 sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
 {
@@ -6178,6 +6725,10 @@ sharkd_session_process(char *buf, const jsmntok_t *tokens, int count)
             sharkd_session_process_dumpconf(buf, tokens, count);
         else if (!strcmp(tok_method, "download"))
             sharkd_session_process_download(buf, tokens, count);
+        else if (!strcmp(tok_method, "encoding"))
+            sharkd_session_process_encoding(buf, tokens, count);
+        else if (!strcmp(tok_method, "snapshot"))
+            sharkd_session_process_snapshot();
         else if (!strcmp(tok_method, "bye"))
         {
             sharkd_json_simple_ok(rpcid);
@@ -6205,9 +6756,11 @@ sharkd_session_main(int mode_setting)
     fprintf(stderr, "Hello in child.\n");
 
     dumper.output_file = stdout;
+    cbor_buf = g_byte_array_new();
 
     /* XXX - This could be a wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(),...) */
     filter_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_session_filter_free);
+    frames_cursors = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, sharkd_session_frames_cursor_free);
 
 #ifdef HAVE_MAXMINDDB
     /* mmdbresolve was stopped before fork(), force starting it */
@@ -6255,7 +6808,9 @@ sharkd_session_main(int mode_setting)
         sharkd_session_process(buf, tokens, ret);
     }
 
+    g_hash_table_destroy(frames_cursors);
     g_hash_table_destroy(filter_table);
+    g_byte_array_free(cbor_buf, TRUE);
     g_free(tokens);
 
     return 0;
@@ -322,6 +322,37 @@ class TestTsharkZExpert:
         assert not grep_output(proc.stdout, 'Chats')
 
 
+class TestTsharkZIoStat:
+    @staticmethod
+    def last_row(output):
+        rows = [line for line in output.splitlines() if '<>' in line]
+        return [cell.strip() for cell in rows[-1].split('|') if cell.strip()]
+
+    def test_tshark_z_io_stat_frames(self, cmd_tshark, capture_file, test_env):
+        # Frames and bytes need no protocol tree.
+        proc = subprocesstest.run((cmd_tshark, '-q', '-z', 'io,stat,0',
+            '-r', capture_file('dhcp.pcap')), capture_output=True, env=test_env)
+        assert self.last_row(proc.stdout)[1] == '4'
+
+    def test_tshark_z_io_stat_field_without_filter(self, cmd_tshark, capture_file, test_env):
+        # The counted field is primed even when it isn't in the filter.
+        proc = subprocesstest.run((cmd_tshark, '-q', '-z', 'io,stat,0,COUNT(udp.length)',
+            '-r', capture_file('dhcp.pcap')), capture_output=True, env=test_env)
+        unfiltered = self.last_row(proc.stdout)
+        proc = subprocesstest.run((cmd_tshark, '-q', '-z', 'io,stat,0,COUNT(udp.length)udp.length',
+            '-r', capture_file('dhcp.pcap')), capture_output=True, env=test_env)
+        assert unfiltered == self.last_row(proc.stdout)
+        assert unfiltered[1] == '4'
+
+
+class TestTsharkZStatsTree:
+    def test_tshark_z_http_tree_response_code(self, cmd_tshark, capture_file, test_env):
+        # Response codes are counted under a node named after the code.
+        proc = subprocesstest.run((cmd_tshark, '-q', '-z', 'http,tree',
+            '-r', capture_file('http.pcap')), capture_output=True, env=test_env)
+        assert grep_output(proc.stdout, '200 OK')
+
+
 class TestTsharkExtcap:
     # dumpcap dependency has been added to run this test only with capture support
     def test_tshark_extcap_interfaces(self, cmd_tshark, cmd_dumpcap, test_env, home_path):
@@ -10,7 +10,10 @@
 
 import os.path
 import shutil
+import socket
+import struct
 import subprocess
+import threading
 
 import pytest
 
@@ -60,6 +63,57 @@ def check_name_resolution(cmd_tshark, capture_file, nameres_setup, test_env):
     return check_name_resolution_real
 
 
+class StubDnsServer:
+    '''Answers every PTR query on a loopback UDP port with a made-up name.'''
+    def __init__(self):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind(('127.0.0.1', 0))
+        self.port = self.sock.getsockname()[1]
+        self.queries = 0
+        self.thread = threading.Thread(target=self.serve, daemon=True)
+        self.thread.start()
+
+    @staticmethod
+    def ptr_name(qname):
+        labels = qname.split('.')
+        if qname.endswith('.in-addr.arpa'):
+            return 'stub-' + '-'.join(reversed(labels[:4])) + '.test'
+        return 'stub-' + ''.join(reversed(labels[:32])) + '.test'
+
+    def answer(self, query):
+        labels = []
+        pos = 12
+        while query[pos]:
+            length = query[pos]
+            labels.append(query[pos + 1:pos + 1 + length].decode('ascii'))
+            pos += 1 + length
+        question = query[12:pos + 5]
+        name = self.ptr_name('.'.join(labels).lower())
+        rdata = b''.join(bytes([len(l)]) + l.encode('ascii') for l in name.split('.')) + b'\0'
+        answer = b'\xc0\x0c' + struct.pack('!HHIH', 12, 1, 3600, len(rdata)) + rdata
+        header = query[:2] + struct.pack('!HHHHH', 0x8180, 1, 1, 0, 0)
+        return header + question + answer
+
+    def serve(self):
+        while True:
+            try:
+                query, peer = self.sock.recvfrom(512)
+            except OSError:
+                return
+            self.queries += 1
+            self.sock.sendto(self.answer(query), peer)
+
+    def close(self):
+        self.sock.close()
+
+
+@pytest.fixture
+def stub_dns_server():
+    server = StubDnsServer()
+    yield server
+    server.close()
+
+
 class TestNameResolution:
 
     def test_name_resolution_net_t_ext_f_hosts_f_global(self, check_name_resolution):
@@ -106,3 +160,34 @@ class TestNameResolution:
                 ), encoding='utf-8', env=base_env)
         assert '174.137.42.65\twww.wireshark.org' not in stdout
         assert 'fe80::6233:4bff:fe13:c558\tCrunch.local' in stdout
+
+    def test_external_two_pass_and_cache(self, cmd_tshark, capture_file, conf_path, test_env, stub_dns_server):
+        '''External resolution on the first pass, then from the resolver cache.'''
+        tshark_cmd = (cmd_tshark,
+            '-r', capture_file('dns+icmp.pcapng.gz'),
+            '-N', 'nN',
+            '-o', 'nameres.use_custom_dns_servers: TRUE',
+            '-o', 'uat:addr_resolve_dns_servers:"127.0.0.1","{0}","{0}"'.format(stub_dns_server.port),
+            '-o', 'nameres.resolver_cache_ttl: 3600',
+            )
+        stdout = subprocess.check_output(tshark_cmd + ('-2',), encoding='utf-8', env=test_env)
+        assert 'stub-174-137-42-65.test' in stdout
+        with open(os.path.join(conf_path, 'resolver_cache')) as cache_file:
+            assert '174.137.42.65\tstub-174-137-42-65.test\t' in cache_file.read()
+
+        # Every name now comes from the cache.
+        queries = stub_dns_server.queries
+        stdout = subprocess.check_output(tshark_cmd, encoding='utf-8', env=test_env)
+        assert 'stub-174-137-42-65.test' in stdout
+        assert stub_dns_server.queries == queries
+
+    def test_mac_cache_size(self, cmd_tshark, capture_file, test_env):
+        '''MAC names are the same when the address table is bounded.'''
+        tshark_cmd = (cmd_tshark,
+            '-r', capture_file('dhcp.pcap'),
+            '-N', 'm',
+            '-T', 'fields', '-e', 'eth.src_resolved', '-e', 'eth.dst_resolved',
+            )
+        unbounded = subprocess.check_output(tshark_cmd, encoding='utf-8', env=test_env)
+        bounded = subprocess.check_output(tshark_cmd + ('-o', 'nameres.mac_cache_size: 1'), encoding='utf-8', env=test_env)
+        assert bounded == unbounded
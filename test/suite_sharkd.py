@@ -9,6 +9,7 @@
 '''sharkd tests'''
 
 import json
+import struct
 import subprocess
 
 import pytest
@@ -16,6 +17,21 @@ import pytest
 from matchers import MatchAny, MatchList, MatchObject, MatchRegExp
 
 
+MATCH_WMEM_SCOPE = MatchObject({
+    "in_use": MatchAny(int),
+    "peak": MatchAny(int),
+    "blocks": MatchAny(int),
+    "allocations": MatchAny(int),
+    "histogram": MatchList(MatchAny(int), n=8),
+})
+
+MATCH_STATUS_MEMORY = MatchObject({
+    "epan": MATCH_WMEM_SCOPE,
+    "file": MATCH_WMEM_SCOPE,
+    "block_cache": MatchAny(int),
+})
+
+
 @pytest.fixture(scope='session')
 def cmd_sharkd(program):
     return program('sharkd')
@@ -23,9 +39,9 @@ def cmd_sharkd(program):
 
 @pytest.fixture
 def run_sharkd_session(cmd_sharkd, base_env):
-    def run_sharkd_session_real(sharkd_commands):
+    def run_sharkd_session_real(sharkd_commands, args=('-',)):
         sharkd_proc = subprocess.Popen(
-            (cmd_sharkd, '-'), stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE, encoding='utf-8', env=base_env)
+            (cmd_sharkd, *args), stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE, encoding='utf-8', env=base_env)
         sharkd_proc.stdin.write('\n'.join(sharkd_commands))
         stdout, stderr = sharkd_proc.communicate()
 
@@ -45,11 +61,65 @@ def run_sharkd_session(cmd_sharkd, base_env):
     return run_sharkd_session_real
 
 
+def decode_cbor_seq(data):
+    '''Decode the subset of CBOR emitted by sharkd into a tuple of items.'''
+    pos = 0
+    def head():
+        nonlocal pos
+        major, minor = data[pos] >> 5, data[pos] & 0x1f
+        pos += 1
+        if minor < 24 or minor == 31:
+            return major, minor
+        size = 1 << (minor - 24)
+        arg = int.from_bytes(data[pos:pos + size], 'big')
+        pos += size
+        return major, arg
+    def item():
+        nonlocal pos
+        if data[pos] == 0xfb:
+            value = struct.unpack('>d', data[pos + 1:pos + 9])[0]
+            pos += 9
+            return value
+        major, arg = head()
+        if major == 0:
+            return arg
+        if major == 1:
+            return -1 - arg
+        if major in (2, 3):
+            if arg == 31:
+                chunks = b''
+                while data[pos] != 0xff:
+                    chunks += item()
+                pos += 1
+                return chunks
+            value = data[pos:pos + arg]
+            pos += arg
+            return value if major == 2 else value.decode('utf-8')
+        if major == 4:
+            value = []
+            while data[pos] != 0xff:
+                value.append(item())
+            pos += 1
+            return value
+        if major == 5:
+            value = {}
+            while data[pos] != 0xff:
+                key = item()
+                value[key] = item()
+            pos += 1
+            return value
+        return {20: False, 21: True, 22: None}[arg]
+    items = []
+    while pos < len(data):
+        items.append(item())
+    return tuple(items)
+
+
 @pytest.fixture
 def check_sharkd_session(run_sharkd_session):
-    def check_sharkd_session_real(sharkd_commands, expected_outputs):
+    def check_sharkd_session_real(sharkd_commands, expected_outputs, args=('-',)):
         sharkd_commands = [json.dumps(x) for x in sharkd_commands]
-        actual_outputs = run_sharkd_session(sharkd_commands)
+        actual_outputs = run_sharkd_session(sharkd_commands, args)
         assert expected_outputs == actual_outputs
     return check_sharkd_session_real
 
@@ -199,7 +269,8 @@ class TestSharkd:
                     "title": "Length", "format": "%L", "visible":True, "display": "R"
                 },{
                     "title": "Info", "format": "%i", "visible":True, "display": "R"
-                }]
+                }],
+                "memory": MATCH_STATUS_MEMORY,
             }},
         ))
 
@@ -230,7 +301,8 @@ class TestSharkd:
                     "title": "Length", "format": "%L", "visible":True, "display": "R"
                 },{
                     "title": "Info", "format": "%i", "visible":True, "display": "R"
-                }]
+                }],
+                "memory": MATCH_STATUS_MEMORY,
             }},
         ))
 
@@ -365,6 +437,146 @@ class TestSharkd:
              },
         ))
 
+    def test_sharkd_req_frames_paged(self, check_sharkd_session, capture_file):
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+             "params":{"file": capture_file('dhcp.pcap')}
+             },
+            {"jsonrpc":"2.0", "id":2, "method":"frames","params":{"paged":True,"limit":3,"column0":"frame.number:0"}},
+            {"jsonrpc":"2.0", "id":3, "method":"frames","params":{"cursor":1,"limit":3}},
+            {"jsonrpc":"2.0", "id":4, "method":"frames","params":{"cursor":1}},
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":2,"result":{
+                "frames":[
+                    {"c":["1"],"num":1,"bg":MatchAny(str),"fg":MatchAny(str)},
+                    {"c":["2"],"num":2,"bg":MatchAny(str),"fg":MatchAny(str)},
+                    {"c":["3"],"num":3,"bg":MatchAny(str),"fg":MatchAny(str)},
+                ],
+                "cursor":1,
+            }},
+            {"jsonrpc":"2.0","id":3,"result":{
+                "frames":[
+                    {"c":["4"],"num":4,"bg":MatchAny(str),"fg":MatchAny(str)},
+                ],
+            }},
+            {"jsonrpc":"2.0","id":4,"error":{"code":-13003,"message":"Cursor 1 not found or expired"}},
+        ))
+
+    def test_sharkd_req_encoding_cbor(self, cmd_sharkd, base_env, capture_file):
+        sharkd_commands = (
+            {"jsonrpc":"2.0", "id":1, "method":"encoding", "params":{"name":"cbor"}},
+            {"jsonrpc":"2.0", "id":2, "method":"load",
+             "params":{"file": capture_file('dhcp.pcap')}
+             },
+            {"jsonrpc":"2.0", "id":3, "method":"frames","params":{"limit":1,"column0":"frame.number:0"}},
+            {"jsonrpc":"2.0", "id":4, "method":"frame","params":{"frame":1,"bytes":True}},
+        )
+        sharkd_proc = subprocess.Popen(
+            (cmd_sharkd, '-'), stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE, env=base_env)
+        stdout, stderr = sharkd_proc.communicate('\n'.join(json.dumps(x) for x in sharkd_commands).encode('utf-8'))
+        assert b'Hello in child.' in stderr
+
+        # The reply to the encoding request itself is still JSON.
+        json_line, cbor_data = stdout.split(b'\n', 1)
+        assert json.loads(json_line) == {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}}
+
+        outputs = decode_cbor_seq(cbor_data)
+        assert outputs[0] == {"jsonrpc":"2.0","id":2,"result":{"status":"OK"}}
+        assert outputs[1] == {"jsonrpc":"2.0","id":3,"result":[
+            {"c":["1"],"num":1,"bg":MatchAny(str),"fg":MatchAny(str)},
+        ]}
+        assert outputs[2]["id"] == 4
+        assert isinstance(outputs[2]["result"]["bytes"], bytes)
+        assert len(outputs[2]["result"]["bytes"]) == 314
+
+    def test_sharkd_req_snapshot(self, check_sharkd_session, capture_file, tmp_path):
+        args = ('--snapshot-dir', str(tmp_path))
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+             "params":{"file": capture_file('dhcp.pcap')}
+             },
+            {"jsonrpc":"2.0", "id":2, "method":"snapshot"},
+            {"jsonrpc":"2.0", "id":3, "method":"load",
+             "params":{"file": capture_file('dhcp.pcap'), "snapshot": True}
+             },
+            {"jsonrpc":"2.0", "id":4, "method":"frames","params":{"column0":"frame.number:0","column1":"frame.len:0"}},
+            {"jsonrpc":"2.0", "id":5, "method":"load",
+             "params":{"file": capture_file('dns_port.pcap'), "snapshot": True}
+             },
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":2,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":3,"result":{"status":"OK","snapshot":"restored"}},
+            {"jsonrpc":"2.0","id":4,"result":[
+                {"c":["1","314"],"num":1,"bg":MatchAny(str),"fg":MatchAny(str)},
+                {"c":["2","342"],"num":2,"bg":MatchAny(str),"fg":MatchAny(str)},
+                {"c":["3","314"],"num":3,"bg":MatchAny(str),"fg":MatchAny(str)},
+                {"c":["4","342"],"num":4,"bg":MatchAny(str),"fg":MatchAny(str)},
+            ]},
+            {"jsonrpc":"2.0","id":5,"result":{"status":"OK","snapshot":"ignored"}},
+        ), args)
+        # The only file written is the snapshot, in the snapshot directory.
+        assert [p.suffix for p in tmp_path.iterdir()] == ['.sharkdfs']
+
+    def test_sharkd_req_snapshot_disabled(self, check_sharkd_session, capture_file):
+        # Without a snapshot directory, clients can neither save nor restore.
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+             "params":{"file": capture_file('dhcp.pcap')}
+             },
+            {"jsonrpc":"2.0", "id":2, "method":"snapshot"},
+            {"jsonrpc":"2.0", "id":3, "method":"load",
+             "params":{"file": capture_file('dhcp.pcap'), "snapshot": True}
+             },
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":2,"error":{"code":-15002,"message":"Snapshots are disabled, start sharkd with --snapshot-dir"}},
+            {"jsonrpc":"2.0","id":3,"result":{"status":"OK","snapshot":"ignored"}},
+        ))
+
+    def test_sharkd_req_snapshot_rewritten(self, check_sharkd_session, capture_file, tmp_path):
+        # A file rewritten in place with the same size must not use the old snapshot.
+        pcap = tmp_path / 'dhcp.pcap'
+        pcap.write_bytes(open(capture_file('dhcp.pcap'), 'rb').read())
+        snapshot_dir = tmp_path / 'snapshots'
+        snapshot_dir.mkdir()
+        args = ('--snapshot-dir', str(snapshot_dir))
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load", "params":{"file": str(pcap)}},
+            {"jsonrpc":"2.0", "id":2, "method":"snapshot"},
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":2,"result":{"status":"OK"}},
+        ), args)
+        data = bytearray(pcap.read_bytes())
+        data[-1] ^= 0xff
+        pcap.write_bytes(bytes(data))
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+             "params":{"file": str(pcap), "snapshot": True}
+             },
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK","snapshot":"ignored"}},
+        ), args)
+
+    def test_sharkd_req_snapshot_dsb(self, check_sharkd_session, capture_file, tmp_path):
+        # Decryption secrets are only read by the sequential pass.
+        args = ('--snapshot-dir', str(tmp_path))
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+             "params":{"file": capture_file('tls12-dsb.pcapng')}
+             },
+            {"jsonrpc":"2.0", "id":2, "method":"snapshot"},
+            {"jsonrpc":"2.0", "id":3, "method":"load",
+             "params":{"file": capture_file('tls12-dsb.pcapng'), "snapshot": True}
+             },
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":2,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":3,"result":{"status":"OK","snapshot":"ignored"}},
+        ), args)
+
     def test_sharkd_req_tap_invalid(self, check_sharkd_session, capture_file):
         # XXX Unrecognized taps result in an empty line, modify
         #     run_sharkd_session such that checking for it is possible.
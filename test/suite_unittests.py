@@ -50,6 +50,12 @@ class TestUnitTests:
             '--verbose'
         ), env=base_env)
 
+    def test_unit_ui(self, program, base_env):
+        '''ui unit tests'''
+        subprocess.check_call((program('test_ui'),
+            '--verbose'
+        ), env=base_env)
+
     def test_unit_wsutil(self, program, base_env):
         '''wsutil unit tests'''
         subprocess.check_call((program('test_wsutil'),
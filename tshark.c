@@ -92,6 +92,7 @@
 #include <epan/epan_dissect.h>
 #include <epan/tap.h>
 #include <epan/stat_tap_ui.h>
+#include <epan/conversation.h>
 #include <epan/conversation_table.h>
 #include <epan/srt_table.h>
 #include <epan/rtd_table.h>
@@ -2186,6 +2187,10 @@ main(int argc, char *argv[])
         goto clean_exit;
     }
 
+    /* Each packet is dissected only once without -2, so conversations that
+       have been idle for a while can be retired if the user asked for it. */
+    conversation_set_expiry_allowed(!perform_two_pass_analysis);
+
 #ifdef HAVE_LIBPCAP
     if (caps_queries) {
         /* We're supposed to list the link-layer/timestamp types for an interface;
@@ -3576,6 +3581,16 @@ process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
         frame_data_set_after_dissect(&fdlocal, &cum_bytes);
         cf->provider.prev_cap = cf->provider.prev_dis = frame_data_sequence_add(cf->provider.frames, &fdlocal);
 
+        /* Start resolving the frame's addresses now, all of them in
+         * parallel, so that the names are known by the time the second
+         * pass prints them. */
+        if (edt && gbl_resolv_flags.network_name) {
+            host_name_lookup_prefetch(&edt->pi.net_src);
+            host_name_lookup_prefetch(&edt->pi.net_dst);
+            host_name_lookup_prefetch(&edt->pi.src);
+            host_name_lookup_prefetch(&edt->pi.dst);
+        }
+
         /* If we're not doing dissection then there won't be any dependent frames.
          * More importantly, edt.pi.fd.dependent_frames won't be initialized because
          * epan hasn't been initialized.
@@ -3948,6 +3963,7 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
     /*
      * Force synchronous resolution of IP addresses; in this pass, we
      * can't do it in the background and fix up past dissections.
+     * This first waits for the lookups the first pass started.
      */
     set_resolution_synchrony(true);
 
@@ -0,0 +1,105 @@
+/* tap-convstat.c
+ * Report how many conversations were created and how many were retired
+ * because they were idle.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/conversation.h>
+#include <epan/prefs.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <wsutil/cmdarg_err.h>
+
+void register_tap_listener_convstat(void);
+
+static tap_packet_status
+convstat_packet(void *tapdata _U_, packet_info *pinfo _U_, epan_dissect_t *edt _U_, const void *data _U_, tap_flags_t flags _U_)
+{
+	/* The counters are kept by the conversation code itself. */
+	return TAP_PACKET_DONT_REDRAW;
+}
+
+static void
+convstat_draw(void *tapdata _U_)
+{
+	conversation_stats_t stats;
+
+	conversation_get_stats(&stats);
+
+	printf("\n");
+	printf("===================================================================\n");
+	printf("Conversation Statistics:\n");
+	if (prefs.conversation_idle_timeout)
+		printf("Idle timeout:                   %u s\n", prefs.conversation_idle_timeout);
+	else
+		printf("Idle timeout:                   none\n");
+	printf("Conversations created:          %" PRIu64 "\n", stats.created);
+	printf("Conversations retired:          %" PRIu64 "\n", stats.retired);
+	printf("Live conversations:             %" PRIu64 "\n", stats.created - stats.retired);
+	printf("Protocol data items retired:    %" PRIu64 "\n", stats.retired_data);
+	printf("===================================================================\n");
+}
+
+static bool
+convstat_init(const char *opt_arg, void *userdata _U_)
+{
+	GString *error_string;
+
+	if (strcmp(opt_arg, "conversations,stat") != 0) {
+		cmdarg_err("invalid \"-z conversations,stat\" argument; it takes no filter");
+		return false;
+	}
+
+	error_string = register_tap_listener("frame", NULL, NULL, TL_REQUIRES_NOTHING,
+			NULL, convstat_packet, convstat_draw, NULL);
+	if (error_string) {
+		cmdarg_err("Couldn't register conversations,stat tap: %s",
+			error_string->str);
+		g_string_free(error_string, TRUE);
+		return false;
+	}
+
+	return true;
+}
+
+static stat_tap_ui convstat_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	"conversations,stat",
+	convstat_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_convstat(void)
+{
+	register_stat_tap_ui(&convstat_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -144,7 +144,8 @@ void init_endpoints(struct register_ct *ct, const char *filter)
 		g_string_free(error_string, TRUE);
 		exit(1);
 	}
-
+	set_tap_worker_callbacks(&iu->hash, endpoint_table_worker_new,
+			endpoint_table_worker_merge, endpoint_table_worker_free);
 }
 
 /*
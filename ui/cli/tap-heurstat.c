@@ -0,0 +1,134 @@
+/* tap-heurstat.c
+ * Report how often each heuristic dissector was tried and accepted a packet.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <wsutil/cmdarg_err.h>
+
+void register_tap_listener_heurstat(void);
+
+static void
+heurstat_collect_entry(const char *table_name _U_, heur_dtbl_entry_t *entry, void *user_data)
+{
+	GPtrArray *entries = (GPtrArray *)user_data;
+
+	if (entry->hits + entry->misses > 0)
+		g_ptr_array_add(entries, entry);
+}
+
+static int
+heurstat_entry_cmp(const void *a, const void *b)
+{
+	const heur_dtbl_entry_t *entry_a = *(const heur_dtbl_entry_t * const *)a;
+	const heur_dtbl_entry_t *entry_b = *(const heur_dtbl_entry_t * const *)b;
+
+	if (entry_a->hits != entry_b->hits)
+		return entry_a->hits > entry_b->hits ? -1 : 1;
+	if (entry_a->misses != entry_b->misses)
+		return entry_a->misses < entry_b->misses ? -1 : 1;
+	return strcmp(entry_a->short_name, entry_b->short_name);
+}
+
+static void
+heurstat_draw_table(const char *table_name, struct heur_dissector_list *table _U_, void *user_data _U_)
+{
+	GPtrArray *entries = g_ptr_array_new();
+	unsigned i;
+
+	heur_dissector_table_foreach(table_name, heurstat_collect_entry, entries);
+	if (entries->len > 0) {
+		g_ptr_array_sort(entries, heurstat_entry_cmp);
+		printf("%s:\n", table_name);
+		for (i = 0; i < entries->len; i++) {
+			const heur_dtbl_entry_t *entry = (const heur_dtbl_entry_t *)g_ptr_array_index(entries, i);
+			unsigned tries = entry->hits + entry->misses;
+
+			printf("  %-32s %10u %10u %7.2f%% %13u\n", entry->short_name,
+			       tries, entry->hits, 100.0 * entry->hits / tries,
+			       entry->conversations);
+		}
+	}
+	g_ptr_array_free(entries, TRUE);
+}
+
+static void
+heurstat_draw(void *tapdata _U_)
+{
+	printf("\n");
+	printf("===================================================================\n");
+	printf("Heuristic Dissector Statistics:\n");
+	printf("  %-32s %10s %10s %8s %13s\n", "Heuristic", "Tries", "Hits", "Hit rate", "Conversations");
+	dissector_all_heur_tables_foreach_table(heurstat_draw_table, NULL, (GCompareFunc)strcmp);
+	printf("===================================================================\n");
+}
+
+static bool
+heurstat_init(const char *opt_arg, void *userdata _U_)
+{
+	GString *error_string;
+
+	if (strcmp(opt_arg, "heuristics,stat") != 0) {
+		cmdarg_err("invalid \"-z heuristics,stat\" argument; it takes no filter");
+		return false;
+	}
+
+	/*
+	 * The counters are kept by the heuristic lists themselves, so there
+	 * is nothing to do per packet; the listener only provides the hook
+	 * that prints them once the capture has been read.
+	 */
+	error_string = register_tap_listener("frame", NULL, NULL, TL_REQUIRES_NOTHING,
+			NULL, NULL, heurstat_draw, NULL);
+	if (error_string) {
+		cmdarg_err("Couldn't register heuristics,stat tap: %s",
+			error_string->str);
+		g_string_free(error_string, TRUE);
+		return false;
+	}
+
+	return true;
+}
+
+static stat_tap_ui heurstat_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	"heuristics,stat",
+	heurstat_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_heurstat(void)
+{
+	register_stat_tap_ui(&heurstat_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
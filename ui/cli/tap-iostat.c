@@ -146,6 +146,82 @@ iostat_io_free(io_stat_t *io)
     g_free(io);
 }
 
+/*
+ *  Store the highest value of a cell in order to determine the width of each stat column.
+ *  For real numbers we only need to know its magnitude (the value to the left of the decimal point
+ *  so round it up before storing it as an integer in max_vals. For AVG of RELATIVE_TIME fields,
+ *  calc the average, round it to the next second and store the seconds. For all other calc types
+ *  of RELATIVE_TIME fields, store the counters without modification.
+ */
+static void
+iostat_item_update_max(io_stat_t *parent, const io_stat_item_t *it)
+{
+    int ftype;
+
+    switch (parent->calc_type[it->colnum]) {
+        case CALC_TYPE_FRAMES:
+        case CALC_TYPE_FRAMES_AND_BYTES:
+            parent->max_frame[it->colnum] =
+                MAX(parent->max_frame[it->colnum], it->frames);
+            if (parent->calc_type[it->colnum] == CALC_TYPE_FRAMES_AND_BYTES)
+                parent->max_vals[it->colnum] =
+                    MAX(parent->max_vals[it->colnum], it->counter);
+            break;
+        case CALC_TYPE_BYTES:
+        case CALC_TYPE_COUNT:
+        case CALC_TYPE_LOAD:
+            parent->max_vals[it->colnum] = MAX(parent->max_vals[it->colnum], it->counter);
+            break;
+        case CALC_TYPE_SUM:
+        case CALC_TYPE_MIN:
+        case CALC_TYPE_MAX:
+            ftype = proto_registrar_get_ftype(parent->hf_indexes[it->colnum]);
+            switch (ftype) {
+                case FT_FLOAT:
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], (uint64_t)(it->float_counter+0.5));
+                    break;
+                case FT_DOUBLE:
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], (uint64_t)(it->double_counter+0.5));
+                    break;
+                case FT_RELATIVE_TIME:
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], it->counter);
+                    break;
+                default:
+                    /* UINT16-64 and INT8-64 */
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], it->counter);
+                    break;
+            }
+            break;
+        case CALC_TYPE_AVG:
+            if (it->num == 0) /* avoid division by zero */
+               break;
+            ftype = proto_registrar_get_ftype(parent->hf_indexes[it->colnum]);
+            switch (ftype) {
+                case FT_FLOAT:
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], (uint64_t)it->float_counter/it->num);
+                    break;
+                case FT_DOUBLE:
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], (uint64_t)it->double_counter/it->num);
+                    break;
+                case FT_RELATIVE_TIME:
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], ((it->counter/(uint64_t)it->num) + UINT64_C(500000000)) / NANOSECS_PER_SEC);
+                    break;
+                default:
+                    /* UINT16-64 and INT8-64 */
+                    parent->max_vals[it->colnum] =
+                        MAX(parent->max_vals[it->colnum], it->counter/it->num);
+                    break;
+            }
+    }
+}
+
 /* Tap function: collect statistics of interest from the current packet. */
 static tap_packet_status
 iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *dummy _U_, tap_flags_t flags _U_)
@@ -502,75 +578,156 @@ iostat_packet(void *arg, packet_info *pinfo, epan_dissect_t *edt, const void *du
         }
         break;
     }
-    /* Store the highest value for this item in order to determine the width of each stat column.
-    *  For real numbers we only need to know its magnitude (the value to the left of the decimal point
-    *  so round it up before storing it as an integer in max_vals. For AVG of RELATIVE_TIME fields,
-    *  calc the average, round it to the next second and store the seconds. For all other calc types
-    *  of RELATIVE_TIME fields, store the counters without modification.
-    *  fields. */
-    switch (parent->calc_type[it->colnum]) {
-        case CALC_TYPE_FRAMES:
-        case CALC_TYPE_FRAMES_AND_BYTES:
-            parent->max_frame[it->colnum] =
-                MAX(parent->max_frame[it->colnum], it->frames);
-            if (parent->calc_type[it->colnum] == CALC_TYPE_FRAMES_AND_BYTES)
-                parent->max_vals[it->colnum] =
-                    MAX(parent->max_vals[it->colnum], it->counter);
-            break;
-        case CALC_TYPE_BYTES:
-        case CALC_TYPE_COUNT:
-        case CALC_TYPE_LOAD:
-            parent->max_vals[it->colnum] = MAX(parent->max_vals[it->colnum], it->counter);
-            break;
-        case CALC_TYPE_SUM:
-        case CALC_TYPE_MIN:
-        case CALC_TYPE_MAX:
-            ftype = proto_registrar_get_ftype(parent->hf_indexes[it->colnum]);
-            switch (ftype) {
-                case FT_FLOAT:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (uint64_t)(it->float_counter+0.5));
-                    break;
-                case FT_DOUBLE:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (uint64_t)(it->double_counter+0.5));
-                    break;
-                case FT_RELATIVE_TIME:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], it->counter);
-                    break;
-                default:
-                    /* UINT16-64 and INT8-64 */
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], it->counter);
-                    break;
-            }
+    iostat_item_update_max(parent, it);
+    return TAP_PACKET_REDRAW;
+}
+
+/*
+ *  Per-worker state for one column: a private io_stat_t carrying the shared
+ *  configuration with its own max_vals/max_frame, and a private item chain.
+ */
+static void *
+iostat_worker_new(void *arg)
+{
+    io_stat_item_t *mit = (io_stat_item_t *)arg;
+    io_stat_t *io;
+    io_stat_item_t *wit;
+
+    io = g_new(io_stat_t, 1);
+    *io = *mit->parent;
+    io->items = NULL;
+    nstime_set_unset(&io->start_time);
+    io->last_relative_time = 0;
+    io->max_vals = g_new0(uint64_t, io->num_cols);
+    io->max_frame = g_new0(uint32_t, io->num_cols);
+
+    wit = g_new0(io_stat_item_t, 1);
+    wit->parent = io;
+    wit->prev = wit;
+    wit->colnum = mit->colnum;
+
+    return wit;
+}
+
+/* Is a worker's MIN or MAX value "better" than the one already in the cell? */
+static bool
+iostat_value_wins(int ftype, bool want_min, const io_stat_item_t *it, const io_stat_item_t *wit)
+{
+    switch (ftype) {
+    case FT_INT8:
+    case FT_INT16:
+    case FT_INT24:
+    case FT_INT32:
+        return want_min ? (int32_t)wit->counter < (int32_t)it->counter :
+                          (int32_t)wit->counter > (int32_t)it->counter;
+    case FT_INT40:
+    case FT_INT48:
+    case FT_INT56:
+    case FT_INT64:
+        return want_min ? (int64_t)wit->counter < (int64_t)it->counter :
+                          (int64_t)wit->counter > (int64_t)it->counter;
+    case FT_FLOAT:
+        return want_min ? wit->float_counter < it->float_counter :
+                          wit->float_counter > it->float_counter;
+    case FT_DOUBLE:
+        return want_min ? wit->double_counter < it->double_counter :
+                          wit->double_counter > it->double_counter;
+    default:
+        /* UINT8-64 and RELATIVE_TIME */
+        return want_min ? wit->counter < it->counter : wit->counter > it->counter;
+    }
+}
+
+/* Fold one interval of a worker's column into the matching main-table cell. */
+static void
+iostat_item_merge(io_stat_t *parent, io_stat_item_t *it, const io_stat_item_t *wit)
+{
+    int calc_type = parent->calc_type[it->colnum];
+    int ftype;
+
+    if (wit->frames == 0 && wit->counter == 0) {
+        /* Nothing happened (LOAD can spill into an otherwise empty interval) */
+        return;
+    }
+
+    switch (calc_type) {
+    case CALC_TYPE_FRAMES:
+    case CALC_TYPE_BYTES:
+    case CALC_TYPE_FRAMES_AND_BYTES:
+    case CALC_TYPE_COUNT:
+    case CALC_TYPE_LOAD:
+        it->counter += wit->counter;
+        break;
+    case CALC_TYPE_SUM:
+    case CALC_TYPE_AVG:
+        ftype = proto_registrar_get_ftype(parent->hf_indexes[it->colnum]);
+        if (ftype == FT_FLOAT)
+            it->float_counter += wit->float_counter;
+        else if (ftype == FT_DOUBLE)
+            it->double_counter += wit->double_counter;
+        else
+            it->counter += wit->counter;
+        it->num += wit->num;
+        break;
+    case CALC_TYPE_MIN:
+    case CALC_TYPE_MAX:
+        if (wit->frames == 0)
             break;
-        case CALC_TYPE_AVG:
-            if (it->num == 0) /* avoid division by zero */
-               break;
-            ftype = proto_registrar_get_ftype(parent->hf_indexes[it->colnum]);
-            switch (ftype) {
-                case FT_FLOAT:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (uint64_t)it->float_counter/it->num);
-                    break;
-                case FT_DOUBLE:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], (uint64_t)it->double_counter/it->num);
-                    break;
-                case FT_RELATIVE_TIME:
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], ((it->counter/(uint64_t)it->num) + UINT64_C(500000000)) / NANOSECS_PER_SEC);
-                    break;
-                default:
-                    /* UINT16-64 and INT8-64 */
-                    parent->max_vals[it->colnum] =
-                        MAX(parent->max_vals[it->colnum], it->counter/it->num);
-                    break;
-            }
+        ftype = proto_registrar_get_ftype(parent->hf_indexes[it->colnum]);
+        if (it->frames == 0 ||
+            iostat_value_wins(ftype, calc_type == CALC_TYPE_MIN, it, wit)) {
+            it->counter = wit->counter; /* 64-bit, copies float and double too */
+        }
+        break;
     }
-    return TAP_PACKET_REDRAW;
+    it->frames += wit->frames;
+
+    iostat_item_update_max(parent, it);
+}
+
+static void
+iostat_worker_merge(void *arg, void *worker_data)
+{
+    io_stat_item_t *mit = (io_stat_item_t *)arg;
+    io_stat_item_t *wmit = (io_stat_item_t *)worker_data;
+    io_stat_t *parent = mit->parent;
+    io_stat_t *wio = wmit->parent;
+    io_stat_item_t *it, *wit;
+
+    if (!nstime_is_unset(&wio->start_time) &&
+        (nstime_is_unset(&parent->start_time) ||
+         nstime_cmp(&wio->start_time, &parent->start_time) < 0)) {
+        parent->start_time = wio->start_time;
+    }
+    parent->last_relative_time = MAX(parent->last_relative_time, wio->last_relative_time);
+
+    /* Both chains start at interval 0 and are contiguous, so they line up. */
+    it = mit;
+    for (wit = wmit; wit != NULL; wit = wit->next) {
+        if (it == NULL) {
+            it = g_new0(io_stat_item_t, 1);
+            it->prev = mit->prev;
+            it->prev->next = it;
+            it->start_time = it->prev->start_time + parent->interval;
+            it->colnum = mit->colnum;
+            mit->prev = it;
+        }
+        iostat_item_merge(parent, it, wit);
+        it = it->next;
+    }
+}
+
+static void
+iostat_worker_free(void *worker_data)
+{
+    io_stat_item_t *wmit = (io_stat_item_t *)worker_data;
+    io_stat_t *wio = wmit->parent;
+
+    iostat_item_reset(wmit);
+    g_free(wmit);
+    g_free(wio->max_vals);
+    g_free(wio->max_frame);
+    g_free(wio);
 }
 
 static unsigned int
@@ -1547,7 +1704,9 @@ register_io_tap(io_stat_t *io, unsigned int i, const char *filter, GString *err)
     }
     g_free(field);
 
-    error_string = register_tap_listener("frame", &io->items[i], flt, TL_REQUIRES_PROTO_TREE,
+    /* The only field the packet callback reads is declared below, so a
+     * column without a filter or a field doesn't need a tree at all. */
+    error_string = register_tap_listener("frame", &io->items[i], flt, TL_REQUIRES_NOTHING,
                                        i ? NULL : iostat_reset,
                                        iostat_packet,
                                        i ? NULL : iostat_draw,
@@ -1564,6 +1723,16 @@ register_io_tap(io_stat_t *io, unsigned int i, const char *filter, GString *err)
         return false;
     }
 
+    set_tap_worker_callbacks(&io->items[i], iostat_worker_new,
+                             iostat_worker_merge, iostat_worker_free);
+    if (hfi && !(io->calc_type[i] == CALC_TYPE_BYTES ||
+                 io->calc_type[i] == CALC_TYPE_FRAMES ||
+                 io->calc_type[i] == CALC_TYPE_FRAMES_AND_BYTES)) {
+        GArray *wanted_hfids = g_array_new(false, false, (unsigned)sizeof(int));
+        g_array_append_val(wanted_hfids, hfi->id);
+        set_tap_wanted_hfids(&io->items[i], wanted_hfids);
+    }
+
     /* On success, clear old errors (from splitting on internal commas). */
     g_string_truncate(err, 0);
     return true;
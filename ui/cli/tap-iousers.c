@@ -274,7 +274,8 @@ void init_iousers(struct register_ct *ct, const char *filter)
 		g_string_free(error_string, TRUE);
 		exit(1);
 	}
-
+	set_tap_worker_callbacks(&iu->hash, conversation_table_worker_new,
+			conversation_table_worker_merge, conversation_table_worker_free);
 }
 
 /*
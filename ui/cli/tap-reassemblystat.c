@@ -0,0 +1,146 @@
+/* tap-reassemblystat.c
+ * Report the memory used by incomplete reassemblies and how many of them
+ * were discarded because of the reassembly limits.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/prefs.h>
+#include <epan/reassemble.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <wsutil/cmdarg_err.h>
+
+void register_tap_listener_reassemblystat(void);
+
+static void
+reassemblystat_print_limits(uint64_t max_memory, uint32_t max_age)
+{
+	if (max_memory)
+		printf("  Memory limit:                    %" PRIu64 " bytes\n", max_memory);
+	else
+		printf("  Memory limit:                    none\n");
+	if (max_age)
+		printf("  Age limit:                       %u s\n", max_age);
+	else
+		printf("  Age limit:                       none\n");
+}
+
+static void
+reassemblystat_print_stats(const reassembly_table_stats *stats)
+{
+	printf("  Incomplete reassemblies:         %u\n", stats->incomplete);
+	printf("  Memory used:                     %" PRIu64 " bytes\n", stats->memory_used);
+	printf("  Peak memory used:                %" PRIu64 " bytes\n", stats->memory_peak);
+	printf("  Discarded over the memory limit: %" PRIu64 "\n", stats->evicted_memory);
+	printf("  Discarded over the age limit:    %" PRIu64 "\n", stats->evicted_age);
+	printf("  Discarded bytes:                 %" PRIu64 "\n", stats->evicted_bytes);
+}
+
+/* Print the tables with limits of their own, and count the others. */
+static void
+reassemblystat_draw_table(const reassembly_table *table, void *user_data)
+{
+	unsigned *pref_tables = (unsigned *)user_data;
+	uint64_t max_memory;
+	uint32_t max_age;
+
+	if (table->max_memory == 0 && table->max_age == 0) {
+		(*pref_tables)++;
+		return;
+	}
+
+	reassembly_table_get_limits(table, &max_memory, &max_age);
+	printf("%s:\n", table->name ? table->name : "(unnamed)");
+	reassemblystat_print_limits(max_memory, max_age);
+	reassemblystat_print_stats(&table->stats);
+}
+
+static void
+reassemblystat_draw(void *tapdata _U_)
+{
+	reassembly_table_stats stats;
+	unsigned pref_tables = 0;
+
+	printf("\n");
+	printf("===================================================================\n");
+	printf("Reassembly Statistics:\n");
+	reassembly_tables_foreach(reassemblystat_draw_table, &pref_tables);
+	if (pref_tables > 0) {
+		printf("%u tables with the preference limits:\n", pref_tables);
+		reassemblystat_print_limits((uint64_t)prefs.reassembly_max_memory * 1024,
+					    prefs.reassembly_max_age);
+	}
+	reassembly_tables_get_stats(&stats);
+	printf("All tables:\n");
+	reassemblystat_print_stats(&stats);
+	printf("===================================================================\n");
+}
+
+static bool
+reassemblystat_init(const char *opt_arg, void *userdata _U_)
+{
+	GString *error_string;
+
+	if (strcmp(opt_arg, "reassembly,stat") != 0) {
+		cmdarg_err("invalid \"-z reassembly,stat\" argument; it takes no filter");
+		return false;
+	}
+
+	/*
+	 * The counters are kept by the reassembly tables themselves, so there
+	 * is nothing to do per packet; the listener only provides the hook
+	 * that prints them once the capture has been read.
+	 */
+	error_string = register_tap_listener("frame", NULL, NULL, TL_REQUIRES_NOTHING,
+			NULL, NULL, reassemblystat_draw, NULL);
+	if (error_string) {
+		cmdarg_err("Couldn't register reassembly,stat tap: %s",
+			error_string->str);
+		g_string_free(error_string, TRUE);
+		return false;
+	}
+
+	return true;
+}
+
+static stat_tap_ui reassemblystat_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	"reassembly,stat",
+	reassemblystat_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_reassemblystat(void)
+{
+	register_stat_tap_ui(&reassemblystat_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -109,6 +109,9 @@ init_stats_tree(const char *opt_arg, void *userdata _U_)
 	if (cfg->init)
 		cfg->init(st);
 
+	set_tap_worker_callbacks(st, stats_tree_worker_new,
+			stats_tree_worker_merge, stats_tree_worker_free);
+
 	return true;
 }
 
@@ -0,0 +1,145 @@
+/* tap-wmemstat.c
+ * Report the memory held by the wmem scopes and the sizes of the
+ * allocations made in them.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+#include <epan/wmem_scopes.h>
+
+#include <wsutil/cmdarg_err.h>
+
+void register_tap_listener_wmemstat(void);
+
+typedef struct _wmemstat_t {
+	bool                   have_packet_scope;
+	wmem_allocator_stats_t packet_scope;
+} wmemstat_t;
+
+static tap_packet_status
+wmemstat_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data _U_, tap_flags_t flags _U_)
+{
+	wmemstat_t *ws = (wmemstat_t *)tapdata;
+
+	/* The packet scope is reset for every packet but its counters are not,
+	 * so the last packet's snapshot covers all of them. */
+	wmem_allocator_get_stats(pinfo->pool, &ws->packet_scope);
+	ws->have_packet_scope = true;
+
+	return TAP_PACKET_DONT_REDRAW;
+}
+
+static void
+wmemstat_print_scope(const char *name, const wmem_allocator_stats_t *stats)
+{
+	unsigned i;
+	size_t   max;
+
+	printf("\n%s scope:\n", name);
+	printf("  Bytes in use:                  %" PRIu64 "\n", stats->bytes_in_use);
+	printf("  Peak bytes in use:             %" PRIu64 "\n", stats->bytes_peak);
+	printf("  Blocks:                        %u\n", stats->block_count);
+	printf("  Allocations:                   %" PRIu64 "\n", stats->alloc_count);
+	for (i = 0; i < WMEM_ALLOC_HISTOGRAM_BUCKETS; i++) {
+		max = wmem_alloc_histogram_bucket_max(i);
+		if (max)
+			printf("    up to %-8zu bytes:        %" PRIu64 "\n", max, stats->alloc_histogram[i]);
+		else
+			printf("    larger:                      %" PRIu64 "\n", stats->alloc_histogram[i]);
+	}
+}
+
+static void
+wmemstat_draw(void *tapdata)
+{
+	wmemstat_t             *ws = (wmemstat_t *)tapdata;
+	wmem_allocator_stats_t  stats;
+
+	printf("\n");
+	printf("===================================================================\n");
+	printf("Memory Statistics:\n");
+
+	wmem_allocator_get_stats(wmem_epan_scope(), &stats);
+	wmemstat_print_scope("Epan", &stats);
+	wmem_allocator_get_stats(wmem_file_scope(), &stats);
+	wmemstat_print_scope("File", &stats);
+	if (ws->have_packet_scope)
+		wmemstat_print_scope("Packet", &ws->packet_scope);
+
+	printf("\nBlock cache of this thread:    %zu bytes\n", wmem_block_cache_size());
+	printf("===================================================================\n");
+}
+
+static void
+wmemstat_finish(void *tapdata)
+{
+	g_free(tapdata);
+}
+
+static bool
+wmemstat_init(const char *opt_arg, void *userdata _U_)
+{
+	wmemstat_t *ws;
+	GString    *error_string;
+
+	if (strcmp(opt_arg, "wmem,stat") != 0) {
+		cmdarg_err("invalid \"-z wmem,stat\" argument; it takes no filter");
+		return false;
+	}
+
+	ws = g_new0(wmemstat_t, 1);
+
+	error_string = register_tap_listener("frame", ws, NULL, TL_REQUIRES_NOTHING,
+			NULL, wmemstat_packet, wmemstat_draw, wmemstat_finish);
+	if (error_string) {
+		g_free(ws);
+		cmdarg_err("Couldn't register wmem,stat tap: %s",
+			error_string->str);
+		g_string_free(error_string, TRUE);
+		return false;
+	}
+
+	return true;
+}
+
+static stat_tap_ui wmemstat_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	"wmem,stat",
+	wmemstat_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_wmemstat(void)
+{
+	register_stat_tap_ui(&wmemstat_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -207,6 +207,33 @@ GString *check_field_unit(const char *field_name, int *hf_index, io_graph_item_u
  */
 double get_io_graph_item(const io_graph_item_t *items, io_graph_item_unit_t val_units, int idx, int hf_index, const capture_file *cap_file, int interval, int cur_idx, bool asAOT);
 
+/** Add the values of one io_graph_item_t to another.
+ *
+ * Used to build an interval out of shorter ones, so that the result is the
+ * same as if the packets had been tapped at the longer interval.
+ *
+ * @param dst [in,out] The item to add to.
+ * @param src [in] The item to add.
+ * @param hf_index [in] Header field index for advanced statistics, or -1.
+ */
+void merge_io_graph_item(io_graph_item_t *dst, const io_graph_item_t *src, int hf_index);
+
+/** Aggregate items into intervals factor times as long.
+ *
+ * Item i of dst is the merge of items i*factor to i*factor+factor-1 of
+ * src, so a graph tapped at a short interval can be shown at any multiple
+ * of it without tapping again. dst may be the same array as src.
+ *
+ * @param dst [out] Array for the aggregated items; must hold
+ *                  (num_items + factor - 1) / factor of them.
+ * @param src [in] Array of items to aggregate.
+ * @param num_items [in] Number of items in src.
+ * @param factor [in] Number of src items per dst item; at least 1.
+ * @param hf_index [in] Header field index for advanced statistics, or -1.
+ * @return The number of items written to dst.
+ */
+size_t aggregate_io_graph_items(io_graph_item_t *dst, const io_graph_item_t *src, size_t num_items, unsigned factor, int hf_index);
+
 /** Update the values of an io_graph_item_t.
  *
  * Frame and byte counts are always calculated. If edt is non-NULL advanced
@@ -30,6 +30,14 @@
 // 2^25 = 16777216
 const int max_io_items_ = 1 << 25;
 
+// Tap at a tenth of the displayed interval, but not below a millisecond,
+// so that changing to a coarser interval doesn't require a retap.
+// The buckets only hold the statistics of the current Y field and value
+// unit, so changing either of those still retaps; see setValueUnits()
+// and setValueUnitField().
+const int tap_interval_divisor_ = 10;
+const int min_tap_interval_ = SCALE / 1000;
+
 IOGraph::IOGraph(QCustomPlot* parent, const char* type_unit_name) :
     Graph(parent),
     moving_avg_period_(0),
@@ -39,9 +47,12 @@ IOGraph::IOGraph(QCustomPlot* parent, const char* type_unit_name) :
     start_time_(NSTIME_INIT_ZERO),
     hf_index_(-1),
     interval_(0),
+    tap_interval_(0),
     asAOT_(false),
     type_unit_name_(type_unit_name),
-    cur_idx_(-1)
+    cur_idx_(-1),
+    view_cur_idx_(-1),
+    view_dirty_(false)
 {
     GString* error_string;
     error_string = register_tap_listener("frame",
@@ -304,14 +315,15 @@ nstime_t IOGraph::startTime() const
 int IOGraph::packetFromTime(double ts) const
 {
     int idx = ts * SCALE_F / interval_;
-    if (idx >= 0 && idx <= cur_idx_) {
+    if (idx >= 0 && idx <= view_cur_idx_) {
+        const io_graph_item_t* item = &viewItems()[idx];
         switch (val_units_) {
         case IOG_ITEM_UNIT_CALC_MAX:
-            return items_[idx].max_frame_in_invl;
+            return item->max_frame_in_invl;
         case IOG_ITEM_UNIT_CALC_MIN:
-            return items_[idx].min_frame_in_invl;
+            return item->min_frame_in_invl;
         default:
-            return items_[idx].last_frame_in_invl;
+            return item->last_frame_in_invl;
         }
     }
     return -1;
@@ -323,10 +335,65 @@ void IOGraph::clearAllData()
     if (items_.size()) {
         reset_io_graph_items(&items_[0], items_.size(), hf_index_);
     }
+    view_items_.clear();
+    view_cur_idx_ = -1;
+    view_dirty_ = false;
+    resetTapInterval();
     nstime_set_zero(&start_time_);
     Graph::clearAllData();
 }
 
+void IOGraph::resetTapInterval()
+{
+    // LOAD spreads each response time over the intervals before it, which
+    // has to be done at the displayed interval.
+    if (val_units_ != IOG_ITEM_UNIT_CALC_LOAD &&
+        interval_ % tap_interval_divisor_ == 0 &&
+        interval_ / tap_interval_divisor_ >= min_tap_interval_) {
+        tap_interval_ = interval_ / tap_interval_divisor_;
+    } else {
+        tap_interval_ = interval_;
+    }
+}
+
+void IOGraph::updateView()
+{
+    if (!view_dirty_) {
+        return;
+    }
+    view_dirty_ = false;
+
+    if (tap_interval_ == interval_ || cur_idx_ < 0) {
+        view_items_.clear();
+        view_cur_idx_ = cur_idx_;
+        return;
+    }
+
+    unsigned factor = interval_ / tap_interval_;
+    try {
+        view_items_.resize(cur_idx_ / factor + 1);
+    }
+    catch (std::bad_alloc&) {
+        ws_warning("Failed memory allocation.");
+        view_items_.clear();
+        view_cur_idx_ = -1;
+        return;
+    }
+    view_cur_idx_ = (int)aggregate_io_graph_items(view_items_.data(), items_.data(), cur_idx_ + 1, factor, hf_index_) - 1;
+}
+
+void IOGraph::coarsenTapInterval()
+{
+    unsigned factor = interval_ / tap_interval_;
+    size_t num_items = aggregate_io_graph_items(items_.data(), items_.data(), cur_idx_ + 1, factor, hf_index_);
+    if (num_items < items_.size()) {
+        reset_io_graph_items(&items_[num_items], items_.size() - num_items, hf_index_);
+    }
+    cur_idx_ = (int)num_items - 1;
+    tap_interval_ = interval_;
+    view_dirty_ = true;
+}
+
 void IOGraph::recalcGraphData(capture_file* cap_file)
 {
     /* Moving average variables */
@@ -341,7 +408,9 @@ void IOGraph::recalcGraphData(capture_file* cap_file)
         bars_->data()->clear();
     }
 
-    if (moving_avg_period_ > 0 && cur_idx_ >= 0) {
+    updateView();
+
+    if (moving_avg_period_ > 0 && view_cur_idx_ >= 0) {
         /* "Warm-up phase" - calculate average on some data not displayed;
          * just to make sure average on leftmost and rightmost displayed
          * values is as reliable as possible
@@ -352,7 +421,7 @@ void IOGraph::recalcGraphData(capture_file* cap_file)
         mavg_in_average_count++;
         for (warmup_interval = 1;
             (warmup_interval < moving_avg_period_ / 2) &&
-            (warmup_interval <= (unsigned)cur_idx_);
+            (warmup_interval <= (unsigned)view_cur_idx_);
             warmup_interval += 1) {
 
             mavg_cumulated += getItemValue((int)warmup_interval, cap_file);
@@ -362,7 +431,7 @@ void IOGraph::recalcGraphData(capture_file* cap_file)
     }
 
     double ts_offset = startOffset();
-    for (int i = 0; i <= cur_idx_; i++) {
+    for (int i = 0; i <= view_cur_idx_; i++) {
         double ts = (double)i * interval_ / SCALE_F + ts_offset;
         double val = getItemValue(i, cap_file);
 
@@ -375,7 +444,7 @@ void IOGraph::recalcGraphData(capture_file* cap_file)
                     mavg_cumulated -= getItemValue(mavg_to_remove, cap_file);
                     mavg_to_remove += 1;
                 }
-                if (mavg_to_add <= (unsigned int)cur_idx_) {
+                if (mavg_to_add <= (unsigned int)view_cur_idx_) {
                     mavg_in_average_count++;
                     mavg_cumulated += getItemValue(mavg_to_add, cap_file);
                     mavg_to_add += 1;
@@ -519,7 +588,7 @@ bool IOGraph::hasItemToShow(int idx, double value) const
 
     bool result = false;
 
-    const io_graph_item_t* item = &items_[idx];
+    const io_graph_item_t* item = &viewItems()[idx];
 
     switch (val_units_) {
     case IOG_ITEM_UNIT_PACKETS:
@@ -554,12 +623,23 @@ bool IOGraph::hasItemToShow(int idx, double value) const
     return result;
 }
 
-void IOGraph::setInterval(int interval)
+bool IOGraph::setInterval(int interval)
 {
+    bool need_retap = (interval != interval_);
+
     interval_ = interval;
     if (bars_) {
         bars_->setWidth(interval_ / SCALE_F);
     }
+    if (need_retap && tap_interval_ > 0 && interval_ % tap_interval_ == 0 &&
+        val_units_ != IOG_ITEM_UNIT_CALC_LOAD) {
+        // Derive the new interval from what was already tapped.
+        need_retap = false;
+        view_dirty_ = true;
+    } else if (need_retap) {
+        resetTapInterval();
+    }
+    return need_retap;
 }
 
 // Get the value at the given interval (idx) for the current value unit.
@@ -567,7 +647,7 @@ double IOGraph::getItemValue(int idx, const capture_file* cap_file) const
 {
     ws_assert(idx < max_io_items_);
 
-    return get_io_graph_item(&items_[0], val_units_, idx, hf_index_, cap_file, interval_, cur_idx_, asAOT_);
+    return get_io_graph_item(viewItems(), val_units_, idx, hf_index_, cap_file, interval_, view_cur_idx_, asAOT_);
 }
 
 // "tap_reset" callback for register_tap_listener
@@ -588,12 +668,21 @@ tap_packet_status IOGraph::tapPacket(void* iog_ptr, packet_info* pinfo, epan_dis
         return TAP_PACKET_DONT_REDRAW;
     }
 
-    int64_t tmp_idx = get_io_graph_index(pinfo, iog->interval_);
+    int64_t tmp_idx = get_io_graph_index(pinfo, iog->tap_interval_);
     bool recalc = false;
 
+    /* If the capture is too long to keep at the finer interval, fall back
+     * to tapping at the displayed one. */
+    if (tmp_idx >= max_io_items_ && iog->tap_interval_ < iog->interval_ &&
+        iog->interval_ % iog->tap_interval_ == 0) {
+        iog->coarsenTapInterval();
+        tmp_idx = get_io_graph_index(pinfo, iog->tap_interval_);
+    }
+
     /* some sanity checks */
     if ((tmp_idx < 0) || (tmp_idx >= max_io_items_)) {
         iog->cur_idx_ = (int)iog->items_.size() - 1;
+        iog->view_dirty_ = true;
         return TAP_PACKET_DONT_REDRAW;
     }
 
@@ -652,9 +741,10 @@ tap_packet_status IOGraph::tapPacket(void* iog_ptr, packet_info* pinfo, epan_dis
         adv_edt = edt;
     }
 
-    if (!update_io_graph_item(&iog->items_[0], idx, pinfo, adv_edt, iog->hf_index_, iog->val_units_, iog->interval_)) {
+    if (!update_io_graph_item(&iog->items_[0], idx, pinfo, adv_edt, iog->hf_index_, iog->val_units_, iog->tap_interval_)) {
         return TAP_PACKET_DONT_REDRAW;
     }
+    iog->view_dirty_ = true;
 
     //    qDebug() << "=tapPacket" << iog->name_ << idx << iog->hf_index_ << iog->val_units_ << iog->num_items_;
 
@@ -183,9 +183,13 @@ public:
 
     /**
      * @brief Sets the time interval for data bucketing.
-     * @param interval The interval in milliseconds.
+     *
+     * If the new interval is a multiple of the interval the data was tapped
+     * at, the graph is derived from the tapped data and only needs a recalc.
+     * @param interval The interval in microseconds.
+     * @return True if the packets must be tapped again, false otherwise.
      */
-    void setInterval(int interval);
+    bool setInterval(int interval);
 
     /**
      * @brief Determines the packet number closest to a specific timestamp.
@@ -214,7 +218,7 @@ public:
      * @brief Retrieves the maximum populated interval index.
      * @return The maximum interval index.
      */
-    int maxInterval() const { return cur_idx_; }
+    int maxInterval() const { return view_cur_idx_; }
 
     /**
      * @brief Clears all cached plotting and tap data.
@@ -344,6 +348,12 @@ private:
     /** The data bucketing interval. */
     int interval_;
 
+    /**
+     * The interval items_ is tapped at. This is a fraction of interval_
+     * when possible so that coarser intervals can be shown without retapping.
+     */
+    int tap_interval_;
+
     /** Flag indicating if values are interpreted as an average over time. */
     bool asAOT_; // Average Over Time interpretation
 
@@ -358,6 +368,38 @@ private:
 
     /** The highest interval index currently populated with data. */
     int cur_idx_;
+
+    /**
+     * items_ aggregated to interval_, when that differs from tap_interval_.
+     * Empty if items_ can be used as is.
+     */
+    std::vector<io_graph_item_t> view_items_;
+
+    /** The highest index in the displayed items. */
+    int view_cur_idx_;
+
+    /** Flag indicating view_items_ needs to be rebuilt from items_. */
+    bool view_dirty_;
+
+    /**
+     * @brief Chooses the interval to tap at for the current interval and value units.
+     */
+    void resetTapInterval();
+
+    /**
+     * @brief Rebuilds the displayed items from the tapped ones if needed.
+     */
+    void updateView();
+
+    /**
+     * @brief Aggregates the tapped items to interval_ and taps at that from now on.
+     */
+    void coarsenTapInterval();
+
+    /**
+     * @brief Returns the items at interval_.
+     */
+    const io_graph_item_t* viewItems() const { return view_items_.empty() ? items_.data() : view_items_.data(); }
 };
 
 #endif // IO_GRAPH_H
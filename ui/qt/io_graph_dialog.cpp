@@ -1532,6 +1532,7 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
 {
     int interval = ui->intervalComboBox->itemData(ui->intervalComboBox->currentIndex()).toInt();
     bool need_retap = false;
+    bool need_recalc = false;
 
     precision_ = ceil(log10(SCALE_F / interval));
     if (precision_ < 0) {
@@ -1553,8 +1554,10 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
         for (int row = 0; row < uat_model_->rowCount(); row++) {
             IOGraph *iog = ioGraphs_.value(row, NULL);
             if (iog) {
-                iog->setInterval(interval);
-                if (iog->visible()) {
+                if (!iog->setInterval(interval)) {
+                    // Derived from the data already tapped.
+                    need_recalc = true;
+                } else if (iog->visible()) {
                     need_retap = true;
                 } else {
                     iog->setNeedRetap(true);
@@ -1565,6 +1568,8 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
 
     if (need_retap) {
         scheduleRetap(true);
+    } else if (need_recalc) {
+        scheduleRecalc(true);
     }
 }
 
@@ -602,6 +602,8 @@ void DisplayFilterEdit::buildCompletionList(const QString &field_word, const QSt
         void *proto_cookie;
 
         int field_dots = static_cast<int>(field_word.count('.')); // Some protocol names (_ws.expert) contain periods.
+        // Register the fields of protocols that register them on first use.
+        if (field_dots > 0) proto_initialize_all_prefixes();
         for (int proto_id = proto_get_first_protocol(&proto_cookie); proto_id != -1; proto_id = proto_get_next_protocol(&proto_cookie)) {
             protocol_t *protocol = find_protocol_by_id(proto_id);
             if (!proto_is_protocol_enabled(protocol)) continue;
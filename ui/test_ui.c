@@ -0,0 +1,367 @@
+/*
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <wsutil/wslog.h>
+
+#include <epan/epan.h>
+#include <epan/proto.h>
+
+#include "ui/io_graph_item.h"
+
+#define PROGNAME "test_ui"
+
+/* 100 ms, in microseconds as I/O graph intervals are. */
+#define IOG_TEST_INTERVAL 100000
+
+static int proto_iogtest;
+static int hf_iogtest_uint;
+static int hf_iogtest_int;
+static int hf_iogtest_double;
+static int hf_iogtest_time;
+
+static void
+register_iogtest(register_cb cb _U_, void *client_data _U_)
+{
+    static hf_register_info hf[] = {
+        { &hf_iogtest_uint,
+          { "UInt32", "iogtest.uint", FT_UINT32, BASE_DEC, NULL, 0x0, NULL, HFILL }},
+        { &hf_iogtest_int,
+          { "Int32", "iogtest.int", FT_INT32, BASE_DEC, NULL, 0x0, NULL, HFILL }},
+        { &hf_iogtest_double,
+          { "Double", "iogtest.double", FT_DOUBLE, BASE_NONE, NULL, 0x0, NULL, HFILL }},
+        { &hf_iogtest_time,
+          { "Time", "iogtest.time", FT_RELATIVE_TIME, BASE_NONE, NULL, 0x0, NULL, HFILL }},
+    };
+
+    proto_iogtest = proto_register_protocol("I/O Graph Test", "IOGTEST", "iogtest");
+    proto_register_field_array(proto_iogtest, hf, G_N_ELEMENTS(hf));
+}
+
+static bool epan_initialized;
+
+/* Register the test protocol, and only it, once for all tests. */
+static void
+test_ui_init(void)
+{
+    static const char *col_fmt[] = { "No.", "%m" };
+    epan_app_data_t app_data = { 0 };
+
+    if (epan_initialized)
+        return;
+
+    app_data.env_var_prefix = "WIRESHARK";
+    app_data.col_fmt = col_fmt;
+    app_data.num_cols = 1;
+    app_data.register_func = register_iogtest;
+    g_assert_true(epan_init(NULL, NULL, false, &app_data));
+    epan_initialized = true;
+}
+
+/* An interval with a single unsigned field value in a single frame. */
+static void
+iog_test_uint_item(io_graph_item_t *item, uint32_t frame, uint64_t value)
+{
+    reset_io_graph_items(item, 1, hf_iogtest_uint);
+    item->frames = 1;
+    item->bytes = 100;
+    item->fields = 1;
+    item->uint_max = item->uint_min = value;
+    item->double_tot = (double)value;
+    item->first_frame_in_invl = item->last_frame_in_invl = frame;
+    item->min_frame_in_invl = item->max_frame_in_invl = frame;
+}
+
+static void
+test_io_graph_item_merge_uint(void)
+{
+    io_graph_item_t dst, src;
+
+    test_ui_init();
+
+    /* dst: frames 1 (value 10) and 3 (value 30) */
+    iog_test_uint_item(&dst, 1, 10);
+    dst.frames = 2;
+    dst.bytes = 200;
+    dst.fields = 2;
+    dst.uint_max = 30;
+    dst.max_frame_in_invl = 3;
+    dst.double_tot = 40;
+    dst.last_frame_in_invl = 3;
+
+    /* src: frames 5 (value 5) and 7 (value 60) */
+    iog_test_uint_item(&src, 5, 5);
+    src.frames = 2;
+    src.bytes = 150;
+    src.fields = 2;
+    src.uint_max = 60;
+    src.max_frame_in_invl = 7;
+    src.double_tot = 65;
+    src.last_frame_in_invl = 7;
+
+    merge_io_graph_item(&dst, &src, hf_iogtest_uint);
+
+    g_assert_cmpuint(dst.frames, ==, 4);
+    g_assert_cmpuint(dst.bytes, ==, 350);
+    g_assert_cmpuint(dst.fields, ==, 4);
+    g_assert_cmpuint(dst.uint_min, ==, 5);
+    g_assert_cmpuint(dst.min_frame_in_invl, ==, 5);
+    g_assert_cmpuint(dst.uint_max, ==, 60);
+    g_assert_cmpuint(dst.max_frame_in_invl, ==, 7);
+    g_assert_cmpuint(dst.first_frame_in_invl, ==, 1);
+    g_assert_cmpuint(dst.last_frame_in_invl, ==, 7);
+
+    /* The average is over all the values, not the mean of the two averages. */
+    g_assert_cmpfloat(get_io_graph_item(&dst, IOG_ITEM_UNIT_CALC_AVERAGE, 0, hf_iogtest_uint,
+                                        NULL, IOG_TEST_INTERVAL, 0, false), ==, 105.0 / 4);
+    g_assert_cmpfloat(get_io_graph_item(&dst, IOG_ITEM_UNIT_CALC_SUM, 0, hf_iogtest_uint,
+                                        NULL, IOG_TEST_INTERVAL, 0, false), ==, 105.0);
+    g_assert_cmpfloat(get_io_graph_item(&dst, IOG_ITEM_UNIT_CALC_MIN, 0, hf_iogtest_uint,
+                                        NULL, IOG_TEST_INTERVAL, 0, false), ==, 5.0);
+    g_assert_cmpfloat(get_io_graph_item(&dst, IOG_ITEM_UNIT_CALC_MAX, 0, hf_iogtest_uint,
+                                        NULL, IOG_TEST_INTERVAL, 0, false), ==, 60.0);
+}
+
+static void
+test_io_graph_item_merge_int(void)
+{
+    io_graph_item_t dst, src;
+
+    test_ui_init();
+
+    /*
+     * An interval without field values has zero min and max; they must
+     * not be taken as values when the other interval's are all negative.
+     */
+    reset_io_graph_items(&dst, 1, hf_iogtest_int);
+    dst.frames = 1;
+    dst.bytes = 60;
+    dst.first_frame_in_invl = dst.last_frame_in_invl = 2;
+
+    reset_io_graph_items(&src, 1, hf_iogtest_int);
+    src.frames = 2;
+    src.bytes = 120;
+    src.fields = 2;
+    src.int_min = -20;
+    src.min_frame_in_invl = 4;
+    src.int_max = -3;
+    src.max_frame_in_invl = 5;
+    src.double_tot = -23;
+    src.first_frame_in_invl = 4;
+    src.last_frame_in_invl = 5;
+
+    merge_io_graph_item(&dst, &src, hf_iogtest_int);
+
+    g_assert_cmpuint(dst.frames, ==, 3);
+    g_assert_cmpuint(dst.fields, ==, 2);
+    g_assert_cmpint(dst.int_min, ==, -20);
+    g_assert_cmpuint(dst.min_frame_in_invl, ==, 4);
+    g_assert_cmpint(dst.int_max, ==, -3);
+    g_assert_cmpuint(dst.max_frame_in_invl, ==, 5);
+    g_assert_cmpfloat(dst.double_tot, ==, -23.0);
+    g_assert_cmpuint(dst.first_frame_in_invl, ==, 2);
+    g_assert_cmpuint(dst.last_frame_in_invl, ==, 5);
+
+    /* Nor the other way round. */
+    reset_io_graph_items(&src, 1, hf_iogtest_int);
+    src.frames = 1;
+    src.first_frame_in_invl = src.last_frame_in_invl = 6;
+    merge_io_graph_item(&dst, &src, hf_iogtest_int);
+
+    g_assert_cmpint(dst.int_min, ==, -20);
+    g_assert_cmpint(dst.int_max, ==, -3);
+    g_assert_cmpuint(dst.last_frame_in_invl, ==, 6);
+}
+
+static void
+test_io_graph_item_merge_double(void)
+{
+    io_graph_item_t dst, src;
+
+    test_ui_init();
+
+    reset_io_graph_items(&dst, 1, hf_iogtest_double);
+    dst.frames = dst.fields = 1;
+    dst.double_min = dst.double_max = dst.double_tot = 1.5;
+    dst.first_frame_in_invl = dst.last_frame_in_invl = 1;
+    dst.min_frame_in_invl = dst.max_frame_in_invl = 1;
+
+    reset_io_graph_items(&src, 1, hf_iogtest_double);
+    src.frames = src.fields = 2;
+    src.double_min = 0.25;
+    src.min_frame_in_invl = 3;
+    src.double_max = 1.25;
+    src.max_frame_in_invl = 2;
+    src.double_tot = 1.5;
+    src.first_frame_in_invl = 2;
+    src.last_frame_in_invl = 3;
+
+    merge_io_graph_item(&dst, &src, hf_iogtest_double);
+
+    g_assert_cmpfloat(dst.double_min, ==, 0.25);
+    g_assert_cmpuint(dst.min_frame_in_invl, ==, 3);
+    g_assert_cmpfloat(dst.double_max, ==, 1.5);
+    g_assert_cmpuint(dst.max_frame_in_invl, ==, 1);
+    g_assert_cmpfloat(get_io_graph_item(&dst, IOG_ITEM_UNIT_CALC_AVERAGE, 0, hf_iogtest_double,
+                                        NULL, IOG_TEST_INTERVAL, 0, false), ==, 1.0);
+}
+
+static void
+test_io_graph_item_merge_time(void)
+{
+    io_graph_item_t items[2];
+    double load_0, load_1, load;
+
+    test_ui_init();
+
+    /* 50 ms of response time in the first interval, 150 ms in the second. */
+    reset_io_graph_items(items, 2, hf_iogtest_time);
+    items[0].frames = items[0].fields = 1;
+    items[0].time_min = items[0].time_max = items[0].time_tot = (nstime_t)NSTIME_INIT_SECS_MSECS(0, 50);
+    items[0].first_frame_in_invl = items[0].last_frame_in_invl = 1;
+    items[0].min_frame_in_invl = items[0].max_frame_in_invl = 1;
+    items[1].frames = items[1].fields = 2;
+    items[1].time_min = (nstime_t)NSTIME_INIT_SECS_MSECS(0, 40);
+    items[1].min_frame_in_invl = 2;
+    items[1].time_max = (nstime_t)NSTIME_INIT_SECS_MSECS(0, 110);
+    items[1].max_frame_in_invl = 3;
+    items[1].time_tot = (nstime_t)NSTIME_INIT_SECS_MSECS(0, 150);
+    items[1].first_frame_in_invl = 2;
+    items[1].last_frame_in_invl = 3;
+
+    load_0 = get_io_graph_item(items, IOG_ITEM_UNIT_CALC_LOAD, 0, hf_iogtest_time,
+                               NULL, IOG_TEST_INTERVAL, 1, false);
+    load_1 = get_io_graph_item(items, IOG_ITEM_UNIT_CALC_LOAD, 1, hf_iogtest_time,
+                               NULL, IOG_TEST_INTERVAL, 1, false);
+    g_assert_cmpfloat_with_epsilon(load_0, 0.5, 1e-9);
+    g_assert_cmpfloat_with_epsilon(load_1, 1.5, 1e-9);
+
+    merge_io_graph_item(&items[0], &items[1], hf_iogtest_time);
+
+    g_assert_cmpint(items[0].time_min.secs, ==, 0);
+    g_assert_cmpint(items[0].time_min.nsecs, ==, 40000000);
+    g_assert_cmpuint(items[0].min_frame_in_invl, ==, 2);
+    g_assert_cmpint(items[0].time_max.nsecs, ==, 110000000);
+    g_assert_cmpuint(items[0].max_frame_in_invl, ==, 3);
+    g_assert_cmpint(items[0].time_tot.nsecs, ==, 200000000);
+    g_assert_cmpuint(items[0].fields, ==, 3);
+
+    /* The load over the twice as long interval is the mean of the two loads. */
+    load = get_io_graph_item(items, IOG_ITEM_UNIT_CALC_LOAD, 0, hf_iogtest_time,
+                             NULL, 2 * IOG_TEST_INTERVAL, 1, false);
+    g_assert_cmpfloat_with_epsilon(load, (load_0 + load_1) / 2, 1e-9);
+    g_assert_cmpfloat_with_epsilon(get_io_graph_item(items, IOG_ITEM_UNIT_CALC_AVERAGE, 0, hf_iogtest_time,
+                                                     NULL, 2 * IOG_TEST_INTERVAL, 1, false),
+                                   0.2 / 3, 1e-9);
+}
+
+static void
+test_io_graph_item_aggregate(void)
+{
+    /* Frame i + 1 in interval i, except for the empty interval 2. */
+    static const uint64_t values[] = { 40, 10, 0, 70, 20 };
+    io_graph_item_t items[G_N_ELEMENTS(values)];
+    io_graph_item_t copy[G_N_ELEMENTS(values)];
+    size_t num_items;
+
+    test_ui_init();
+
+    for (size_t i = 0; i < G_N_ELEMENTS(values); i++) {
+        iog_test_uint_item(&items[i], (uint32_t)i + 1, values[i]);
+    }
+    reset_io_graph_items(&items[2], 1, hf_iogtest_uint);
+    memcpy(copy, items, sizeof(items));
+
+    g_assert_cmpuint(aggregate_io_graph_items(items, items, G_N_ELEMENTS(items), 0, hf_iogtest_uint), ==, 0);
+
+    /* A factor of 1 leaves the items as they are. */
+    g_assert_cmpuint(aggregate_io_graph_items(items, items, G_N_ELEMENTS(items), 1, hf_iogtest_uint), ==, 5);
+    g_assert_true(memcmp(copy, items, sizeof(items)) == 0);
+
+    /* In place, by 2: { 0, 1 }, { 2, 3 } and the partial { 4 }. */
+    num_items = aggregate_io_graph_items(items, items, G_N_ELEMENTS(items), 2, hf_iogtest_uint);
+    g_assert_cmpuint(num_items, ==, 3);
+
+    g_assert_cmpuint(items[0].frames, ==, 2);
+    g_assert_cmpuint(items[0].bytes, ==, 200);
+    g_assert_cmpuint(items[0].first_frame_in_invl, ==, 1);
+    g_assert_cmpuint(items[0].last_frame_in_invl, ==, 2);
+    g_assert_cmpuint(items[0].uint_min, ==, 10);
+    g_assert_cmpuint(items[0].min_frame_in_invl, ==, 2);
+    g_assert_cmpuint(items[0].uint_max, ==, 40);
+    g_assert_cmpuint(items[0].max_frame_in_invl, ==, 1);
+    g_assert_cmpfloat(items[0].double_tot, ==, 50.0);
+
+    /* The empty interval comes first, and neither its zero frame
+     * number nor its zero values are taken. */
+    g_assert_cmpuint(items[1].frames, ==, 1);
+    g_assert_cmpuint(items[1].first_frame_in_invl, ==, 4);
+    g_assert_cmpuint(items[1].last_frame_in_invl, ==, 4);
+    g_assert_cmpuint(items[1].uint_min, ==, 70);
+    g_assert_cmpuint(items[1].uint_max, ==, 70);
+
+    g_assert_cmpuint(items[2].frames, ==, 1);
+    g_assert_cmpuint(items[2].first_frame_in_invl, ==, 5);
+    g_assert_cmpuint(items[2].uint_min, ==, 20);
+
+    /* By more than there are items: a single interval with everything. */
+    num_items = aggregate_io_graph_items(items, copy, G_N_ELEMENTS(copy), 10, hf_iogtest_uint);
+    g_assert_cmpuint(num_items, ==, 1);
+    g_assert_cmpuint(items[0].frames, ==, 4);
+    g_assert_cmpuint(items[0].fields, ==, 4);
+    g_assert_cmpuint(items[0].first_frame_in_invl, ==, 1);
+    g_assert_cmpuint(items[0].last_frame_in_invl, ==, 5);
+    g_assert_cmpuint(items[0].uint_min, ==, 10);
+    g_assert_cmpuint(items[0].uint_max, ==, 70);
+    g_assert_cmpuint(items[0].max_frame_in_invl, ==, 4);
+    g_assert_cmpfloat(get_io_graph_item(items, IOG_ITEM_UNIT_CALC_AVERAGE, 0, hf_iogtest_uint,
+                                        NULL, IOG_TEST_INTERVAL, 0, false), ==, 35.0);
+}
+
+int main(int argc, char **argv)
+{
+    int ret;
+
+    /* Set the program name. */
+    g_set_prgname(PROGNAME);
+
+    ws_log_init(NULL, "Test Logging Debug Console");
+
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/io_graph_item/merge_uint", test_io_graph_item_merge_uint);
+    g_test_add_func("/io_graph_item/merge_int", test_io_graph_item_merge_int);
+    g_test_add_func("/io_graph_item/merge_double", test_io_graph_item_merge_double);
+    g_test_add_func("/io_graph_item/merge_time", test_io_graph_item_merge_time);
+    g_test_add_func("/io_graph_item/aggregate", test_io_graph_item_aggregate);
+
+    ret = g_test_run();
+
+    if (epan_initialized)
+        epan_cleanup();
+
+    return ret;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -1265,6 +1265,128 @@ static void test_ws_hexbuftoi64(void)
     test_int64(hexstr, 2, &hexstr[1], 16, true, 0, 0);
     test_int64(hexstr, 2, &hexstr[1], 0, true, 0, 0);
 }
+#include "ws_mempbrk.h"
+
+static const uint8_t *
+scalar_mempbrk(const uint8_t *haystack, size_t haystacklen, const char *needles, unsigned char *found_needle)
+{
+    for (size_t i = 0; i < haystacklen; i++) {
+        if (memchr(needles, haystack[i], strlen(needles)) != NULL) {
+            *found_needle = haystack[i];
+            return &haystack[i];
+        }
+    }
+    return NULL;
+}
+
+static void test_mempbrk_exec(void)
+{
+    static const char *needle_sets[] = {
+        "\r\n",
+        "\"\\",
+        " \t,;=",
+        "\x7f\x80\xff",
+        "\x01\x10\x81\xef",
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZ",
+    };
+    uint8_t buf[160];
+    GRand *rand = g_rand_new_with_seed(1234);
+
+    for (size_t s = 0; s < G_N_ELEMENTS(needle_sets); s++) {
+        ws_mempbrk_pattern pattern;
+
+        ws_mempbrk_compile(&pattern, needle_sets[s]);
+        for (int iter = 0; iter < 50; iter++) {
+            /* Mostly bytes that aren't needles, with a few that are. */
+            for (size_t i = 0; i < sizeof buf; i++) {
+                buf[i] = (uint8_t)g_rand_int_range(rand, 0, 256);
+                while (strchr(needle_sets[s], buf[i]) != NULL)
+                    buf[i]++;
+            }
+            for (int n = g_rand_int_range(rand, 0, 3); n > 0; n--) {
+                size_t len = strlen(needle_sets[s]);
+                buf[g_rand_int_range(rand, 0, sizeof buf)] =
+                    needle_sets[s][g_rand_int_range(rand, 0, (int)len)];
+            }
+
+            /* Every alignment and every length up to 100 bytes, so that
+             * all of the SIMD loop, tail and fallback paths are used. */
+            for (size_t off = 0; off < 32; off++) {
+                for (size_t len = 0; len <= 100 && off + len <= sizeof buf; len++) {
+                    unsigned char found = 0, want_found = 0;
+                    const uint8_t *want = scalar_mempbrk(buf + off, len, needle_sets[s], &want_found);
+                    const uint8_t *have = ws_mempbrk_exec(buf + off, len, &pattern, &found);
+
+                    g_assert_true(have == want);
+                    if (want != NULL)
+                        g_assert_cmpuint(found, ==, want_found);
+                }
+            }
+        }
+    }
+
+    g_rand_free(rand);
+}
+
+static void test_mempbrk_perf(void)
+{
+#define MEMPBRK_TEXT_LEN (1024 * 1024)
+#define MEMPBRK_LOOP_COUNT 100
+    static const char line[] = "X-Header-Field-Name: some moderately long header value text";
+    ws_mempbrk_pattern pattern;
+    uint8_t *text;
+    size_t pos;
+    const uint8_t *p;
+    unsigned char found;
+    unsigned lines;
+    int i;
+    double start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    /* Build a large text payload of header-like lines ending in CRLF. */
+    text = g_malloc(MEMPBRK_TEXT_LEN);
+    for (pos = 0; pos + sizeof line + 1 <= MEMPBRK_TEXT_LEN; pos += sizeof line + 1) {
+        memcpy(text + pos, line, sizeof line - 1);
+        text[pos + sizeof line - 1] = '\r';
+        text[pos + sizeof line] = '\n';
+    }
+    memset(text + pos, 'x', MEMPBRK_TEXT_LEN - pos);
+
+    ws_mempbrk_compile(&pattern, "\r\n");
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < MEMPBRK_LOOP_COUNT; i++) {
+        lines = 0;
+        for (pos = 0; (p = ws_mempbrk_exec(text + pos, MEMPBRK_TEXT_LEN - pos, &pattern, &found)) != NULL; pos = p - text + 1)
+            lines++;
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "ws_mempbrk_exec(): %u line ends, u %.3f ms s %.3f ms", lines, utime_ms, stime_ms);
+
+    RESOURCE_USAGE_START;
+    for (i = 0; i < MEMPBRK_LOOP_COUNT; i++) {
+        lines = 0;
+        for (pos = 0; (p = scalar_mempbrk(text + pos, MEMPBRK_TEXT_LEN - pos, "\r\n", &found)) != NULL; pos = p - text + 1)
+            lines++;
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "scalar loop: %u line ends, u %.3f ms s %.3f ms", lines, utime_ms, stime_ms);
+
+    /* memchr() for a single needle, as a lower bound. */
+    RESOURCE_USAGE_START;
+    for (i = 0; i < MEMPBRK_LOOP_COUNT; i++) {
+        lines = 0;
+        for (pos = 0; (p = memchr(text + pos, '\n', MEMPBRK_TEXT_LEN - pos)) != NULL; pos = p - text + 1)
+            lines++;
+    }
+    RESOURCE_USAGE_END;
+    g_test_minimized_result(utime_ms + stime_ms,
+        "memchr(): %u line ends, u %.3f ms s %.3f ms", lines, utime_ms, stime_ms);
+
+    g_free(text);
+}
+
 int main(int argc, char **argv)
 {
     int ret;
@@ -1329,6 +1451,11 @@ int main(int argc, char **argv)
     g_test_add_func("/sap_lzclzh_decompress", test_sap_lzclzh_decompress);
     g_test_add_func("/sap_lzclzh_decompress/errors", test_sap_lzclzh_decompress_errors);
 
+    g_test_add_func("/ws_mempbrk/exec", test_mempbrk_exec);
+    if (g_test_perf()) {
+        g_test_add_func("/ws_mempbrk/perf", test_mempbrk_perf);
+    }
+
     ret = g_test_run();
 
     return ret;
@@ -16,6 +16,8 @@
 #include <glib.h>
 #include <string.h>
 
+#include "wmem_core.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -49,8 +51,64 @@ struct _wmem_allocator_t {
     void *private_data; /**< Allocator-specific internal state. */
     enum _wmem_allocator_type_t type; /**< Allocator type (e.g., scope, file-backed, slab). */
     bool in_scope; /**< Indicates whether the allocator is currently active in a scope. */
+
+    /* Statistics */
+    wmem_allocator_stats_t stats; /**< Usage counters, see wmem_allocator_get_stats(). */
 };
 
+/**
+ * @brief Account for a block of system memory acquired by an allocator.
+ *
+ * @param stats The allocator's counters.
+ * @param size The size of the block.
+ */
+static inline void
+wmem_stats_add_block(wmem_allocator_stats_t *stats, size_t size)
+{
+    stats->bytes_in_use += size;
+    stats->block_count++;
+    if (stats->bytes_in_use > stats->bytes_peak) {
+        stats->bytes_peak = stats->bytes_in_use;
+    }
+}
+
+/**
+ * @brief Account for a block of system memory released by an allocator.
+ *
+ * @param stats The allocator's counters.
+ * @param size The size of the block.
+ */
+static inline void
+wmem_stats_remove_block(wmem_allocator_stats_t *stats, size_t size)
+{
+    stats->bytes_in_use -= size;
+    stats->block_count--;
+}
+
+/**
+ * @brief Get a block of exactly the given size for a block allocator.
+ *
+ * The block comes from the calling thread's block cache if it has one of
+ * that size, and from the system otherwise.
+ *
+ * @param size The size of the block.
+ * @return The block.
+ */
+void *
+wmem_block_cache_get(size_t size);
+
+/**
+ * @brief Release a block obtained from wmem_block_cache_get().
+ *
+ * The block is kept in the calling thread's block cache unless the cache is
+ * full, in which case it is returned to the system.
+ *
+ * @param block The block.
+ * @param size The size it was obtained with.
+ */
+void
+wmem_block_cache_put(void *block, size_t size);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -144,6 +144,8 @@
 /* The header for an entire OS-level 'block' of memory */
 typedef struct _wmem_block_hdr_t {
     struct _wmem_block_hdr_t *prev, *next;
+
+    size_t size;
 } wmem_block_hdr_t;
 
 /* The header for a single 'chunk' of memory as returned from alloc/realloc.
@@ -199,6 +201,8 @@ typedef struct _wmem_block_allocator_t {
     wmem_block_hdr_t   *block_list;
     wmem_block_chunk_t *master_head;
     wmem_block_chunk_t *recycler_head;
+
+    wmem_allocator_stats_t *stats;
 } wmem_block_allocator_t;
 
 /* DEBUG AND TEST */
@@ -762,8 +766,10 @@ wmem_block_new_block(wmem_block_allocator_t *allocator)
     wmem_block_hdr_t *block;
 
     /* allocate the new block and add it to the block list */
-    block = (wmem_block_hdr_t *)wmem_alloc(NULL, WMEM_BLOCK_SIZE);
+    block = (wmem_block_hdr_t *)wmem_block_cache_get(WMEM_BLOCK_SIZE);
+    block->size = WMEM_BLOCK_SIZE;
     wmem_block_add_to_block_list(allocator, block);
+    wmem_stats_add_block(allocator->stats, block->size);
 
     /* initialize it */
     wmem_block_init_block(allocator, block);
@@ -782,9 +788,11 @@ wmem_block_alloc_jumbo(wmem_block_allocator_t *allocator, const size_t size)
     block = (wmem_block_hdr_t *) wmem_alloc(NULL, size
             + WMEM_BLOCK_HEADER_SIZE
             + WMEM_CHUNK_HEADER_SIZE);
+    block->size = size + WMEM_BLOCK_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE;
 
     /* add it to the block list */
     wmem_block_add_to_block_list(allocator, block);
+    wmem_stats_add_block(allocator->stats, block->size);
 
     /* the new block contains a single jumbo chunk */
     chunk = WMEM_BLOCK_TO_CHUNK(block);
@@ -808,6 +816,7 @@ wmem_block_free_jumbo(wmem_block_allocator_t *allocator,
     block = WMEM_CHUNK_TO_BLOCK(chunk);
 
     wmem_block_remove_from_block_list(allocator, block);
+    wmem_stats_remove_block(allocator->stats, block->size);
 
     wmem_free(NULL, block);
 }
@@ -821,10 +830,13 @@ wmem_block_realloc_jumbo(wmem_block_allocator_t *allocator,
     wmem_block_hdr_t *block;
 
     block = WMEM_CHUNK_TO_BLOCK(chunk);
+    wmem_stats_remove_block(allocator->stats, block->size);
 
     block = (wmem_block_hdr_t *) wmem_realloc(NULL, block, size
             + WMEM_BLOCK_HEADER_SIZE
             + WMEM_CHUNK_HEADER_SIZE);
+    block->size = size + WMEM_BLOCK_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE;
+    wmem_stats_add_block(allocator->stats, block->size);
 
     if (block->next) {
         block->next->prev = block;
@@ -1018,6 +1030,7 @@ wmem_block_free_all(void *private_data)
         chunk = WMEM_BLOCK_TO_CHUNK(cur);
         if (chunk->jumbo) {
             wmem_block_remove_from_block_list(allocator, cur);
+            wmem_stats_remove_block(allocator->stats, cur->size);
             cur = cur->next;
             wmem_free(NULL, WMEM_CHUNK_TO_BLOCK(chunk));
         }
@@ -1047,8 +1060,8 @@ wmem_block_gc(void *private_data)
 
         if (!chunk->jumbo && !chunk->used && chunk->last) {
             /* If the first chunk is also the last, and is unused, then
-             * the block as a whole is entirely unused, so return it to
-             * the OS and remove it from whatever lists it is in. */
+             * the block as a whole is entirely unused, so release it
+             * and remove it from whatever lists it is in. */
             free_chunk = WMEM_GET_FREE(chunk);
             if (free_chunk->next) {
                 WMEM_GET_FREE(free_chunk->next)->prev = free_chunk->prev;
@@ -1067,7 +1080,8 @@ wmem_block_gc(void *private_data)
             else if (allocator->master_head == chunk) {
                 allocator->master_head = free_chunk->next;
             }
-            wmem_free(NULL, cur);
+            wmem_stats_remove_block(allocator->stats, cur->size);
+            wmem_block_cache_put(cur, WMEM_BLOCK_SIZE);
         }
         else {
             /* part of this block is used, so add it to the new block list */
@@ -1082,7 +1096,7 @@ static void
 wmem_block_allocator_cleanup(void *private_data)
 {
     /* wmem guarantees that free_all() is called directly before this, so
-     * calling gc will return all our blocks to the OS automatically */
+     * calling gc will release all our blocks automatically */
     wmem_block_gc(private_data);
 
     /* then just free the allocator structs */
@@ -1109,6 +1123,7 @@ wmem_block_allocator_init(wmem_allocator_t *allocator)
     block_allocator->block_list    = NULL;
     block_allocator->master_head   = NULL;
     block_allocator->recycler_head = NULL;
+    block_allocator->stats         = &allocator->stats;
 }
 
 /*
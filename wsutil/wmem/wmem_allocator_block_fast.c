@@ -57,12 +57,16 @@ typedef struct {
 #define JUMBO_MAGIC 0xFFFFFFFF
 typedef struct _wmem_block_fast_jumbo {
     struct _wmem_block_fast_jumbo *prev, *next;
+
+    size_t size;
 } wmem_block_fast_jumbo_t;
 #define WMEM_JUMBO_HEADER_SIZE WMEM_ALIGN_SIZE(sizeof(wmem_block_fast_jumbo_t))
 
 typedef struct {
     wmem_block_fast_hdr_t   *block_list;
     wmem_block_fast_jumbo_t *jumbo_list;
+
+    wmem_allocator_stats_t  *stats;
 } wmem_block_fast_allocator_t;
 
 /* Creates a new block, and initializes it. */
@@ -72,12 +76,13 @@ wmem_block_fast_new_block(wmem_block_fast_allocator_t *allocator)
     wmem_block_fast_hdr_t *block;
 
     /* allocate/initialize the new block and add it to the block list */
-    block = (wmem_block_fast_hdr_t *)wmem_alloc(NULL, WMEM_BLOCK_SIZE);
+    block = (wmem_block_fast_hdr_t *)wmem_block_cache_get(WMEM_BLOCK_SIZE);
 
     block->pos  = WMEM_BLOCK_HEADER_SIZE;
     block->next = allocator->block_list;
 
     allocator->block_list = block;
+    wmem_stats_add_block(allocator->stats, WMEM_BLOCK_SIZE);
 }
 
 /* API */
@@ -95,6 +100,8 @@ wmem_block_fast_alloc(void *private_data, const size_t size)
         /* allocate/initialize a new block of the necessary size */
         block = (wmem_block_fast_jumbo_t *)wmem_alloc(NULL,
                 size + WMEM_JUMBO_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE);
+        block->size = size + WMEM_JUMBO_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE;
+        wmem_stats_add_block(allocator->stats, block->size);
 
         block->next = allocator->jumbo_list;
         if (block->next) {
@@ -141,16 +148,19 @@ wmem_block_fast_realloc(void *private_data, void *ptr, const size_t size)
     chunk = WMEM_DATA_TO_CHUNK(ptr);
 
     if (chunk->len == JUMBO_MAGIC) {
+        wmem_block_fast_allocator_t *allocator = (wmem_block_fast_allocator_t*) private_data;
         wmem_block_fast_jumbo_t *block;
 
         block = ((wmem_block_fast_jumbo_t*)((uint8_t*)(chunk) - WMEM_JUMBO_HEADER_SIZE));
+        wmem_stats_remove_block(allocator->stats, block->size);
         block =  (wmem_block_fast_jumbo_t*)wmem_realloc(NULL, block,
                 size + WMEM_JUMBO_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE);
+        block->size = size + WMEM_JUMBO_HEADER_SIZE + WMEM_CHUNK_HEADER_SIZE;
+        wmem_stats_add_block(allocator->stats, block->size);
         if (block->prev) {
             block->prev->next = block;
         }
         else {
-            wmem_block_fast_allocator_t *allocator = (wmem_block_fast_allocator_t*) private_data;
             allocator->jumbo_list = block;
         }
         if (block->next) {
@@ -193,7 +203,8 @@ wmem_block_fast_free_all(void *private_data)
 
     while (cur) {
         nxt  = cur->next;
-        wmem_free(NULL, cur);
+        wmem_stats_remove_block(allocator->stats, WMEM_BLOCK_SIZE);
+        wmem_block_cache_put(cur, WMEM_BLOCK_SIZE);
         cur = nxt;
     }
 
@@ -201,6 +212,7 @@ wmem_block_fast_free_all(void *private_data)
     cur_jum = allocator->jumbo_list;
     while (cur_jum) {
         nxt_jum  = cur_jum->next;
+        wmem_stats_remove_block(allocator->stats, cur_jum->size);
         wmem_free(NULL, cur_jum);
         cur_jum = nxt_jum;
     }
@@ -219,8 +231,8 @@ wmem_block_fast_allocator_cleanup(void *private_data)
     wmem_block_fast_allocator_t *allocator = (wmem_block_fast_allocator_t*) private_data;
 
     /* wmem guarantees that free_all() is called directly before this, so
-     * simply free the first block */
-    wmem_free(NULL, allocator->block_list);
+     * simply release the first block */
+    wmem_block_cache_put(allocator->block_list, WMEM_BLOCK_SIZE);
 
     /* then just free the allocator structs */
     wmem_free(NULL, private_data);
@@ -245,6 +257,7 @@ wmem_block_fast_allocator_init(wmem_allocator_t *allocator)
 
     block_allocator->block_list = NULL;
     block_allocator->jumbo_list = NULL;
+    block_allocator->stats      = &allocator->stats;
 }
 
 /*
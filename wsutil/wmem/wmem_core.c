@@ -28,6 +28,116 @@
 static bool do_override;
 static wmem_allocator_type_t override_type;
 
+/* The block allocators release their blocks into a cache owned by the
+ * releasing thread, which keeps at most this many bytes. The packet pool of a
+ * dissection thread is reset for every packet and the file scope is collected
+ * for every file, so this lets them get their blocks back without going
+ * through the system allocator, which for blocks this size usually means
+ * mapping and unmapping pages. */
+#define WMEM_BLOCK_CACHE_MAX_SIZE (32 * 1024 * 1024)
+
+typedef struct _wmem_cached_block_t {
+    struct _wmem_cached_block_t *next;
+    size_t size;
+} wmem_cached_block_t;
+
+typedef struct _wmem_block_cache_t {
+    wmem_cached_block_t *head;
+    size_t size;
+} wmem_block_cache_t;
+
+static void
+wmem_block_cache_destroy(void *data)
+{
+    wmem_block_cache_t  *cache = (wmem_block_cache_t *)data;
+    wmem_cached_block_t *cur, *next;
+
+    for (cur = cache->head; cur; cur = next) {
+        next = cur->next;
+        g_free(cur);
+    }
+    g_free(cache);
+}
+
+static GPrivate block_cache_private = G_PRIVATE_INIT(wmem_block_cache_destroy);
+
+void *
+wmem_block_cache_get(size_t size)
+{
+    wmem_block_cache_t  *cache = (wmem_block_cache_t *)g_private_get(&block_cache_private);
+    wmem_cached_block_t **prev, *cur;
+
+    if (cache) {
+        /* There are only a few blocks in the cache, and only a couple of
+         * distinct sizes */
+        for (prev = &cache->head; (cur = *prev) != NULL; prev = &cur->next) {
+            if (cur->size == size) {
+                *prev = cur->next;
+                cache->size -= size;
+                return cur;
+            }
+        }
+    }
+
+    return g_malloc(size);
+}
+
+void
+wmem_block_cache_put(void *block, size_t size)
+{
+    wmem_block_cache_t  *cache = (wmem_block_cache_t *)g_private_get(&block_cache_private);
+    wmem_cached_block_t *cached;
+
+    if (block == NULL) {
+        return;
+    }
+
+    if ((cache ? cache->size : 0) + size > WMEM_BLOCK_CACHE_MAX_SIZE) {
+        g_free(block);
+        return;
+    }
+
+    if (cache == NULL) {
+        cache = g_new0(wmem_block_cache_t, 1);
+        g_private_set(&block_cache_private, cache);
+    }
+
+    cached = (wmem_cached_block_t *)block;
+    cached->size = size;
+    cached->next = cache->head;
+    cache->head  = cached;
+    cache->size += size;
+}
+
+size_t
+wmem_block_cache_size(void)
+{
+    wmem_block_cache_t *cache = (wmem_block_cache_t *)g_private_get(&block_cache_private);
+
+    return cache ? cache->size : 0;
+}
+
+static inline void
+wmem_stats_count_alloc(wmem_allocator_stats_t *stats, const size_t size)
+{
+    unsigned bucket;
+
+    if (size > ((size_t)16 << (2 * (WMEM_ALLOC_HISTOGRAM_BUCKETS - 2)))) {
+        bucket = WMEM_ALLOC_HISTOGRAM_BUCKETS - 1;
+    }
+    else if (size <= 16) {
+        bucket = 0;
+    }
+    else {
+        /* 17-64 bytes need 5 or 6 bits, 65-256 bytes 7 or 8 bits, ... */
+        bucket = (g_bit_storage((unsigned long)(size - 1)) - 3) / 2;
+    }
+
+    stats->alloc_histogram[bucket]++;
+    stats->alloc_count++;
+    stats->bytes_allocated += size;
+}
+
 void *
 wmem_alloc(wmem_allocator_t *allocator, const size_t size)
 {
@@ -41,6 +151,8 @@ wmem_alloc(wmem_allocator_t *allocator, const size_t size)
         return NULL;
     }
 
+    wmem_stats_count_alloc(&allocator->stats, size);
+
     return allocator->walloc(allocator->private_data, size);
 }
 
@@ -102,6 +214,7 @@ wmem_free_all_real(wmem_allocator_t *allocator, bool final)
     wmem_call_callbacks(allocator,
             final ? WMEM_CB_DESTROY_EVENT : WMEM_CB_FREE_EVENT);
     allocator->free_all(allocator->private_data);
+    allocator->stats.bytes_allocated = 0;
 }
 
 void
@@ -142,6 +255,7 @@ wmem_allocator_new(const wmem_allocator_type_t type)
     allocator->type      = real_type;
     allocator->callbacks = NULL;
     allocator->in_scope  = true;
+    memset(&allocator->stats, 0, sizeof(allocator->stats));
 
     switch (real_type) {
         case WMEM_ALLOCATOR_SIMPLE:
@@ -204,6 +318,9 @@ wmem_init(void)
 void
 wmem_cleanup(void)
 {
+    /* Return the blocks cached by this thread to the system; those of other
+     * threads go when the threads exit. */
+    g_private_replace(&block_cache_private, NULL);
 }
 
 void
@@ -225,6 +342,22 @@ wmem_in_scope(wmem_allocator_t *allocator)
     return allocator->in_scope;
 }
 
+void
+wmem_allocator_get_stats(wmem_allocator_t *allocator, wmem_allocator_stats_t *stats)
+{
+    *stats = allocator->stats;
+}
+
+size_t
+wmem_alloc_histogram_bucket_max(unsigned bucket)
+{
+    if (bucket >= WMEM_ALLOC_HISTOGRAM_BUCKETS - 1) {
+        return 0;
+    }
+
+    return (size_t)16 << (2 * bucket);
+}
+
 
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
@@ -290,6 +290,64 @@ WS_DLL_PUBLIC
 bool
 wmem_in_scope(wmem_allocator_t *allocator);
 
+/** The number of buckets in wmem_allocator_stats_t.alloc_histogram. */
+#define WMEM_ALLOC_HISTOGRAM_BUCKETS 8
+
+/**
+ * @brief Usage counters of one allocator.
+ *
+ * bytes_in_use, bytes_peak and block_count describe the memory the allocator
+ * holds from the system, so they show which pool grows. Only the block
+ * allocators track them; the simple and strict allocators, which allocate
+ * every chunk from the system separately, leave them at zero.
+ */
+typedef struct _wmem_allocator_stats_t {
+    uint64_t bytes_in_use;   /**< Bytes of system memory currently held. */
+    uint64_t bytes_peak;     /**< Highest value bytes_in_use has reached. */
+    uint32_t block_count;    /**< Blocks (including jumbo blocks) currently held. */
+    uint64_t bytes_allocated; /**< Bytes requested since the last free_all. */
+    uint64_t alloc_count;    /**< Allocations since the allocator was created. */
+    /** Allocations by size since the allocator was created. Bucket i counts
+     * the allocations of at most 16 << (2 * i) bytes that didn't fit in the
+     * previous bucket, and the last bucket counts all larger ones. */
+    uint64_t alloc_histogram[WMEM_ALLOC_HISTOGRAM_BUCKETS];
+} wmem_allocator_stats_t;
+
+/**
+ * @brief Get the usage counters of an allocator.
+ *
+ * @param allocator The allocator to query.
+ * @param stats Filled in with the allocator's counters.
+ */
+WS_DLL_PUBLIC
+void
+wmem_allocator_get_stats(wmem_allocator_t *allocator, wmem_allocator_stats_t *stats);
+
+/**
+ * @brief Get the upper bound of an allocation histogram bucket.
+ *
+ * @param bucket The bucket index, less than WMEM_ALLOC_HISTOGRAM_BUCKETS.
+ * @return The largest allocation size counted in the bucket, or 0 for the
+ * last bucket, which has no upper bound.
+ */
+WS_DLL_PUBLIC
+size_t
+wmem_alloc_histogram_bucket_max(unsigned bucket);
+
+/**
+ * @brief Get the amount of memory in the calling thread's block cache.
+ *
+ * The block allocators don't return their blocks to the system when they are
+ * freed, collected or destroyed, but keep a limited number in a cache owned
+ * by the thread that released them, so that the next pool on that thread can
+ * reuse them without going through the system allocator.
+ *
+ * @return The number of bytes held by the cache.
+ */
+WS_DLL_PUBLIC
+size_t
+wmem_block_cache_size(void);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -10,6 +10,8 @@
  */
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 
 #ifdef HAVE_XXHASH
@@ -26,6 +28,7 @@
 #include "wsutil/bits_ctz.h"
 
 static uint32_t x; /* Used for universal integer hashing (see the HASH macro) */
+static uint64_t x64; /* Same for flat maps (see the FLAT_HASH macro) */
 
 /* Used for the wmem_strong_hash() function */
 static uint32_t preseed;
@@ -39,6 +42,8 @@ wmem_init_hashing(void)
     if ((x % 2) == 0)
         x += 1;
 
+    x64 = ((uint64_t)g_random_int() << 32) | g_random_int() | 1;
+
     preseed  = g_random_int();
     postseed = g_random_int();
 }
@@ -57,6 +62,13 @@ typedef struct _wmem_map_item_t {
     uint32_t hash;
 } wmem_map_item_t;
 
+/* A slot of a flat map. Whether it is in use is recorded in the control
+ * byte of the same index, so the slot itself is just the pair. */
+typedef struct _wmem_map_slot_t {
+    const void *key;
+    void *value;
+} wmem_map_slot_t;
+
 struct _wmem_map_t {
     /* Number of items stored. */
     size_t count;
@@ -85,6 +97,18 @@ struct _wmem_map_t {
      */
     wmem_stack_t *deleted_items;
 
+    /* Flat maps (see wmem_map_new_flat) use open addressing instead of
+     * the table and items above. Each slot has a control byte that is
+     * FLAT_CTRL_EMPTY, FLAT_CTRL_DELETED, or 7 bits of the hash of its
+     * key, and slots are probed a group of FLAT_GROUP_WIDTH at a time. */
+    bool flat;
+    uint8_t *ctrl;
+    wmem_map_slot_t *slots;
+
+    /* Number of empty slots that can be filled before the flat map is over
+     * its maximum load factor. Deleted slots are not counted as empty. */
+    size_t growth_left;
+
     GHashFunc  hash_func;
     GEqualFunc eql_func;
 
@@ -111,6 +135,61 @@ struct _wmem_map_t {
 
 #define MASK_HASH(MAP, HASH) ((uint32_t)((HASH) >> (32 - (MAP)->capacity)))
 
+/* Flat maps. The control bytes of a group are loaded into a uint64_t and
+ * compared all at once (SWAR), which works the same on every platform
+ * instead of needing SSE2 or NEON. Groups are aligned, so a group never
+ * wraps around the end of the table. */
+#define FLAT_GROUP_WIDTH  8
+#define FLAT_GROUP_SHIFT  3
+#define FLAT_CTRL_EMPTY   ((uint8_t)0x80)
+#define FLAT_CTRL_DELETED ((uint8_t)0xFE)
+#define FLAT_IS_FULL(CTRL) (((CTRL) & 0x80) == 0)
+#define FLAT_LSBS UINT64_C(0x0101010101010101)
+#define FLAT_MSBS UINT64_C(0x8080808080808080)
+
+/* Keep at least one slot in eight empty, so that every probe ends. */
+#define FLAT_MAX_LOAD(CAP) ((CAP) - (CAP) / 8)
+
+/* Multiplying into 64 bits leaves the high bits depending on every bit of
+ * the hash; the top ones pick the group and the 7 bits below the low half
+ * go in the control byte. */
+#define FLAT_HASH(MAP, KEY) ((uint64_t)(MAP)->hash_func(KEY) * x64)
+#define FLAT_H1(MAP, HASH) ((size_t)((HASH) >> (64 - (MAP)->capacity + FLAT_GROUP_SHIFT)))
+#define FLAT_H2(HASH) ((uint8_t)(((HASH) >> 32) & 0x7F))
+
+static inline uint64_t
+flat_group_load(const uint8_t *ctrl)
+{
+    uint64_t group;
+
+    memcpy(&group, ctrl, sizeof group);
+    return GUINT64_FROM_LE(group);
+}
+
+/* May have false positives next to a real match; check the control byte. */
+static inline uint64_t
+flat_group_match(uint64_t group, uint8_t h2)
+{
+    uint64_t cmp = group ^ (FLAT_LSBS * h2);
+
+    return (cmp - FLAT_LSBS) & ~cmp & FLAT_MSBS;
+}
+
+static inline uint64_t
+flat_group_match_empty(uint64_t group)
+{
+    return group & ~(group << 6) & FLAT_MSBS;
+}
+
+static inline uint64_t
+flat_group_match_empty_or_deleted(uint64_t group)
+{
+    return group & ~(group << 7) & FLAT_MSBS;
+}
+
+/* Index within the group of the lowest byte set in a match. */
+#define FLAT_MATCH_INDEX(MATCH) ((size_t)(ws_ctz(MATCH) >> 3))
+
 static void
 wmem_map_init_table(wmem_map_t *map)
 {
@@ -122,6 +201,121 @@ wmem_map_init_table(wmem_map_t *map)
     map->next_item = map->items;
 }
 
+static void
+wmem_map_flat_alloc_table(wmem_map_t *map)
+{
+    map->ctrl        = (uint8_t *)wmem_alloc(map->data_allocator, CAPACITY(map));
+    memset(map->ctrl, FLAT_CTRL_EMPTY, CAPACITY(map));
+    /* The slots are only read where the control byte is full. */
+    map->slots       = wmem_alloc_array(map->data_allocator, wmem_map_slot_t, CAPACITY(map));
+    map->growth_left = FLAT_MAX_LOAD(CAPACITY(map));
+}
+
+static void
+wmem_map_flat_init_table(wmem_map_t *map)
+{
+    map->count    = 0;
+    map->capacity = map->min_capacity;
+    wmem_map_flat_alloc_table(map);
+}
+
+static wmem_map_slot_t *
+wmem_map_flat_find(const wmem_map_t *map, const void *key, uint64_t hash)
+{
+    uint8_t h2 = FLAT_H2(hash);
+    size_t  group_mask = (CAPACITY(map) >> FLAT_GROUP_SHIFT) - 1;
+    size_t  group = FLAT_H1(map, hash);
+    size_t  probe;
+
+    /* Triangular probing visits every group of a power of two table. */
+    for (probe = 1; ; probe++) {
+        size_t base = group << FLAT_GROUP_SHIFT;
+        uint64_t ctrl = flat_group_load(&map->ctrl[base]);
+        uint64_t match;
+
+        for (match = flat_group_match(ctrl, h2); match; match &= match - 1) {
+            size_t i = base + FLAT_MATCH_INDEX(match);
+            if (map->ctrl[i] == h2 && map->eql_func(key, map->slots[i].key)) {
+                return &map->slots[i];
+            }
+        }
+        /* A key is never placed past a group that had room for it. */
+        if (flat_group_match_empty(ctrl)) {
+            return NULL;
+        }
+        group = (group + probe) & group_mask;
+    }
+}
+
+static size_t
+wmem_map_flat_find_free(const wmem_map_t *map, uint64_t hash)
+{
+    size_t  group_mask = (CAPACITY(map) >> FLAT_GROUP_SHIFT) - 1;
+    size_t  group = FLAT_H1(map, hash);
+    size_t  probe;
+
+    for (probe = 1; ; probe++) {
+        size_t base = group << FLAT_GROUP_SHIFT;
+        uint64_t match = flat_group_match_empty_or_deleted(flat_group_load(&map->ctrl[base]));
+
+        if (match) {
+            return base + FLAT_MATCH_INDEX(match);
+        }
+        group = (group + probe) & group_mask;
+    }
+}
+
+static void
+wmem_map_flat_resize(wmem_map_t *map, unsigned new_capacity)
+{
+    uint8_t         *old_ctrl;
+    wmem_map_slot_t *old_slots;
+    size_t           old_cap, i;
+
+    if (new_capacity > 32) {
+        ws_error("wmem_map does not support more than 2^32 items");
+        return;
+    }
+
+    old_ctrl  = map->ctrl;
+    old_slots = map->slots;
+    old_cap   = CAPACITY(map);
+
+    map->capacity = new_capacity;
+    wmem_map_flat_alloc_table(map);
+
+    /* Deleted slots are dropped, so this also serves to clean up a table
+     * with many removals without growing it. */
+    for (i = 0; i < old_cap; i++) {
+        if (FLAT_IS_FULL(old_ctrl[i])) {
+            uint64_t hash = FLAT_HASH(map, old_slots[i].key);
+            size_t   slot = wmem_map_flat_find_free(map, hash);
+            map->ctrl[slot]  = FLAT_H2(hash);
+            map->slots[slot] = old_slots[i];
+        }
+    }
+    map->growth_left -= map->count;
+
+    wmem_free(map->data_allocator, old_ctrl);
+    wmem_free(map->data_allocator, old_slots);
+}
+
+static void
+wmem_map_flat_erase(wmem_map_t *map, size_t slot)
+{
+    size_t base = slot & ~((size_t)FLAT_GROUP_WIDTH - 1);
+
+    /* If the group already has an empty slot, no probe goes past it, so
+     * this slot can be made empty too; otherwise leave a tombstone. */
+    if (flat_group_match_empty(flat_group_load(&map->ctrl[base]))) {
+        map->ctrl[slot] = FLAT_CTRL_EMPTY;
+        map->growth_left++;
+    } else {
+        map->ctrl[slot] = FLAT_CTRL_DELETED;
+    }
+    map->count--;
+}
+
 static bool
 wmem_map_destroy_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event _U_,
         void *user_data)
@@ -159,6 +353,23 @@ wmem_map_new(wmem_allocator_t *allocator,
     map->data_scope_cb_id = 0;
     map->metadata_scope_cb_id = 0;
 
+    map->flat = false;
+    map->ctrl = NULL;
+    map->slots = NULL;
+    map->growth_left = 0;
+
+    return map;
+}
+
+wmem_map_t *
+wmem_map_new_flat(wmem_allocator_t *allocator,
+        GHashFunc hash_func, GEqualFunc eql_func)
+{
+    wmem_map_t *map;
+
+    map = wmem_map_new(allocator, hash_func, eql_func);
+    map->flat = true;
+
     return map;
 }
 
@@ -172,6 +383,9 @@ wmem_map_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
     map->table = NULL;
     map->items = NULL;
     map->next_item = NULL;
+    map->ctrl = NULL;
+    map->slots = NULL;
+    map->growth_left = 0;
     while (wmem_stack_count(map->deleted_items))
         wmem_stack_pop(map->deleted_items);
 
@@ -203,12 +417,29 @@ wmem_map_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_
     map->next_item = NULL;
     map->deleted_items = wmem_stack_new(metadata_scope);
 
+    map->flat = false;
+    map->ctrl = NULL;
+    map->slots = NULL;
+    map->growth_left = 0;
+
     map->metadata_scope_cb_id = wmem_register_callback(metadata_scope, wmem_map_destroy_cb, map);
     map->data_scope_cb_id  = wmem_register_callback(data_scope, wmem_map_reset_cb, map);
 
     return map;
 }
 
+wmem_map_t *
+wmem_map_new_flat_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope,
+        GHashFunc hash_func, GEqualFunc eql_func)
+{
+    wmem_map_t *map;
+
+    map = wmem_map_new_autoreset(metadata_scope, data_scope, hash_func, eql_func);
+    map->flat = true;
+
+    return map;
+}
+
 static inline void
 wmem_map_grow(wmem_map_t *map, unsigned new_capacity)
 {
@@ -283,18 +514,70 @@ wmem_map_destroy(wmem_map_t *map, bool free_keys _U_, bool free_values _U_)
         wmem_unregister_callback(map->data_allocator, map->data_scope_cb_id);
     }
     wmem_free(map->data_allocator, map->table);
+    wmem_free(map->data_allocator, map->ctrl);
+    wmem_free(map->data_allocator, map->slots);
     // The arrays of items created before the last time the map grew the map
     // are orphaned and get freed when the data_allocator does.
     wmem_free(map->data_allocator, map->items);
     wmem_free(map->metadata_allocator, map);
 }
 
+static void *
+wmem_map_flat_insert(wmem_map_t *map, const void *key, void *value)
+{
+    wmem_map_slot_t *found;
+    uint64_t hash;
+    size_t slot;
+    void *old_val;
+
+    /* Make sure we have a table */
+    if (map->ctrl == NULL) {
+        wmem_map_flat_init_table(map);
+    }
+
+    hash = FLAT_HASH(map, key);
+    found = wmem_map_flat_find(map, key, hash);
+    if (found) {
+        /* replace and return old value for this key */
+        old_val = found->value;
+        found->value = value;
+        return old_val;
+    }
+
+    slot = wmem_map_flat_find_free(map, hash);
+    if (map->growth_left == 0 && map->ctrl[slot] == FLAT_CTRL_EMPTY) {
+        /* Full, counting tombstones. If most of that is tombstones,
+         * rehashing in place is enough. */
+        if (map->count < FLAT_MAX_LOAD(CAPACITY(map)) / 2) {
+            wmem_map_flat_resize(map, map->capacity);
+        } else {
+            wmem_map_flat_resize(map, map->capacity + 1);
+        }
+        slot = wmem_map_flat_find_free(map, hash);
+    }
+
+    if (map->ctrl[slot] == FLAT_CTRL_EMPTY) {
+        map->growth_left--;
+    }
+    map->ctrl[slot]        = FLAT_H2(hash);
+    map->slots[slot].key   = key;
+    map->slots[slot].value = value;
+    map->count++;
+
+    /* no previous entry, return NULL */
+    return NULL;
+}
+
 void *
 wmem_map_insert(wmem_map_t *map, const void *key, void *value)
 {
     wmem_map_item_t **item;
     void *old_val;
 
+    if (map->flat) {
+        return wmem_map_flat_insert(map, key, value);
+    }
+
     /* Make sure we have a table */
     if (map->table == NULL) {
         wmem_map_init_table(map);
@@ -344,6 +627,10 @@ wmem_map_contains(const wmem_map_t *map, const void *key)
 {
     wmem_map_item_t *item;
 
+    if (map != NULL && map->flat) {
+        return map->ctrl != NULL && wmem_map_flat_find(map, key, FLAT_HASH(map, key)) != NULL;
+    }
+
     /* Make sure we have map and a table */
     if (map == NULL || map->table == NULL) {
         return false;
@@ -369,6 +656,16 @@ wmem_map_lookup(const wmem_map_t *map, const void *key)
 {
     wmem_map_item_t *item;
 
+    if (map != NULL && map->flat) {
+        const wmem_map_slot_t *slot;
+
+        if (map->ctrl == NULL) {
+            return NULL;
+        }
+        slot = wmem_map_flat_find(map, key, FLAT_HASH(map, key));
+        return slot ? slot->value : NULL;
+    }
+
     /* Make sure we have map and a table */
     if (map == NULL || map->table == NULL) {
         return NULL;
@@ -394,6 +691,25 @@ wmem_map_lookup_extended(const wmem_map_t *map, const void *key, const void **or
 {
     wmem_map_item_t *item;
 
+    if (map != NULL && map->flat) {
+        const wmem_map_slot_t *slot;
+
+        if (map->ctrl == NULL) {
+            return false;
+        }
+        slot = wmem_map_flat_find(map, key, FLAT_HASH(map, key));
+        if (slot == NULL) {
+            return false;
+        }
+        if (orig_key) {
+            *orig_key = slot->key;
+        }
+        if (value) {
+            *value = slot->value;
+        }
+        return true;
+    }
+
     /* Make sure we have map and a table */
     if (map == NULL || map->table == NULL) {
         return false;
@@ -426,6 +742,21 @@ wmem_map_remove(wmem_map_t *map, const void *key)
     wmem_map_item_t **item, *tmp;
     void *value;
 
+    if (map != NULL && map->flat) {
+        wmem_map_slot_t *slot;
+
+        if (map->ctrl == NULL) {
+            return NULL;
+        }
+        slot = wmem_map_flat_find(map, key, FLAT_HASH(map, key));
+        if (slot == NULL) {
+            return NULL;
+        }
+        value = slot->value;
+        wmem_map_flat_erase(map, (size_t)(slot - map->slots));
+        return value;
+    }
+
     /* Make sure we have map and a table */
     if (map == NULL || map->table == NULL) {
         return NULL;
@@ -458,6 +789,20 @@ wmem_map_steal(wmem_map_t *map, const void *key)
 {
     wmem_map_item_t **item, *tmp;
 
+    if (map != NULL && map->flat) {
+        wmem_map_slot_t *slot;
+
+        if (map->ctrl == NULL) {
+            return false;
+        }
+        slot = wmem_map_flat_find(map, key, FLAT_HASH(map, key));
+        if (slot == NULL) {
+            return false;
+        }
+        wmem_map_flat_erase(map, (size_t)(slot - map->slots));
+        return true;
+    }
+
     /* Make sure we have map and a table */
     if (map == NULL || map->table == NULL) {
         return false;
@@ -491,6 +836,16 @@ wmem_map_get_keys(wmem_allocator_t *list_allocator, const wmem_map_t *map)
     wmem_map_item_t *cur;
     wmem_list_t* list = wmem_list_new(list_allocator);
 
+    if (map->ctrl != NULL) {
+        capacity = CAPACITY(map);
+
+        for (i=0; i<capacity; i++) {
+            if (FLAT_IS_FULL(map->ctrl[i])) {
+                wmem_list_prepend(list, (void*)map->slots[i].key);
+            }
+        }
+    }
+
     if (map->table != NULL) {
         capacity = CAPACITY(map);
 
@@ -514,6 +869,16 @@ wmem_map_get_keys_sorted(wmem_allocator_t *list_allocator, const wmem_map_t *map
     wmem_map_item_t *cur;
     wmem_list_t* list = wmem_list_new(list_allocator);
 
+    if (map->ctrl != NULL) {
+        capacity = CAPACITY(map);
+
+        for (i=0; i<capacity; i++) {
+            if (FLAT_IS_FULL(map->ctrl[i])) {
+                wmem_list_insert_sorted(list, (void*)map->slots[i].key, compare_func);
+            }
+        }
+    }
+
     if (map->table != NULL) {
         capacity = CAPACITY(map);
 
@@ -536,6 +901,15 @@ wmem_map_foreach(const wmem_map_t *map, GHFunc foreach_func, void * user_data)
     wmem_map_item_t *cur;
     unsigned i;
 
+    if (map != NULL && map->ctrl != NULL) {
+        for (i = 0; i < CAPACITY(map); i++) {
+            if (FLAT_IS_FULL(map->ctrl[i])) {
+                foreach_func((void *)map->slots[i].key, map->slots[i].value, user_data);
+            }
+        }
+        return;
+    }
+
     /* Make sure we have a table */
     if (map == NULL || map->table == NULL) {
         return;
@@ -556,6 +930,16 @@ wmem_map_find(const wmem_map_t *map, GHRFunc foreach_func, void * user_data)
     wmem_map_item_t **item;
     unsigned i;
 
+    if (map != NULL && map->ctrl != NULL) {
+        for (i = 0; i < CAPACITY(map); i++) {
+            if (FLAT_IS_FULL(map->ctrl[i]) &&
+                foreach_func((void *)map->slots[i].key, map->slots[i].value, user_data)) {
+                return map->slots[i].value;
+            }
+        }
+        return NULL;
+    }
+
     /* Make sure we have a table */
     if (map == NULL || map->table == NULL) {
         return 0;
@@ -580,6 +964,18 @@ wmem_map_foreach_remove(wmem_map_t *map, GHRFunc foreach_func, void * user_data)
     wmem_map_item_t **item, *tmp;
     unsigned i, deleted = 0;
 
+    if (map != NULL && map->ctrl != NULL) {
+        /* Removing doesn't move other items, so the scan can carry on. */
+        for (i = 0; i < CAPACITY(map); i++) {
+            if (FLAT_IS_FULL(map->ctrl[i]) &&
+                foreach_func((void *)map->slots[i].key, map->slots[i].value, user_data)) {
+                wmem_map_flat_erase(map, i);
+                deleted++;
+            }
+        }
+        return deleted;
+    }
+
     /* Make sure we have a table */
     if (map == NULL || map->table == NULL) {
         return 0;
@@ -614,11 +1010,20 @@ wmem_map_reserve(wmem_map_t *map, uint64_t capacity)
 {
     ws_return_val_if(!capacity, ((size_t)1) << map->min_capacity);
 
+    if (map->flat) {
+        /* Leave room for the empty slots a flat map needs. */
+        capacity += capacity / 7;
+    }
+
     map->min_capacity = (unsigned)ws_ilog2(capacity) + 1;
 
     map->min_capacity = MAX(map->min_capacity, WMEM_MAP_DEFAULT_CAPACITY);
 
-    if (map->table) {
+    if (map->ctrl) {
+        if (map->min_capacity > map->capacity) {
+            wmem_map_flat_resize(map, map->min_capacity);
+        }
+    } else if (map->table) {
         /* XXX - Should reserving after an item has been inserted be allowed?
          * Either we orphan some items in the old array or have to do a more
          * expensive copy operation.
@@ -95,6 +95,41 @@ wmem_map_t *
 wmem_map_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope,
         GHashFunc hash_func, GEqualFunc eql_func);
 
+/**
+ * @brief Creates a map that uses open addressing.
+ *
+ * Behaves the same as a map created with wmem_map_new(), and is used with
+ * the same functions, but stores its keys and values directly in an array
+ * of slots instead of in chained items. Each slot has a control byte
+ * holding part of the hash of its key, so a lookup usually touches one
+ * group of control bytes and one slot. Slots are reused after removal and
+ * old arrays are freed when the map grows.
+ *
+ * Prefer this for large maps with cheap hash functions, as the keys are
+ * hashed again when the map grows.
+ *
+ * @param allocator The allocator scope with which to create the map.
+ * @param hash_func The hash function used to place inserted keys.
+ * @param eql_func  The equality function used to compare inserted keys.
+ * @return The newly-allocated map.
+ */
+WS_DLL_PUBLIC
+wmem_map_t *
+wmem_map_new_flat(wmem_allocator_t *allocator,
+        GHashFunc hash_func, GEqualFunc eql_func);
+
+/**
+ * @brief Creates an open addressing map with two allocator scopes.
+ *
+ * The equivalent of wmem_map_new_autoreset() for wmem_map_new_flat().
+ *
+ * @warning This cannot be used with either allocator scope being NULL.
+ */
+WS_DLL_PUBLIC
+wmem_map_t *
+wmem_map_new_flat_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope,
+        GHashFunc hash_func, GEqualFunc eql_func);
+
 /**
  * @brief Inserts a value into the map.
  *
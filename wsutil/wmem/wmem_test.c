@@ -194,6 +194,95 @@ wmem_test_allocator_callbacks(void)
     g_assert_true(cb_called_count == 3);
 }
 
+static void
+wmem_test_allocator_stats(void)
+{
+    wmem_allocator_t       *allocator;
+    wmem_allocator_stats_t  stats;
+    size_t                  cached;
+    void                   *ptr;
+
+    g_assert_true(wmem_alloc_histogram_bucket_max(0) == 16);
+    g_assert_true(wmem_alloc_histogram_bucket_max(1) == 64);
+    g_assert_true(wmem_alloc_histogram_bucket_max(WMEM_ALLOC_HISTOGRAM_BUCKETS - 1) == 0);
+
+    /* start with an empty block cache */
+    wmem_cleanup();
+    g_assert_true(wmem_block_cache_size() == 0);
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+    wmem_allocator_get_stats(allocator, &stats);
+    g_assert_true(stats.bytes_in_use == 0);
+    g_assert_true(stats.block_count == 0);
+    g_assert_true(stats.alloc_count == 0);
+
+    ptr = wmem_alloc(allocator, 100);
+    g_assert_true(ptr != NULL);
+    ptr = wmem_alloc(allocator, 16);
+    g_assert_true(ptr != NULL);
+    wmem_allocator_get_stats(allocator, &stats);
+    g_assert_true(stats.block_count == 1);
+    g_assert_true(stats.bytes_in_use > 0);
+    g_assert_true(stats.bytes_peak == stats.bytes_in_use);
+    g_assert_true(stats.bytes_allocated == 116);
+    g_assert_true(stats.alloc_count == 2);
+    g_assert_true(stats.alloc_histogram[0] == 1);
+    g_assert_true(stats.alloc_histogram[2] == 1);
+
+    /* a jumbo allocation gets a block of its own */
+    ptr = wmem_alloc(allocator, 10 * 1024 * 1024);
+    g_assert_true(ptr != NULL);
+    wmem_allocator_get_stats(allocator, &stats);
+    g_assert_true(stats.block_count == 2);
+    g_assert_true(stats.bytes_in_use > 10 * 1024 * 1024);
+    g_assert_true(stats.alloc_histogram[WMEM_ALLOC_HISTOGRAM_BUCKETS - 1] == 1);
+
+    wmem_free_all(allocator);
+    wmem_allocator_get_stats(allocator, &stats);
+    g_assert_true(stats.block_count == 1);
+    g_assert_true(stats.bytes_in_use < 10 * 1024 * 1024);
+    g_assert_true(stats.bytes_peak > 10 * 1024 * 1024);
+    g_assert_true(stats.bytes_allocated == 0);
+    g_assert_true(stats.alloc_count == 3);
+
+    /* the remaining block goes to the cache, and the next allocator on this
+     * thread gets it back */
+    wmem_destroy_allocator(allocator);
+    cached = wmem_block_cache_size();
+    g_assert_true(cached > 0);
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+    ptr = wmem_alloc(allocator, 100);
+    g_assert_true(ptr != NULL);
+    g_assert_true(wmem_block_cache_size() == 0);
+    wmem_destroy_allocator(allocator);
+
+    /* blocks emptied by the block allocator's gc go to the cache too */
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+    ptr = wmem_alloc(allocator, 100);
+    g_assert_true(ptr != NULL);
+    wmem_free_all(allocator);
+    wmem_gc(allocator);
+    wmem_allocator_get_stats(allocator, &stats);
+    g_assert_true(stats.block_count == 0);
+    g_assert_true(stats.bytes_in_use == 0);
+    g_assert_true(wmem_block_cache_size() > cached);
+    wmem_destroy_allocator(allocator);
+
+    /* allocators without blocks only count allocations */
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+    ptr = wmem_alloc(allocator, 1000);
+    wmem_free(allocator, ptr);
+    wmem_allocator_get_stats(allocator, &stats);
+    g_assert_true(stats.bytes_in_use == 0);
+    g_assert_true(stats.alloc_count == 1);
+    g_assert_true(stats.alloc_histogram[3] == 1);
+    wmem_destroy_allocator(allocator);
+
+    wmem_cleanup();
+    g_assert_true(wmem_block_cache_size() == 0);
+}
+
 static void
 wmem_test_allocator_det(wmem_allocator_t *allocator, wmem_verify_func verify,
         unsigned len)
@@ -903,14 +992,19 @@ equal_val_map(void * key _U_, void * val, void * user_data)
     return val == user_data;
 }
 
+typedef wmem_map_t *(*wmem_test_map_new_func)(wmem_allocator_t *allocator,
+        GHashFunc hash_func, GEqualFunc eql_func);
+typedef wmem_map_t *(*wmem_test_map_new_autoreset_func)(wmem_allocator_t *metadata_scope,
+        wmem_allocator_t *data_scope, GHashFunc hash_func, GEqualFunc eql_func);
+
 static void
-wmem_test_map(void)
+wmem_test_map_impl(wmem_test_map_new_func map_new, wmem_test_map_new_autoreset_func map_new_autoreset)
 {
     wmem_allocator_t   *allocator, *extra_allocator;
     wmem_map_t       *map;
     char             *str_key;
     const void       *str_key_ret;
-    unsigned int      i;
+    unsigned int      i, j;
     unsigned int     *key_ret;
     unsigned int     *value_ret;
     void             *ret;
@@ -919,7 +1013,7 @@ wmem_test_map(void)
     extra_allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
 
     /* insertion, lookup and removal of simple integer keys */
-    map = wmem_map_new(allocator, g_direct_hash, g_direct_equal);
+    map = map_new(allocator, g_direct_hash, g_direct_equal);
     g_assert_true(map);
 
     for (i=0; i<CONTAINER_ITERS; i++) {
@@ -957,7 +1051,7 @@ wmem_test_map(void)
     wmem_free_all(allocator);
 
     /* test auto-reset functionality */
-    map = wmem_map_new_autoreset(allocator, extra_allocator, g_direct_hash, g_direct_equal);
+    map = map_new_autoreset(allocator, extra_allocator, g_direct_hash, g_direct_equal);
     g_assert_true(map);
     for (i=0; i<CONTAINER_ITERS; i++) {
         ret = wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(777777));
@@ -973,7 +1067,7 @@ wmem_test_map(void)
     }
     wmem_free_all(allocator);
 
-    map = wmem_map_new(allocator, wmem_str_hash, g_str_equal);
+    map = map_new(allocator, wmem_str_hash, g_str_equal);
     g_assert_true(map);
 
     /* string keys and for-each */
@@ -991,7 +1085,7 @@ wmem_test_map(void)
     }
 
     /* test foreach */
-    map = wmem_map_new(allocator, wmem_str_hash, g_str_equal);
+    map = map_new(allocator, wmem_str_hash, g_str_equal);
     g_assert_true(map);
     for (i=0; i<CONTAINER_ITERS; i++) {
         str_key = wmem_test_rand_string(allocator, 1, 64);
@@ -1003,7 +1097,7 @@ wmem_test_map(void)
     g_assert_true(wmem_map_size(map) == 0);
 
     /* test size */
-    map = wmem_map_new(allocator, g_direct_hash, g_direct_equal);
+    map = map_new(allocator, g_direct_hash, g_direct_equal);
     g_assert_true(map);
     for (i=0; i<CONTAINER_ITERS; i++) {
         wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
@@ -1015,10 +1109,124 @@ wmem_test_map(void)
     }
     g_assert_true(wmem_map_size(map) == CONTAINER_ITERS/2);
 
+    /* repeated removal and reinsertion, which leaves deleted slots behind */
+    for (j=0; j<10; j++) {
+        for (i=1; i<CONTAINER_ITERS; i+=2) {
+            g_assert_true(wmem_map_remove(map, GINT_TO_POINTER(i)) == GINT_TO_POINTER(i));
+            g_assert_true(wmem_map_contains(map, GINT_TO_POINTER(i)) == false);
+            g_assert_true(wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i)) == NULL);
+        }
+    }
+    g_assert_true(wmem_map_size(map) == CONTAINER_ITERS/2);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_map_contains(map, GINT_TO_POINTER(i)) == (i % 2 == 1));
+    }
+
+    /* reserving capacity */
+    map = map_new(allocator, g_direct_hash, g_direct_equal);
+    g_assert_true(wmem_map_reserve(map, CONTAINER_ITERS) >= CONTAINER_ITERS);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        wmem_map_insert(map, GINT_TO_POINTER(i), GINT_TO_POINTER(i));
+    }
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_map_lookup(map, GINT_TO_POINTER(i)) == GINT_TO_POINTER(i));
+    }
+
     wmem_destroy_allocator(extra_allocator);
     wmem_destroy_allocator(allocator);
 }
 
+static void
+wmem_test_map(void)
+{
+    wmem_test_map_impl(wmem_map_new, wmem_map_new_autoreset);
+}
+
+static void
+wmem_test_map_flat(void)
+{
+    wmem_test_map_impl(wmem_map_new_flat, wmem_map_new_flat_autoreset);
+}
+
+/* NOTE: You have to run "wmem_test -m perf" to run the performance tests. */
+static void
+wmem_test_mapperf_impl(const char *name, wmem_test_map_new_func map_new)
+{
+#define MAPPERF_MAX_ITEMS (10 * 1000 * 1000)
+    wmem_allocator_t   *allocator;
+    wmem_map_t         *map;
+    unsigned           *order;
+    unsigned            num_items, i, j, tmp;
+    double              start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+    order = g_new(unsigned, MAPPERF_MAX_ITEMS);
+
+    /* The keys are scattered, as pointers and addresses are, and looked up
+     * in a random order so the items aren't read in the order they were
+     * inserted. */
+#define MAPPERF_KEY(i) GUINT_TO_POINTER(((i) + 1) * 2654435761U)
+
+    for (num_items = 1000; num_items <= MAPPERF_MAX_ITEMS; num_items *= 10) {
+        for (i = 0; i < num_items; i++) {
+            order[i] = i;
+        }
+        for (i = num_items - 1; i > 0; i--) {
+            j = g_random_int_range(0, i + 1);
+            tmp = order[i];
+            order[i] = order[j];
+            order[j] = tmp;
+        }
+
+        map = map_new(allocator, g_direct_hash, g_direct_equal);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < num_items; i++) {
+            wmem_map_insert(map, MAPPERF_KEY(i), GUINT_TO_POINTER(i));
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s insert %u: u %.3f ms s %.3f ms", name, num_items, utime_ms, stime_ms);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < num_items; i++) {
+            g_assert_true(wmem_map_lookup(map, MAPPERF_KEY(order[i])) == GUINT_TO_POINTER(order[i]));
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s lookup %u: u %.3f ms s %.3f ms", name, num_items, utime_ms, stime_ms);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < num_items; i++) {
+            g_assert_true(wmem_map_lookup(map, MAPPERF_KEY(num_items + order[i])) == NULL);
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s lookup missing %u: u %.3f ms s %.3f ms", name, num_items, utime_ms, stime_ms);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < num_items; i++) {
+            wmem_map_remove(map, MAPPERF_KEY(order[i]));
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s remove %u: u %.3f ms s %.3f ms", name, num_items, utime_ms, stime_ms);
+        g_assert_true(wmem_map_size(map) == 0);
+
+        wmem_free_all(allocator);
+    }
+
+    g_free(order);
+    wmem_destroy_allocator(allocator);
+}
+
+static void
+wmem_test_mapperf(void)
+{
+    wmem_test_mapperf_impl("wmem_map_new", wmem_map_new);
+    wmem_test_mapperf_impl("wmem_map_new_flat", wmem_map_new_flat);
+}
+
 static void
 wmem_test_queue(void)
 {
@@ -1354,6 +1562,181 @@ wmem_test_tree(void)
 }
 
 
+static bool
+wmem_test_tree_order_cb(const void *key, void *value _U_, void *user_data)
+{
+    uint32_t *last_key = (uint32_t *)user_data;
+
+    g_assert_true(GPOINTER_TO_UINT(key) > *last_key || (*last_key == 0 && GPOINTER_TO_UINT(key) == 0));
+    *last_key = GPOINTER_TO_UINT(key);
+    return false;
+}
+
+static void
+wmem_test_tree_btree(void)
+{
+    wmem_allocator_t   *allocator, *extra_allocator;
+    wmem_tree_t        *tree;
+    uint32_t            i, j, found_key, last_key;
+    uint32_t            rand_int;
+    bool               *present;
+    wmem_tree_key_t     keys[2];
+
+    allocator       = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+    extra_allocator = wmem_allocator_new(WMEM_ALLOCATOR_STRICT);
+
+    /* 32-bit keys in increasing order, as frame numbers are */
+    tree = wmem_tree_new_btree(allocator);
+    g_assert_true(wmem_tree_is_empty(tree));
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_tree_lookup32(tree, i*2) == NULL);
+        if (i > 0) {
+            g_assert_true(wmem_tree_lookup32_le_full(tree, i*2, &found_key) == GINT_TO_POINTER(i-1));
+            g_assert_true(found_key == (i-1)*2);
+        }
+        wmem_tree_insert32(tree, i*2, GINT_TO_POINTER(i));
+        g_assert_true(wmem_tree_lookup32(tree, i*2) == GINT_TO_POINTER(i));
+        g_assert_true(wmem_tree_contains32(tree, i*2));
+        g_assert_true(!wmem_tree_is_empty(tree));
+    }
+    g_assert_true(wmem_tree_count(tree) == CONTAINER_ITERS);
+    for (i=1; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_tree_lookup32_le(tree, i*2-1) == GINT_TO_POINTER(i-1));
+        g_assert_true(wmem_tree_lookup32_ge_full(tree, i*2-1, &found_key) == GINT_TO_POINTER(i));
+        g_assert_true(found_key == i*2);
+    }
+    g_assert_true(wmem_tree_lookup32_ge(tree, CONTAINER_ITERS*2) == NULL);
+    last_key = 0;
+    wmem_tree_foreach(tree, wmem_test_tree_order_cb, &last_key);
+    g_assert_true(last_key == (CONTAINER_ITERS-1)*2);
+    wmem_free_all(allocator);
+
+    /* random insertion and removal, checked against a bitmap */
+    tree = wmem_tree_new_btree(allocator);
+    present = wmem_alloc0_array(allocator, bool, CONTAINER_ITERS);
+    for (i=0; i<CONTAINER_ITERS*10; i++) {
+        rand_int = ((uint32_t)g_test_rand_int()) % CONTAINER_ITERS;
+        if (g_test_rand_int() % 3) {
+            wmem_tree_insert32(tree, rand_int, GINT_TO_POINTER(rand_int + 1));
+            present[rand_int] = true;
+        } else {
+            g_assert_true(wmem_tree_remove32(tree, rand_int) ==
+                    (present[rand_int] ? GINT_TO_POINTER(rand_int + 1) : NULL));
+            present[rand_int] = false;
+        }
+    }
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_tree_lookup32(tree, i) == (present[i] ? GINT_TO_POINTER(i + 1) : NULL));
+        for (j=i+1; j>0 && !present[j-1]; j--);
+        g_assert_true(wmem_tree_lookup32_le(tree, i) == (j > 0 ? GINT_TO_POINTER(j) : NULL));
+        for (j=i; j<CONTAINER_ITERS && !present[j]; j++);
+        g_assert_true(wmem_tree_lookup32_ge(tree, i) == (j < CONTAINER_ITERS ? GINT_TO_POINTER(j + 1) : NULL));
+    }
+    last_key = 0;
+    wmem_tree_foreach(tree, wmem_test_tree_order_cb, &last_key);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        wmem_tree_remove32(tree, i);
+    }
+    g_assert_true(wmem_tree_is_empty(tree));
+    wmem_free_all(allocator);
+
+    /* test auto-reset functionality */
+    tree = wmem_tree_new_btree_autoreset(allocator, extra_allocator);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        wmem_tree_insert32(tree, i, GINT_TO_POINTER(i));
+    }
+    g_assert_true(wmem_tree_count(tree) == CONTAINER_ITERS);
+    wmem_free_all(extra_allocator);
+    g_assert_true(wmem_tree_count(tree) == 0);
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        g_assert_true(wmem_tree_lookup32(tree, i) == NULL);
+        g_assert_true(wmem_tree_lookup32_le(tree, i) == NULL);
+    }
+    wmem_free_all(allocator);
+
+    /* test array key functionality, which uses a subtree per first key */
+    tree = wmem_tree_new_btree(allocator);
+    keys[0].length = 2;
+    keys[0].key    = wmem_alloc_array(allocator, uint32_t, 2);
+    keys[1].length = 0;
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        keys[0].key[0] = i % 16;
+        keys[0].key[1] = (i / 16) * 4;
+        wmem_tree_insert32_array(tree, keys, GINT_TO_POINTER(i));
+    }
+    for (i=0; i<CONTAINER_ITERS; i++) {
+        keys[0].key[0] = i % 16;
+        keys[0].key[1] = (i / 16) * 4;
+        g_assert_true(wmem_tree_lookup32_array(tree, keys) == GINT_TO_POINTER(i));
+        keys[0].key[1] += 3;
+        g_assert_true(wmem_tree_lookup32_array_le(tree, keys) == GINT_TO_POINTER(i));
+    }
+    g_assert_true(wmem_tree_count(tree) == CONTAINER_ITERS);
+    wmem_free_all(allocator);
+
+    wmem_destroy_allocator(extra_allocator);
+    wmem_destroy_allocator(allocator);
+}
+
+/* NOTE: You have to run "wmem_test -m perf" to run the performance tests. */
+static void
+wmem_test_treeperf_impl(const char *name, wmem_tree_t *(*tree_new)(wmem_allocator_t *allocator))
+{
+#define TREEPERF_MAX_ITEMS (10 * 1000 * 1000)
+    wmem_allocator_t   *allocator;
+    wmem_tree_t        *tree;
+    uint32_t            num_items, i;
+    double              start_utime, start_stime, end_utime, end_stime, utime_ms, stime_ms;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK);
+
+    /* Keys are inserted in increasing order, like frame numbers, with gaps
+     * so that wmem_tree_lookup32_le has to find the previous key. The
+     * lookups are in a scattered order. */
+#define TREEPERF_QUERY(i, n) ((uint32_t)(((uint64_t)(i) * 2654435761U) % ((uint64_t)(n) * 4)))
+
+    for (num_items = 1000; num_items <= TREEPERF_MAX_ITEMS; num_items *= 10) {
+        tree = tree_new(allocator);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < num_items; i++) {
+            wmem_tree_insert32(tree, i * 4, GUINT_TO_POINTER(i + 1));
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s insert32 %u: u %.3f ms s %.3f ms", name, num_items, utime_ms, stime_ms);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < num_items; i++) {
+            g_assert_true(wmem_tree_lookup32_le(tree, TREEPERF_QUERY(i, num_items)) ==
+                    GUINT_TO_POINTER(TREEPERF_QUERY(i, num_items) / 4 + 1));
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s lookup32_le %u: u %.3f ms s %.3f ms", name, num_items, utime_ms, stime_ms);
+
+        RESOURCE_USAGE_START;
+        for (i = 0; i < num_items; i++) {
+            wmem_tree_remove32(tree, i * 4);
+        }
+        RESOURCE_USAGE_END;
+        g_test_minimized_result(utime_ms + stime_ms,
+            "%s remove32 %u: u %.3f ms s %.3f ms", name, num_items, utime_ms, stime_ms);
+        g_assert_true(wmem_tree_is_empty(tree));
+
+        wmem_free_all(allocator);
+    }
+
+    wmem_destroy_allocator(allocator);
+}
+
+static void
+wmem_test_treeperf(void)
+{
+    wmem_test_treeperf_impl("wmem_tree_new", wmem_tree_new);
+    wmem_test_treeperf_impl("wmem_tree_new_btree", wmem_tree_new_btree);
+}
+
 /* to be used as userdata in the callback wmem_test_itree_check_overlap_cb*/
 typedef struct wmem_test_itree_user_data {
     wmem_range_t range;
@@ -1470,22 +1853,27 @@ main(int argc, char **argv)
     g_test_add_func("/wmem/allocator/simple",    wmem_test_allocator_simple);
     g_test_add_func("/wmem/allocator/strict",    wmem_test_allocator_strict);
     g_test_add_func("/wmem/allocator/callbacks", wmem_test_allocator_callbacks);
+    g_test_add_func("/wmem/allocator/stats",     wmem_test_allocator_stats);
 
     g_test_add_func("/wmem/utils/misc",    wmem_test_miscutls);
     g_test_add_func("/wmem/utils/strings", wmem_test_strutls);
 
     if (g_test_perf()) {
         g_test_add_func("/wmem/utils/stringperf", wmem_test_stringperf);
+        g_test_add_func("/wmem/datastruct/mapperf", wmem_test_mapperf);
+        g_test_add_func("/wmem/datastruct/treeperf", wmem_test_treeperf);
     }
 
     g_test_add_func("/wmem/datastruct/array",  wmem_test_array);
     g_test_add_func("/wmem/datastruct/list",   wmem_test_list);
     g_test_add_func("/wmem/datastruct/map",    wmem_test_map);
+    g_test_add_func("/wmem/datastruct/map/flat", wmem_test_map_flat);
     g_test_add_func("/wmem/datastruct/queue",  wmem_test_queue);
     g_test_add_func("/wmem/datastruct/stack",  wmem_test_stack);
     g_test_add_func("/wmem/datastruct/strbuf", wmem_test_strbuf);
     g_test_add_func("/wmem/datastruct/strbuf/validate", wmem_test_strbuf_validate);
     g_test_add_func("/wmem/datastruct/tree",   wmem_test_tree);
+    g_test_add_func("/wmem/datastruct/tree/btree", wmem_test_tree_btree);
     g_test_add_func("/wmem/datastruct/itree",  wmem_test_itree);
 
     ret = g_test_run();
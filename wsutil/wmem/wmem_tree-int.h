@@ -70,6 +70,12 @@ typedef struct _wmem_tree_node_t wmem_tree_node_t;
 typedef struct _wmem_itree_node_t wmem_itree_node_t;
 
 
+/**
+ * @typedef wmem_btree_node_t
+ * @brief Opaque type representing a node of a tree created with wmem_tree_new_btree().
+ */
+typedef struct _wmem_btree_node_t wmem_btree_node_t;
+
 /**
  * @brief Internal representation of a wmem balanced tree.
  *
@@ -87,6 +93,9 @@ struct _wmem_tree_t {
     unsigned data_scope_cb_id;            /**< Callback ID for data scope lifecycle management. */
 
     void (*post_rotation_cb)(wmem_tree_node_t *); /**< Optional callback invoked after tree rotations. */
+
+    bool is_btree;                        /**< True if the tree is a B+ tree of 32 bit keys instead of a red-black tree. */
+    wmem_btree_node_t *btree_root;        /**< Root node of the B+ tree, if is_btree. */
 };
 
 /**
@@ -143,6 +152,102 @@ typedef struct _wmem_range_t wmem_range_t;
 bool
 wmem_itree_range_overlap(const wmem_range_t *r1, const wmem_range_t *r2);
 
+/**
+ * @brief Look up a key in a B+ tree, inserting it if it is not there.
+ *
+ * The B+ tree equivalent of the red-black tree's lookup_or_insert32.
+ *
+ * @param tree The tree, which must have been created as a B+ tree.
+ * @param key The key to look up or insert.
+ * @param func If not NULL, called with data to create the value to insert.
+ * @param data The value to insert, or the argument to func.
+ * @param is_subtree True if the value is a wmem_tree_t of the next level of an array key.
+ * @param replace True to replace the value of an existing key.
+ * @return The value stored for the key.
+ */
+void *
+wmem_btree_lookup_or_insert32(wmem_tree_t *tree, uint32_t key,
+        void*(*func)(void*), void *data, bool is_subtree, bool replace);
+
+/**
+ * @brief Look up a key in a B+ tree.
+ *
+ * @param tree The tree.
+ * @param key The key to look up.
+ * @param[out] data If not NULL, set to the value of the key if found.
+ * @return true if the key was found.
+ */
+bool
+wmem_btree_lookup32(const wmem_tree_t *tree, uint32_t key, void **data);
+
+/**
+ * @brief Look up the greatest key less than or equal to key in a B+ tree.
+ *
+ * @param tree The tree.
+ * @param key The key to look up.
+ * @param[out] orig_key If not NULL, set to the key found.
+ * @param[out] data If not NULL, set to the value of the key found.
+ * @return true if a key was found.
+ */
+bool
+wmem_btree_lookup32_le(const wmem_tree_t *tree, uint32_t key, uint32_t *orig_key, void **data);
+
+/**
+ * @brief Look up the least key greater than or equal to key in a B+ tree.
+ *
+ * @param tree The tree.
+ * @param key The key to look up.
+ * @param[out] orig_key If not NULL, set to the key found.
+ * @param[out] data If not NULL, set to the value of the key found.
+ * @return true if a key was found.
+ */
+bool
+wmem_btree_lookup32_ge(const wmem_tree_t *tree, uint32_t key, uint32_t *orig_key, void **data);
+
+/**
+ * @brief Remove a key from a B+ tree.
+ *
+ * @param tree The tree.
+ * @param key The key to remove.
+ * @return The value of the removed key, or NULL if it was not found.
+ */
+void *
+wmem_btree_remove32(wmem_tree_t *tree, uint32_t key);
+
+/**
+ * @brief Call a function for each value of a B+ tree, in key order.
+ *
+ * Subtrees are traversed the same way as by wmem_tree_foreach().
+ *
+ * @return true if the callback stopped the traversal.
+ */
+bool
+wmem_btree_foreach(const wmem_tree_t *tree, wmem_foreach_func callback, void *user_data);
+
+/**
+ * @brief Free all the nodes of a B+ tree, leaving it empty.
+ *
+ * @param tree The tree.
+ * @param free_keys Passed on to the subtrees.
+ * @param free_values Whether to free the values as well.
+ */
+void
+wmem_btree_free(wmem_tree_t *tree, bool free_keys, bool free_values);
+
+/**
+ * @brief Print the nodes of a B+ tree, for wmem_print_tree().
+ */
+void
+wmem_btree_print(const wmem_tree_t *tree, uint32_t level,
+        wmem_printer_func key_printer, wmem_printer_func data_printer);
+
+/**
+ * @brief Print a tree of any kind, indented to the given level.
+ */
+void
+wmem_print_subtree(const wmem_tree_t *tree, uint32_t level,
+        wmem_printer_func key_printer, wmem_printer_func data_printer);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
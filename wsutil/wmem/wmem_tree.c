@@ -368,6 +368,17 @@ wmem_tree_new(wmem_allocator_t *allocator)
     return tree;
 }
 
+wmem_tree_t *
+wmem_tree_new_btree(wmem_allocator_t *allocator)
+{
+    wmem_tree_t *tree;
+
+    tree = wmem_tree_new(allocator);
+    tree->is_btree = true;
+
+    return tree;
+}
+
 static bool
 wmem_tree_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
         void *user_data)
@@ -375,6 +386,7 @@ wmem_tree_reset_cb(wmem_allocator_t *allocator _U_, wmem_cb_event_t event,
     wmem_tree_t *tree = (wmem_tree_t *)user_data;
 
     tree->root = NULL;
+    tree->btree_root = NULL;
 
     if (event == WMEM_CB_DESTROY_EVENT) {
         wmem_unregister_callback(tree->metadata_allocator, tree->metadata_scope_cb_id);
@@ -412,6 +424,17 @@ wmem_tree_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data
     return tree;
 }
 
+wmem_tree_t *
+wmem_tree_new_btree_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope)
+{
+    wmem_tree_t *tree;
+
+    tree = wmem_tree_new_autoreset(metadata_scope, data_scope);
+    tree->is_btree = true;
+
+    return tree;
+}
+
 static void
 free_tree_node(wmem_allocator_t *allocator, wmem_tree_node_t* node, bool free_keys, bool free_values)
 {
@@ -446,6 +469,7 @@ void
 wmem_tree_destroy(wmem_tree_t *tree, bool free_keys, bool free_values)
 {
     free_tree_node(tree->data_allocator, tree->root, free_keys, free_values);
+    wmem_btree_free(tree, free_keys, free_values);
     if (tree->metadata_allocator) {
         wmem_unregister_callback(tree->metadata_allocator, tree->metadata_scope_cb_id);
     }
@@ -458,7 +482,7 @@ wmem_tree_destroy(wmem_tree_t *tree, bool free_keys, bool free_values)
 bool
 wmem_tree_is_empty(const wmem_tree_t *tree)
 {
-    return tree->root == NULL;
+    return tree->root == NULL && tree->btree_root == NULL;
 }
 
 static bool
@@ -573,6 +597,10 @@ static void *
 lookup_or_insert32(wmem_tree_t *tree, uint32_t key,
         void*(*func)(void*), void* data, bool is_subtree, bool replace)
 {
+    if (tree->is_btree) {
+        return wmem_btree_lookup_or_insert32(tree, key, func, data, is_subtree, replace);
+    }
+
     wmem_tree_node_t *node = lookup_or_insert32_node(tree, key, func, data, is_subtree, replace);
     return node->data;
 }
@@ -610,6 +638,9 @@ wmem_tree_insert_node(wmem_tree_t *tree, const void *key, void *data, compare_fu
     wmem_tree_node_t *node = tree->root;
     wmem_tree_node_t *new_node = NULL;
 
+    /* A B+ tree only has 32 bit keys. */
+    ws_assert(!tree->is_btree);
+
     /* is this the first node ?*/
     if (!node) {
         tree->root = create_node(tree->data_allocator, node, key,
@@ -668,6 +699,10 @@ bool wmem_tree_contains32(const wmem_tree_t *tree, uint32_t key)
         return false;
     }
 
+    if (tree->is_btree) {
+        return wmem_btree_lookup32(tree, key, NULL);
+    }
+
     wmem_tree_node_t *node = tree->root;
 
     while (node) {
@@ -712,6 +747,12 @@ wmem_tree_lookup32_node(const wmem_tree_t *tree, uint32_t key)
 void *
 wmem_tree_lookup32(const wmem_tree_t *tree, uint32_t key)
 {
+    if (tree && tree->is_btree) {
+        void *data = NULL;
+        wmem_btree_lookup32(tree, key, &data);
+        return data;
+    }
+
     wmem_tree_node_t *node = wmem_tree_lookup32_node(tree, key);
     if (node == NULL) {
         return NULL;
@@ -788,6 +829,12 @@ wmem_tree_lookup32_le_node(const wmem_tree_t *tree, uint32_t key)
 void *
 wmem_tree_lookup32_le(const wmem_tree_t *tree, uint32_t key)
 {
+    if (tree && tree->is_btree) {
+        void *data = NULL;
+        wmem_btree_lookup32_le(tree, key, NULL, &data);
+        return data;
+    }
+
     wmem_tree_node_t *node = wmem_tree_lookup32_le_node(tree, key);
     if (node == NULL) {
         return NULL;
@@ -799,6 +846,12 @@ wmem_tree_lookup32_le(const wmem_tree_t *tree, uint32_t key)
 void *
 wmem_tree_lookup32_le_full(const wmem_tree_t *tree, uint32_t key, uint32_t *orig_key)
 {
+    if (tree && tree->is_btree) {
+        void *data = NULL;
+        wmem_btree_lookup32_le(tree, key, orig_key, &data);
+        return data;
+    }
+
     wmem_tree_node_t *node = wmem_tree_lookup32_le_node(tree, key);
     if (node == NULL) {
         return NULL;
@@ -877,6 +930,12 @@ wmem_tree_lookup32_ge_node(const wmem_tree_t *tree, uint32_t key)
 void *
 wmem_tree_lookup32_ge(const wmem_tree_t *tree, uint32_t key)
 {
+    if (tree && tree->is_btree) {
+        void *data = NULL;
+        wmem_btree_lookup32_ge(tree, key, NULL, &data);
+        return data;
+    }
+
     wmem_tree_node_t *node = wmem_tree_lookup32_ge_node(tree, key);
     if (node == NULL) {
         return NULL;
@@ -888,6 +947,12 @@ wmem_tree_lookup32_ge(const wmem_tree_t *tree, uint32_t key)
 void *
 wmem_tree_lookup32_ge_full(const wmem_tree_t *tree, uint32_t key, uint32_t *orig_key)
 {
+    if (tree && tree->is_btree) {
+        void *data = NULL;
+        wmem_btree_lookup32_ge(tree, key, orig_key, &data);
+        return data;
+    }
+
     wmem_tree_node_t *node = wmem_tree_lookup32_ge_node(tree, key);
     if (node == NULL) {
         return NULL;
@@ -900,6 +965,10 @@ wmem_tree_lookup32_ge_full(const wmem_tree_t *tree, uint32_t key, uint32_t *orig
 void *
 wmem_tree_remove32(wmem_tree_t *tree, uint32_t key)
 {
+    if (tree && tree->is_btree) {
+        return wmem_btree_remove32(tree, key);
+    }
+
     wmem_tree_node_t *node = wmem_tree_lookup32_node(tree, key);
     if (node == NULL) {
         return NULL;
@@ -960,7 +1029,12 @@ wmem_tree_remove_string(wmem_tree_t* tree, const char* k, uint32_t flags)
 static void *
 create_sub_tree(void* d)
 {
-    return wmem_tree_new(((wmem_tree_t *)d)->data_allocator);
+    wmem_tree_t *tree = (wmem_tree_t *)d;
+
+    if (tree->is_btree) {
+        return wmem_tree_new_btree(tree->data_allocator);
+    }
+    return wmem_tree_new(tree->data_allocator);
 }
 
 void
@@ -1076,6 +1150,10 @@ bool
 wmem_tree_foreach(const wmem_tree_t* tree, wmem_foreach_func callback,
         void *user_data)
 {
+    if (tree->is_btree) {
+        return wmem_btree_foreach(tree, callback, user_data);
+    }
+
     if(!tree->root)
         return false;
 
@@ -1088,8 +1166,6 @@ wmem_tree_get_data_scope(const wmem_tree_t* tree)
     return tree->data_allocator;
 }
 
-static void wmem_print_subtree(const wmem_tree_t *tree, uint32_t level, wmem_printer_func key_printer, wmem_printer_func data_printer);
-
 static void
 wmem_print_indent(uint32_t level) {
     uint32_t i;
@@ -1134,12 +1210,19 @@ wmem_tree_print_nodes(const char *prefix, wmem_tree_node_t *node, uint32_t level
 }
 
 
-static void
+void
 wmem_print_subtree(const wmem_tree_t *tree, uint32_t level, wmem_printer_func key_printer, wmem_printer_func data_printer)
 {
     if (!tree)
         return;
 
+    if (tree->is_btree) {
+        wmem_print_indent(level);
+        printf("WMEM B+ tree:%p root:%p\n", (const void *)tree, (void *)tree->btree_root);
+        wmem_btree_print(tree, level, key_printer, data_printer);
+        return;
+    }
+
     wmem_print_indent(level);
 
     printf("WMEM tree:%p root:%p\n", (void *)tree, (void *)tree->root);
@@ -82,6 +82,38 @@ WS_DLL_PUBLIC
 wmem_tree_t *
 wmem_tree_new_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope);
 
+/**
+ * @brief Creates a tree backed by a B+ tree instead of a red-black tree.
+ *
+ * Keys are stored in wide, sorted nodes, so a lookup touches a handful of
+ * cache lines instead of one node per level, and wmem_tree_lookup32_le()
+ * on densely inserted keys (such as frame numbers) is considerably faster.
+ * Keys inserted in increasing order fill the nodes completely.
+ *
+ * Only 32-bit keys and arrays of 32-bit keys are supported; the string and
+ * generic key functions must not be used with this tree.
+ *
+ * @param allocator Allocator used for the tree.
+ * @return A pointer to the newly created tree.
+ */
+WS_DLL_PUBLIC
+wmem_tree_t *
+wmem_tree_new_btree(wmem_allocator_t *allocator);
+
+/**
+ * @brief Creates a B+ tree with two allocator scopes.
+ *
+ * This is the B+ tree counterpart of wmem_tree_new_autoreset(); see
+ * wmem_tree_new_btree() for the restrictions on keys.
+ *
+ * @param metadata_scope Allocator for the base structure and metadata.
+ * @param data_scope Allocator for the tree data that resets on free_all.
+ * @return A pointer to the newly created tree.
+ */
+WS_DLL_PUBLIC
+wmem_tree_t *
+wmem_tree_new_btree_autoreset(wmem_allocator_t *metadata_scope, wmem_allocator_t *data_scope);
+
 /**
  * @brief Cleanup memory used by tree.
  *
@@ -0,0 +1,574 @@
+/* wmem_tree_btree.c
+ * Wireshark Memory Manager B+ tree backend for 32 bit keys
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <glib.h>
+
+#include "wmem-int.h"
+#include "wmem_core.h"
+#include "wmem_tree.h"
+#include "wmem_tree-int.h"
+
+/* A node holds up to WMEM_BTREE_MAX_KEYS keys, which are searched as one
+ * small array instead of by following a pointer per comparison. Every node
+ * but the root holds at least WMEM_BTREE_MIN_KEYS. The arrays have one
+ * spare entry so that a node can overflow by one before it is split. */
+#define WMEM_BTREE_MAX_KEYS 31
+#define WMEM_BTREE_MIN_KEYS (WMEM_BTREE_MAX_KEYS / 2)
+
+/* Values are only stored in the leaves, which are linked in key order.
+ * In an inner node, all the keys under children[i] are less than keys[i],
+ * and all the keys under children[i+1] are greater or equal. */
+struct _wmem_btree_node_t {
+    unsigned count;
+    bool is_leaf;
+    uint32_t keys[WMEM_BTREE_MAX_KEYS + 1];
+    union {
+        struct {
+            void *values[WMEM_BTREE_MAX_KEYS + 1];
+            bool is_subtree[WMEM_BTREE_MAX_KEYS + 1];
+            struct _wmem_btree_node_t *prev;
+            struct _wmem_btree_node_t *next;
+        } leaf;
+        struct _wmem_btree_node_t *children[WMEM_BTREE_MAX_KEYS + 2];
+    } u;
+};
+
+static wmem_btree_node_t *
+btree_node_new(wmem_allocator_t *allocator, bool is_leaf)
+{
+    wmem_btree_node_t *node;
+
+    node = wmem_new(allocator, wmem_btree_node_t);
+    node->count   = 0;
+    node->is_leaf = is_leaf;
+    if (is_leaf) {
+        node->u.leaf.prev = NULL;
+        node->u.leaf.next = NULL;
+    }
+
+    return node;
+}
+
+/* Index of the first key greater than key, i.e. the child to descend to. */
+static inline unsigned
+btree_upper_bound(const wmem_btree_node_t *node, uint32_t key)
+{
+    unsigned lo = 0, hi = node->count;
+
+    while (lo < hi) {
+        unsigned mid = (lo + hi) / 2;
+        if (node->keys[mid] <= key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Index of the first key greater or equal to key. */
+static inline unsigned
+btree_lower_bound(const wmem_btree_node_t *node, uint32_t key)
+{
+    unsigned lo = 0, hi = node->count;
+
+    while (lo < hi) {
+        unsigned mid = (lo + hi) / 2;
+        if (node->keys[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static const wmem_btree_node_t *
+btree_find_leaf(const wmem_tree_t *tree, uint32_t key)
+{
+    const wmem_btree_node_t *node = tree->btree_root;
+
+    while (node && !node->is_leaf) {
+        node = node->u.children[btree_upper_bound(node, key)];
+    }
+    return node;
+}
+
+bool
+wmem_btree_lookup32(const wmem_tree_t *tree, uint32_t key, void **data)
+{
+    const wmem_btree_node_t *leaf = btree_find_leaf(tree, key);
+    unsigned i;
+
+    if (!leaf) {
+        return false;
+    }
+
+    i = btree_lower_bound(leaf, key);
+    if (i < leaf->count && leaf->keys[i] == key) {
+        if (data) {
+            *data = leaf->u.leaf.values[i];
+        }
+        return true;
+    }
+    return false;
+}
+
+bool
+wmem_btree_lookup32_le(const wmem_tree_t *tree, uint32_t key, uint32_t *orig_key, void **data)
+{
+    const wmem_btree_node_t *leaf = btree_find_leaf(tree, key);
+    unsigned i;
+
+    if (!leaf) {
+        return false;
+    }
+
+    i = btree_upper_bound(leaf, key);
+    if (i == 0) {
+        /* Everything in this leaf is greater, but everything in the
+         * previous one is less than its lowest possible key. */
+        leaf = leaf->u.leaf.prev;
+        if (!leaf) {
+            return false;
+        }
+        i = leaf->count;
+    }
+    i--;
+
+    if (orig_key) {
+        *orig_key = leaf->keys[i];
+    }
+    if (data) {
+        *data = leaf->u.leaf.values[i];
+    }
+    return true;
+}
+
+bool
+wmem_btree_lookup32_ge(const wmem_tree_t *tree, uint32_t key, uint32_t *orig_key, void **data)
+{
+    const wmem_btree_node_t *leaf = btree_find_leaf(tree, key);
+    unsigned i;
+
+    if (!leaf) {
+        return false;
+    }
+
+    i = btree_lower_bound(leaf, key);
+    if (i == leaf->count) {
+        leaf = leaf->u.leaf.next;
+        if (!leaf) {
+            return false;
+        }
+        i = 0;
+    }
+
+    if (orig_key) {
+        *orig_key = leaf->keys[i];
+    }
+    if (data) {
+        *data = leaf->u.leaf.values[i];
+    }
+    return true;
+}
+
+/* Splits an overflowing node in two, returning the new right half and the
+ * key that separates it from the left.
+ *
+ * Keys are mostly frame or sequence numbers, inserted in increasing order.
+ * When appending at the right edge of the tree, the left node is left full
+ * and only the new key moves, so that such trees are packed instead of
+ * having every node half empty. */
+static wmem_btree_node_t *
+btree_split(wmem_tree_t *tree, wmem_btree_node_t *node, bool append, uint32_t *sep_key)
+{
+    wmem_btree_node_t *right = btree_node_new(tree->data_allocator, node->is_leaf);
+    unsigned half;
+
+    if (!append) {
+        half = node->count / 2;
+    } else if (node->is_leaf) {
+        half = node->count - 1;
+    } else {
+        /* Keep a key in the right node, so that it has two children. */
+        half = node->count - 2;
+    }
+
+    if (node->is_leaf) {
+        right->count = node->count - half;
+        memcpy(right->keys, &node->keys[half], right->count * sizeof(uint32_t));
+        memcpy(right->u.leaf.values, &node->u.leaf.values[half], right->count * sizeof(void *));
+        memcpy(right->u.leaf.is_subtree, &node->u.leaf.is_subtree[half], right->count * sizeof(bool));
+        node->count = half;
+
+        right->u.leaf.prev = node;
+        right->u.leaf.next = node->u.leaf.next;
+        if (node->u.leaf.next) {
+            node->u.leaf.next->u.leaf.prev = right;
+        }
+        node->u.leaf.next = right;
+
+        *sep_key = right->keys[0];
+    } else {
+        /* The middle key moves up instead of being copied. */
+        *sep_key = node->keys[half];
+        right->count = node->count - half - 1;
+        memcpy(right->keys, &node->keys[half + 1], right->count * sizeof(uint32_t));
+        memcpy(right->u.children, &node->u.children[half + 1], (right->count + 1) * sizeof(wmem_btree_node_t *));
+        node->count = half;
+    }
+
+    return right;
+}
+
+static void *
+btree_insert_rec(wmem_tree_t *tree, wmem_btree_node_t *node, bool rightmost, uint32_t key,
+        void*(*func)(void*), void *data, bool is_subtree, bool replace,
+        wmem_btree_node_t **split, uint32_t *sep_key)
+{
+    void *ret;
+    unsigned i;
+
+    *split = NULL;
+
+    if (node->is_leaf) {
+        i = btree_lower_bound(node, key);
+        if (i < node->count && node->keys[i] == key) {
+            if (replace) {
+                node->u.leaf.values[i] = func ? func(data) : data;
+            }
+            return node->u.leaf.values[i];
+        }
+
+        memmove(&node->keys[i + 1], &node->keys[i], (node->count - i) * sizeof(uint32_t));
+        memmove(&node->u.leaf.values[i + 1], &node->u.leaf.values[i], (node->count - i) * sizeof(void *));
+        memmove(&node->u.leaf.is_subtree[i + 1], &node->u.leaf.is_subtree[i], (node->count - i) * sizeof(bool));
+        node->keys[i] = key;
+        node->u.leaf.values[i] = func ? func(data) : data;
+        node->u.leaf.is_subtree[i] = is_subtree;
+        node->count++;
+        ret = node->u.leaf.values[i];
+    } else {
+        wmem_btree_node_t *child_split;
+        uint32_t child_sep;
+
+        i = btree_upper_bound(node, key);
+        ret = btree_insert_rec(tree, node->u.children[i], rightmost && i == node->count,
+                key, func, data, is_subtree, replace, &child_split, &child_sep);
+        if (!child_split) {
+            return ret;
+        }
+
+        memmove(&node->keys[i + 1], &node->keys[i], (node->count - i) * sizeof(uint32_t));
+        memmove(&node->u.children[i + 2], &node->u.children[i + 1], (node->count - i) * sizeof(wmem_btree_node_t *));
+        node->keys[i] = child_sep;
+        node->u.children[i + 1] = child_split;
+        node->count++;
+    }
+
+    if (node->count > WMEM_BTREE_MAX_KEYS) {
+        *split = btree_split(tree, node, rightmost && i == node->count - 1, sep_key);
+    }
+    return ret;
+}
+
+void *
+wmem_btree_lookup_or_insert32(wmem_tree_t *tree, uint32_t key,
+        void*(*func)(void*), void *data, bool is_subtree, bool replace)
+{
+    wmem_btree_node_t *split;
+    uint32_t sep_key;
+    void *ret;
+
+    if (!tree->btree_root) {
+        tree->btree_root = btree_node_new(tree->data_allocator, true);
+    }
+
+    ret = btree_insert_rec(tree, tree->btree_root, true, key, func, data, is_subtree,
+            replace, &split, &sep_key);
+
+    if (split) {
+        wmem_btree_node_t *root = btree_node_new(tree->data_allocator, false);
+        root->count = 1;
+        root->keys[0] = sep_key;
+        root->u.children[0] = tree->btree_root;
+        root->u.children[1] = split;
+        tree->btree_root = root;
+    }
+
+    return ret;
+}
+
+/* Moves the entries of children[i+1] into children[i] and drops it. */
+static void
+btree_merge(wmem_tree_t *tree, wmem_btree_node_t *parent, unsigned i)
+{
+    wmem_btree_node_t *left  = parent->u.children[i];
+    wmem_btree_node_t *right = parent->u.children[i + 1];
+
+    if (left->is_leaf) {
+        memcpy(&left->keys[left->count], right->keys, right->count * sizeof(uint32_t));
+        memcpy(&left->u.leaf.values[left->count], right->u.leaf.values, right->count * sizeof(void *));
+        memcpy(&left->u.leaf.is_subtree[left->count], right->u.leaf.is_subtree, right->count * sizeof(bool));
+        left->count += right->count;
+
+        left->u.leaf.next = right->u.leaf.next;
+        if (right->u.leaf.next) {
+            right->u.leaf.next->u.leaf.prev = left;
+        }
+    } else {
+        left->keys[left->count] = parent->keys[i];
+        memcpy(&left->keys[left->count + 1], right->keys, right->count * sizeof(uint32_t));
+        memcpy(&left->u.children[left->count + 1], right->u.children, (right->count + 1) * sizeof(wmem_btree_node_t *));
+        left->count += right->count + 1;
+    }
+
+    memmove(&parent->keys[i], &parent->keys[i + 1], (parent->count - i - 1) * sizeof(uint32_t));
+    memmove(&parent->u.children[i + 1], &parent->u.children[i + 2], (parent->count - i - 1) * sizeof(wmem_btree_node_t *));
+    parent->count--;
+
+    wmem_free(tree->data_allocator, right);
+}
+
+/* Brings children[i] of parent back up to the minimum number of keys, by
+ * borrowing from a sibling if one can spare it and merging otherwise. */
+static void
+btree_rebalance(wmem_tree_t *tree, wmem_btree_node_t *parent, unsigned i)
+{
+    wmem_btree_node_t *child = parent->u.children[i];
+    wmem_btree_node_t *left  = i > 0 ? parent->u.children[i - 1] : NULL;
+    wmem_btree_node_t *right = i < parent->count ? parent->u.children[i + 1] : NULL;
+
+    if (left && left->count > WMEM_BTREE_MIN_KEYS) {
+        memmove(&child->keys[1], child->keys, child->count * sizeof(uint32_t));
+        if (child->is_leaf) {
+            memmove(&child->u.leaf.values[1], child->u.leaf.values, child->count * sizeof(void *));
+            memmove(&child->u.leaf.is_subtree[1], child->u.leaf.is_subtree, child->count * sizeof(bool));
+            child->keys[0] = left->keys[left->count - 1];
+            child->u.leaf.values[0] = left->u.leaf.values[left->count - 1];
+            child->u.leaf.is_subtree[0] = left->u.leaf.is_subtree[left->count - 1];
+            parent->keys[i - 1] = child->keys[0];
+        } else {
+            memmove(&child->u.children[1], child->u.children, (child->count + 1) * sizeof(wmem_btree_node_t *));
+            child->keys[0] = parent->keys[i - 1];
+            child->u.children[0] = left->u.children[left->count];
+            parent->keys[i - 1] = left->keys[left->count - 1];
+        }
+        child->count++;
+        left->count--;
+    } else if (right && right->count > WMEM_BTREE_MIN_KEYS) {
+        if (child->is_leaf) {
+            child->keys[child->count] = right->keys[0];
+            child->u.leaf.values[child->count] = right->u.leaf.values[0];
+            child->u.leaf.is_subtree[child->count] = right->u.leaf.is_subtree[0];
+            memmove(right->keys, &right->keys[1], (right->count - 1) * sizeof(uint32_t));
+            memmove(right->u.leaf.values, &right->u.leaf.values[1], (right->count - 1) * sizeof(void *));
+            memmove(right->u.leaf.is_subtree, &right->u.leaf.is_subtree[1], (right->count - 1) * sizeof(bool));
+            parent->keys[i] = right->keys[0];
+        } else {
+            child->keys[child->count] = parent->keys[i];
+            child->u.children[child->count + 1] = right->u.children[0];
+            parent->keys[i] = right->keys[0];
+            memmove(right->keys, &right->keys[1], (right->count - 1) * sizeof(uint32_t));
+            memmove(right->u.children, &right->u.children[1], right->count * sizeof(wmem_btree_node_t *));
+        }
+        child->count++;
+        right->count--;
+    } else if (left) {
+        btree_merge(tree, parent, i - 1);
+    } else {
+        ws_assert(right);
+        btree_merge(tree, parent, i);
+    }
+}
+
+static bool
+btree_remove_rec(wmem_tree_t *tree, wmem_btree_node_t *node, uint32_t key, void **data)
+{
+    unsigned i;
+
+    if (node->is_leaf) {
+        i = btree_lower_bound(node, key);
+        if (i == node->count || node->keys[i] != key) {
+            return false;
+        }
+        *data = node->u.leaf.values[i];
+        memmove(&node->keys[i], &node->keys[i + 1], (node->count - i - 1) * sizeof(uint32_t));
+        memmove(&node->u.leaf.values[i], &node->u.leaf.values[i + 1], (node->count - i - 1) * sizeof(void *));
+        memmove(&node->u.leaf.is_subtree[i], &node->u.leaf.is_subtree[i + 1], (node->count - i - 1) * sizeof(bool));
+        node->count--;
+        return true;
+    }
+
+    i = btree_upper_bound(node, key);
+    if (!btree_remove_rec(tree, node->u.children[i], key, data)) {
+        return false;
+    }
+    if (node->u.children[i]->count < WMEM_BTREE_MIN_KEYS) {
+        btree_rebalance(tree, node, i);
+    }
+    return true;
+}
+
+void *
+wmem_btree_remove32(wmem_tree_t *tree, uint32_t key)
+{
+    wmem_btree_node_t *root = tree->btree_root;
+    void *data = NULL;
+
+    if (!root || !btree_remove_rec(tree, root, key, &data)) {
+        return NULL;
+    }
+
+    if (root->count == 0) {
+        if (root->is_leaf) {
+            tree->btree_root = NULL;
+        } else {
+            tree->btree_root = root->u.children[0];
+        }
+        wmem_free(tree->data_allocator, root);
+    }
+
+    return data;
+}
+
+bool
+wmem_btree_foreach(const wmem_tree_t *tree, wmem_foreach_func callback, void *user_data)
+{
+    const wmem_btree_node_t *leaf = tree->btree_root;
+    unsigned i;
+
+    while (leaf && !leaf->is_leaf) {
+        leaf = leaf->u.children[0];
+    }
+
+    for (; leaf; leaf = leaf->u.leaf.next) {
+        for (i = 0; i < leaf->count; i++) {
+            bool stop_traverse;
+
+            if (leaf->u.leaf.is_subtree[i]) {
+                stop_traverse = wmem_tree_foreach((wmem_tree_t *)leaf->u.leaf.values[i],
+                        callback, user_data);
+            } else {
+                stop_traverse = callback(GUINT_TO_POINTER(leaf->keys[i]),
+                        leaf->u.leaf.values[i], user_data);
+            }
+            if (stop_traverse) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+static void
+btree_free_node(wmem_allocator_t *allocator, wmem_btree_node_t *node, bool free_keys, bool free_values)
+{
+    unsigned i;
+
+    if (node->is_leaf) {
+        for (i = 0; i < node->count; i++) {
+            if (node->u.leaf.is_subtree[i]) {
+                wmem_tree_destroy((wmem_tree_t *)node->u.leaf.values[i], free_keys, free_values);
+            } else if (free_values) {
+                wmem_free(allocator, node->u.leaf.values[i]);
+            }
+        }
+    } else {
+        for (i = 0; i <= node->count; i++) {
+            btree_free_node(allocator, node->u.children[i], free_keys, free_values);
+        }
+    }
+    wmem_free(allocator, node);
+}
+
+void
+wmem_btree_free(wmem_tree_t *tree, bool free_keys, bool free_values)
+{
+    /* The keys are integers, so there is nothing to free for free_keys
+     * except in subtrees of a different kind. */
+    if (tree->btree_root) {
+        btree_free_node(tree->data_allocator, tree->btree_root, free_keys, free_values);
+        tree->btree_root = NULL;
+    }
+}
+
+static void
+btree_print_indent(uint32_t level)
+{
+    uint32_t i;
+    for (i=0; i<level; i++) {
+        printf("    ");
+    }
+}
+
+static void
+btree_print_node(const wmem_btree_node_t *node, uint32_t level,
+        wmem_printer_func key_printer, wmem_printer_func data_printer)
+{
+    unsigned i;
+
+    btree_print_indent(level);
+    printf("%s:%p keys:%u\n", node->is_leaf ? "LEAF" : "NODE", (const void *)node, node->count);
+
+    if (!node->is_leaf) {
+        for (i = 0; i <= node->count; i++) {
+            btree_print_node(node->u.children[i], level + 1, key_printer, data_printer);
+        }
+        return;
+    }
+
+    for (i = 0; i < node->count; i++) {
+        btree_print_indent(level + 1);
+        printf("key:%u %s:%p\n", node->keys[i],
+                node->u.leaf.is_subtree[i] ? "tree" : "data", node->u.leaf.values[i]);
+        if (key_printer) {
+            btree_print_indent(level + 1);
+            key_printer(GUINT_TO_POINTER(node->keys[i]));
+            printf("\n");
+        }
+        if (node->u.leaf.is_subtree[i]) {
+            wmem_print_subtree((const wmem_tree_t *)node->u.leaf.values[i], level + 2,
+                    key_printer, data_printer);
+        } else if (data_printer) {
+            btree_print_indent(level + 1);
+            data_printer(node->u.leaf.values[i]);
+            printf("\n");
+        }
+    }
+}
+
+void
+wmem_btree_print(const wmem_tree_t *tree, uint32_t level,
+        wmem_printer_func key_printer, wmem_printer_func data_printer)
+{
+    if (tree->btree_root) {
+        btree_print_node(tree->btree_root, level, key_printer, data_printer);
+    }
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -62,13 +62,16 @@
  * on Windows anyway, so the answer is probably "no".
  */
 #if defined(_M_IX86) || defined(_M_X64)
+#include <intrin.h>
+
 static bool
 ws_cpuid(uint32_t *CPUInfo, uint32_t selector)
 {
 	/* https://docs.microsoft.com/en-us/cpp/intrinsics/cpuid-cpuidex */
 
 	CPUInfo[0] = CPUInfo[1] = CPUInfo[2] = CPUInfo[3] = 0;
-	__cpuid((int *) CPUInfo, selector);
+	/* Subleaf 0, as with the GCC/clang version below */
+	__cpuidex((int *) CPUInfo, selector, 0);
 	/* XXX, how to check if it's supported on MSVC? just in case clear all flags above */
 	return true;
 }
@@ -174,6 +177,29 @@ ws_cpuid(uint32_t *CPUInfo _U_, int selector _U_)
 }
 #endif
 
+/**
+ * @brief Read extended control register 0 (XCR0), which tells which
+ * register sets the OS saves and restores on context switches.
+ *
+ * Only call this if CPUID reports OSXSAVE.
+ *
+ * @return The value of XCR0, or 0 on non-x86 processors.
+ */
+static inline uint64_t
+ws_xgetbv0(void)
+{
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	return _xgetbv(0);
+#elif defined(__GNUC__) && defined(__x86_64__)
+	uint32_t eax, edx;
+
+	__asm__ __volatile__("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+	return ((uint64_t)edx << 32) | eax;
+#else
+	return 0;
+#endif
+}
+
 /**
  * @brief Checks if the CPU supports SSE4.2 instruction set.
  *
@@ -190,3 +216,32 @@ ws_cpuid_sse42(void)
 	/* in ECX bit 20 toggled on */
 	return (CPUInfo[2] & (1 << 20));
 }
+
+/**
+ * @brief Checks if the CPU supports the AVX2 instruction set and the OS
+ * saves the AVX registers.
+ *
+ * @return true if AVX2 instructions can be used.
+ */
+static inline bool
+ws_cpuid_avx2(void)
+{
+	uint32_t CPUInfo[4];
+	const uint32_t osxsave_avx = (1U << 27) | (1U << 28);
+
+	if (!ws_cpuid(CPUInfo, 0) || CPUInfo[0] < 7)
+		return false;
+
+	/* in ECX bit 27 (OSXSAVE) and bit 28 (AVX) toggled on */
+	ws_cpuid(CPUInfo, 1);
+	if ((CPUInfo[2] & osxsave_avx) != osxsave_avx)
+		return false;
+
+	/* XMM and YMM state saved by the OS */
+	if ((ws_xgetbv0() & 0x6) != 0x6)
+		return false;
+
+	/* in EBX bit 5 toggled on */
+	ws_cpuid(CPUInfo, 7);
+	return (CPUInfo[1] & (1U << 5)) != 0;
+}
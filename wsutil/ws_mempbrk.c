@@ -27,16 +27,41 @@
 
 #include <string.h>
 
+#ifdef HAVE_AVX2
+#include "ws_cpuid.h"
+
+/* -1 until ws_mempbrk_compile() has asked the CPU */
+static int use_avx2 = -1;
+#endif
+
+#ifdef HAVE_MEMPBRK_NEON
+#include <arm_neon.h>
+#include "bits_ctz.h"
+#endif
+
 void
 ws_mempbrk_compile(ws_mempbrk_pattern* pattern, const char *needles)
 {
     const char *n = needles;
     memset(pattern->patt, 0, 256);
+    memset(pattern->rows_0_7, 0, sizeof pattern->rows_0_7);
+    memset(pattern->rows_8_15, 0, sizeof pattern->rows_8_15);
     while (*n) {
-        pattern->patt[(int)*n] = 1;
+        uint8_t c = (uint8_t)*n;
+
+        pattern->patt[c] = 1;
+        if (c < 0x80)
+            pattern->rows_0_7[c & 0x0f] |= 1 << (c >> 4);
+        else
+            pattern->rows_8_15[c & 0x0f] |= 1 << ((c >> 4) - 8);
         n++;
     }
 
+#ifdef HAVE_AVX2
+    if (use_avx2 < 0)
+        use_avx2 = ws_cpuid_avx2();
+#endif
+
 #ifdef HAVE_SSE4_2
     ws_mempbrk_sse42_compile(pattern, needles);
 #endif
@@ -61,9 +86,63 @@ ws_mempbrk_portable_exec(const uint8_t* haystack, size_t haystacklen, const ws_m
 }
 
 
+#ifdef HAVE_MEMPBRK_NEON
+/*
+ * Test 16 bytes at a time for membership in the set: the low nibble of
+ * each byte selects a row of the bit matrix in the pattern, the high
+ * nibble a bit in that row.
+ */
+const uint8_t *
+ws_mempbrk_neon_exec(const uint8_t* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, unsigned char *found_needle)
+{
+    static const uint8_t bit_for_nibble[16] = {
+        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80
+    };
+    const uint8x16_t rows_0_7 = vld1q_u8(pattern->rows_0_7);
+    const uint8x16_t rows_8_15 = vld1q_u8(pattern->rows_8_15);
+    const uint8x16_t bits = vld1q_u8(bit_for_nibble);
+    const uint8x16_t low_nibble = vdupq_n_u8(0x0f);
+    const uint8_t *p = haystack;
+    const uint8_t *end = haystack + haystacklen;
+
+    while (end - p >= 16) {
+        uint8x16_t v = vld1q_u8(p);
+        uint8x16_t lo = vandq_u8(v, low_nibble);
+        uint8x16_t row = vbslq_u8(vcgeq_u8(v, vdupq_n_u8(0x80)),
+                                  vqtbl1q_u8(rows_8_15, lo),
+                                  vqtbl1q_u8(rows_0_7, lo));
+        uint8x16_t match = vtstq_u8(row, vqtbl1q_u8(bits, vshrq_n_u8(v, 4)));
+
+        if (vmaxvq_u8(match)) {
+            /* Narrow each byte of the match mask to a nibble. */
+            uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+                    vshrn_n_u16(vreinterpretq_u16_u8(match), 4)), 0);
+            p += ws_ctz(mask) / 4;
+            if (found_needle)
+                *found_needle = *p;
+            return p;
+        }
+        p += 16;
+    }
+
+    return ws_mempbrk_portable_exec(p, end - p, pattern, found_needle);
+}
+#endif
+
 WS_DLL_PUBLIC const uint8_t *
 ws_mempbrk_exec(const uint8_t* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, unsigned char *found_needle)
 {
+#ifdef HAVE_AVX2
+    if (haystacklen >= 32 && use_avx2 > 0)
+        return ws_mempbrk_avx2_exec(haystack, haystacklen, pattern, found_needle);
+#endif
+
+#ifdef HAVE_MEMPBRK_NEON
+    if (haystacklen >= 16)
+        return ws_mempbrk_neon_exec(haystack, haystacklen, pattern, found_needle);
+#endif
+
 #ifdef HAVE_SSE4_2
     if (haystacklen >= 16 && pattern->use_sse42)
         return (const uint8_t*)ws_mempbrk_sse42_exec((const char*)haystack, haystacklen, pattern, found_needle);
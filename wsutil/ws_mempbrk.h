@@ -20,6 +20,12 @@
  */
 typedef struct {
     char patt[256];
+    /* The needles as a 16x16 bit matrix indexed by the low nibble of a
+     * byte, for the AVX2 and NEON kernels: bit n of rows_0_7[lo] is set
+     * if (n << 4 | lo) is a needle, bit n of rows_8_15[lo] if
+     * ((n + 8) << 4 | lo) is. */
+    uint8_t rows_0_7[16];
+    uint8_t rows_8_15[16];
 #ifdef HAVE_SSE4_2
     bool use_sse42;
     __m128i mask;
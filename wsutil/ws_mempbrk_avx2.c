@@ -0,0 +1,103 @@
+/* ws_mempbrk_avx2.c
+ * ws_mempbrk_exec() for processors with AVX2
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_AVX2
+
+#include <immintrin.h>
+
+#include "ws_mempbrk.h"
+#include "ws_mempbrk_int.h"
+#include "bits_ctz.h"
+
+/*
+ * Return a mask with bit i set if byte i of v is one of the needles.
+ *
+ * The low nibble of each byte selects a row of the pattern's bit matrix,
+ * from rows_0_7 or rows_8_15 depending on the top bit of the byte, and
+ * the high nibble selects the bit in that row. This works for any set
+ * of needles, including NUL, unlike the SSE 4.2 string instructions.
+ */
+static inline uint32_t
+match_mask(__m256i v, __m256i rows_0_7, __m256i rows_8_15, __m256i bits, __m256i low_nibble)
+{
+    __m256i lo = _mm256_and_si256(v, low_nibble);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_nibble);
+    /* vpshufb works within each 128-bit lane, so the tables are
+     * repeated in both lanes. */
+    __m256i row = _mm256_blendv_epi8(_mm256_shuffle_epi8(rows_0_7, lo),
+                                     _mm256_shuffle_epi8(rows_8_15, lo), v);
+    __m256i bit = _mm256_shuffle_epi8(bits, hi);
+    __m256i none = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), _mm256_setzero_si256());
+
+    return ~(uint32_t)_mm256_movemask_epi8(none);
+}
+
+const uint8_t *
+ws_mempbrk_avx2_exec(const uint8_t* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, unsigned char *found_needle)
+{
+    const __m256i rows_0_7 = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128((const __m128i *)(const void *)pattern->rows_0_7));
+    const __m256i rows_8_15 = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128((const __m128i *)(const void *)pattern->rows_8_15));
+    const __m256i bits = _mm256_setr_epi8(
+            0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char)0x80,
+            0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char)0x80,
+            0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char)0x80,
+            0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char)0x80);
+    const __m256i low_nibble = _mm256_set1_epi8(0x0f);
+    const uint8_t *p = haystack;
+    const uint8_t *end = haystack + haystacklen;
+    uint32_t mask;
+
+    /* The caller guarantees at least 32 bytes. */
+    while (end - p >= 32) {
+        mask = match_mask(_mm256_loadu_si256((const __m256i *)(const void *)p),
+                          rows_0_7, rows_8_15, bits, low_nibble);
+        if (mask) {
+            p += ws_ctz(mask);
+            goto found;
+        }
+        p += 32;
+    }
+
+    if (p == end)
+        return NULL;
+
+    /* Check the remaining bytes by loading the last 32 bytes of the
+     * haystack and ignoring the ones that have already been checked. */
+    mask = match_mask(_mm256_loadu_si256((const __m256i *)(const void *)(end - 32)),
+                      rows_0_7, rows_8_15, bits, low_nibble);
+    mask >>= 32 - (end - p);
+    if (!mask)
+        return NULL;
+    p += ws_ctz(mask);
+
+found:
+    if (found_needle)
+        *found_needle = *p;
+    return p;
+}
+
+#endif /* HAVE_AVX2 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -26,6 +26,25 @@
  */
 const uint8_t *ws_mempbrk_portable_exec(const uint8_t* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, unsigned char *found_needle);
 
+#ifdef HAVE_AVX2
+/**
+ * @brief AVX2 version of ws_mempbrk_portable_exec().
+ *
+ * Only call this if ws_cpuid_avx2() returns true.
+ */
+const uint8_t *ws_mempbrk_avx2_exec(const uint8_t* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, unsigned char *found_needle);
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+/* NEON is part of the base ARMv8-A 64-bit instruction set. */
+#define HAVE_MEMPBRK_NEON 1
+
+/**
+ * @brief NEON version of ws_mempbrk_portable_exec().
+ */
+const uint8_t *ws_mempbrk_neon_exec(const uint8_t* haystack, size_t haystacklen, const ws_mempbrk_pattern* pattern, unsigned char *found_needle);
+#endif
+
 #ifdef HAVE_SSE4_2
 
 /**